@@ -51,6 +51,50 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+// The same upsamples, through SkPaint::kHigh_FilterLevel instead of the image
+// filter.
+
+class BicubicShaderBench : public SkBenchmark {
+    SkSize         fScale;
+    SkBitmap       fBitmap;
+    SkString       fName;
+
+public:
+    BicubicShaderBench(void* param, float x, float y)
+        :  INHERITED(param), fScale(SkSize::Make(SkFloatToScalar(x), SkFloatToScalar(y))) {
+        fName.printf("bicubic_shader_%gx%g",
+            SkScalarToFloat(fScale.fWidth), SkScalarToFloat(fScale.fHeight));
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, 40, 40);
+        fBitmap.allocPixels();
+        fBitmap.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(fBitmap);
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setAntiAlias(true);
+        canvas.drawOval(SkRect::MakeWH(40, 40), paint);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setFilterLevel(SkPaint::kHigh_FilterLevel);
+
+        canvas->scale(fScale.fWidth, fScale.fHeight);
+        canvas->drawBitmap(fBitmap, 0, 0, &paint);
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 static SkBenchmark* Fact00(void* p) { return new BicubicBench(p, 10.0f, 10.0f); }
 static SkBenchmark* Fact01(void* p) { return new BicubicBench(p, 2.5f, 10.0f); }
 static SkBenchmark* Fact02(void* p) { return new BicubicBench(p, 10.0f, 2.5f); }
@@ -60,3 +104,8 @@ static BenchRegistry gReg00(Fact00);
 static BenchRegistry gReg01(Fact01);
 static BenchRegistry gReg02(Fact02);
 static BenchRegistry gReg03(Fact03);
+
+DEF_BENCH( return new BicubicShaderBench(p, 10.0f, 10.0f); )
+DEF_BENCH( return new BicubicShaderBench(p, 2.5f, 10.0f); )
+DEF_BENCH( return new BicubicShaderBench(p, 10.0f, 2.5f); )
+DEF_BENCH( return new BicubicShaderBench(p, 2.5f, 2.5f); )
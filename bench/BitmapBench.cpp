@@ -342,6 +342,74 @@ protected:
 private:
     typedef BitmapBench INHERITED;
 };
+/** Draw a bitmap scaled down (where kMedium_FilterLevel and up use mipmaps)
+    or up, with each SkPaint::FilterLevel, onto a 256x256 area. The bitmap is
+    immutable, like a decoded image, unless isImmutable is false. */
+
+class FilterLevelBitmapBench : public SkBenchmark {
+    SkBitmap                fBitmap;
+    SkScalar                fScale;
+    SkPaint::FilterLevel    fLevel;
+    bool                    fIsImmutable;
+    SkString                fName;
+    enum { N = SkBENCHLOOP(10) };
+    enum { kDstSize = 256 };
+public:
+    FilterLevelBitmapBench(void* param, float scale, SkPaint::FilterLevel level,
+                           bool isImmutable = true)
+        : INHERITED(param)
+        , fScale(SkFloatToScalar(scale))
+        , fLevel(level)
+        , fIsImmutable(isImmutable) {
+        static const char* gLevelName[] = { "none", "low", "medium", "high" };
+        fName.printf("bitmap_filter_%s_%g%s", gLevelName[level], scale,
+                     isImmutable ? "" : "_mutable");
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        const int size = SkScalarRoundToInt(SkScalarDiv(SkIntToScalar(kDstSize), fScale));
+        fBitmap.setConfig(SkBitmap::kARGB_8888_Config, size, size);
+        fBitmap.allocPixels();
+        fBitmap.eraseColor(SK_ColorWHITE);
+        fBitmap.setIsOpaque(true);
+
+        // Lots of detail, for the downscales to alias.
+        {
+            SkCanvas canvas(fBitmap);
+            SkRandom rand;
+            SkPaint p;
+            p.setAntiAlias(true);
+            for (int i = 0; i < 200; i++) {
+                p.setColor(rand.nextU() | 0xFF000000);
+                canvas.drawCircle(rand.nextUScalar1() * size, rand.nextUScalar1() * size,
+                                  rand.nextUScalar1() * size / 16, p);
+            }
+        }
+        if (fIsImmutable) {
+            fBitmap.setImmutable();
+        }
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setFilterLevel(fLevel);
+
+        canvas->scale(fScale, fScale);
+        for (int i = 0; i < N; i++) {
+            canvas->drawBitmap(fBitmap, 0, 0, &paint);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 static SkBenchmark* Fact0(void* p) { return new BitmapBench(p, false, SkBitmap::kARGB_8888_Config); }
 static SkBenchmark* Fact1(void* p) { return new BitmapBench(p, true, SkBitmap::kARGB_8888_Config); }
 static SkBenchmark* Fact2(void* p) { return new BitmapBench(p, true, SkBitmap::kRGB_565_Config); }
@@ -394,3 +462,11 @@ static BenchRegistry gReg17(Fact17);
 static BenchRegistry gReg18(Fact18);
 static BenchRegistry gReg19(Fact19);
 static BenchRegistry gReg20(Fact20);
+
+DEF_BENCH( return new FilterLevelBitmapBench(p, 0.25f, SkPaint::kNone_FilterLevel); )
+DEF_BENCH( return new FilterLevelBitmapBench(p, 0.25f, SkPaint::kLow_FilterLevel); )
+DEF_BENCH( return new FilterLevelBitmapBench(p, 0.25f, SkPaint::kMedium_FilterLevel); )
+DEF_BENCH( return new FilterLevelBitmapBench(p, 0.25f, SkPaint::kHigh_FilterLevel); )
+DEF_BENCH( return new FilterLevelBitmapBench(p, 0.25f, SkPaint::kMedium_FilterLevel, false); )
+DEF_BENCH( return new FilterLevelBitmapBench(p, 2.5f, SkPaint::kLow_FilterLevel); )
+DEF_BENCH( return new FilterLevelBitmapBench(p, 2.5f, SkPaint::kHigh_FilterLevel); )
@@ -7,8 +7,11 @@
  */
 #include "SkBenchmark.h"
 #include "SkCanvas.h"
+#include "SkBlurMask.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
+#include "SkRRect.h"
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkBlurMaskFilter.h"
@@ -30,10 +33,12 @@ class BlurBench : public SkBenchmark {
     SkBlurMaskFilter::BlurStyle fStyle;
     uint32_t                    fFlags;
     SkString    fName;
+    size_t      fPrevCacheLimit;
 
 public:
     BlurBench(void* param, SkScalar rad, SkBlurMaskFilter::BlurStyle bs, uint32_t flags = 0) : INHERITED(param) {
         fRadius = rad;
+        fPrevCacheLimit = 0;
         fStyle = bs;
         fFlags = flags;
         const char* name = rad > 0 ? gStyleName[bs] : "none";
@@ -50,6 +55,16 @@ protected:
         return fName.c_str();
     }
 
+    // The same ovals are drawn on every loop; keep them out of the blur
+    // mask cache so that we time the blur itself.
+    virtual void onPreDraw() {
+        fPrevCacheLimit = SkGraphics::SetBlurMaskCacheLimit(0);
+    }
+
+    virtual void onPostDraw() {
+        SkGraphics::SetBlurMaskCacheLimit(fPrevCacheLimit);
+    }
+
     virtual void onDraw(SkCanvas* canvas) {
         SkPaint paint;
         this->setupPaint(&paint);
@@ -103,3 +118,139 @@ DEF_BENCH(return new BlurBench(p, REALBIG, SkBlurMaskFilter::kNormal_BlurStyle,
 DEF_BENCH(return new BlurBench(p, REAL, SkBlurMaskFilter::kNormal_BlurStyle, SkBlurMaskFilter::kHighQuality_BlurFlag);)
 
 DEF_BENCH(return new BlurBench(p, 0, SkBlurMaskFilter::kNormal_BlurStyle);)
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Draws the same blurred round rect, a typical UI shadow, at many places on
+// the canvas, with and without the blur mask cache. With the cache, every
+// draw after the first is a cache hit, so this times the hit path.
+class BlurShadowBench : public SkBenchmark {
+    SkScalar    fRadius;
+    bool        fCached;
+    SkString    fName;
+    size_t      fPrevCacheLimit;
+
+public:
+    BlurShadowBench(void* param, SkScalar rad, bool cached) : INHERITED(param) {
+        fRadius = rad;
+        fCached = cached;
+        fPrevCacheLimit = 0;
+        fName.printf("blur_shadow_%d%s", SkScalarRound(rad), cached ? "_cached" : "");
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        fPrevCacheLimit = SkGraphics::SetBlurMaskCacheLimit(fCached ? 1024 * 1024 : 0);
+    }
+
+    virtual void onPostDraw() {
+        SkGraphics::SetBlurMaskCacheLimit(fPrevCacheLimit);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setAntiAlias(true);
+        paint.setMaskFilter(SkBlurMaskFilter::Create(fRadius,
+                                SkBlurMaskFilter::kNormal_BlurStyle))->unref();
+
+        SkRRect rrect;
+        rrect.setRectXY(SkRect::MakeWH(SkIntToScalar(120), SkIntToScalar(40)),
+                        SkIntToScalar(8), SkIntToScalar(8));
+
+        for (int i = 0; i < SkBENCHLOOP(100); i++) {
+            canvas->save();
+            canvas->translate(SkIntToScalar(i % 5 * 130), SkIntToScalar(i / 5 % 8 * 50));
+            canvas->drawRRect(rrect, paint);
+            canvas->restore();
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH(return new BlurShadowBench(p, SMALL, false);)
+DEF_BENCH(return new BlurShadowBench(p, SMALL, true);)
+DEF_BENCH(return new BlurShadowBench(p, BIG, false);)
+DEF_BENCH(return new BlurShadowBench(p, BIG, true);)
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Blurs a 512x512 mask directly with SkBlurMask, so that we time the blur
+// passes themselves, without rasterizing or blitting.
+class BlurMaskBench : public SkBenchmark {
+    SkScalar            fRadius;
+    SkBlurMask::Quality fQuality;
+    SkString            fName;
+    SkMask              fSrcMask;
+
+    enum {
+        kSize = 512,
+    };
+
+public:
+    BlurMaskBench(void* param, SkScalar rad, SkBlurMask::Quality quality) : INHERITED(param) {
+        fRadius = rad;
+        fQuality = quality;
+        const char* name = SkBlurMask::kHigh_Quality == quality ? "high_quality" : "low_quality";
+        if (SkScalarFraction(rad) != 0) {
+            fName.printf("blur_mask_%d_%.2f_%s", kSize, SkScalarToFloat(rad), name);
+        } else {
+            fName.printf("blur_mask_%d_%d_%s", kSize, SkScalarRound(rad), name);
+        }
+        fSrcMask.fImage = NULL;
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        fSrcMask.fBounds.set(0, 0, kSize, kSize);
+        fSrcMask.fFormat = SkMask::kA8_Format;
+        fSrcMask.fRowBytes = kSize;
+        fSrcMask.fImage = SkMask::AllocImage(fSrcMask.computeImageSize());
+
+        // a checkerboard of 32x32 squares, with some partial coverage
+        SkRandom rand;
+        for (int y = 0; y < kSize; ++y) {
+            for (int x = 0; x < kSize; ++x) {
+                uint8_t value = ((x >> 5) ^ (y >> 5)) & 1 ? 0xFF : 0;
+                if ((x & 31) == 0 || (y & 31) == 0) {
+                    value = rand.nextU() & 0xFF;
+                }
+                fSrcMask.fImage[y * kSize + x] = value;
+            }
+        }
+    }
+
+    virtual void onPostDraw() {
+        SkMask::FreeImage(fSrcMask.fImage);
+        fSrcMask.fImage = NULL;
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        for (int i = 0; i < SkBENCHLOOP(10); i++) {
+            SkMask mask;
+            SkBlurMask::BlurSeparable(&mask, fSrcMask, fRadius, SkBlurMask::kNormal_Style,
+                                      fQuality);
+            SkMask::FreeImage(mask.fImage);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH(return new BlurMaskBench(p, SMALL, SkBlurMask::kLow_Quality);)
+DEF_BENCH(return new BlurMaskBench(p, BIG, SkBlurMask::kLow_Quality);)
+DEF_BENCH(return new BlurMaskBench(p, BIG, SkBlurMask::kHigh_Quality);)
+DEF_BENCH(return new BlurMaskBench(p, REAL, SkBlurMask::kLow_Quality);)
+DEF_BENCH(return new BlurMaskBench(p, REALBIG, SkBlurMask::kHigh_Quality);)
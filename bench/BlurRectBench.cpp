@@ -7,11 +7,13 @@
 
 #include "SkBenchmark.h"
 #include "SkCanvas.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkShader.h"
 #include "SkString.h"
 #include "SkBlurMask.h"
+#include "SkBlurMaskFilter.h"
 
 #define SMALL   SkIntToScalar(2)
 #define REAL    SkFloatToScalar(1.5f)
@@ -174,6 +176,63 @@ private:
     typedef BlurRectSeparableBench INHERITED;
 };
 
+// Draws the same blurred rect through SkBlurMaskFilter at many places on the
+// canvas, with and without the blur mask cache, to compare the cost of a
+// cache hit with computing the nine-patch.
+class BlurRectMaskFilterBench: public SkBenchmark {
+    SkScalar    fRadius;
+    bool        fCached;
+    SkString    fName;
+    size_t      fPrevCacheLimit;
+
+public:
+    BlurRectMaskFilterBench(void *param, SkScalar rad, bool cached) : INHERITED(param) {
+        fRadius = rad;
+        fCached = cached;
+        fPrevCacheLimit = 0;
+        if (SkScalarFraction(rad) != 0) {
+            fName.printf("blurrect_maskfilter_%.2f", SkScalarToFloat(rad));
+        } else {
+            fName.printf("blurrect_maskfilter_%d", SkScalarRoundToInt(rad));
+        }
+        if (cached) {
+            fName.append("_cached");
+        }
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        fPrevCacheLimit = SkGraphics::SetBlurMaskCacheLimit(fCached ? 1024 * 1024 : 0);
+    }
+
+    virtual void onPostDraw() {
+        SkGraphics::SetBlurMaskCacheLimit(fPrevCacheLimit);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setAntiAlias(true);
+        paint.setMaskFilter(SkBlurMaskFilter::Create(fRadius,
+                                SkBlurMaskFilter::kNormal_BlurStyle))->unref();
+
+        SkRect r = SkRect::MakeWH(SkIntToScalar(100), SkIntToScalar(60));
+        for (int i = 0; i < SkBENCHLOOP(100); i++) {
+            canvas->save();
+            canvas->translate(SkIntToScalar(i % 5 * 120), SkIntToScalar(i / 5 % 6 * 80));
+            canvas->drawRect(r, paint);
+            canvas->restore();
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 DEF_BENCH(return new BlurRectBoxFilterBench(p, SMALL);)
 DEF_BENCH(return new BlurRectBoxFilterBench(p, BIG);)
 DEF_BENCH(return new BlurRectBoxFilterBench(p, REALBIG);)
@@ -193,6 +252,11 @@ DEF_BENCH(return new BlurRectDirectBench(p, SkIntToScalar(20));)
 DEF_BENCH(return new BlurRectBoxFilterBench(p, SkIntToScalar(5));)
 DEF_BENCH(return new BlurRectBoxFilterBench(p, SkIntToScalar(20));)
 
+DEF_BENCH(return new BlurRectMaskFilterBench(p, BIG, false);)
+DEF_BENCH(return new BlurRectMaskFilterBench(p, BIG, true);)
+DEF_BENCH(return new BlurRectMaskFilterBench(p, REALBIG, false);)
+DEF_BENCH(return new BlurRectMaskFilterBench(p, REALBIG, true);)
+
 #if 0
 // disable Gaussian benchmarks; the algorithm works well enough
 // and serves as a baseline for ground truth, but it's too slow
@@ -11,6 +11,7 @@
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkString.h"
+#include "SkTaskScheduler.h"
 
 extern bool gSkSuppressFontCachePurgeSpew;
 
@@ -51,6 +52,84 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/**
+ *  Draws text from several threads at once, each into its own bitmap, to
+ *  measure contention on the shared glyph cache. Unlike FontScalerBench the
+ *  cache is left warm: the time goes into finding, detaching and reattaching
+ *  strikes, not into the scaler.
+ */
+class FontScalerMTBench : public SkBenchmark {
+    enum {
+        N = SkBENCHLOOP(20),
+        kJobsPerThread = 4,
+    };
+
+    SkString            fName;
+    SkString            fText;
+    bool                fDoLCD;
+    int                 fThreadCount;
+    SkTaskScheduler*    fScheduler;
+    SkBitmap*           fBitmaps;
+public:
+    FontScalerMTBench(void* param, bool doLCD, int threadCount)
+        : INHERITED(param)
+        , fDoLCD(doLCD)
+        , fThreadCount(threadCount)
+        , fScheduler(NULL)
+        , fBitmaps(NULL) {
+        fName.printf("fontscaler_mt_%s_%d", doLCD ? "lcd" : "aa", threadCount);
+        fText.set("abcdefghijklmnopqrstuvwxyz01234567890");
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    // Thread creation is kept out of the timed loop.
+    virtual void onPreDraw() {
+        fScheduler = SkNEW_ARGS(SkTaskScheduler, (fThreadCount));
+        fBitmaps = SkNEW_ARRAY(SkBitmap, this->jobCount());
+        for (int i = 0; i < this->jobCount(); i++) {
+            fBitmaps[i].setConfig(SkBitmap::kARGB_8888_Config, 640, 32);
+            fBitmaps[i].allocPixels();
+        }
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        for (int i = 0; i < N; i++) {
+            SkParallelFor(fScheduler, this->jobCount(), DrawJob, this);
+        }
+    }
+
+    virtual void onPostDraw() {
+        SkDELETE(fScheduler);
+        fScheduler = NULL;
+        SkDELETE_ARRAY(fBitmaps);
+        fBitmaps = NULL;
+    }
+
+private:
+    int jobCount() const { return SkMax32(fThreadCount, 1) * kJobsPerThread; }
+
+    static void DrawJob(FontScalerMTBench* self, int index) {
+        SkCanvas canvas(self->fBitmaps[index]);
+        SkPaint paint;
+        self->setupPaint(&paint);
+        paint.setLCDRenderText(self->fDoLCD);
+
+        // Start each job at a different size so that threads mostly want
+        // different strikes at any one moment.
+        for (int i = 0; i < 8; i++) {
+            int ps = 9 + 2 * ((index + i) % 8);
+            paint.setTextSize(SkIntToScalar(ps));
+            canvas.drawText(self->fText.c_str(), self->fText.size(),
+                            0, SkIntToScalar(20), paint);
+        }
+    }
+
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return SkNEW_ARGS(FontScalerBench, (p, false)); }
@@ -58,3 +137,7 @@ static SkBenchmark* Fact1(void* p) { return SkNEW_ARGS(FontScalerBench, (p, true
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
+
+DEF_BENCH( return SkNEW_ARGS(FontScalerMTBench, (p, false, 1)); )
+DEF_BENCH( return SkNEW_ARGS(FontScalerMTBench, (p, false, 4)); )
+DEF_BENCH( return SkNEW_ARGS(FontScalerMTBench, (p, true, 4)); )
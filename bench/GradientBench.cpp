@@ -264,8 +264,49 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+// Like a page of buttons, each of which makes its own shader for the same
+// gradient: measures how much of the setup the shaders share.
+class GradientButtonBench : public SkBenchmark {
+public:
+    GradientButtonBench(void* param) : INHERITED(param) {}
+
+protected:
+    virtual const char* onGetName() {
+        return "gradient_create_same";
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+
+        const SkRect r = { 0, 0, SkIntToScalar(40), SkIntToScalar(12) };
+        const SkPoint pts[] = {
+            { 0, 0 },
+            { 0, SkIntToScalar(12) },
+        };
+        const SkColor colors[] = {
+            SkColorSetRGB(0xF4, 0xF4, 0xF4),
+            SkColorSetRGB(0xDE, 0xDE, 0xDE),
+            SkColorSetRGB(0xC8, 0xC8, 0xC8),
+        };
+        const SkScalar pos[] = { 0, SK_Scalar1 * 2 / 5, SK_Scalar1 };
+
+        for (int i = 0; i < SkBENCHLOOP(1000); i++) {
+            SkShader* s = SkGradientShader::CreateLinear(pts, colors, pos,
+                                                         SK_ARRAY_COUNT(colors),
+                                                         SkShader::kClamp_TileMode);
+            paint.setShader(s)->unref();
+            canvas->drawRect(r, paint);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 DEF_BENCH( return new GradientBench(p, kLinear_GradType); )
 DEF_BENCH( return new GradientBench(p, kLinear_GradType, SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(p, kLinear_GradType, SkShader::kRepeat_TileMode); )
 
 // Draw a radial gradient of radius 1/2 on a rectangle; half the lines should
 // be completely pinned, the other half should pe partially pinned
@@ -276,6 +317,7 @@ DEF_BENCH( return new GradientBench(p, kRadial_GradType, SkShader::kClamp_TileMo
 DEF_BENCH( return new GradientBench(p, kRadial_GradType, SkShader::kClamp_TileMode, kOval_GeomType); )
 
 DEF_BENCH( return new GradientBench(p, kRadial_GradType, SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(p, kRadial_GradType, SkShader::kRepeat_TileMode); )
 DEF_BENCH( return new GradientBench(p, kSweep_GradType); )
 DEF_BENCH( return new GradientBench(p, kRadial2_GradType); )
 DEF_BENCH( return new GradientBench(p, kRadial2_GradType, SkShader::kMirror_TileMode); )
@@ -283,3 +325,4 @@ DEF_BENCH( return new GradientBench(p, kConical_GradType); )
 
 DEF_BENCH( return new Gradient2Bench(p, false); )
 DEF_BENCH( return new Gradient2Bench(p, true); )
+DEF_BENCH( return new GradientButtonBench(p); )
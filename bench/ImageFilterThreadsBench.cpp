@@ -0,0 +1,95 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkBitmap.h"
+#include "SkBlurImageFilter.h"
+#include "SkColorPriv.h"
+#include "SkMatrix.h"
+#include "SkMorphologyImageFilter.h"
+#include "SkRandom.h"
+#include "SkString.h"
+
+// Runs a blur or a dilate over a full screen sized layer, split across a
+// given number of threads, to show how the raster image filters scale.
+class ImageFilterThreadsBench : public SkBenchmark {
+public:
+    enum Type {
+        kBlur_Type,
+        kDilate_Type,
+    };
+
+    ImageFilterThreadsBench(void* param, Type type, int threadCount)
+        : INHERITED(param)
+        , fType(type)
+        , fThreadCount(threadCount) {
+        fName.printf("imagefilter_threads_%s_%dx%d_%d", kBlur_Type == type ? "blur" : "dilate",
+                     kWidth, kHeight, threadCount);
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fSource.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+        fSource.allocPixels();
+        SkRandom rand;
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                *fSource.getAddr32(x, y) = SkPreMultiplyColor(rand.nextU());
+            }
+        }
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        fSource.reset();
+    }
+
+    virtual void onDraw(SkCanvas*) SK_OVERRIDE {
+        SkAutoTUnref<SkImageFilter> filter;
+        if (kBlur_Type == fType) {
+            SkBlurImageFilter* blur = SkNEW_ARGS(SkBlurImageFilter,
+                                                 (SkIntToScalar(8), SkIntToScalar(8)));
+            blur->setThreadCount(fThreadCount);
+            filter.reset(blur);
+        } else {
+            SkDilateImageFilter* dilate = SkNEW_ARGS(SkDilateImageFilter, (4, 4));
+            dilate->setThreadCount(fThreadCount);
+            filter.reset(dilate);
+        }
+
+        for (int i = 0; i < SkBENCHLOOP(2); i++) {
+            SkBitmap result;
+            SkIPoint offset = SkIPoint::Make(0, 0);
+            filter->filterImage(NULL, fSource, SkMatrix::I(), &result, &offset);
+        }
+    }
+
+private:
+    enum {
+        kWidth = 1024,
+        kHeight = 768,
+    };
+
+    Type     fType;
+    int      fThreadCount;
+    SkString fName;
+    SkBitmap fSource;
+
+    typedef SkBenchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kBlur_Type, 1)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kBlur_Type, 2)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kBlur_Type, 4)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kBlur_Type, 8)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kDilate_Type, 1)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kDilate_Type, 2)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kDilate_Type, 4)); )
+DEF_BENCH( return SkNEW_ARGS(ImageFilterThreadsBench, (p, ImageFilterThreadsBench::kDilate_Type, 8)); )
@@ -9,6 +9,7 @@
 #include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkShader.h"
@@ -18,13 +19,17 @@
 
 enum Flags {
     kStroke_Flag = 1 << 0,
-    kBig_Flag    = 1 << 1
+    kBig_Flag    = 1 << 1,
+    // fill with the analytic rasterizer (see SkGraphics::SetAnalyticAntiAlias)
+    kAnalytic_Flag = 1 << 2
 };
 
 #define FLAGS00  Flags(0)
 #define FLAGS01  Flags(kStroke_Flag)
 #define FLAGS10  Flags(kBig_Flag)
 #define FLAGS11  Flags(kStroke_Flag | kBig_Flag)
+#define FLAGS_A0 Flags(kAnalytic_Flag)
+#define FLAGS_A1 Flags(kAnalytic_Flag | kBig_Flag)
 
 class PathBench : public SkBenchmark {
     SkPaint     fPaint;
@@ -48,6 +53,9 @@ protected:
         fName.printf("path_%s_%s_",
                      fFlags & kStroke_Flag ? "stroke" : "fill",
                      fFlags & kBig_Flag ? "big" : "small");
+        if (fFlags & kAnalytic_Flag) {
+            fName.append("analytic_");
+        }
         this->appendName(&fName);
         return fName.c_str();
     }
@@ -70,9 +78,11 @@ protected:
         }
         count >>= (3 * complexity());
 
+        bool prevAnalytic = SkGraphics::SetAnalyticAntiAlias(SkToBool(fFlags & kAnalytic_Flag));
         for (int i = 0; i < count; i++) {
             canvas->drawPath(path, paint);
         }
+        SkGraphics::SetAnalyticAntiAlias(prevAnalytic);
     }
 
 private:
@@ -220,6 +230,44 @@ private:
     typedef PathBench INHERITED;
 };
 
+// Covers about all of a 640x480 canvas: long scanlines with few spans each.
+class FullRRectPathBench : public PathBench {
+public:
+    FullRRectPathBench(void* param, Flags flags) : INHERITED(param, flags) {}
+
+    virtual void appendName(SkString* name) SK_OVERRIDE {
+        name->append("full_rrect");
+    }
+    virtual void makePath(SkPath* path) SK_OVERRIDE {
+        SkRect r = { SK_Scalar1 / 2, SK_Scalar1 / 2,
+                     SkIntToScalar(640) - SK_Scalar1 / 2, SkIntToScalar(480) - SK_Scalar1 / 2 };
+        path->addRoundRect(r, SkIntToScalar(24), SkIntToScalar(24));
+    }
+    virtual int complexity() SK_OVERRIDE { return 1; }
+private:
+    typedef PathBench INHERITED;
+};
+
+// The outlines of a line of text: many short spans on each scanline.
+class TextPathBench : public PathBench {
+public:
+    TextPathBench(void* param, Flags flags) : INHERITED(param, flags) {}
+
+    virtual void appendName(SkString* name) SK_OVERRIDE {
+        name->append("text");
+    }
+    virtual void makePath(SkPath* path) SK_OVERRIDE {
+        static const char gText[] =
+            "The quick brown fox jumps over the lazy dog, again and again.";
+        SkPaint paint;
+        paint.setTextSize(SkIntToScalar(24));
+        paint.getTextPath(gText, strlen(gText), SkIntToScalar(8), SkIntToScalar(40), path);
+    }
+    virtual int complexity() SK_OVERRIDE { return 1; }
+private:
+    typedef PathBench INHERITED;
+};
+
 class RandomPathBench : public SkBenchmark {
 public:
     RandomPathBench(void* param) : INHERITED(param) {
@@ -874,29 +922,42 @@ DEF_BENCH( return new TrianglePathBench(p, FLAGS00); )
 DEF_BENCH( return new TrianglePathBench(p, FLAGS01); )
 DEF_BENCH( return new TrianglePathBench(p, FLAGS10); )
 DEF_BENCH( return new TrianglePathBench(p, FLAGS11); )
+DEF_BENCH( return new TrianglePathBench(p, FLAGS_A0); )
+DEF_BENCH( return new TrianglePathBench(p, FLAGS_A1); )
 
 DEF_BENCH( return new RectPathBench(p, FLAGS00); )
 DEF_BENCH( return new RectPathBench(p, FLAGS01); )
 DEF_BENCH( return new RectPathBench(p, FLAGS10); )
 DEF_BENCH( return new RectPathBench(p, FLAGS11); )
+DEF_BENCH( return new RectPathBench(p, FLAGS_A0); )
+DEF_BENCH( return new RectPathBench(p, FLAGS_A1); )
 
 DEF_BENCH( return new OvalPathBench(p, FLAGS00); )
 DEF_BENCH( return new OvalPathBench(p, FLAGS01); )
 DEF_BENCH( return new OvalPathBench(p, FLAGS10); )
 DEF_BENCH( return new OvalPathBench(p, FLAGS11); )
+DEF_BENCH( return new OvalPathBench(p, FLAGS_A0); )
+DEF_BENCH( return new OvalPathBench(p, FLAGS_A1); )
 
 DEF_BENCH( return new CirclePathBench(p, FLAGS00); )
 DEF_BENCH( return new CirclePathBench(p, FLAGS01); )
 DEF_BENCH( return new CirclePathBench(p, FLAGS10); )
 DEF_BENCH( return new CirclePathBench(p, FLAGS11); )
+DEF_BENCH( return new CirclePathBench(p, FLAGS_A0); )
+DEF_BENCH( return new CirclePathBench(p, FLAGS_A1); )
 
 DEF_BENCH( return new SawToothPathBench(p, FLAGS00); )
 DEF_BENCH( return new SawToothPathBench(p, FLAGS01); )
+DEF_BENCH( return new SawToothPathBench(p, FLAGS_A0); )
 
 DEF_BENCH( return new LongCurvedPathBench(p, FLAGS00); )
 DEF_BENCH( return new LongCurvedPathBench(p, FLAGS01); )
+DEF_BENCH( return new LongCurvedPathBench(p, FLAGS_A0); )
 DEF_BENCH( return new LongLinePathBench(p, FLAGS00); )
 DEF_BENCH( return new LongLinePathBench(p, FLAGS01); )
+DEF_BENCH( return new LongLinePathBench(p, FLAGS_A0); )
+DEF_BENCH( return new FullRRectPathBench(p, FLAGS00); )
+DEF_BENCH( return new TextPathBench(p, FLAGS00); )
 
 DEF_BENCH( return new PathCreateBench(p); )
 DEF_BENCH( return new PathCopyBench(p); )
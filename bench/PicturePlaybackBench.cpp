@@ -7,6 +7,7 @@
 #include "SkBenchmark.h"
 #include "SkCanvas.h"
 #include "SkColor.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkPicture.h"
 #include "SkPoint.h"
@@ -135,12 +136,90 @@ private:
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  Plays back a picture which draws the same small picture, an icon, at
+ *  every cell of a grid, with and without the cache of rasterized nested
+ *  pictures.
+ */
+class NestedPicturePlaybackBench : public SkBenchmark {
+public:
+    NestedPicturePlaybackBench(void* param, bool cached)
+        : INHERITED(param)
+        , fCached(cached)
+        , fOldCacheLimit(0) {
+        fName.printf("picture_playback_nested_%s", cached ? "cached" : "uncached");
+    }
+
+    enum {
+        N = SkBENCHLOOP(10),    // number of times to playback the picture
+        kIconSize = 24,
+        kColumns = 25,
+        kRows = 20,
+    };
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() {
+        SkCanvas* iconCanvas = fIcon.beginRecording(kIconSize, kIconSize);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setColor(SK_ColorBLUE);
+        SkScalar half = SkIntToScalar(kIconSize) / 2;
+        iconCanvas->drawCircle(half, half, half - 2, paint);
+        paint.setColor(SK_ColorWHITE);
+        paint.setStyle(SkPaint::kStroke_Style);
+        paint.setStrokeWidth(SkIntToScalar(2));
+        iconCanvas->drawCircle(half, half, half / 2, paint);
+        fIcon.endRecording();
+
+        SkCanvas* canvas = fPicture.beginRecording(kColumns * kIconSize, kRows * kIconSize);
+        for (int y = 0; y < kRows; y++) {
+            for (int x = 0; x < kColumns; x++) {
+                canvas->save();
+                canvas->translate(SkIntToScalar(x * kIconSize), SkIntToScalar(y * kIconSize));
+                canvas->drawPicture(fIcon);
+                canvas->restore();
+            }
+        }
+        fPicture.endRecording();
+
+        fOldCacheLimit = SkGraphics::SetPictureCacheLimit(fCached ? 1024 * 1024 : 0);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        for (int i = 0; i < N; i++) {
+            fPicture.draw(canvas);
+        }
+    }
+
+    virtual void onPostDraw() {
+        SkGraphics::SetPictureCacheLimit(fOldCacheLimit);
+    }
+
+private:
+    SkString    fName;
+    bool        fCached;
+    size_t      fOldCacheLimit;
+    SkPicture   fIcon;
+    SkPicture   fPicture;
+
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return new TextPlaybackBench(p); }
 static SkBenchmark* Fact1(void* p) { return new PosTextPlaybackBench(p, true); }
 static SkBenchmark* Fact2(void* p) { return new PosTextPlaybackBench(p, false); }
+static SkBenchmark* Fact3(void* p) { return new NestedPicturePlaybackBench(p, false); }
+static SkBenchmark* Fact4(void* p) { return new NestedPicturePlaybackBench(p, true); }
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
+static BenchRegistry gReg4(Fact4);
@@ -9,10 +9,12 @@
 #include "SkColor.h"
 #include "SkPaint.h"
 #include "SkPicture.h"
+#include "SkPictureRecordGroup.h"
 #include "SkPoint.h"
 #include "SkRandom.h"
 #include "SkRect.h"
 #include "SkString.h"
+#include "SkTaskScheduler.h"
 
 class PictureRecordBench : public SkBenchmark {
 public:
@@ -129,21 +131,30 @@ private:
 
 /*
  *  Populates the SkPaint dictionary with a large number of unique paint
- *  objects that differ only by color
+ *  objects that differ only by color. The _many variant records enough of
+ *  them that the cost of adding each new paint to the dictionary dominates.
  */
 class UniquePaintDictionaryRecordBench : public PictureRecordBench {
 public:
     UniquePaintDictionaryRecordBench(void* param)
-        : INHERITED(param, "unique_paint_dictionary") { }
+        : INHERITED(param, "unique_paint_dictionary")
+        , fPaintCount(M) { }
+
+    UniquePaintDictionaryRecordBench(void* param, const char name[], int paintCount)
+        : INHERITED(param, name)
+        , fPaintCount(paintCount) { }
 
     enum {
         M = SkBENCHLOOP(15000),   // number of unique paint objects
+        kManyPaints = SkBENCHLOOP(100000),
     };
 protected:
-    virtual float innerLoopScale() const SK_OVERRIDE { return 0.1f; }
+    virtual float innerLoopScale() const SK_OVERRIDE {
+        return 0.1f * M / fPaintCount;
+    }
     virtual void recordCanvas(SkCanvas* canvas) {
         SkRandom rand;
-        for (int i = 0; i < M; i++) {
+        for (int i = 0; i < fPaintCount; i++) {
             SkPaint paint;
             paint.setColor(rand.nextU());
             canvas->drawPaint(paint);
@@ -151,6 +162,8 @@ protected:
     }
 
 private:
+    int fPaintCount;
+
     typedef PictureRecordBench INHERITED;
 };
 
@@ -182,12 +195,124 @@ private:
     typedef PictureRecordBench INHERITED;
 };
 
+/*
+ *  Records a tall picture of rows of rects, either on one thread into a plain
+ *  SkPicture or split into horizontal bands that are recorded on threadCount
+ *  threads through an SkPictureRecordGroup and then spliced together. The
+ *  paints recur across bands, so the threads contend for the shared paint
+ *  dictionary.
+ */
+class ParallelRecordBench : public SkBenchmark {
+public:
+    ParallelRecordBench(void* param, int threadCount)
+        : INHERITED(param)
+        , fThreadCount(threadCount)
+        , fScheduler(NULL)
+        , fGroup(NULL) {
+        if (threadCount > 0) {
+            fName.printf("picture_record_parallel_%d", threadCount);
+        } else {
+            fName.set("picture_record_parallel_serial");
+        }
+        fIsRendering = false;
+    }
+
+    enum {
+        N = SkBENCHLOOP(10),     // number of times to create the picture
+        kPartCount = 16,
+        kPartHeight = 256,
+        kRowsPerPart = 64,
+        kRectsPerRow = 32,
+        kPaintCount = 50,
+    };
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    // Thread creation is kept out of the timed loop.
+    virtual void onPreDraw() {
+        if (fThreadCount > 0) {
+            fScheduler = SkNEW_ARGS(SkTaskScheduler, (fThreadCount));
+        }
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        for (int i = 0; i < N; i++) {
+            if (NULL == fScheduler) {
+                SkPicture picture;
+                SkCanvas* canvas = picture.beginRecording(kWidth, kPartCount * kPartHeight);
+                for (int part = 0; part < kPartCount; part++) {
+                    canvas->save();
+                    canvas->translate(0, SkIntToScalar(part * kPartHeight));
+                    RecordPart(canvas, part);
+                    canvas->restore();
+                }
+                picture.endRecording();
+            } else {
+                SkPictureRecordGroup group(kPartCount);
+                fGroup = &group;
+                SkParallelFor(fScheduler, kPartCount, RecordJob, this);
+                SkPoint offsets[kPartCount];
+                for (int part = 0; part < kPartCount; part++) {
+                    offsets[part].set(0, SkIntToScalar(part * kPartHeight));
+                }
+                SkAutoTUnref<SkPicture> picture(group.createSplicedPicture(
+                        kWidth, kPartCount * kPartHeight, offsets));
+            }
+        }
+    }
+
+    virtual void onPostDraw() {
+        SkDELETE(fScheduler);
+        fScheduler = NULL;
+    }
+
+private:
+    enum {
+        kWidth = kRectsPerRow * 4,
+    };
+
+    static void RecordJob(ParallelRecordBench* self, int part) {
+        RecordPart(self->fGroup->beginRecording(part, kWidth, kPartHeight), part);
+        self->fGroup->endRecording(part);
+    }
+
+    static void RecordPart(SkCanvas* canvas, int part) {
+        SkPaint paint;
+        for (int y = 0; y < kRowsPerPart; y++) {
+            for (int x = 0; x < kRectsPerRow; x++) {
+                paint.setColor(0xFF000000 | ((part * kRowsPerPart + y + x) % kPaintCount));
+                canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(x * 4), SkIntToScalar(y * 4),
+                                                  SkIntToScalar(3), SkIntToScalar(3)), paint);
+            }
+        }
+    }
+
+    SkString                fName;
+    int                     fThreadCount;
+    SkTaskScheduler*        fScheduler;
+    SkPictureRecordGroup*   fGroup;
+
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return new DictionaryRecordBench(p); }
 static SkBenchmark* Fact1(void* p) { return new UniquePaintDictionaryRecordBench(p); }
 static SkBenchmark* Fact2(void* p) { return new RecurringPaintDictionaryRecordBench(p); }
+static SkBenchmark* Fact3(void* p) { return new ParallelRecordBench(p, 0); }
+static SkBenchmark* Fact4(void* p) { return new ParallelRecordBench(p, 2); }
+static SkBenchmark* Fact5(void* p) { return new ParallelRecordBench(p, 4); }
+static SkBenchmark* Fact6(void* p) {
+    return new UniquePaintDictionaryRecordBench(p, "unique_paint_dictionary_many",
+                                                UniquePaintDictionaryRecordBench::kManyPaints);
+}
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
+static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg5(Fact5);
+static BenchRegistry gReg6(Fact6);
@@ -17,6 +17,10 @@ static const int GENERATE_EXTENTS = 1000;
 static const int NUM_BUILD_RECTS = 500;
 static const int NUM_QUERY_RECTS = 5000;
 static const int NUM_QUERIES = 1000;
+// tile queries are made for square blocks of adjacent tiles, as a tiled renderer would make them
+static const int TILE_BLOCK_SIZE = 4;
+static const int NUM_TILES_PER_BLOCK = TILE_BLOCK_SIZE * TILE_BLOCK_SIZE;
+static const int TILE_SIZE = GENERATE_EXTENTS / 16;
 
 typedef SkIRect (*MakeRectProc)(SkRandom&, int, int);
 
@@ -70,22 +74,30 @@ public:
         kSmall_QueryType, // small queries
         kLarge_QueryType, // large queries
         kRandom_QueryType,// randomly sized queries
-        kFull_QueryType   // queries that cover everything
+        kFull_QueryType,  // queries that cover everything
+        kTiles_QueryType  // blocks of adjacent tile sized queries
     };
 
     BBoxQueryBench(void* param, const char* name, MakeRectProc proc, bool bulkLoad,
-                    QueryType q, SkBBoxHierarchy* tree)
+                    QueryType q, SkBBoxHierarchy* tree, bool batched = false)
         : INHERITED(param)
         , fTree(tree)
         , fProc(proc)
         , fBulkLoad(bulkLoad)
+        , fBatched(batched)
         , fQuery(q) {
         fName.append("rtree_");
         fName.append(name);
         fName.append("_query");
+        if (kTiles_QueryType == fQuery) {
+            fName.append("_tiles");
+        }
         if (fBulkLoad) {
             fName.append("_bulk");
         }
+        if (fBatched) {
+            fName.append("_batched");
+        }
         SkRandom rand;
         for (int j = 0; j < SkBENCHLOOP(NUM_QUERY_RECTS); ++j) {
             fTree->insert(reinterpret_cast<void*>(j), fProc(rand, j,
@@ -102,6 +114,10 @@ protected:
         return fName.c_str();
     }
     virtual void onDraw(SkCanvas* canvas) {
+        if (kTiles_QueryType == fQuery) {
+            this->drawTiles();
+            return;
+        }
         SkRandom rand;
         for (int i = 0; i < SkBENCHLOOP(NUM_QUERIES); ++i) {
             SkTDArray<void*> hits;
@@ -137,10 +153,34 @@ protected:
         }
     }
 private:
+    // Makes the same number of queries as onDraw() does otherwise
+    void drawTiles() {
+        SkRandom rand;
+        for (int i = 0; i < SkBENCHLOOP(NUM_QUERIES / NUM_TILES_PER_BLOCK); ++i) {
+            SkIRect queries[NUM_TILES_PER_BLOCK];
+            SkTDArray<void*> hits[NUM_TILES_PER_BLOCK];
+            int left = rand.nextU() % GENERATE_EXTENTS;
+            int top = rand.nextU() % GENERATE_EXTENTS;
+            for (int j = 0; j < NUM_TILES_PER_BLOCK; ++j) {
+                queries[j] = SkIRect::MakeXYWH(left + (j % TILE_BLOCK_SIZE) * TILE_SIZE,
+                                               top + (j / TILE_BLOCK_SIZE) * TILE_SIZE,
+                                               TILE_SIZE, TILE_SIZE);
+            }
+            if (fBatched) {
+                fTree->searchBatch(queries, NUM_TILES_PER_BLOCK, hits);
+            } else {
+                for (int j = 0; j < NUM_TILES_PER_BLOCK; ++j) {
+                    fTree->search(queries[j], &hits[j]);
+                }
+            }
+        }
+    }
+
     SkBBoxHierarchy* fTree;
     MakeRectProc fProc;
     SkString fName;
     bool fBulkLoad;
+    bool fBatched;
     QueryType fQuery;
     typedef SkBenchmark INHERITED;
 };
@@ -187,6 +227,13 @@ static inline SkIRect make_large_rects(SkRandom& rand, int index, int numRects)
     return out;
 }
 
+// A bulk-loaded tree left as separately allocated nodes, rather than packed into one array
+static inline SkBBoxHierarchy* make_unpacked_rtree() {
+    SkRTree* tree = SkRTree::Create(5, 16);
+    tree->setPackBulkLoads(false);
+    return tree;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static inline SkBenchmark* Fact0(void* p) {
@@ -210,8 +257,34 @@ static inline SkBenchmark* Fact4(void* p) {
                       BBoxQueryBench::kRandom_QueryType, SkRTree::Create(5, 16)));
 }
 
+static inline SkBenchmark* Fact5(void* p) {
+    return SkNEW_ARGS(BBoxBuildBench, (p, "random_unpacked", &make_random_rects, true,
+                      make_unpacked_rtree()));
+}
+static inline SkBenchmark* Fact6(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random_unpacked", &make_random_rects, true,
+                      BBoxQueryBench::kRandom_QueryType, make_unpacked_rtree()));
+}
+static inline SkBenchmark* Fact7(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random", &make_random_rects, true,
+                      BBoxQueryBench::kTiles_QueryType, SkRTree::Create(5, 16)));
+}
+static inline SkBenchmark* Fact8(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random", &make_random_rects, true,
+                      BBoxQueryBench::kTiles_QueryType, SkRTree::Create(5, 16), true));
+}
+static inline SkBenchmark* Fact9(void* p) {
+    return SkNEW_ARGS(BBoxQueryBench, (p, "random_unpacked", &make_random_rects, true,
+                      BBoxQueryBench::kTiles_QueryType, make_unpacked_rtree()));
+}
+
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
 static BenchRegistry gReg3(Fact3);
 static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg5(Fact5);
+static BenchRegistry gReg6(Fact6);
+static BenchRegistry gReg7(Fact7);
+static BenchRegistry gReg8(Fact8);
+static BenchRegistry gReg9(Fact9);
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkCountdown.h"
+#include "SkRunnable.h"
+#include "SkString.h"
+#include "SkTaskScheduler.h"
+#include "SkThread.h"
+#include "SkThreadPool.h"
+
+namespace {
+
+// A small, fixed amount of work, so that the bench measures scheduling overhead rather than
+// the work itself.
+class SpinRunnable : public SkRunnable {
+public:
+    SpinRunnable() : fDone(NULL) {}
+
+    virtual void run() SK_OVERRIDE {
+        volatile uint32_t x = 0;
+        for (int i = 0; i < 64; i++) {
+            x = x * 1664525 + 1013904223;
+        }
+        if (NULL != fDone) {
+            fDone->run();
+        }
+    }
+
+    SkRunnable* fDone;
+};
+
+}  // namespace
+
+/**
+ * Submits many tiny runnables and waits for them, once through the single-queue SkThreadPool
+ * (paired with an SkCountdown) and once through the work-stealing SkTaskScheduler, either one
+ * runnable at a time or as a single batch.
+ */
+class TaskSchedulerBench : public SkBenchmark {
+public:
+    enum Mode {
+        kThreadPool_Mode,
+        kScheduler_Mode,
+        kSchedulerBatch_Mode,
+    };
+
+private:
+    enum {
+        N = SkBENCHLOOP(10),
+        kTasks = 1024,
+    };
+
+    Mode             fMode;
+    int              fThreadCount;
+    SkString         fName;
+    SkThreadPool*    fPool;
+    SkTaskScheduler* fScheduler;
+    SpinRunnable     fRunnables[kTasks];
+    SkRunnable*      fBatch[kTasks];
+
+public:
+    TaskSchedulerBench(void* param, Mode mode, int threadCount)
+        : INHERITED(param)
+        , fMode(mode)
+        , fThreadCount(threadCount)
+        , fPool(NULL)
+        , fScheduler(NULL) {
+        static const char* gNames[] = { "threadpool", "taskscheduler", "taskscheduler_batch" };
+        fName.printf("%s_%d", gNames[mode], threadCount);
+        for (int i = 0; i < kTasks; i++) {
+            fBatch[i] = &fRunnables[i];
+        }
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    // Thread creation is kept out of the timed loop.
+    virtual void onPreDraw() {
+        if (kThreadPool_Mode == fMode) {
+            fPool = SkNEW_ARGS(SkThreadPool, (fThreadCount));
+        } else {
+            fScheduler = SkNEW_ARGS(SkTaskScheduler, (fThreadCount));
+        }
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        switch (fMode) {
+            case kThreadPool_Mode: {
+                SkCountdown countdown(kTasks);
+                for (int loop = 0; loop < N; loop++) {
+                    countdown.reset(kTasks);
+                    for (int i = 0; i < kTasks; i++) {
+                        fRunnables[i].fDone = &countdown;
+                        fPool->add(&fRunnables[i]);
+                    }
+                    countdown.wait();
+                }
+            } break;
+            case kScheduler_Mode: {
+                for (int loop = 0; loop < N; loop++) {
+                    SkTaskGroup group(fScheduler);
+                    for (int i = 0; i < kTasks; i++) {
+                        group.add(&fRunnables[i]);
+                    }
+                    group.wait();
+                }
+            } break;
+            case kSchedulerBatch_Mode: {
+                for (int loop = 0; loop < N; loop++) {
+                    SkTaskGroup group(fScheduler);
+                    group.addBatch(fBatch, kTasks);
+                    group.wait();
+                }
+            } break;
+        }
+    }
+
+    virtual void onPostDraw() {
+        SkDELETE(fPool);
+        fPool = NULL;
+        SkDELETE(fScheduler);
+        fScheduler = NULL;
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+DEF_BENCH(return new TaskSchedulerBench(p, TaskSchedulerBench::kThreadPool_Mode, 4))
+DEF_BENCH(return new TaskSchedulerBench(p, TaskSchedulerBench::kScheduler_Mode, 4))
+DEF_BENCH(return new TaskSchedulerBench(p, TaskSchedulerBench::kSchedulerBatch_Mode, 4))
+DEF_BENCH(return new TaskSchedulerBench(p, TaskSchedulerBench::kThreadPool_Mode, 16))
+DEF_BENCH(return new TaskSchedulerBench(p, TaskSchedulerBench::kScheduler_Mode, 16))
+DEF_BENCH(return new TaskSchedulerBench(p, TaskSchedulerBench::kSchedulerBatch_Mode, 16))
@@ -8,6 +8,7 @@
 
 #include "SkBenchmark.h"
 #include "SkCanvas.h"
+#include "SkColorPriv.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkString.h"
@@ -68,3 +69,99 @@ static SkBenchmark* Fact2(void* p) { return new XfermodeBench(p, SkXfermode::kDa
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Benchmark that calls SkXfermode::xfer32 directly, so that the cost of the
+// mode itself isn't hidden by the rest of the drawing pipeline. Every width
+// blends the same number of pixels, split into rows of that width.
+class XfermodeRowBench : public SkBenchmark {
+public:
+    XfermodeRowBench(void* param, SkXfermode::Mode mode, int width)
+        : INHERITED(param)
+        , fWidth(width) {
+        fXfermode.reset(SkXfermode::Create(mode));
+        SkASSERT(NULL != fXfermode.get());
+        fName.printf("Xfermode_row_%s_%d", SkXfermode::ModeName(mode), width);
+
+        SkMWCRandom random;
+        for (int i = 0; i < kPixels; ++i) {
+            fSrc[i] = random_pmcolor(&random);
+            fDstOrig[i] = random_pmcolor(&random);
+        }
+        fIsRendering = false;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE { return fName.c_str(); }
+
+    virtual void onDraw(SkCanvas*) SK_OVERRIDE {
+        for (int loop = 0; loop < N; ++loop) {
+            memcpy(fDst, fDstOrig, sizeof(fDst));
+            for (int x = 0; x + fWidth <= kPixels; x += fWidth) {
+                fXfermode->xfer32(fDst + x, fSrc + x, fWidth, NULL);
+            }
+        }
+    }
+
+private:
+    enum {
+        N = SkBENCHLOOP(100),
+        kPixels = 4096,
+    };
+
+    static SkPMColor random_pmcolor(SkMWCRandom* random) {
+        unsigned a = random->nextULessThan(256);
+        return SkPackARGB32(a, random->nextULessThan(a + 1), random->nextULessThan(a + 1),
+                            random->nextULessThan(a + 1));
+    }
+
+    SkAutoTUnref<SkXfermode> fXfermode;
+    int fWidth;
+    SkString fName;
+    SkPMColor fSrc[kPixels];
+    SkPMColor fDst[kPixels];
+    SkPMColor fDstOrig[kPixels];
+
+    typedef SkBenchmark INHERITED;
+};
+
+template <SkXfermode::Mode mode, int width>
+static SkBenchmark* RowFact(void* p) { return new XfermodeRowBench(p, mode, width); }
+
+#define ROW_BENCH(mode, width) \
+    static BenchRegistry gRowReg_##mode##_##width(RowFact<SkXfermode::mode, width>);
+#define ROW_BENCHES(mode) ROW_BENCH(mode, 4) ROW_BENCH(mode, 32) ROW_BENCH(mode, 256)
+
+// kSrcOver has no SkXfermode; the blitters handle it with SkBlitRow procs.
+ROW_BENCHES(kClear_Mode)
+ROW_BENCHES(kSrc_Mode)
+ROW_BENCHES(kDst_Mode)
+ROW_BENCHES(kDstOver_Mode)
+ROW_BENCHES(kSrcIn_Mode)
+ROW_BENCHES(kDstIn_Mode)
+ROW_BENCHES(kSrcOut_Mode)
+ROW_BENCHES(kDstOut_Mode)
+ROW_BENCHES(kSrcATop_Mode)
+ROW_BENCHES(kDstATop_Mode)
+ROW_BENCHES(kXor_Mode)
+ROW_BENCHES(kPlus_Mode)
+ROW_BENCHES(kModulate_Mode)
+ROW_BENCHES(kScreen_Mode)
+ROW_BENCHES(kOverlay_Mode)
+ROW_BENCHES(kDarken_Mode)
+ROW_BENCHES(kLighten_Mode)
+ROW_BENCHES(kColorDodge_Mode)
+ROW_BENCHES(kColorBurn_Mode)
+ROW_BENCHES(kHardLight_Mode)
+ROW_BENCHES(kSoftLight_Mode)
+ROW_BENCHES(kDifference_Mode)
+ROW_BENCHES(kExclusion_Mode)
+ROW_BENCHES(kMultiply_Mode)
+ROW_BENCHES(kHue_Mode)
+ROW_BENCHES(kSaturation_Mode)
+ROW_BENCHES(kColor_Mode)
+ROW_BENCHES(kLuminosity_Mode)
+
+#undef ROW_BENCHES
+#undef ROW_BENCH
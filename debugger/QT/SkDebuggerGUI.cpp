@@ -143,10 +143,10 @@ void SkDebuggerGUI::showDeletes() {
 // offsets to individual commands.
 class SkTimedPicturePlayback : public SkPicturePlayback {
 public:
-    SkTimedPicturePlayback(SkStream* stream, const SkPictInfo& info,
+    SkTimedPicturePlayback(SkStream* stream, const SkPictInfo& info, bool* isValid,
                            SkPicture::InstallPixelRefProc proc, const SkTDArray<size_t>& offsets,
                            const SkTDArray<bool>& deletedCommands)
-        : INHERITED(stream, info, proc)
+        : INHERITED(stream, info, isValid, proc)
         , fOffsets(offsets)
         , fSkipCommands(deletedCommands)
         , fTot(0.0)
@@ -270,8 +270,14 @@ public:
         }
 
         if (stream->readBool()) {
+            bool isValid;
             fPlayback = SkNEW_ARGS(SkTimedPicturePlayback,
-                                   (stream, info, proc, offsets, deletedCommands));
+                                   (stream, info, &isValid, proc, offsets, deletedCommands));
+            if (!isValid) {
+                SkDELETE(fPlayback);
+                fPlayback = NULL;
+                return;
+            }
         }
 
         // do this at the end, so that they will be zero if we hit an error.
@@ -918,9 +924,9 @@ void SkDebuggerGUI::setupDirectoryWidget(const QString& path) {
 // These are needed by the profiling system.
 class SkOffsetPicturePlayback : public SkPicturePlayback {
 public:
-    SkOffsetPicturePlayback(SkStream* stream, const SkPictInfo& info,
+    SkOffsetPicturePlayback(SkStream* stream, const SkPictInfo& info, bool* isValid,
                             SkPicture::InstallPixelRefProc proc)
-        : INHERITED(stream, info, proc) {
+        : INHERITED(stream, info, isValid, proc) {
     }
 
     const SkTDArray<size_t>& offsets() const { return fOffsets; }
@@ -958,7 +964,13 @@ public:
         }
 
         if (stream->readBool()) {
-            fPlayback = SkNEW_ARGS(SkOffsetPicturePlayback, (stream, info, proc));
+            bool isValid;
+            fPlayback = SkNEW_ARGS(SkOffsetPicturePlayback, (stream, info, &isValid, proc));
+            if (!isValid) {
+                SkDELETE(fPlayback);
+                fPlayback = NULL;
+                return;
+            }
         }
 
         // do this at the end, so that they will be zero if we hit an error.
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "gm.h"
+#include "SkCanvas.h"
+#include "SkGraphics.h"
+#include "SkPath.h"
+
+namespace skiagm {
+
+static const int kCell = 48;
+static const int kZoom = 4;
+static const int kGap = 10;
+static const int kShapeCount = 4;
+
+static void make_shape(int index, SkPath* path, SkPaint* paint) {
+    switch (index) {
+        case 0:
+            // A sliver, nearly horizontal, where supersampling only has 4
+            // samples vertically to go by.
+            path->moveTo(SkIntToScalar(2), SkIntToScalar(20));
+            path->lineTo(SkIntToScalar(46), SkIntToScalar(23));
+            path->lineTo(SkIntToScalar(2), SkFloatToScalar(21.5f));
+            path->close();
+            break;
+        case 1:
+            path->addCircle(SkFloatToScalar(24.2f), SkFloatToScalar(23.7f),
+                            SkFloatToScalar(19.3f));
+            break;
+        case 2: {
+            // A star, whose middle even-odd leaves out.
+            const SkScalar cx = SkIntToScalar(24), cy = SkIntToScalar(25);
+            const SkScalar r = SkIntToScalar(21);
+            path->moveTo(cx, cy - r);
+            for (int i = 1; i < 5; ++i) {
+                SkScalar cosValue;
+                SkScalar sinValue = SkScalarSinCos(i * 4 * SK_ScalarPI / 5, &cosValue);
+                path->lineTo(cx + SkScalarMul(r, sinValue), cy - SkScalarMul(r, cosValue));
+            }
+            path->close();
+            path->setFillType(SkPath::kEvenOdd_FillType);
+            break;
+        }
+        default:
+            path->moveTo(SkIntToScalar(6), SkIntToScalar(40));
+            path->cubicTo(SkIntToScalar(10), SkIntToScalar(-10),
+                          SkIntToScalar(38), SkIntToScalar(58),
+                          SkIntToScalar(42), SkIntToScalar(8));
+            paint->setStyle(SkPaint::kStroke_Style);
+            paint->setStrokeWidth(SkFloatToScalar(2.5f));
+            break;
+    }
+}
+
+/**
+ *  Fills a few paths with the supersampling and the analytic rasterizers,
+ *  side by side, each at its own size and zoomed in to show the coverage of
+ *  the edge pixels.
+ */
+class AnalyticAAGM : public GM {
+public:
+    AnalyticAAGM() {}
+
+protected:
+    virtual SkString onShortName() SK_OVERRIDE {
+        return SkString("analyticaa");
+    }
+
+    virtual SkISize onISize() SK_OVERRIDE {
+        return make_isize(2 * kCell + 2 * kCell * kZoom + 5 * kGap,
+                          kShapeCount * (kCell * kZoom + kGap) + kGap);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        for (int shape = 0; shape < kShapeCount; ++shape) {
+            SkPath path;
+            SkPaint paint;
+            paint.setAntiAlias(true);
+            make_shape(shape, &path, &paint);
+
+            const SkScalar y = SkIntToScalar(kGap + shape * (kCell * kZoom + kGap));
+            for (int analytic = 0; analytic < 2; ++analytic) {
+                // Rasterize into a bitmap of our own, so that the rasterizer
+                // in use is ours whatever the canvas draws to.
+                SkBitmap bitmap;
+                bitmap.setConfig(SkBitmap::kARGB_8888_Config, kCell, kCell);
+                bitmap.allocPixels();
+                bitmap.eraseColor(SK_ColorWHITE);
+                SkCanvas bitmapCanvas(bitmap);
+                bool prev = SkGraphics::SetAnalyticAntiAlias(SkToBool(analytic));
+                bitmapCanvas.drawPath(path, paint);
+                SkGraphics::SetAnalyticAntiAlias(prev);
+
+                const SkScalar x = SkIntToScalar(kGap + analytic * (kCell + kGap));
+                canvas->drawBitmap(bitmap, x, y);
+
+                canvas->save();
+                canvas->translate(SkIntToScalar(2 * (kCell + kGap) + kGap +
+                                                analytic * (kCell * kZoom + kGap)), y);
+                canvas->scale(SkIntToScalar(kZoom), SkIntToScalar(kZoom));
+                canvas->drawBitmap(bitmap, 0, 0);
+                canvas->restore();
+            }
+        }
+    }
+
+private:
+    typedef GM INHERITED;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+
+static GM* MyFactory(void*) { return new AnalyticAAGM; }
+static GMRegistry reg(MyFactory);
+
+}
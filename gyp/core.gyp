@@ -34,6 +34,34 @@
               '-lpthread',
             ],
           },
+          'sources!': [
+            '../src/core/SkThreadUtils_pthread_other.cpp',
+          ],
+        },{ #else if 'skia_os not in ["linux", "freebsd", "openbsd", "solaris"]'
+          'sources!': [
+            '../src/core/SkThreadUtils_pthread_linux.cpp',
+          ],
+        }],
+        [ 'skia_os in ["mac", "ios"]', {
+          'sources!': [
+            '../src/core/SkThreadUtils_pthread_other.cpp',
+          ],
+        },{ #else if 'skia_os not in ["mac", "ios"]'
+          'sources!': [
+            '../src/core/SkThreadUtils_pthread_mach.cpp',
+          ],
+        }],
+        [ 'skia_os == "win"', {
+          'sources!': [
+            '../src/core/SkThreadUtils_pthread.cpp',
+            '../src/core/SkThreadUtils_pthread.h',
+            '../src/core/SkThreadUtils_pthread_other.cpp',
+          ],
+        },{ #else if 'skia_os != "win"'
+          'sources!': [
+            '../src/core/SkThreadUtils_win.cpp',
+            '../src/core/SkThreadUtils_win.h',
+          ],
         }],
         [ 'skia_os == "mac"', {
           'include_dirs': [
@@ -11,6 +11,7 @@
       'include_dirs': [
         '../include/effects',
         '../src/core',
+        '../include/utils',
       ],
       'direct_dependent_settings': {
         'include_dirs': [
@@ -9,7 +9,7 @@
       ],
       'include_dirs': [
         # For SkThreadUtils.h
-        '../src/utils',
+        '../src/core',
       ],
       'sources': [
         '../../nacl/src/nacl_interface.cpp',
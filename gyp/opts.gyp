@@ -48,7 +48,11 @@
             '../src/opts/SkBitmapProcState_opts_SSE2.cpp',
             '../src/opts/SkBlitRow_opts_SSE2.cpp',
             '../src/opts/SkBlitRect_opts_SSE2.cpp',
+            '../src/opts/SkBlurMask_opts_SSE2.cpp',
+            '../src/opts/SkCoverage_opts_SSE2.cpp',
+            '../src/opts/SkGradient_opts_SSE2.cpp',
             '../src/opts/SkUtils_opts_SSE2.cpp',
+            '../src/opts/SkXfermode_opts_SSE2.cpp',
           ],
         }],
         [ 'skia_arch_type == "arm" and armv7 == 1', {
@@ -93,7 +97,11 @@
           'sources': [
             '../src/opts/SkBitmapProcState_opts_none.cpp',
             '../src/opts/SkBlitRow_opts_none.cpp',
+            '../src/opts/SkBlurMask_opts_none.cpp',
+            '../src/opts/SkCoverage_opts_none.cpp',
+            '../src/opts/SkGradient_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
+            '../src/opts/SkXfermode_opts_none.cpp',
           ],
         }],
       ],
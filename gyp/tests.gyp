@@ -18,9 +18,11 @@
       ],
       'sources': [
         '../tests/AAClipTest.cpp',
+        '../tests/AnalyticAATest.cpp',
         '../tests/AnnotationTest.cpp',
         '../tests/AtomicTest.cpp',
         '../tests/BitmapCopyTest.cpp',
+        '../tests/BitmapFilterLevelTest.cpp',
         '../tests/BitmapFactoryTest.cpp',
         '../tests/BitmapGetColorTest.cpp',
         '../tests/BitmapHeapTest.cpp',
@@ -39,6 +41,7 @@
         '../tests/ColorTest.cpp',
         '../tests/DataRefTest.cpp',
         '../tests/DeferredCanvasTest.cpp',
+        '../tests/DenseCoverageTest.cpp',
         '../tests/DequeTest.cpp',
         '../tests/DrawBitmapRectTest.cpp',
         '../tests/DrawPathTest.cpp',
@@ -53,6 +56,7 @@
         '../tests/FontMgrTest.cpp',
         '../tests/FontNamesTest.cpp',
         '../tests/GeometryTest.cpp',
+        '../tests/GlyphCacheTest.cpp',
         '../tests/GLInterfaceValidation.cpp',
         '../tests/GLProgramsTest.cpp',
         '../tests/GpuBitmapCopyTest.cpp',
@@ -61,6 +65,9 @@
         '../tests/GrMemoryPoolTest.cpp',
         '../tests/GrSurfaceTest.cpp',
         '../tests/HashCacheTest.cpp',
+        '../tests/ImageFilterCacheTest.cpp',
+        '../tests/ImageFilterThreadsTest.cpp',
+        '../tests/IncrementalPictureTest.cpp',
         '../tests/InfRectTest.cpp',
         '../tests/LListTest.cpp',
         '../tests/MD5Test.cpp',
@@ -76,7 +83,9 @@
         '../tests/PathMeasureTest.cpp',
         '../tests/PathTest.cpp',
         '../tests/PDFPrimitivesTest.cpp',
+        '../tests/PictureOptimizationTest.cpp',
         '../tests/PictureTest.cpp',
+        '../tests/PictureTileCacheTest.cpp',
         '../tests/PictureUtilsTest.cpp',
         '../tests/PipeTest.cpp',
         '../tests/PointTest.cpp',
@@ -93,6 +102,7 @@
         '../tests/RTreeTest.cpp',
         '../tests/SHA1Test.cpp',
         '../tests/ScalarTest.cpp',
+        '../tests/SegmentedPictureTest.cpp',
         '../tests/ShaderImageFilterTest.cpp',
         '../tests/ShaderOpacityTest.cpp',
         '../tests/Sk64Test.cpp',
@@ -103,6 +113,7 @@
         '../tests/StringTest.cpp',
         '../tests/StrokeTest.cpp',
         '../tests/SurfaceTest.cpp',
+        '../tests/TaskSchedulerTest.cpp',
         '../tests/Test.cpp',
         '../tests/Test.h',
         '../tests/TestSize.cpp',
@@ -22,12 +22,9 @@
         '../src/utils',
       ],
       'sources': [
-        # Classes for a threadpool.
-        '../include/utils/SkCondVar.h',
+        # Classes for a threadpool. SkTaskScheduler, which replaces them, is in core.
         '../include/utils/SkCountdown.h',
-        '../include/utils/SkRunnable.h',
         '../include/utils/SkThreadPool.h',
-        '../src/utils/SkCondVar.cpp',
         '../src/utils/SkCountdown.cpp',
         '../src/utils/SkThreadPool.cpp',
 
@@ -38,6 +35,7 @@
         '../include/utils/SkDebugUtils.h',
         '../include/utils/SkDeferredCanvas.h',
         '../include/utils/SkDumpCanvas.h',
+        '../include/utils/SkIncrementalPicture.h',
         '../include/utils/SkInterpolator.h',
         '../include/utils/SkLayer.h',
         '../include/utils/SkMatrix44.h',
@@ -48,10 +46,12 @@
         '../include/utils/SkParse.h',
         '../include/utils/SkParsePaint.h',
         '../include/utils/SkParsePath.h',
+        '../include/utils/SkPictureTileCache.h',
         '../include/utils/SkPictureUtils.h',
         '../include/utils/SkRandom.h',
         '../include/utils/SkRTConf.h',
         '../include/utils/SkProxyCanvas.h',
+        '../include/utils/SkSegmentedPicture.h',
         '../include/utils/SkUnitMappers.h',
         '../include/utils/SkWGL.h',
 
@@ -71,6 +71,7 @@
         '../src/utils/SkCullPoints.cpp',
         '../src/utils/SkDeferredCanvas.cpp',
         '../src/utils/SkDumpCanvas.cpp',
+        '../src/utils/SkIncrementalPicture.cpp',
         '../src/utils/SkFloatUtils.h',
         '../src/utils/SkInterpolator.cpp',
         '../src/utils/SkLayer.cpp',
@@ -85,19 +86,13 @@
         '../src/utils/SkParse.cpp',
         '../src/utils/SkParseColor.cpp',
         '../src/utils/SkParsePath.cpp',
+        '../src/utils/SkPictureTileCache.cpp',
         '../src/utils/SkPictureUtils.cpp',
         '../src/utils/SkProxyCanvas.cpp',
+        '../src/utils/SkSegmentedPicture.cpp',
         '../src/utils/SkSHA1.cpp',
         '../src/utils/SkSHA1.h',
         '../src/utils/SkRTConf.cpp',
-        '../src/utils/SkThreadUtils.h',
-        '../src/utils/SkThreadUtils_pthread.cpp',
-        '../src/utils/SkThreadUtils_pthread.h',
-        '../src/utils/SkThreadUtils_pthread_linux.cpp',
-        '../src/utils/SkThreadUtils_pthread_mach.cpp',
-        '../src/utils/SkThreadUtils_pthread_other.cpp',
-        '../src/utils/SkThreadUtils_win.cpp',
-        '../src/utils/SkThreadUtils_win.h',
         '../src/utils/SkUnitMappers.cpp',
 
         #mac
@@ -135,9 +130,6 @@
               '../include/utils/mac',
             ],
           },
-          'sources!': [
-            '../src/utils/SkThreadUtils_pthread_other.cpp',
-          ],
         },{ #else if 'skia_os != "mac"'
           'include_dirs!': [
             '../include/utils/mac',
@@ -145,20 +137,12 @@
           'sources!': [
             '../include/utils/mac/SkCGUtils.h',
             '../src/utils/mac/SkCreateCGImageRef.cpp',
-            '../src/utils/SkThreadUtils_pthread_mach.cpp',
           ],
         }],
-        [ 'skia_os in ["linux", "freebsd", "openbsd", "solaris"]', {
-          'sources!': [
-            '../src/utils/SkThreadUtils_pthread_other.cpp',
-          ],
-        },{ #else if 'skia_os not in ["linux", "freebsd", "openbsd", "solaris"]'
+        [ 'skia_os not in ["linux", "freebsd", "openbsd", "solaris"]', {
           'include_dirs!': [
             '../include/utils/unix',
           ],
-          'sources!': [
-            '../src/utils/SkThreadUtils_pthread_linux.cpp',
-          ],
         }],
         [ 'skia_os == "win"', {
           'direct_dependent_settings': {
@@ -166,11 +150,6 @@
               '../include/utils/win',
             ],
           },
-          'sources!': [
-            '../src/utils/SkThreadUtils_pthread.cpp',
-            '../src/utils/SkThreadUtils_pthread.h',
-            '../src/utils/SkThreadUtils_pthread_other.cpp',
-          ],
         },{ #else if 'skia_os != "win"'
           'include_dirs!': [
             '../include/utils/win',
@@ -191,11 +170,7 @@
           ],
         }],
         [ 'skia_os == "nacl"', {
-          'sources': [
-            '../src/utils/SkThreadUtils_pthread_other.cpp',
-          ],
           'sources!': [
-            '../src/utils/SkThreadUtils_pthread_linux.cpp',
             '../src/utils/SkCityHash.cpp',
             '../src/utils/SkCityHash.h',
           ],
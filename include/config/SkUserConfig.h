@@ -122,6 +122,13 @@
  */
 //#define SK_DEFAULT_FONT_CACHE_LIMIT   (1024 * 1024)
 
+/*
+ *  To specify a different default limit for the cache of blurred masks,
+ *  define this. If this is undefined, skia will use a built-in value. Use 0 to
+ *  turn the cache off.
+ */
+//#define SK_DEFAULT_BLUR_MASK_CACHE_LIMIT   (1024 * 1024)
+
 /* If defined, use CoreText instead of ATSUI on OS X.
 */
 //#define SK_USE_MAC_CORE_TEXT
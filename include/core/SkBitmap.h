@@ -533,6 +533,14 @@ public:
     bool canCopyTo(Config newConfig) const;
 
     bool hasMipMap() const;
+    /** Build the mipmap levels for this bitmap. They are shared with other
+        bitmaps of the same pixels (and the same subset of them) through the
+        pixelref, so that only the first of them to ask pays for the build,
+        unless the generation ID has changed since or forceRebuild is true.
+        Drawing into the pixels through a canvas changes the generation ID;
+        code which writes to them directly must call notifyPixelsChanged()
+        before they are drawn filtered again, or the old levels are used.
+    */
     void buildMipMap(bool forceRebuild = false);
     void freeMipMap();
 
@@ -645,6 +653,10 @@ private:
     struct MipMap;
     mutable MipMap* fMipMap;
 
+    // SkPixelRef holds the last MipMap built for its pixels (see buildMipMap())
+    friend class SkPixelRef;
+    static void UnrefMipMap(MipMap*);
+
     mutable SkPixelRef* fPixelRef;
     mutable size_t      fPixelRefOffset;
     mutable int         fPixelLockCount;
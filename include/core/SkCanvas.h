@@ -381,6 +381,18 @@ public:
         fAllowSoftClip = allow;
     }
 
+    /** Set to false to always play back the pictures nested inside a picture
+        that is drawn into this canvas, even when the cache of rasterized
+        nested pictures is on (see SkGraphics::SetPictureCacheLimit()).
+        Callers which need exact results should do this, since a picture drawn
+        from the cache is clipped to its width and height and composited onto
+        the canvas rather than drawn onto it. The default is true.
+     */
+    void setAllowPictureCache(bool allow) {
+        fAllowPictureCache = allow;
+    }
+    bool getAllowPictureCache() const { return fAllowPictureCache; }
+
     /** Modify the current clip with the specified region. Note that unlike
         clipRect() and clipPath() which transform their arguments by the current
         matrix, clipRegion() assumes its argument is already in device
@@ -1064,6 +1076,7 @@ private:
     mutable SkRectCompareType fLocalBoundsCompareType;
     mutable bool              fLocalBoundsCompareTypeDirty;
     bool fAllowSoftClip;
+    bool fAllowPictureCache;
 
     const SkRectCompareType& getLocalClipBoundsCompareType() const {
         if (fLocalBoundsCompareTypeDirty) {
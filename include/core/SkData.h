@@ -94,6 +94,13 @@ public:
      */
     static SkData* NewFromMMap(const void* data, size_t length);
 
+    /**
+     *  Create a new dataref with the contents of the file at path, mapping it
+     *  with mmap where that is supported and reading it into memory otherwise.
+     *  Returns NULL if the file cannot be opened.
+     */
+    static SkData* NewFromFileName(const char path[]);
+
     /**
      *  Create a new dataref using a subset of the data in the specified
      *  src dataref.
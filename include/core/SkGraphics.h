@@ -60,10 +60,188 @@ public:
      */
     static void PurgeFontCache();
 
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  blurred masks. Drawing a shape again with the same blur (e.g. the same
+     *  shadow, anywhere on the canvas) reuses the cached mask instead of
+     *  blurring again. This max can be changed by calling
+     *  SetBlurMaskCacheLimit().
+     */
+    static size_t GetBlurMaskCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the cache of
+     *  blurred masks. If the cache needs to allocate more, it will purge the
+     *  least recently used masks. A limit of 0 turns the cache off.
+     *
+     *  This function returns the previous setting, as if
+     *  GetBlurMaskCacheLimit() had be called before the new limit was set.
+     */
+    static size_t SetBlurMaskCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the cache of blurred masks.
+     */
+    static size_t GetBlurMaskCacheUsed();
+
+    /**
+     *  Free every mask in the cache of blurred masks. This does not change the
+     *  limit.
+     */
+    static void PurgeBlurMaskCache();
+
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  image filter results. When a filter is applied again to the same
+     *  source with the same matrix, including a filter which is an input of
+     *  several others, the cached result is reused. This max can be changed
+     *  by calling SetImageFilterCacheLimit().
+     */
+    static size_t GetImageFilterCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the cache of
+     *  image filter results. If the cache needs more, it will purge the least
+     *  recently used results. The default limit is 0, which turns the cache
+     *  off, since results are looked up by the source bitmap's generation ID:
+     *  an application which turns it on must call notifyPixelsChanged() on
+     *  any bitmap whose pixels it changes before filtering it again.
+     *
+     *  This function returns the previous setting, as if
+     *  GetImageFilterCacheLimit() had be called before the new limit was set.
+     */
+    static size_t SetImageFilterCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the cache of image filter
+     *  results.
+     */
+    static size_t GetImageFilterCacheUsed();
+
+    /**
+     *  Free every result in the cache of image filter results. This does not
+     *  change the limit.
+     */
+    static void PurgeImageFilterCache();
+
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  rasterized nested pictures. When a picture nested inside another one
+     *  is drawn again into a raster canvas with the same scale and rotation,
+     *  the cached raster is blitted instead of playing the picture back. This
+     *  max can be changed by calling SetPictureCacheLimit().
+     */
+    static size_t GetPictureCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the cache of
+     *  rasterized nested pictures. If the cache needs more, it will purge the
+     *  least recently used rasters. The default limit is 0, which turns the
+     *  cache off, since a cached picture is clipped to its width and height
+     *  and may round differently than playing it back would: see
+     *  SkCanvas::setAllowPictureCache() to opt a canvas out.
+     *
+     *  This function returns the previous setting, as if
+     *  GetPictureCacheLimit() had be called before the new limit was set.
+     */
+    static size_t SetPictureCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the cache of rasterized
+     *  nested pictures.
+     */
+    static size_t GetPictureCacheUsed();
+
+    /**
+     *  Free every raster in the cache of rasterized nested pictures. This does
+     *  not change the limit.
+     */
+    static void PurgePictureCache();
+
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  gradient lookup tables. Gradient shaders with the same colors and
+     *  positions, drawn with the same paint alpha, share one table rather
+     *  than each building its own. This max can be changed by calling
+     *  SetGradientCacheLimit().
+     */
+    static size_t GetGradientCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the cache of
+     *  gradient lookup tables. If the cache needs more, it will purge the
+     *  least recently used tables; shaders which are using one keep it until
+     *  they are done. A limit of 0 turns the cache off.
+     *
+     *  This function returns the previous setting, as if
+     *  GetGradientCacheLimit() had be called before the new limit was set.
+     */
+    static size_t SetGradientCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the cache of gradient
+     *  lookup tables.
+     */
+    static size_t GetGradientCacheUsed();
+
+    /**
+     *  Free every table in the cache of gradient lookup tables. This does not
+     *  change the limit.
+     */
+    static void PurgeGradientCache();
+
+    /**
+     *  Return the number of threads that image filters which support it (blur,
+     *  dilate and erode) split their work across when they have not been
+     *  given their own thread count. The default is 1, meaning every filter
+     *  runs on the calling thread.
+     */
+    static int GetImageFilterThreadCount();
+
+    /**
+     *  Specify the number of threads that image filters split their work
+     *  across by default. The results are identical for every count; only
+     *  the time taken changes. Counts below 1 are treated as 1.
+     *
+     *  This function returns the previous setting.
+     */
+    static int SetImageFilterThreadCount(int count);
+
+    /**
+     *  Stop the worker threads that image filters split their work across.
+     *  They are started again the next time a filter needs them. Lowering
+     *  the count with SetImageFilterThreadCount() also does this.
+     */
+    static void PurgeImageFilterThreads();
+
+    /**
+     *  Return true if antialiased paths are filled by computing the exact area
+     *  each pixel has inside the path, rather than by supersampling. The
+     *  default is false.
+     */
+    static bool GetAnalyticAntiAlias();
+
+    /**
+     *  Choose how antialiased paths are filled. The analytic rasterizer gives
+     *  smoother edges, especially nearly horizontal and vertical ones, which
+     *  supersampling only resolves to 1/4 of a pixel. Where contours cross
+     *  within a pixel, its coverage is estimated from the area-weighted
+     *  winding, so self-intersecting paths may differ from supersampling
+     *  there. Inverse fills are always supersampled.
+     *
+     *  This function returns the previous setting.
+     */
+    static bool SetAnalyticAntiAlias(bool analytic);
+
     /**
      *  Applications with command line options may pass optional state, such
      *  as cache sizes, here, for instance:
      *  font-cache-limit=12345678
+     *  blur-mask-cache-limit=12345678
+     *  image-filter-cache-limit=12345678
+     *  picture-cache-limit=12345678
+     *  gradient-cache-limit=12345678
+     *  analytic-aa=1
      *
      *  The flags format is name=value[;name=value...] with no spaces.
      *  This format is subject to change.
@@ -75,12 +75,40 @@ public:
     bool filterImage(Proxy*, const SkBitmap& src, const SkMatrix& ctm,
                      SkBitmap* result, SkIPoint* offset);
 
+    /**
+     *  As above, but only the part of the result inside clipBounds (in the
+     *  same space as offset) is needed. When the filter can tell which part
+     *  of src that is computed from (see filterSourceBounds()), only that
+     *  part of src is filtered, so nothing outside it is evaluated anywhere
+     *  in the filter graph. The result may still extend past clipBounds.
+     *
+     *  Returns false if no part of the result can reach clipBounds.
+     */
+    bool filterImage(Proxy*, const SkBitmap& src, const SkMatrix& ctm,
+                     const SkIRect& clipBounds, SkBitmap* result, SkIPoint* offset);
+
+    /**
+     *  Returns an ID which is unique to this filter object, and never 0.
+     *  Filters are immutable once created, so together with the source image
+     *  and the matrix it identifies a result (see SkGraphics'
+     *  SetImageFilterCacheLimit).
+     */
+    uint32_t uniqueID() const { return fUniqueID; }
+
     /**
      *  Given the src bounds of an image, this returns the bounds of the result
      *  image after the filter has been applied.
      */
     bool filterBounds(const SkIRect& src, const SkMatrix& ctm, SkIRect* dst);
 
+    /**
+     *  The reverse of filterBounds(): given the bounds of part of the result
+     *  image, this returns the bounds of the part of the src image that it is
+     *  computed from. Returns false if the filter cannot tell, in which case
+     *  any of the src image may be needed.
+     */
+    bool filterSourceBounds(const SkIRect& dst, const SkMatrix& ctm, SkIRect* src);
+
     /**
      *  Returns true if the filter can be expressed a single-pass
      *  GrEffect, used to process this filter on the GPU, or false if
@@ -158,6 +186,13 @@ protected:
                                SkBitmap* result, SkIPoint* offset);
     // Default impl copies src into dst and returns true
     virtual bool onFilterBounds(const SkIRect&, const SkMatrix&, SkIRect*);
+    // Default impl returns false
+    virtual bool onFilterSourceBounds(const SkIRect&, const SkMatrix&, SkIRect*);
+
+    // For filters whose result at each pixel only depends on their inputs'
+    // results at that pixel: joins the source bounds of every input, where an
+    // unconnected input is the source itself.
+    bool getInputsSourceBounds(const SkIRect& dst, const SkMatrix& ctm, SkIRect* src);
 
     // Return the result of processing the given input, or the source bitmap
     // if we have no connected input at that index.
@@ -165,9 +200,12 @@ protected:
                             SkIPoint*);
 
 private:
+    static uint32_t NextUniqueID();
+
     typedef SkFlattenable INHERITED;
     int fInputCount;
     SkImageFilter** fInputs;
+    uint32_t fUniqueID;
 };
 
 #endif
@@ -13,6 +13,7 @@
 #include "SkFlattenable.h"
 #include "SkMask.h"
 #include "SkPaint.h"
+#include "SkTDArray.h"
 
 class SkBlitter;
 class SkBounder;
@@ -131,6 +132,16 @@ protected:
                                            const SkIRect& clipBounds,
                                            NinePatch*) const;
 
+    /**
+     *  Override if the result of filterMask() depends only on the src mask and
+     *  on settings of the filter which can be written out as a key, so that
+     *  filtered paths may be cached (see SkGraphics::SetBlurMaskCacheLimit).
+     *  Append the key for this matrix and return true. The key must start
+     *  with a tag unique to the subclass. The default returns false, and
+     *  nothing is cached.
+     */
+    virtual bool asCacheKey(const SkMatrix&, SkTDArray<uint32_t>* key) const;
+
 private:
     friend class SkDraw;
 
@@ -143,6 +154,13 @@ private:
                     const SkRasterClip&, SkBounder*, SkBlitter* blitter,
                     SkPaint::Style style) const;
 
+    /** If filterPath() may cache its result for this path, build the cache key and return the
+     device position that the cached mask's bounds are relative to.
+     */
+    bool makePathCacheKey(const SkPath& devPath, const SkMatrix& devMatrix,
+                          const SkIRect& clipBounds, SkPaint::Style style,
+                          SkTDArray<uint32_t>* key, SkIPoint* origin) const;
+
     typedef SkFlattenable INHERITED;
 };
 
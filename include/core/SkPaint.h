@@ -105,11 +105,13 @@ public:
         kAutoHinting_Flag     = 0x800,  //!< mask to force Freetype's autohinter
         kVerticalText_Flag    = 0x1000,
         kGenA8FromLCD_Flag    = 0x2000, // hack for GDI -- do not use if you can help it
+        kMediumQualityFilterBitmap_Flag = 0x4000,   //!< see setFilterLevel()
+        kHighQualityFilterBitmap_Flag   = 0x8000,   //!< see setFilterLevel()
 
         // when adding extra flags, note that the fFlags member is specified
         // with a bit-width and you'll have to expand it.
 
-        kAllFlags = 0x3FFF
+        kAllFlags = 0xFFFF
     };
 
     /** Return the paint's flags. Use the Flag enum to test flag values.
@@ -272,12 +274,51 @@ public:
     */
     void setDevKernText(bool devKernText);
 
+    /** Returns true if bitmaps are filtered at all, i.e. if the filter level
+        is anything but kNone_FilterLevel.
+    */
     bool isFilterBitmap() const {
         return SkToBool(this->getFlags() & kFilterBitmap_Flag);
     }
 
+    /** Helper for setFilterLevel(): sets kLow_FilterLevel if filterBitmap is
+        true, and kNone_FilterLevel if it is false.
+    */
     void setFilterBitmap(bool filterBitmap);
 
+    /** How carefully bitmaps are sampled when they are scaled or rotated.
+        Each level costs more than the one before; where a level does not
+        apply (e.g. a config the high quality filter does not handle), the
+        next one down is used.
+    */
+    enum FilterLevel {
+        /** Take the nearest pixel. */
+        kNone_FilterLevel,
+        /** Bilinear filtering. */
+        kLow_FilterLevel,
+        /** Bilinear filtering, and when the bitmap is scaled down, sample
+            a mipmap level near the destination's size instead, so that
+            heavy downscales do not alias. The levels are built the first
+            time they are needed, and cached with the bitmap's pixels.
+        */
+        kMedium_FilterLevel,
+        /** As kMedium_FilterLevel, but sampling with a bicubic (Mitchell)
+            filter rather than a bilinear one.
+        */
+        kHigh_FilterLevel
+    };
+
+    /** Return the paint's filter level. It is stored in the paint's flags, as
+        kFilterBitmap_Flag alone for kLow_FilterLevel, and along with
+        kMediumQualityFilterBitmap_Flag or kHighQualityFilterBitmap_Flag for
+        the other levels.
+    */
+    FilterLevel getFilterLevel() const;
+
+    /** Set the paint's filter level (see FilterLevel).
+    */
+    void setFilterLevel(FilterLevel);
+
     /** Styles apply to rect, oval, path, and text.
         Bitmaps are always drawn in "fill", and lines are always drawn in
         "stroke".
@@ -15,6 +15,8 @@
 
 class SkBBoxHierarchy;
 class SkCanvas;
+class SkData;
+class SkMemoryStream;
 class SkPicturePlayback;
 class SkPictureRecord;
 class SkStream;
@@ -69,6 +71,20 @@ public:
      */
     SkPicture(SkStream*, bool* success, InstallPixelRefProc proc);
 
+    /**
+     *  Recreate a picture that was serialized into data, such as a file mapped
+     *  with SkData::NewFromFileName(). If it was written by
+     *  serializeForInPlacePlayback(), rather than copying its op stream, the
+     *  picture plays back straight from data, on which it holds a ref, and
+     *  each paint and path is only decoded the first time it is drawn. Data
+     *  written by serialize() is loaded as from a stream.
+     *  @param data Serialized picture data.
+     *  @param proc Function pointer for installing pixelrefs on SkBitmaps representing the
+     *              encoded bitmap data.
+     *  @return The new picture, or NULL if data does not hold a valid picture.
+     */
+    static SkPicture* CreateFromData(SkData* data, InstallPixelRefProc proc = NULL);
+
     virtual ~SkPicture();
 
     /**
@@ -115,7 +131,22 @@ public:
             Note: Currently this is not serializable, the bounding data will be
             discarded if you serialize into a stream and then deserialize.
         */
-        kOptimizeForClippedPlayback_RecordingFlag = 0x02
+        kOptimizeForClippedPlayback_RecordingFlag = 0x02,
+        /*  Only meaningful with kOptimizeForClippedPlayback_RecordingFlag, and
+            currently only used by SkTileGridPicture. This flag causes the
+            picture to note, for each tile, the last draw which paints all of
+            it with opaque colors (a rect, bitmap, drawPaint or clear, drawn
+            outside of any layer and with a matrix and clip that keep it
+            rectangular), so that playback can skip every draw before it in
+            that tile. Pages with stacked opaque backgrounds benefit the most.
+        */
+        kCullOccludedDraws_RecordingFlag = 0x04,
+        /*  This flag turns off the rewriting of the recorded commands that
+            removes save/restore pairs, layers, matrix changes and clips which
+            do not change what is drawn. It is meant for checking and
+            measuring those rewrites, and should not otherwise be needed.
+        */
+        kDisableRecordOptimizations_RecordingFlag = 0x08
     };
 
     /** Returns the canvas that records the drawing commands.
@@ -159,6 +190,13 @@ public:
     */
     int height() const { return fHeight; }
 
+    /**
+     *  Return an ID for the recorded content of this picture, which copies
+     *  and clones of it share, and which changes when it is recorded again.
+     *  Returns 0 if the picture has not finished recording.
+     */
+    uint32_t uniqueID() const;
+
     /**
      *  Function to encode an SkBitmap to an SkWStream. A function with this
      *  signature can be passed to serialize() and SkOrderedWriteBuffer. The
@@ -174,6 +212,13 @@ public:
      */
     void serialize(SkWStream*, EncodeBitmap encoder = NULL) const;
 
+    /**
+     *  As serialize(), but in a format that CreateFromData() can play back in
+     *  place. Readers from before that format cannot load it, so only use this
+     *  for pictures that will be loaded with CreateFromData().
+     */
+    void serializeForInPlacePlayback(SkWStream*, EncodeBitmap encoder = NULL) const;
+
 #ifdef SK_BUILD_FOR_ANDROID
     /** Signals that the caller is prematurely done replaying the drawing
         commands. This can be called from a canvas virtual while the picture
@@ -195,6 +240,10 @@ protected:
     //      SK_SUPPORT_HINTING_SCALE_FACTOR
     // V10: add drawRRect, drawOval, clipRRect
     static const uint32_t PICTURE_VERSION = 10;
+    // V11: as V10, but everything after SkPictInfo stays 4-byte aligned, and
+    //      each paint and path is written with its size, so a picture can be
+    //      played back in place. Only written by serializeForInPlacePlayback().
+    static const uint32_t IN_PLACE_PICTURE_VERSION = 11;
 
     // fPlayback, fRecord, fWidth & fHeight are protected to allow derived classes to
     // install their own SkPicturePlayback-derived players,SkPictureRecord-derived
@@ -208,10 +257,13 @@ protected:
     virtual SkBBoxHierarchy* createBBoxHierarchy() const;
 
 private:
-    void initFromStream(SkStream*, bool* success, InstallPixelRefProc);
+    void initFromStream(SkStream*, bool* success, InstallPixelRefProc,
+                        SkMemoryStream* backing = NULL);
+    void serialize(SkWStream*, EncodeBitmap, bool inPlace) const;
 
     friend class SkFlatPicture;
     friend class SkPicturePlayback;
+    friend class SkPictureRecordGroup;
 
     typedef SkRefCnt INHERITED;
 };
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureRecordGroup_DEFINED
+#define SkPictureRecordGroup_DEFINED
+
+#include "SkPicture.h"
+#include "SkPoint.h"
+
+class SkCanvas;
+class SkPictureDictionaries;
+
+/**
+ * Records the parts of a picture on several threads at once, then splices them
+ * into one picture.
+ *
+ * Each part is recorded into a canvas of its own, which only one thread may use
+ * at a time, but different parts can be recorded on different threads. The
+ * parts share their bitmap, matrix, paint, path and region dictionaries, so
+ * splicing them copies their commands as they are rather than flattening them
+ * again. In exchange, adding a new paint (or bitmap, matrix, ...) to the
+ * dictionaries takes a lock which all of the parts contend for.
+ */
+class SK_API SkPictureRecordGroup : SkNoncopyable {
+public:
+    /**
+     * Prepare to record partCount parts, with the SkPicture::RecordingFlags in
+     * recordFlags. kOptimizeForClippedPlayback_RecordingFlag and
+     * kCullOccludedDraws_RecordingFlag are not supported, and ignored.
+     */
+    explicit SkPictureRecordGroup(int partCount, uint32_t recordFlags = 0);
+    ~SkPictureRecordGroup();
+
+    int countParts() const { return fPartCount; }
+
+    /**
+     * Returns the canvas that records the given part, which must not have been
+     * begun before. May be called from any thread.
+     * @param width the width of the part's recording canvas
+     * @param height the height of the part's recording canvas
+     */
+    SkCanvas* beginRecording(int part, int width, int height);
+
+    /**
+     * Signal that the part is done recording. This invalidates its canvas. May
+     * be called from any thread, but only once the part's canvas is no longer
+     * used.
+     */
+    void endRecording(int part);
+
+    /**
+     * Returns a new picture of the given size, which draws each part that was
+     * recorded translated by offsets[part], in order of their indices. Ends the
+     * recording of any part which has not been ended. Must not be called while
+     * any part is still being drawn into, and only once for a group.
+     */
+    SkPicture* createSplicedPicture(int width, int height, const SkPoint offsets[]);
+
+private:
+    class Part;
+
+    int                     fPartCount;
+    uint32_t                fRecordFlags;
+    SkPictureDictionaries*  fDictionaries;
+    Part*                   fParts;
+};
+
+#endif
@@ -50,6 +50,7 @@ public:
     SK_DECLARE_INST_COUNT(SkPixelRef)
 
     explicit SkPixelRef(SkBaseMutex* mutex = NULL);
+    virtual ~SkPixelRef();
 
     /** Return the pixel memory returned from lockPixels, or null if the
         lockCount is 0.
@@ -231,6 +232,11 @@ private:
 
     SkString    fURI;
 
+    // The mipmap last built for these pixels, which SkBitmap::buildMipMap()
+    // shares between the bitmaps that use them until the generation ID
+    // changes.
+    SkBitmap::MipMap* fMipMap;
+
     // can go from false to true, but never from true to false
     bool    fIsImmutable;
     // only ever set in constructor, const after that
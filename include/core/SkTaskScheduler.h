@@ -0,0 +1,159 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTaskScheduler_DEFINED
+#define SkTaskScheduler_DEFINED
+
+#include "SkCondVar.h"
+#include "SkRunnable.h"
+#include "SkTypes.h"
+
+class SkTaskGroup;
+class SkThread;
+
+/**
+ * A work-stealing scheduler for SkRunnables.
+ *
+ * Unlike SkThreadPool, which funnels every runnable through a single locked list, each worker
+ * thread owns its own queue. Workers run their own work newest-first and, when they run dry,
+ * steal the oldest work from the other queues. Queue storage is reused, so submitting work does
+ * not allocate once the queues have grown to their working size.
+ *
+ * Runnables are never owned by the scheduler. Completion is tracked with SkTaskGroup.
+ */
+class SkTaskScheduler : SkNoncopyable {
+public:
+    /**
+     * Create a scheduler with exactly count (>=0) worker threads. With no threads every
+     * runnable is run immediately on the thread that adds it.
+     */
+    explicit SkTaskScheduler(int count);
+
+    /**
+     * Runs all work that is still queued, then stops and joins the worker threads.
+     */
+    ~SkTaskScheduler();
+
+    int countThreads() const { return fThreadCount; }
+
+    /**
+     * Queues up an SkRunnable to run when a thread is available, or immediately if there are
+     * no threads. NULL is a safe no-op. Does not take ownership.
+     */
+    void add(SkRunnable* runnable) { this->add(runnable, NULL); }
+
+    /**
+     * Queues up count runnables at once. The batch is split into contiguous slices, one per
+     * worker queue, so each queue's lock is taken once for the whole batch.
+     */
+    void addBatch(SkRunnable* const runnables[], int count) {
+        this->addBatch(runnables, count, NULL);
+    }
+
+private:
+    struct Task {
+        SkRunnable*  fRunnable;
+        SkTaskGroup* fGroup;
+    };
+
+    class TaskQueue;
+    struct Worker;
+
+    void add(SkRunnable*, SkTaskGroup*);
+    void addBatch(SkRunnable* const[], int count, SkTaskGroup*);
+
+    // Wakes up to count sleeping workers after fPending has been bumped.
+    void wake(int count);
+
+    // Claims a task, preferring the back of queue 'home' and stealing from the front of the
+    // others. Returns false if every queue was empty.
+    bool pop(int home, Task*);
+
+    // Runs one queued task on the calling thread, if there is one. Used by SkTaskGroup::wait()
+    // so that waiting threads help instead of blocking.
+    bool runOne();
+
+    static void Run(const Task&);
+    static void Loop(void*);  // Static because we pass in a Worker.
+
+    const int   fThreadCount;
+    TaskQueue*  fQueues;        // fThreadCount queues, one per worker.
+    Worker*     fWorkers;
+    int32_t     fNextQueue;     // Round-robin target for work added from outside the workers.
+    int32_t     fPending;       // Tasks queued but not yet claimed.
+    int32_t     fSleepers;      // Workers blocked (or about to block) on fWake.
+    SkCondVar   fWake;
+    bool        fDone;
+
+    friend class SkTaskGroup;
+};
+
+/**
+ * A set of runnables submitted to an SkTaskScheduler which can be waited on as a unit. This
+ * replaces pairing SkThreadPool with an SkCountdown that every runnable must remember to run.
+ */
+class SkTaskGroup : SkNoncopyable {
+public:
+    explicit SkTaskGroup(SkTaskScheduler* scheduler);
+
+    /**
+     * Waits for any outstanding work before going away.
+     */
+    ~SkTaskGroup() { this->wait(); }
+
+    /**
+     * Adds a runnable (or a batch of them) to the scheduler as part of this group.
+     * Does not take ownership.
+     */
+    void add(SkRunnable*);
+    void addBatch(SkRunnable* const runnables[], int count);
+
+    /**
+     * Blocks until every runnable added to this group has finished. While there is queued work
+     * the calling thread runs it, so it is safe to wait from inside a running task.
+     */
+    void wait();
+
+    /**
+     * Calls proc(context, i) for every i in [0, count), spreading the calls across the
+     * scheduler in contiguous chunks of at least 'grain' indices, and waits for all of them.
+     */
+    void parallelFor(int count, void (*proc)(void* context, int index), void* context,
+                     int grain = 1);
+
+private:
+    void finishOne();
+
+    SkTaskScheduler* fScheduler;
+    int32_t          fPending;
+    SkCondVar        fDone;
+
+    friend class SkTaskScheduler;
+};
+
+/**
+ * Typed convenience for SkTaskGroup::parallelFor(). Calls proc(context, i) for every i in
+ * [0, count) on the scheduler's threads, returning once all calls have completed.
+ */
+template <typename T>
+void SkParallelFor(SkTaskScheduler* scheduler, int count, void (*proc)(T*, int), T* context,
+                   int grain = 1) {
+    struct Thunk {
+        void (*fProc)(T*, int);
+        T*   fContext;
+
+        static void Call(void* thunk, int index) {
+            const Thunk* self = static_cast<const Thunk*>(thunk);
+            self->fProc(self->fContext, index);
+        }
+    };
+    Thunk thunk = { proc, context };
+    SkTaskGroup group(scheduler);
+    group.parallelFor(count, &Thunk::Call, &thunk, grain);
+}
+
+#endif
@@ -48,6 +48,15 @@ public:
 
     virtual SkBBoxHierarchy* createBBoxHierarchy() const SK_OVERRIDE;
 
+    /**
+     * The number of draws that playback of tile grid pictures recorded with
+     * kCullOccludedDraws_RecordingFlag has skipped, because a later draw hid
+     * them. When one playback covers several tiles, a draw is counted once for
+     * each of them that it is hidden in.
+     */
+    static int32_t GetOccludedDrawCount();
+    static void ResetOccludedDrawCount();
+
 private:
     int fXTileCount, fYTileCount;
     TileGridInfo fInfo;
@@ -15,6 +15,17 @@ class SK_API SkBlurImageFilter : public SkImageFilter {
 public:
     SkBlurImageFilter(SkScalar sigmaX, SkScalar sigmaY, SkImageFilter* input = NULL);
 
+    /** Return the number of threads the blur is split across. 0, the
+        default, means SkGraphics::GetImageFilterThreadCount().
+    */
+    int getThreadCount() const { return fThreadCount; }
+
+    /** Split the blur across this many threads, or 0 to use
+        SkGraphics::GetImageFilterThreadCount(). The result is the same for
+        every count. This setting is not serialized.
+    */
+    void setThreadCount(int count) { fThreadCount = SkMax32(count, 0); }
+
     SK_DECLARE_PUBLIC_FLATTENABLE_DESERIALIZATION_PROCS(SkBlurImageFilter)
 
 protected:
@@ -23,12 +34,14 @@ protected:
 
     virtual bool onFilterImage(Proxy*, const SkBitmap& src, const SkMatrix&,
                                SkBitmap* result, SkIPoint* offset) SK_OVERRIDE;
+    virtual bool onFilterSourceBounds(const SkIRect&, const SkMatrix&, SkIRect*) SK_OVERRIDE;
 
     bool canFilterImageGPU() const SK_OVERRIDE { return true; }
     virtual bool filterImageGPU(Proxy* proxy, const SkBitmap& src, SkBitmap* result) SK_OVERRIDE;
 
 private:
     SkSize   fSigma;
+    int      fThreadCount;
     typedef SkImageFilter INHERITED;
 };
 
@@ -16,9 +16,21 @@ class SK_API SkMorphologyImageFilter : public SkImageFilter {
 public:
     SkMorphologyImageFilter(int radiusX, int radiusY, SkImageFilter* input);
 
+    /** Return the number of threads the filter is split across. 0, the
+        default, means SkGraphics::GetImageFilterThreadCount().
+    */
+    int getThreadCount() const { return fThreadCount; }
+
+    /** Split the filter across this many threads, or 0 to use
+        SkGraphics::GetImageFilterThreadCount(). The result is the same for
+        every count. This setting is not serialized.
+    */
+    void setThreadCount(int count) { fThreadCount = SkMax32(count, 0); }
+
 protected:
     SkMorphologyImageFilter(SkFlattenableReadBuffer& buffer);
     virtual void flatten(SkFlattenableWriteBuffer&) const SK_OVERRIDE;
+    virtual bool onFilterSourceBounds(const SkIRect&, const SkMatrix&, SkIRect*) SK_OVERRIDE;
 #if SK_SUPPORT_GPU
     virtual bool canFilterImageGPU() const SK_OVERRIDE { return true; }
 #endif
@@ -27,6 +39,7 @@ protected:
 
 private:
     SkISize    fRadius;
+    int        fThreadCount;
     typedef SkImageFilter INHERITED;
 };
 
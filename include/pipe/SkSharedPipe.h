@@ -0,0 +1,112 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkSharedPipe_DEFINED
+#define SkSharedPipe_DEFINED
+
+#include "SkGPipe.h"
+
+class SkCanvas;
+struct SkSharedPipeHeader;
+
+/**
+ *  An SkGPipeController which hands the writer blocks of a ring buffer laid
+ *  out in memory shared with an SkSharedPipeReader, typically in another
+ *  process (e.g. a shm_open()ed file mapped by both). The reader plays the
+ *  commands back straight out of the ring, so nothing is copied between the
+ *  two.
+ *
+ *  There must be exactly one writer and one reader. The ring's indices are
+ *  updated with atomic adds rather than a lock; when the writer finds the ring
+ *  full, or the reader finds it empty, it waits on a futex on Linux, and
+ *  yields the CPU on other platforms.
+ *
+ *  For the stream to make sense in another process, the SkGPipeWriter must be
+ *  started with SkGPipeWriter::kCrossProcess_Flag.
+ */
+class SK_API SkSharedPipeController : public SkGPipeController {
+public:
+    /**
+     *  Lay out the ring in memory, which must be 4-byte aligned and shared
+     *  with the reader, and must outlive both the controller and the reader.
+     *  The ring's capacity is the largest power of 2 that fits in size, after
+     *  a small header. The writer asks for 16K at a time, so a capacity of a
+     *  few times that keeps it from waiting on the reader after each block;
+     *  a single command larger than the capacity (e.g. a big flattened
+     *  bitmap) stops the writer.
+     */
+    SkSharedPipeController(void* memory, size_t size);
+
+    /** Calls close(). */
+    virtual ~SkSharedPipeController();
+
+    virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
+    virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
+
+    /**
+     *  Tell the reader that no more data will be written. If the writer had
+     *  not finished its stream by then, the reader stops with
+     *  SkGPipeReader::kError_Status.
+     */
+    void close();
+
+    /** Returns how much memory to share for a ring of the given capacity. */
+    static size_t MemorySize(size_t capacity);
+
+private:
+    void publish(uint32_t bytes);
+    uint32_t waitForSpace(uint32_t bytes);
+
+    SkSharedPipeHeader* fHeader;
+    char*               fData;
+    uint32_t            fCapacity;
+    uint32_t            fWritten;   // mirrors fHeader's count of published bytes
+    int32_t             fReaderSleepsWoken;
+    bool                fClosed;
+};
+
+/**
+ *  Plays back the commands an SkSharedPipeController writes into shared
+ *  memory.
+ */
+class SK_API SkSharedPipeReader : SkNoncopyable {
+public:
+    /**
+     *  memory must already have been laid out by an SkSharedPipeController,
+     *  possibly in another process.
+     */
+    SkSharedPipeReader(void* memory, SkCanvas* target);
+
+    void setCanvas(SkCanvas* target) { fReader.setCanvas(target); }
+
+    /**
+     *  Play back commands as they are written, until the writer finishes or
+     *  an error occurs. Returns kDone_Status if the stream ended normally.
+     */
+    SkGPipeReader::Status playback();
+
+    /**
+     *  Play back the commands that have been written so far without waiting
+     *  for more. Returns kEOF_Status if more are expected.
+     */
+    SkGPipeReader::Status playbackAvailable();
+
+private:
+    SkGPipeReader::Status playback(bool wait);
+    void release(size_t bytes);
+    void finish(SkGPipeReader::Status);
+
+    SkSharedPipeHeader*     fHeader;
+    const char*             fData;
+    uint32_t                fCapacity;
+    uint32_t                fRead;      // mirrors fHeader's count of consumed bytes
+    int32_t                 fWriterSleepsWoken;
+    SkGPipeReader           fReader;
+    SkGPipeReader::Status   fStatus;    // kEOF_Status until the stream ends
+};
+
+#endif
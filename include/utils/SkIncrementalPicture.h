@@ -0,0 +1,93 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkIncrementalPicture_DEFINED
+#define SkIncrementalPicture_DEFINED
+
+#include "SkPicture.h"
+#include "SkRegion.h"
+#include "SkTDArray.h"
+
+class SkCanvas;
+
+/**
+ *  Keeps the content of a picture up to date as parts of it change, by
+ *  recording only the parts that changed.
+ *
+ *  The content is a list of pieces, each a picture drawn clipped to the part
+ *  of the area that it is still responsible for. An update records a piece
+ *  for the invalidated area and takes that area away from the pieces under
+ *  it, releasing the ones left with nothing to draw. Pieces are shared by
+ *  ref rather than copied, both here and in the pictures returned by
+ *  createPicture(), so an update costs what recording the change costs, and
+ *  the pieces that did not change keep their op data, dictionaries and
+ *  uniqueID() (which also keeps them in SkPictureCache).
+ *
+ *  Once there are more than kMaxPieces pieces, they are played back into a
+ *  single new piece, so that drawing does not slow down as updates pile up.
+ */
+class SK_API SkIncrementalPicture : SkNoncopyable {
+public:
+    enum {
+        kMaxPieces = 16,
+    };
+
+    /** Starts out empty. */
+    SkIncrementalPicture(int width, int height);
+
+    /** Starts out drawing picture, which is ref'ed, at its own size. */
+    explicit SkIncrementalPicture(SkPicture* picture);
+
+    ~SkIncrementalPicture();
+
+    int width() const { return fWidth; }
+    int height() const { return fHeight; }
+
+    /**
+     *  Returns a canvas which records the new content of the invalid area, in
+     *  the coordinates of the whole picture. The canvas is clipped to the
+     *  area, so drawing outside it can be skipped with quickReject(). The
+     *  update takes effect at endUpdate(). recordFlags are also used to
+     *  record the piece that the pieces are compacted into.
+     */
+    SkCanvas* beginUpdate(const SkIRect& invalid, uint32_t recordFlags = 0);
+    void endUpdate();
+
+    /**
+     *  Replace the content of the invalid area with update, which is drawn in
+     *  the coordinates of the whole picture and clipped to the area. update
+     *  is ref'ed, and must not change afterwards.
+     */
+    void update(const SkRegion& invalid, SkPicture* update);
+
+    int countPieces() const { return fPieces.count(); }
+
+    /**
+     *  Returns a new picture which draws the current content. Each piece is
+     *  drawn in it as a nested picture, so making it takes time proportional
+     *  to the number of pieces rather than to their content.
+     */
+    SkPicture* createPicture() const;
+
+private:
+    struct Piece {
+        SkPicture*  fPicture;
+        SkRegion*   fClip;
+    };
+
+    void drawPieces(SkCanvas*, bool nested) const;
+    void compact();
+
+    int                 fWidth;
+    int                 fHeight;
+    SkTDArray<Piece>    fPieces;    // in drawing order
+    SkPicture*          fUpdate;    // between beginUpdate() and endUpdate()
+    SkIRect             fUpdateArea;
+    uint32_t            fRecordFlags;   // passed to the last beginUpdate()
+};
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureTileCache_DEFINED
+#define SkPictureTileCache_DEFINED
+
+#include "SkBitmap.h"
+#include "SkRect.h"
+#include "SkTInternalLList.h"
+#include "SkTemplates.h"
+
+class SkCanvas;
+class SkPicture;
+class SkTaskScheduler;
+
+/**
+ *  Keeps a picture rasterized in tiles from one draw to the next, so that
+ *  redrawing it (e.g. while scrolling) only renders the tiles which were
+ *  invalidated or have not been rendered yet, and copies the rest.
+ *
+ *  Tiles are rendered at the picture's own scale, into N32 bitmaps cleared to
+ *  transparent, and stay cached until they are invalidated or evicted. Once
+ *  the tiles use more than the byte limit, the least recently drawn ones are
+ *  evicted, but never the ones a draw still needs: while drawing an area
+ *  larger than the limit allows, the limit is exceeded rather than leaving
+ *  part of the area undrawn.
+ *
+ *  If a scheduler is given, the tiles a draw needs are rendered on its
+ *  threads, each of which plays back a clone of the picture.
+ *
+ *  Not thread-safe: all of the calls must come from one thread at a time.
+ */
+class SK_API SkPictureTileCache : SkNoncopyable {
+public:
+    /**
+     *  @param tileWidth, tileHeight the size of each tile, in pixels
+     *  @param byteLimit how many bytes of tile pixels to keep at most
+     *  @param scheduler if not NULL, renders tiles on its threads; must
+     *         outlive the cache
+     */
+    SkPictureTileCache(int tileWidth, int tileHeight, size_t byteLimit,
+                       SkTaskScheduler* scheduler = NULL);
+    ~SkPictureTileCache();
+
+    /**
+     *  Replace the picture to draw, which is ref'ed and must not change
+     *  afterwards. Invalidates every tile; the pixels of tiles that will still
+     *  be needed are reused if the picture's size stays the same.
+     */
+    void setPicture(SkPicture* picture);
+    SkPicture* getPicture() const { return fPicture; }
+
+    /**
+     *  Mark the tiles touching area, in the picture's coordinates, to be
+     *  rendered again the next time they are drawn, e.g. because the pixels
+     *  of a bitmap drawn there changed.
+     */
+    void invalidate(const SkIRect& area);
+
+    /**
+     *  Like setPicture(), but only invalidates the tiles touching changed:
+     *  picture must be the same size as the current one and draw the same
+     *  content outside changed.
+     */
+    void replacePicture(SkPicture* picture, const SkIRect& changed);
+
+    /**
+     *  Draw the part of the picture inside area, in the picture's coordinates,
+     *  into canvas at its current matrix and clip. Tiles of the area that are
+     *  missing or invalid are rendered first. Returns the number of tiles that
+     *  were rendered.
+     */
+    int draw(SkCanvas* canvas, const SkIRect& area);
+
+    /** Draw the whole picture. */
+    int draw(SkCanvas* canvas);
+
+    size_t getByteLimit() const { return fByteLimit; }
+
+    /**
+     *  Set a new limit, evicting tiles until it is met. Returns the previous
+     *  limit.
+     */
+    size_t setByteLimit(size_t newLimit);
+
+    /** Returns how many bytes of tile pixels are currently kept. */
+    size_t getBytesUsed() const { return fBytesUsed; }
+
+    /** Free the pixels of every tile. */
+    void purge();
+
+    int tileWidth() const { return fTileWidth; }
+    int tileHeight() const { return fTileHeight; }
+
+private:
+    struct Tile {
+        Tile() : fValid(false), fInUse(false) {}
+
+        SkBitmap    fBitmap;    // empty until the tile is rendered
+        bool        fValid;     // fBitmap matches the picture
+        bool        fInUse;     // needed by the draw in progress
+
+        SK_DECLARE_INTERNAL_LLIST_INTERFACE(Tile);
+    };
+
+    struct RenderState;
+    static void RenderTiles(RenderState*, int group);
+
+    void resetTiles();
+    void setTileCount(int width, int height);
+    void evictTile(Tile*);
+    void purgeAsNeeded(size_t bytesNeeded);
+    bool allocTile(Tile*, const SkIRect& bounds);
+    void renderTiles(Tile* const tiles[], const SkIRect bounds[], int count);
+    SkIRect tileBounds(int x, int y) const;
+
+    int                     fTileWidth;
+    int                     fTileHeight;
+    size_t                  fByteLimit;
+    size_t                  fBytesUsed;
+    SkTaskScheduler*        fScheduler;
+
+    SkPicture*              fPicture;
+    SkAutoTArray<SkPicture> fClones;        // made on the first parallel render
+    int                     fCloneCount;
+
+    SkAutoTArray<Tile>      fTiles;         // row by row
+    int                     fTilesX;
+    int                     fTilesY;
+
+    SkTInternalLList<Tile>  fLRU;           // tiles with pixels; head is the most recent
+};
+
+#endif
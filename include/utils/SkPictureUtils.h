@@ -10,8 +10,10 @@
 
 #include "SkPicture.h"
 
+class SkCanvas;
 class SkData;
 struct SkRect;
+class SkTaskScheduler;
 
 class SK_API SkPictureUtils {
 public:
@@ -26,6 +28,37 @@ public:
      *  and remains unchanged.
      */
     static SkData* GatherPixelRefs(SkPicture* pict, const SkRect& area);
+
+    /**
+     *  Draw the picture into a raster canvas using all of the scheduler's
+     *  threads. The canvas' top device is split into horizontal bands which
+     *  are played back concurrently, each restricted to its band by the clip
+     *  (so a picture with a bounding box hierarchy only visits the ops that
+     *  touch the band), and each writing straight into the device's pixels.
+     *
+     *  The canvas' current matrix and clip are honored. Canvases that are not
+     *  backed by raster pixels, and schedulers without threads, fall back to
+     *  a serial canvas->drawPicture(). The canvas must not be drawn to from
+     *  other threads while this runs, and its draw filter (if any) is shared
+     *  by all bands, so it must be thread-safe. As with any tiled rendering,
+     *  anti-aliased curves that cross a band boundary may differ slightly
+     *  from a serial draw, since each band clips its edges separately.
+     *
+     *  bandCount of 0 picks one band per scheduler thread, plus one for the
+     *  calling thread (which helps while it waits).
+     */
+    static void DrawParallel(SkPicture* pict, SkCanvas* canvas,
+                             SkTaskScheduler* scheduler, int bandCount = 0);
+
+    /**
+     *  As above, but bands after the first draw the caller's clones of pict
+     *  (from pict->clone()) instead of cloning it for each call, so drawing
+     *  the same picture repeatedly only pays for cloning once. At most
+     *  cloneCount + 1 bands are used. Each clone must only be used by one
+     *  draw at a time.
+     */
+    static void DrawParallel(SkPicture* pict, SkPicture clones[], int cloneCount,
+                             SkCanvas* canvas, SkTaskScheduler* scheduler);
 };
 
 #endif
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkSegmentedPicture_DEFINED
+#define SkSegmentedPicture_DEFINED
+
+#include "SkNWayCanvas.h"
+#include "SkPicture.h"
+#include "SkRRect.h"
+#include "SkTArray.h"
+#include "SkTDArray.h"
+
+class SkStream;
+class SkWStream;
+
+/**
+ *  A segmented picture is a stream of self-contained segments, each one a
+ *  complete serialized SkPicture holding only the paints, paths and bitmaps
+ *  that its own ops use. Neither writing nor reading one needs more than a
+ *  single segment in memory, so documents far larger than memory can be
+ *  recorded and drawn.
+ *
+ *  The stream starts with a header (a tag, the format version, the width and
+ *  the height), followed by each segment's size and bytes (padded to a
+ *  multiple of 4), and ends with a segment size of 0.
+ */
+
+/**
+ *  A canvas which records what is drawn to it into a segmented picture,
+ *  writing each segment to the stream as soon as it is complete.
+ *
+ *  A new segment is started before the next call once the current one has
+ *  grown past the segment size. The new segment starts by recreating the save
+ *  stack, matrix and clip in effect at that point, so a cut can be made at any
+ *  save depth. The one exception is inside a saveLayer(), whose contents have
+ *  to be composited together, so no cut is made until it is restored.
+ */
+class SkSegmentedPictureWriter : public SkNWayCanvas {
+public:
+    enum {
+        kDefaultSegmentSize = 1 << 20,
+    };
+
+    /**
+     *  @param stream Where the segments are written. It must outlive the
+     *                writer, or the call to finish().
+     *  @param segmentSize Roughly how much op, path, text and bitmap data
+     *                     each segment may hold.
+     *  @param encoder Passed to SkPicture::serialize() for each segment.
+     */
+    SkSegmentedPictureWriter(SkWStream* stream, int width, int height,
+                             size_t segmentSize = kDefaultSegmentSize,
+                             SkPicture::EncodeBitmap encoder = NULL);
+
+    /** Calls finish(), if it has not been called. */
+    virtual ~SkSegmentedPictureWriter();
+
+    /**
+     *  Write out the last segment and the end of the stream. Nothing may be
+     *  drawn after this. Returns false if writing to the stream failed at any
+     *  point.
+     */
+    bool finish();
+
+    /** The number of segments written so far. */
+    int segmentCount() const { return fSegmentCount; }
+
+    virtual int save(SaveFlags) SK_OVERRIDE;
+    virtual int saveLayer(const SkRect* bounds, const SkPaint*,
+                          SaveFlags) SK_OVERRIDE;
+    virtual void restore() SK_OVERRIDE;
+    virtual bool translate(SkScalar dx, SkScalar dy) SK_OVERRIDE;
+    virtual bool scale(SkScalar sx, SkScalar sy) SK_OVERRIDE;
+    virtual bool rotate(SkScalar degrees) SK_OVERRIDE;
+    virtual bool skew(SkScalar sx, SkScalar sy) SK_OVERRIDE;
+    virtual bool concat(const SkMatrix& matrix) SK_OVERRIDE;
+    virtual void setMatrix(const SkMatrix& matrix) SK_OVERRIDE;
+    virtual bool clipRect(const SkRect&, SkRegion::Op, bool) SK_OVERRIDE;
+    virtual bool clipRRect(const SkRRect&, SkRegion::Op, bool) SK_OVERRIDE;
+    virtual bool clipPath(const SkPath& path, SkRegion::Op, bool) SK_OVERRIDE;
+    virtual bool clipRegion(const SkRegion& deviceRgn,
+                            SkRegion::Op) SK_OVERRIDE;
+
+    virtual void clear(SkColor) SK_OVERRIDE;
+    virtual void drawPaint(const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawPoints(PointMode mode, size_t count, const SkPoint pts[],
+                            const SkPaint&) SK_OVERRIDE;
+    virtual void drawOval(const SkRect&, const SkPaint&) SK_OVERRIDE;
+    virtual void drawRect(const SkRect&, const SkPaint&) SK_OVERRIDE;
+    virtual void drawRRect(const SkRRect&, const SkPaint&) SK_OVERRIDE;
+    virtual void drawPath(const SkPath& path, const SkPaint&) SK_OVERRIDE;
+    virtual void drawBitmap(const SkBitmap& bitmap, SkScalar left, SkScalar top,
+                            const SkPaint*) SK_OVERRIDE;
+    virtual void drawBitmapRectToRect(const SkBitmap& bitmap, const SkRect* src,
+                                      const SkRect& dst, const SkPaint*) SK_OVERRIDE;
+    virtual void drawBitmapMatrix(const SkBitmap& bitmap, const SkMatrix& m,
+                                  const SkPaint*) SK_OVERRIDE;
+    virtual void drawSprite(const SkBitmap& bitmap, int left, int top,
+                            const SkPaint*) SK_OVERRIDE;
+    virtual void drawText(const void* text, size_t byteLength, SkScalar x,
+                          SkScalar y, const SkPaint&) SK_OVERRIDE;
+    virtual void drawPosText(const void* text, size_t byteLength,
+                             const SkPoint pos[], const SkPaint&) SK_OVERRIDE;
+    virtual void drawPosTextH(const void* text, size_t byteLength,
+                              const SkScalar xpos[], SkScalar constY,
+                              const SkPaint&) SK_OVERRIDE;
+    virtual void drawTextOnPath(const void* text, size_t byteLength,
+                                const SkPath& path, const SkMatrix* matrix,
+                                const SkPaint&) SK_OVERRIDE;
+    virtual void drawPicture(SkPicture&) SK_OVERRIDE;
+    virtual void drawVertices(VertexMode vmode, int vertexCount,
+                              const SkPoint vertices[], const SkPoint texs[],
+                              const SkColor colors[], SkXfermode* xmode,
+                              const uint16_t indices[], int indexCount,
+                              const SkPaint&) SK_OVERRIDE;
+    virtual void drawData(const void* data, size_t length) SK_OVERRIDE;
+
+private:
+    // Called before each call is recorded, with a rough size of what it adds
+    // to the current segment. Starts a new segment first if it is time to.
+    void willRecord(size_t size);
+
+    void beginSegment();
+    void endSegment();
+    // Recreate the current save stack, matrix and clip in the new segment.
+    void replayState();
+
+    // Each clip call that is still in effect, in order, along with the matrix
+    // it was made with.
+    struct ClipRec {
+        enum Type {
+            kRect_Type,
+            kRRect_Type,
+            kPath_Type,
+            kRegion_Type,
+        };
+
+        Type            fType;
+        SkMatrix        fMatrix;
+        SkRect          fRect;
+        SkRRect         fRRect;
+        SkPath          fPath;
+        SkRegion        fRegion;
+        SkRegion::Op    fOp;
+        bool            fDoAA;
+    };
+
+    struct SaveRec {
+        SkMatrix    fMatrix;    // the matrix when save() was called
+        SaveFlags   fFlags;
+        int         fClipCount; // how many clips were made before it
+        bool        fIsLayer;
+    };
+
+    ClipRec* appendClip(ClipRec::Type, SkRegion::Op, bool doAA);
+    static void ReplayClip(SkCanvas*, const ClipRec&);
+    void pushSave(SaveFlags, bool isLayer);
+
+    SkWStream*              fStream;
+    int                     fWidth;
+    int                     fHeight;
+    size_t                  fSegmentSize;
+    SkPicture::EncodeBitmap fEncoder;
+
+    SkPicture*              fSegment;
+    SkCanvas*               fRecordingCanvas;
+    size_t                  fRecordedSize;
+    SkTDArray<SaveRec>      fSaveStack;
+    SkTArray<ClipRec>       fClips;
+    int                     fLayerCount;    // how many saveLayer()s are open
+    int                     fSegmentCount;
+    bool                    fSucceeded;
+    bool                    fFinished;
+
+    typedef SkNWayCanvas INHERITED;
+};
+
+/**
+ *  Reads a segmented picture from a stream and draws it, holding only one
+ *  segment in memory at a time.
+ */
+class SkSegmentedPictureReader : SkNoncopyable {
+public:
+    /**
+     *  Reads the header from the stream. The stream must outlive the reader.
+     *  @param proc Used to decode the bitmaps of each segment, as with
+     *              SkPicture::CreateFromData().
+     */
+    SkSegmentedPictureReader(SkStream* stream, SkPicture::InstallPixelRefProc proc = NULL);
+
+    /** Returns false if the stream does not start with a segmented picture. */
+    bool isValid() const { return fValid; }
+
+    int width() const { return fWidth; }
+    int height() const { return fHeight; }
+
+    /**
+     *  Draw the segments that have not been read yet, in order. Each one is
+     *  drawn in a save/restore of its own. Returns false if the stream ends
+     *  early or holds a bad segment, after drawing what came before it.
+     */
+    bool draw(SkCanvas*);
+
+    /**
+     *  Read the next segment. The caller owns the returned picture. Returns
+     *  NULL at the end of the stream, or if the segment could not be read
+     *  (which the next call to draw() or readSegment() also reports).
+     */
+    SkPicture* readSegment();
+
+private:
+    SkStream*                       fStream;
+    SkPicture::InstallPixelRefProc  fProc;
+    int                             fWidth;
+    int                             fHeight;
+    bool                            fValid;
+    bool                            fAtEnd;
+};
+
+#endif
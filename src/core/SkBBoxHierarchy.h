@@ -51,6 +51,14 @@ public:
      */
     virtual void insert(void* data, const SkIRect& bounds, bool defer = false) = 0;
 
+    /**
+     * Tell the hierarchy that 'data', which must be the element inserted last, paints every
+     * pixel of 'bounds' with an opaque color, hiding whatever was inserted before it there.
+     * Hierarchies which can leave hidden elements out of search results may override this,
+     * by default it is ignored.
+     */
+    virtual void insertOccluder(void* data, const SkIRect& bounds) {}
+
     /**
      * If any insertions have been deferred, this forces them to be inserted
      */
@@ -61,6 +69,33 @@ public:
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results) = 0;
 
+    /**
+     * Like search(), but where only 'visible', a part of 'query', will actually be drawn to.
+     * Hierarchies which keep track of occluders may leave out data that is hidden there. By
+     * default this is the same as search().
+     */
+    virtual void searchVisible(const SkIRect& query, const SkIRect& visible,
+                               SkTDArray<void*>* results) {
+        this->search(query, results);
+    }
+
+    /**
+     * Whether search results come in the order in which they were inserted. If not, callers that
+     * need them in that order have to sort them.
+     */
+    virtual bool searchIsOrdered() const { return false; }
+
+    /**
+     * Populate results[i] as search() would for queries[i], for each of 'count' queries.
+     * Hierarchies may be able to answer a batch of nearby queries in less time than it takes to
+     * answer them one by one. By default this calls search() for each query.
+     */
+    virtual void searchBatch(const SkIRect queries[], int count, SkTDArray<void*> results[]) {
+        for (int i = 0; i < count; ++i) {
+            this->search(queries[i], &results[i]);
+        }
+    }
+
     virtual void clear() = 0;
 
     /**
@@ -7,16 +7,24 @@
  */
 
 #include "SkBBoxHierarchyRecord.h"
+#include "SkPicture.h"
 #include "SkPictureStateTree.h"
+#include "SkShader.h"
+#include "SkXfermode.h"
 
 SkBBoxHierarchyRecord::SkBBoxHierarchyRecord(uint32_t recordFlags,
                                              SkBBoxHierarchy* h,
-                                             SkDevice* device)
-    : INHERITED(recordFlags, device) {
+                                             SkDevice* device,
+                                             uint32_t optimizations)
+    : INHERITED(recordFlags, device, optimizations) {
     fStateTree = SkNEW(SkPictureStateTree);
     fBoundingHierarchy = h;
     fBoundingHierarchy->ref();
     fBoundingHierarchy->setClient(this);
+    fLastDraw = NULL;
+    if (recordFlags & SkPicture::kCullOccludedDraws_RecordingFlag) {
+        fClipInteriorStack.push()->setLargest();
+    }
 }
 
 void SkBBoxHierarchyRecord::handleBBox(const SkRect& bounds) {
@@ -24,21 +32,32 @@ void SkBBoxHierarchyRecord::handleBBox(const SkRect& bounds) {
     bounds.roundOut(&r);
     SkPictureStateTree::Draw* draw = fStateTree->appendDraw(this->writeStream().size());
     fBoundingHierarchy->insert(draw, r, true);
+    fLastDraw = draw;
 }
 
 int SkBBoxHierarchyRecord::save(SaveFlags flags) {
     fStateTree->appendSave();
+    if (this->cullsOccludedDraws()) {
+        *fClipInteriorStack.append() = fClipInteriorStack.top();
+    }
     return INHERITED::save(flags);
 }
 
 int SkBBoxHierarchyRecord::saveLayer(const SkRect* bounds, const SkPaint* paint,
                                      SaveFlags flags) {
     fStateTree->appendSaveLayer(this->writeStream().size());
+    if (this->cullsOccludedDraws()) {
+        *fClipInteriorStack.append() = fClipInteriorStack.top();
+    }
     return INHERITED::saveLayer(bounds, paint, flags);
 }
 
 void SkBBoxHierarchyRecord::restore() {
     fStateTree->appendRestore();
+    // Like the canvas, never pop the bottom of the stack.
+    if (fClipInteriorStack.count() > 1) {
+        fClipInteriorStack.pop();
+    }
     INHERITED::restore();
 }
 
@@ -81,12 +100,18 @@ bool SkBBoxHierarchyRecord::clipRect(const SkRect& rect,
                                      SkRegion::Op op,
                                      bool doAntiAlias) {
     fStateTree->appendClip(this->writeStream().size());
+    this->clipInteriorToRect(rect, op);
     return INHERITED::clipRect(rect, op, doAntiAlias);
 }
 
 bool SkBBoxHierarchyRecord::clipRegion(const SkRegion& region,
                                        SkRegion::Op op) {
     fStateTree->appendClip(this->writeStream().size());
+    if (region.isRect()) {
+        this->clipInteriorToDeviceRect(region.getBounds(), op);
+    } else {
+        this->clipInteriorToShape(op);
+    }
     return INHERITED::clipRegion(region, op);
 }
 
@@ -94,6 +119,12 @@ bool SkBBoxHierarchyRecord::clipPath(const SkPath& path,
                                      SkRegion::Op op,
                                      bool doAntiAlias) {
     fStateTree->appendClip(this->writeStream().size());
+    SkRect rect;
+    if (!path.isInverseFillType() && path.isRect(&rect)) {
+        this->clipInteriorToRect(rect, op);
+    } else {
+        this->clipInteriorToShape(op);
+    }
     return INHERITED::clipPath(path, op, doAntiAlias);
 }
 
@@ -101,9 +132,171 @@ bool SkBBoxHierarchyRecord::clipRRect(const SkRRect& rrect,
                                       SkRegion::Op op,
                                       bool doAntiAlias) {
     fStateTree->appendClip(this->writeStream().size());
+    if (rrect.isRect()) {
+        this->clipInteriorToRect(rrect.rect(), op);
+    } else {
+        this->clipInteriorToShape(op);
+    }
     return INHERITED::clipRRect(rrect, op, doAntiAlias);
 }
 
+void SkBBoxHierarchyRecord::clear(SkColor color) {
+    fLastDraw = NULL;
+    INHERITED::clear(color);
+    // clear() ignores the clip.
+    if (this->cullsOccludedDraws() && 0xFF == SkColorGetA(color) && !this->isDrawingToLayer()) {
+        SkIRect everything;
+        everything.setLargest();
+        this->occludeDeviceRect(everything);
+    }
+}
+
+void SkBBoxHierarchyRecord::drawPaint(const SkPaint& paint) {
+    fLastDraw = NULL;
+    INHERITED::drawPaint(paint);
+    if (this->canOcclude(&paint) &&
+        (NULL == paint.getShader() || paint.getShader()->isOpaque())) {
+        this->occludeDeviceRect(fClipInteriorStack.top());
+    }
+}
+
+void SkBBoxHierarchyRecord::drawRect(const SkRect& rect, const SkPaint& paint) {
+    fLastDraw = NULL;
+    INHERITED::drawRect(rect, paint);
+    if (this->canOcclude(&paint) && SkPaint::kFill_Style == paint.getStyle() &&
+        (NULL == paint.getShader() || paint.getShader()->isOpaque())) {
+        this->occludeRect(rect);
+    }
+}
+
+void SkBBoxHierarchyRecord::drawBitmap(const SkBitmap& bitmap, SkScalar left, SkScalar top,
+                                       const SkPaint* paint) {
+    fLastDraw = NULL;
+    INHERITED::drawBitmap(bitmap, left, top, paint);
+    if (this->canOcclude(paint) && bitmap.isOpaque()) {
+        this->occludeRect(SkRect::MakeXYWH(left, top, SkIntToScalar(bitmap.width()),
+                                           SkIntToScalar(bitmap.height())));
+    }
+}
+
+void SkBBoxHierarchyRecord::drawBitmapRectToRect(const SkBitmap& bitmap, const SkRect* src,
+                                                 const SkRect& dst, const SkPaint* paint) {
+    fLastDraw = NULL;
+    INHERITED::drawBitmapRectToRect(bitmap, src, dst, paint);
+    if (this->canOcclude(paint) && bitmap.isOpaque()) {
+        this->occludeRect(dst);
+    }
+}
+
+void SkBBoxHierarchyRecord::drawSprite(const SkBitmap& bitmap, int left, int top,
+                                       const SkPaint* paint) {
+    fLastDraw = NULL;
+    INHERITED::drawSprite(bitmap, left, top, paint);
+    if (this->canOcclude(paint) && bitmap.isOpaque()) {
+        // Sprites ignore the matrix.
+        SkIRect deviceRect = SkIRect::MakeXYWH(left, top, bitmap.width(), bitmap.height());
+        if (!deviceRect.intersect(fClipInteriorStack.top())) {
+            return;
+        }
+        this->occludeDeviceRect(deviceRect);
+    }
+}
+
+void SkBBoxHierarchyRecord::clipInteriorToRect(const SkRect& rect, SkRegion::Op op) {
+    if (!this->cullsOccludedDraws()) {
+        return;
+    }
+    const SkMatrix& matrix = this->getTotalMatrix();
+    if (!matrix.rectStaysRect()) {
+        this->clipInteriorToShape(op);
+        return;
+    }
+    SkRect deviceRect;
+    matrix.mapRect(&deviceRect, rect);
+    // Only the pixels entirely inside the rect are let through at full coverage, whether or not
+    // the clip is antialiased.
+    SkIRect interior;
+    deviceRect.roundIn(&interior);
+    this->clipInteriorToDeviceRect(interior, op);
+}
+
+void SkBBoxHierarchyRecord::clipInteriorToDeviceRect(const SkIRect& rect, SkRegion::Op op) {
+    if (!this->cullsOccludedDraws()) {
+        return;
+    }
+    SkIRect& interior = fClipInteriorStack.top();
+    switch (op) {
+        case SkRegion::kIntersect_Op:
+            if (!interior.intersect(rect)) {
+                interior.setEmpty();
+            }
+            break;
+        case SkRegion::kReplace_Op:
+            if (rect.isEmpty()) {
+                interior.setEmpty();
+            } else {
+                interior = rect;
+            }
+            break;
+        default:
+            this->clipInteriorToShape(op);
+            break;
+    }
+}
+
+void SkBBoxHierarchyRecord::clipInteriorToShape(SkRegion::Op op) {
+    if (!this->cullsOccludedDraws()) {
+        return;
+    }
+    // A union can only open up more of the device, so the old interior is still inside the
+    // clip. After anything else we no longer know of a part of the device that is.
+    if (SkRegion::kUnion_Op != op) {
+        fClipInteriorStack.top().setEmpty();
+    }
+}
+
+bool SkBBoxHierarchyRecord::canOcclude(const SkPaint* paint) const {
+    // A draw inside a layer only hides the draws before it in the same layer, and only if the
+    // layer is drawn back opaquely, so only draws to the base device are considered.
+    if (!this->cullsOccludedDraws() || NULL == fLastDraw || this->isDrawingToLayer()) {
+        return false;
+    }
+    if (NULL == paint) {
+        return true;
+    }
+    return 0xFF == paint->getAlpha() &&
+           NULL == paint->getPathEffect() &&
+           NULL == paint->getMaskFilter() &&
+           NULL == paint->getColorFilter() &&
+           NULL == paint->getRasterizer() &&
+           NULL == paint->getLooper() &&
+           NULL == paint->getImageFilter() &&
+           (SkXfermode::IsMode(paint->getXfermode(), SkXfermode::kSrcOver_Mode) ||
+            SkXfermode::IsMode(paint->getXfermode(), SkXfermode::kSrc_Mode));
+}
+
+void SkBBoxHierarchyRecord::occludeDeviceRect(const SkIRect& deviceRect) {
+    SkASSERT(NULL != fLastDraw);
+    if (!deviceRect.isEmpty()) {
+        fBoundingHierarchy->insertOccluder(fLastDraw, deviceRect);
+    }
+}
+
+void SkBBoxHierarchyRecord::occludeRect(const SkRect& rect) {
+    const SkMatrix& matrix = this->getTotalMatrix();
+    if (!matrix.rectStaysRect()) {
+        return;
+    }
+    SkRect deviceRect;
+    matrix.mapRect(&deviceRect, rect);
+    // As with the clip, only count the pixels that are entirely covered.
+    SkIRect covered;
+    deviceRect.roundIn(&covered);
+    if (covered.intersect(fClipInteriorStack.top())) {
+        this->occludeDeviceRect(covered);
+    }
+}
+
 bool SkBBoxHierarchyRecord::shouldRewind(void* data) {
     // SkBBoxHierarchy::rewindInserts is called by SkPicture after the
     // SkPicture has rewound its command stream.  To match that rewind in the
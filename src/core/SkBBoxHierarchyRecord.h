@@ -11,6 +11,7 @@
 
 #include "SkBBoxHierarchy.h"
 #include "SkBBoxRecord.h"
+#include "SkPictureStateTree.h"
 
 /**
  * This records bounding box information into an SkBBoxHierarchy, and clip/transform information
@@ -20,7 +21,7 @@ class SkBBoxHierarchyRecord : public SkBBoxRecord, public SkBBoxHierarchyClient
 public:
     /** This will take a ref of h */
     SkBBoxHierarchyRecord(uint32_t recordFlags, SkBBoxHierarchy* h,
-                          SkDevice*);
+                          SkDevice*, uint32_t optimizations = kAll_Optimizations);
 
     virtual void handleBBox(const SkRect& bounds) SK_OVERRIDE;
 
@@ -48,10 +49,40 @@ public:
                            SkRegion::Op op = SkRegion::kIntersect_Op,
                            bool doAntiAlias = false) SK_OVERRIDE;
 
+    virtual void clear(SkColor) SK_OVERRIDE;
+    virtual void drawPaint(const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawRect(const SkRect& rect, const SkPaint& paint) SK_OVERRIDE;
+    virtual void drawBitmap(const SkBitmap& bitmap, SkScalar left, SkScalar top,
+                            const SkPaint* paint = NULL) SK_OVERRIDE;
+    virtual void drawBitmapRectToRect(const SkBitmap& bitmap, const SkRect* src,
+                                      const SkRect& dst, const SkPaint* paint) SK_OVERRIDE;
+    virtual void drawSprite(const SkBitmap& bitmap, int left, int top,
+                            const SkPaint* paint) SK_OVERRIDE;
+
     // Implementation of the SkBBoxHierarchyClient interface
     virtual bool shouldRewind(void* data) SK_OVERRIDE;
 
 private:
+    /**
+     * When culling occluded draws, these keep track of the part of the device in which the
+     * current clip is known to let every pixel through, and tell the hierarchy about the draws
+     * which hide whatever is under them there.
+     */
+    void clipInteriorToRect(const SkRect& rect, SkRegion::Op op);
+    void clipInteriorToDeviceRect(const SkIRect& rect, SkRegion::Op op);
+    void clipInteriorToShape(SkRegion::Op op);
+    bool cullsOccludedDraws() const { return fClipInteriorStack.count() > 0; }
+    bool canOcclude(const SkPaint* paint) const;
+    void occludeDeviceRect(const SkIRect& deviceRect);
+    void occludeRect(const SkRect& rect);
+
+    // The draw appended by the last call to handleBBox(), or NULL if the last draw call was
+    // clipped out.
+    SkPictureStateTree::Draw* fLastDraw;
+    // One clip interior for each level of the save stack, the current one on top. Empty unless
+    // recording with SkPicture::kCullOccludedDraws_RecordingFlag.
+    SkTDArray<SkIRect> fClipInteriorStack;
+
     typedef SkBBoxRecord INHERITED;
 };
 
@@ -19,8 +19,9 @@
 class SkBBoxRecord : public SkPictureRecord {
 public:
 
-    SkBBoxRecord(uint32_t recordFlags, SkDevice* device)
-            : INHERITED(recordFlags, device) { }
+    SkBBoxRecord(uint32_t recordFlags, SkDevice* device,
+                 uint32_t optimizations = kAll_Optimizations)
+            : INHERITED(recordFlags, device, NULL, optimizations) { }
     virtual ~SkBBoxRecord() { }
 
     /**
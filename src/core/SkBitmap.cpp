@@ -37,6 +37,12 @@ struct MipLevel {
 struct SkBitmap::MipMap : SkNoncopyable {
     int32_t fRefCnt;
     int     fLevelCount;
+    // what the levels were built from, so that other bitmaps of the same
+    // pixelref can tell if they may share them
+    uint32_t fGenerationID;
+    size_t   fPixelRefOffset;
+    uint32_t fWidth, fHeight, fRowBytes;
+    uint8_t  fConfig;
 //  MipLevel    fLevel[fLevelCount];
 //  Pixels[]
 
@@ -57,6 +63,15 @@ struct SkBitmap::MipMap : SkNoncopyable {
         return mm;
     }
 
+    bool builtFrom(const SkBitmap& bm) const {
+        return fGenerationID == bm.getGenerationID() &&
+               fPixelRefOffset == bm.pixelRefOffset() &&
+               fWidth == (uint32_t)bm.width() &&
+               fHeight == (uint32_t)bm.height() &&
+               fRowBytes == bm.rowBytes() &&
+               fConfig == bm.config();
+    }
+
     const MipLevel* levels() const { return (const MipLevel*)(this + 1); }
     MipLevel* levels() { return (MipLevel*)(this + 1); }
 
@@ -1267,6 +1282,15 @@ static void downsampleby2_proc4444(SkBitmap* dst, int x, int y,
     *dst->getAddr16(x >> 1, y >> 1) = (uint16_t)collaps4444(c >> 2);
 }
 
+// Guards SkPixelRef::fMipMap.
+SK_DECLARE_STATIC_MUTEX(gSharedMipMapMutex);
+
+void SkBitmap::UnrefMipMap(MipMap* mm) {
+    if (NULL != mm) {
+        mm->unref();
+    }
+}
+
 void SkBitmap::buildMipMap(bool forceRebuild) {
     if (forceRebuild)
         this->freeMipMap();
@@ -1275,6 +1299,19 @@ void SkBitmap::buildMipMap(bool forceRebuild) {
 
     SkASSERT(NULL == fMipMap);
 
+    // The levels are shared as long as the generation ID that they were built
+    // from is current, so writes to the pixels must notifyPixelsChanged().
+    const bool shareable = NULL != fPixelRef;
+    if (!forceRebuild && shareable) {
+        SkAutoMutexAcquire ac(gSharedMipMapMutex);
+        MipMap* shared = fPixelRef->fMipMap;
+        if (NULL != shared && shared->builtFrom(*this)) {
+            shared->ref();
+            fMipMap = shared;
+            return;
+        }
+    }
+
     void (*proc)(SkBitmap* dst, int x, int y, const SkBitmap& src);
 
     const SkBitmap::Config config = this->getConfig();
@@ -1365,7 +1402,24 @@ void SkBitmap::buildMipMap(bool forceRebuild) {
         addr += height * rowBytes;
     }
     SkASSERT(addr == (uint8_t*)mm->pixels() + size);
+    mm->fGenerationID = this->getGenerationID();
+    mm->fPixelRefOffset = fPixelRefOffset;
+    mm->fWidth = fWidth;
+    mm->fHeight = fHeight;
+    mm->fRowBytes = fRowBytes;
+    mm->fConfig = fConfig;
     fMipMap = mm;
+
+    if (shareable) {
+        MipMap* prev;
+        {
+            SkAutoMutexAcquire ac(gSharedMipMapMutex);
+            prev = fPixelRef->fMipMap;
+            fPixelRef->fMipMap = mm;
+            mm->ref();
+        }
+        UnrefMipMap(prev);
+    }
 }
 
 bool SkBitmap::hasMipMap() const {
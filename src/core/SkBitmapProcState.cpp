@@ -6,6 +6,7 @@
  * found in the LICENSE file.
  */
 #include "SkBitmapProcState.h"
+#include "SkBitmapProcState_bicubic.h"
 #include "SkColorPriv.h"
 #include "SkFilterProc.h"
 #include "SkPaint.h"
@@ -81,6 +82,16 @@ static bool valid_for_filtering(unsigned dimension) {
     return (dimension & ~0x3FFF) == 0;
 }
 
+// Returns true if inv scales down by enough that extractMipLevel() would pick
+// a level other than the bitmap itself.
+static bool wants_mip_level(const SkMatrix& inv) {
+    if (inv.hasPerspective()) {
+        return false;
+    }
+    const SkScalar two = SkIntToScalar(2);
+    return SkScalarAbs(inv.getScaleX()) >= two || SkScalarAbs(inv.getSkewY()) >= two;
+}
+
 bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
     if (fOrigBitmap.width() == 0 || fOrigBitmap.height() == 0) {
         return false;
@@ -99,20 +110,31 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
         m = &fUnitInvMatrix;
     }
 
+    const SkPaint::FilterLevel filterLevel = paint.getFilterLevel();
+    if (filterLevel >= SkPaint::kMedium_FilterLevel && wants_mip_level(inv)) {
+        // the levels are shared through the pixelref, so this only builds
+        // them the first time these pixels are drawn scaled down
+        fOrigBitmap.buildMipMap();
+    }
+
     fBitmap = &fOrigBitmap;
+    int mipShift = 0;
     if (fOrigBitmap.hasMipMap()) {
-        int shift = fOrigBitmap.extractMipLevel(&fMipBitmap,
-                                                SkScalarToFixed(m->getScaleX()),
-                                                SkScalarToFixed(m->getSkewY()));
-
-        if (shift > 0) {
+        // measure the scale with inv, since m may map to the unit square
+        mipShift = fOrigBitmap.extractMipLevel(&fMipBitmap,
+                                               SkScalarToFixed(inv.getScaleX()),
+                                               SkScalarToFixed(inv.getSkewY()));
+
+        if (mipShift > 0) {
+            // the unit square is the same for every level, so only a matrix
+            // that maps to fOrigBitmap's pixels needs scaling
             if (m != &fUnitInvMatrix) {
                 fUnitInvMatrix = *m;
                 m = &fUnitInvMatrix;
-            }
 
-            SkScalar scale = SkFixedToScalar(SK_Fixed1 >> shift);
-            fUnitInvMatrix.postScale(scale, scale);
+                SkScalar scale = SkFixedToScalar(SK_Fixed1 >> mipShift);
+                fUnitInvMatrix.postScale(scale, scale);
+            }
 
             // now point here instead of fOrigBitmap
             fBitmap = &fMipBitmap;
@@ -298,6 +320,18 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
         fShaderProc32 = this->chooseShaderProc32();
     }
 
+    // The bicubic filter keeps its own matrix, to fBitmap's pixels, so the
+    // procs above still work for the 16bit path (which stays bilinear).
+    if (SkPaint::kHigh_FilterLevel == filterLevel && fDoFilter &&
+            SkBitmap::kARGB_8888_Config == fBitmap->config() && !inv.hasPerspective()) {
+        fHighQualityInvMatrix = inv;
+        if (mipShift > 0) {
+            SkScalar scale = SkFixedToScalar(SK_Fixed1 >> mipShift);
+            fHighQualityInvMatrix.postScale(scale, scale);
+        }
+        fShaderProc32 = S32_D32_bicubic_shaderproc;
+    }
+
     // see if our platform has any accelerated overrides
     this->platformProcs();
     return true;
@@ -417,6 +451,47 @@ static void Repeat_S32_D32_nofilter_trans_shaderproc(const SkBitmapProcState& s,
     }
 }
 
+static inline float pin_float(float value, float max) {
+    return value < 0 ? 0 : (value > max ? max : value);
+}
+
+void S32_D32_bicubic_shaderproc(const SkBitmapProcState& s, int x, int y,
+                                SkPMColor* SK_RESTRICT colors, int count) {
+    SkASSERT(count > 0 && colors != NULL);
+
+    const float alphaScale = s.fAlphaScale * (1.0f / 256);
+    SkBicubicTaps taps(s, x, y);
+    for (int n = 0; n < count; ++n) {
+        float a = 0, r = 0, g = 0, b = 0;
+        for (int j = 0; j < 4; ++j) {
+            float ra = 0, rr = 0, rg = 0, rb = 0;
+            for (int i = 0; i < 4; ++i) {
+                const SkPMColor c = taps.fRow[j][taps.fX[i]];
+                const float w = taps.fWeightX[i];
+                ra += w * SkGetPackedA32(c);
+                rr += w * SkGetPackedR32(c);
+                rg += w * SkGetPackedG32(c);
+                rb += w * SkGetPackedB32(c);
+            }
+            const float w = taps.fWeightY[j];
+            a += w * ra;
+            r += w * rr;
+            g += w * rg;
+            b += w * rb;
+        }
+        // The filter overshoots; pin back to a valid premultiplied color.
+        a = pin_float(a, 255);
+        r = pin_float(r, a);
+        g = pin_float(g, a);
+        b = pin_float(b, a);
+        colors[n] = SkPackARGB32((int)(a * alphaScale + 0.5f),
+                                 (int)(r * alphaScale + 0.5f),
+                                 (int)(g * alphaScale + 0.5f),
+                                 (int)(b * alphaScale + 0.5f));
+        taps.next();
+    }
+}
+
 static void S32_D32_constX_shaderproc(const SkBitmapProcState& s,
                                       int x, int y,
                                       SkPMColor* SK_RESTRICT colors,
@@ -82,6 +82,10 @@ struct SkBitmapProcState {
     uint8_t             fTileModeY;         // CONSTRUCTOR
     SkBool8             fDoFilter;          // chooseProcs
 
+    // Maps device space to fBitmap's pixels (whatever the tile modes), for the
+    // bicubic shaderprocs. Only set for SkPaint::kHigh_FilterLevel.
+    SkMatrix            fHighQualityInvMatrix;  // chooseProcs
+
     /** Platforms implement this, and can optionally overwrite only the
         following fields:
 
@@ -192,5 +196,7 @@ void ClampX_ClampY_nofilter_affine(const SkBitmapProcState& s,
                                    uint32_t xy[], int count, int x, int y);
 void S32_D16_filter_DX(const SkBitmapProcState& s,
                                    const uint32_t* xy, int count, uint16_t* colors);
+void S32_D32_bicubic_shaderproc(const SkBitmapProcState& s, int x, int y,
+                                SkPMColor colors[], int count);
 
 #endif
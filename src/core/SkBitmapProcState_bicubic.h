@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapProcState_bicubic_DEFINED
+#define SkBitmapProcState_bicubic_DEFINED
+
+#include "SkBitmapProcState.h"
+#include "SkFloatingPoint.h"
+#include "SkShader.h"
+
+/*
+    SkBicubicTaps
+
+    Walks the span of destination pixels that a bicubic shaderproc (see
+    S32_D32_bicubic_shaderproc) is asked for, and finds the 4x4 source pixels
+    that each is filtered from, and their weights. The procs only differ in
+    how they blend those; the portable one and the platform ones must blend in
+    the same order (one row at a time, then the rows together), so that they
+    give the same results.
+ */
+class SkBicubicTaps {
+public:
+    SkBicubicTaps(const SkBitmapProcState& s, int x, int y) {
+        const SkMatrix& inv = s.fHighQualityInvMatrix;
+        SkASSERT(!(inv.getType() & SkMatrix::kPerspective_Mask));
+        SkASSERT(SkBitmap::kARGB_8888_Config == s.fBitmap->config());
+
+        SkPoint pt;
+        inv.mapXY(SkIntToScalar(x) + SK_ScalarHalf,
+                  SkIntToScalar(y) + SK_ScalarHalf, &pt);
+        // Pixel centers are at the halves; make them the integers.
+        fFx = SkScalarToFloat(pt.fX) - 0.5f;
+        fFy = SkScalarToFloat(pt.fY) - 0.5f;
+        fDx = SkScalarToFloat(inv.getScaleX());
+        fDy = SkScalarToFloat(inv.getSkewY());
+        fBitmap = s.fBitmap;
+        fTileModeX = s.fTileModeX;
+        fTileModeY = s.fTileModeY;
+        this->compute();
+    }
+
+    void next() {
+        fFx += fDx;
+        fFy += fDy;
+        this->compute();
+    }
+
+    const SkPMColor*    fRow[4];
+    int                 fX[4];
+    float               fWeightX[4];
+    float               fWeightY[4];
+
+private:
+    // Mitchell-Netravali (B = C = 1/3), as SkBicubicImageFilter::CreateMitchell,
+    // for the taps at -1, 0, 1 and 2 from a sample t past the second of them.
+    static void ComputeWeights(float t, float w[4]) {
+        const float t2 = t * t;
+        const float t3 = t2 * t;
+        const float k = 1.0f / 18;
+        w[0] = (1 - 9 * t + 15 * t2 - 7 * t3) * k;
+        w[1] = (16 - 36 * t2 + 21 * t3) * k;
+        w[2] = (1 + 9 * t + 27 * t2 - 21 * t3) * k;
+        w[3] = (-6 * t2 + 7 * t3) * k;
+    }
+
+    static int Tile(int i, int n, unsigned mode) {
+        switch (mode) {
+            case SkShader::kClamp_TileMode:
+                return SkClampMax(i, n - 1);
+            case SkShader::kRepeat_TileMode:
+                i %= n;
+                return i < 0 ? i + n : i;
+            default: {
+                const int period = 2 * n;
+                i %= period;
+                if (i < 0) {
+                    i += period;
+                }
+                return i < n ? i : period - 1 - i;
+            }
+        }
+    }
+
+    void compute() {
+        const int ix = sk_float_floor2int(fFx);
+        const int iy = sk_float_floor2int(fFy);
+        ComputeWeights(fFx - ix, fWeightX);
+        ComputeWeights(fFy - iy, fWeightY);
+
+        const int width = fBitmap->width();
+        const int height = fBitmap->height();
+        for (int i = 0; i < 4; ++i) {
+            fX[i] = Tile(ix - 1 + i, width, fTileModeX);
+            fRow[i] = fBitmap->getAddr32(0, Tile(iy - 1 + i, height, fTileModeY));
+        }
+    }
+
+    float           fFx, fFy;
+    float           fDx, fDy;
+    const SkBitmap* fBitmap;
+    unsigned        fTileModeX;
+    unsigned        fTileModeY;
+};
+
+#endif
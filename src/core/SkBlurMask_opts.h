@@ -0,0 +1,62 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlurMask_opts_DEFINED
+#define SkBlurMask_opts_DEFINED
+
+#include "SkTypes.h"
+
+/** Procs that SkBlurMask can use for its separable box blurs. Rather than
+    blurring along a row, which is one long serial dependency, these blur
+    down the columns of an A8 image, so that a whole row of columns can be
+    summed in parallel. A blur in X is then a transpose followed by a blur
+    down the columns.
+
+    A row proc writes one row of output. sums holds the running sum of each
+    of the width columns. right, if not NULL, is the row entering the kernel,
+    and is added before writing; left, if not NULL, is the row leaving it,
+    and is subtracted after. With both NULL, the sums are left alone.
+    half is 0 or 1 << 23, and the products never reach 2^32. The results must
+    be exactly those of the scalar blurs in SkBlurMask.cpp.
+*/
+class SkBlurMaskProcs {
+public:
+    /** dst[i] = (sums[i] * scale + half) >> 24 */
+    typedef void (*BoxBlurRowProc)(uint8_t* SK_RESTRICT dst,
+                                   const uint8_t* SK_RESTRICT right,
+                                   const uint8_t* SK_RESTRICT left,
+                                   uint16_t* SK_RESTRICT sums, int width,
+                                   uint32_t scale, uint32_t half);
+
+    /** The interpolating blur keeps a sum for an outer and an inner kernel.
+        Unless right and left are both NULL, innerSums[i] is first set to
+        outerSums[i] - left[i] (or to outerSums[i] if left is NULL). Then
+        dst[i] = (outerSums[i] * outerScale + innerSums[i] * innerScale + half) >> 24
+    */
+    typedef void (*BoxBlurInterpRowProc)(uint8_t* SK_RESTRICT dst,
+                                         const uint8_t* SK_RESTRICT right,
+                                         const uint8_t* SK_RESTRICT left,
+                                         uint16_t* SK_RESTRICT outerSums,
+                                         uint16_t* SK_RESTRICT innerSums, int width,
+                                         uint32_t outerScale, uint32_t innerScale,
+                                         uint32_t half);
+
+    /** dst[x * dstRB + y] = src[y * srcRB + x], for a width x height src. */
+    typedef void (*TransposeProc)(uint8_t* SK_RESTRICT dst, int dstRB,
+                                  const uint8_t* SK_RESTRICT src, int srcRB,
+                                  int width, int height);
+
+    /** Return the platform's procs, or NULL if there are none. They are
+        implemented in src/opts for the CPU we're running on. SkBlurMask only
+        uses the column blurs when all three are available.
+    */
+    static BoxBlurRowProc PlatformBoxBlurRow();
+    static BoxBlurInterpRowProc PlatformBoxBlurInterpRow();
+    static TransposeProc PlatformTranspose();
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkCoverage_opts_DEFINED
+#define SkCoverage_opts_DEFINED
+
+#include "SkTypes.h"
+
+/** Procs that the supersampling path filler can use to resolve a scanline
+    of coverage it accumulated densely: as the change in coverage from each
+    pixel to the next, rather than as runs of alpha.
+*/
+class SkCoverageProcs {
+public:
+    /** Add deltas[0..count) to sum one at a time, storing each sum in dst
+        with 256 clamped to 255, and return the final sum. Every sum is in
+        [0, 256]. Clears deltas to 0 for the next scanline.
+    */
+    typedef int (*DeltasToAlphaProc)(uint8_t* SK_RESTRICT dst,
+                                     int16_t* SK_RESTRICT deltas, int count, int sum);
+
+    /** Return the platform's proc, or NULL if there is none. It is
+        implemented in src/opts for the CPU we're running on.
+    */
+    static DeltasToAlphaProc PlatformDeltasToAlpha();
+};
+
+#endif
@@ -2708,7 +2708,7 @@ static bool compute_bounds(const SkPath& devPath, const SkIRect* clipBounds,
         // clip, and bring down the renderer (at least on finite RAM machines
         // like handsets, etc.). Need to balance this invented value between
         // quality of large filters like blurs, and the corresponding memory
-        // requests.
+        // requests. (SkMaskFilter::makePathCacheKey() assumes this limit.)
         static const int MAX_MARGIN = 128;
         tmp.inset(-SkMin32(margin.fX, MAX_MARGIN),
                   -SkMin32(margin.fY, MAX_MARGIN));
@@ -16,7 +16,6 @@
 #include "SkTypeface.h"
 
 //#define SPEW_PURGE_STATUS
-//#define USE_CACHE_HASH
 //#define RECORD_HASH_EFFICIENCY
 
 bool gSkSuppressFontCachePurgeSpew;
@@ -378,27 +377,18 @@ void SkGlyphCache::invokeAndRemoveAuxProcs() {
     #define SK_DEFAULT_FONT_CACHE_LIMIT     (2 * 1024 * 1024)
 #endif
 
-#ifdef USE_CACHE_HASH
-    #define HASH_BITCOUNT   6
-    #define HASH_COUNT      (1 << HASH_BITCOUNT)
-    #define HASH_MASK       (HASH_COUNT - 1)
-
-    static unsigned desc_to_hashindex(const SkDescriptor* desc)
-    {
-        SkASSERT(HASH_MASK < 256);  // since our munging reduces to 8 bits
-
-        uint32_t n = *(const uint32_t*)desc;    //desc->getChecksum();
-        SkASSERT(n == desc->getChecksum());
-
-        // don't trust that the low bits of checksum vary enough, so...
-        n ^= (n >> 24) ^ (n >> 16) ^ (n >> 8) ^ (n >> 30);
-
-        return n & HASH_MASK;
-    }
-#endif
-
 #include "SkThread.h"
 
+/*  The strikes are spread over kShardCount independent lists, picked by the
+    descriptor's checksum, each with its own mutex. Finding, detaching and
+    reattaching a strike only takes the lock of its shard, so threads drawing
+    different strikes no longer serialize on a single mutex. Each shard is kept
+    in LRU order; a purge visits the shards in turn and frees from the tail of
+    each in proportion to how much it holds.
+
+    The total is maintained with atomics, so the budget check on attach doesn't
+    have to lock (or even look at) the other shards.
+*/
 class SkGlyphCache_Globals {
 public:
     enum UseMutex {
@@ -406,45 +396,89 @@ public:
         kYes_UseMutex  // shared cache
     };
 
+    enum {
+        kShardBits  = 3,
+        kShardCount = 1 << kShardBits,
+        kShardMask  = kShardCount - 1
+    };
+
+    struct Shard {
+        SkMutex         fMutex;
+        SkGlyphCache*   fHead;
+        size_t          fMemoryUsed;    // attached strikes only, guarded by fMutex
+        // keep neighbouring shards' locks off each other's cache lines
+        char            fPadding[64];
+    };
+
     SkGlyphCache_Globals(UseMutex um) {
-        fHead = NULL;
+        fUseMutex = (kYes_UseMutex == um);
         fTotalMemoryUsed = 0;
+        fPurgeCursor = 0;
         fFontCacheLimit = SK_DEFAULT_FONT_CACHE_LIMIT;
-        fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
-
-#ifdef USE_CACHE_HASH
-        sk_bzero(fHash, sizeof(fHash));
-#endif
+        for (int i = 0; i < kShardCount; i++) {
+            fShards[i].fHead = NULL;
+            fShards[i].fMemoryUsed = 0;
+        }
     }
 
     ~SkGlyphCache_Globals() {
-        SkGlyphCache* cache = fHead;
-        while (cache) {
-            SkGlyphCache* next = cache->fNext;
-            SkDELETE(cache);
-            cache = next;
+        for (int i = 0; i < kShardCount; i++) {
+            SkGlyphCache* cache = fShards[i].fHead;
+            while (cache) {
+                SkGlyphCache* next = cache->fNext;
+                SkDELETE(cache);
+                cache = next;
+            }
         }
+    }
+
+    Shard& shardFor(const SkDescriptor* desc) {
+        uint32_t n = desc->getChecksum();
+        // don't trust that the low bits of checksum vary enough, so...
+        n ^= (n >> 24) ^ (n >> 16) ^ (n >> 8);
+        return fShards[n & kShardMask];
+    }
 
-        SkDELETE(fMutex);
+    Shard& shardAt(int index) {
+        SkASSERT((unsigned)index < kShardCount);
+        return fShards[index];
     }
 
-    SkMutex*        fMutex;
-    SkGlyphCache*   fHead;
-    size_t          fTotalMemoryUsed;
-#ifdef USE_CACHE_HASH
-    SkGlyphCache*   fHash[HASH_COUNT];
-#endif
+    // NULL for a thread-local cache, which needs no locking
+    SkMutex* mutex(Shard* shard) {
+        return fUseMutex ? &shard->fMutex : NULL;
+    }
+
+    // The shard's mutex must be held for these.
+    void attachToShard(Shard* shard, SkGlyphCache* cache) {
+        cache->attachToHead(&shard->fHead);
+        shard->fMemoryUsed += cache->fMemoryUsed;
+        sk_atomic_add(&fTotalMemoryUsed, SkToS32(cache->fMemoryUsed));
+    }
+    void detachFromShard(Shard* shard, SkGlyphCache* cache) {
+        cache->detach(&shard->fHead);
+        SkASSERT(shard->fMemoryUsed >= cache->fMemoryUsed);
+        shard->fMemoryUsed -= cache->fMemoryUsed;
+        sk_atomic_add(&fTotalMemoryUsed, -SkToS32(cache->fMemoryUsed));
+    }
 
 #ifdef SK_DEBUG
-    void validate() const;
+    void validate(const Shard&) const;
 #else
-    void validate() const {}
+    void validate(const Shard&) const {}
 #endif
 
+    size_t  getTotalMemoryUsed() const { return (size_t)SkMax32(fTotalMemoryUsed, 0); }
     size_t  getFontCacheLimit() const { return fFontCacheLimit; }
     size_t  setFontCacheLimit(size_t limit);
     void    purgeAll(); // does not change budget
 
+    /*  Free strikes until no more than targetBytes are attached, or at least a
+        quarter of the cache if that is more. Takes the shard locks itself, one
+        at a time, so it must not be called with any of them held.
+    */
+    size_t  purgeDownTo(size_t targetBytes);
+
     // can return NULL
     static SkGlyphCache_Globals* FindTLS() {
         return (SkGlyphCache_Globals*)SkTLS::Find(CreateTLS);
@@ -457,6 +491,15 @@ public:
     static void DeleteTLS() { SkTLS::Delete(CreateTLS); }
 
 private:
+    // Frees strikes from the tail of the shard until bytesNeeded are released.
+    // The shard's mutex must be held.
+    size_t  purgeShard(Shard*, size_t bytesNeeded);
+
+    Shard   fShards[kShardCount];
+    bool    fUseMutex;
+    int32_t fTotalMemoryUsed;   // sum of the shards' fMemoryUsed, updated atomically
+    int32_t fPurgeCursor;       // shard the next purge starts at, so no shard is always first
+    SkMutex fPurgeMutex;        // serializes purges; never taken while holding a shard lock
     size_t  fFontCacheLimit;
 
     static void* CreateTLS() {
@@ -470,24 +513,94 @@ private:
 
 size_t SkGlyphCache_Globals::setFontCacheLimit(size_t newLimit) {
     static const size_t minLimit = 256 * 1024;
+    // the total is tracked in an int32_t
+    static const size_t maxLimit = SK_MaxS32;
     if (newLimit < minLimit) {
         newLimit = minLimit;
+    } else if (newLimit > maxLimit) {
+        newLimit = maxLimit;
     }
 
     size_t prevLimit = fFontCacheLimit;
     fFontCacheLimit = newLimit;
 
-    size_t currUsed = fTotalMemoryUsed;
-    if (currUsed > newLimit) {
-        SkAutoMutexAcquire    ac(fMutex);
-        SkGlyphCache::InternalFreeCache(this, currUsed - newLimit);
+    if (this->getTotalMemoryUsed() > newLimit) {
+        this->purgeDownTo(newLimit);
     }
     return prevLimit;
 }
 
 void SkGlyphCache_Globals::purgeAll() {
-    SkAutoMutexAcquire    ac(fMutex);
-    SkGlyphCache::InternalFreeCache(this, fTotalMemoryUsed);
+    this->purgeDownTo(0);
+}
+
+size_t SkGlyphCache_Globals::purgeDownTo(size_t targetBytes) {
+    SkAutoMutexAcquire  ap(fUseMutex ? &fPurgeMutex : NULL);
+
+    // Another thread may have purged while we waited for the lock.
+    size_t total = this->getTotalMemoryUsed();
+    if (total <= targetBytes) {
+        return 0;
+    }
+
+    // don't do any "small" purges
+    size_t bytesNeeded = total - targetBytes;
+    size_t minToPurge = total >> 2;
+    if (bytesNeeded < minToPurge) {
+        bytesNeeded = minToPurge;
+    }
+    size_t bytesFreed = 0;
+
+    int start = sk_atomic_inc(&fPurgeCursor);
+    // The first pass takes from each shard its share of bytesNeeded, so the
+    // least recently used strikes of every shard go first. The second pass
+    // makes up whatever is left (shards may have changed under us).
+    for (int pass = 0; pass < 2 && bytesFreed < bytesNeeded; pass++) {
+        for (int i = 0; i < kShardCount && bytesFreed < bytesNeeded; i++) {
+            Shard& shard = fShards[(start + i) & kShardMask];
+            SkAutoMutexAcquire  ac(this->mutex(&shard));
+
+            size_t quota = bytesNeeded - bytesFreed;
+            if (0 == pass) {
+                uint64_t share = (uint64_t)bytesNeeded * shard.fMemoryUsed;
+                share = (share + total - 1) / total;
+                if (share < quota) {
+                    quota = (size_t)share;
+                }
+            }
+            bytesFreed += this->purgeShard(&shard, quota);
+        }
+    }
+    return bytesFreed;
+}
+
+size_t SkGlyphCache_Globals::purgeShard(Shard* shard, size_t bytesNeeded) {
+    this->validate(*shard);
+
+    size_t  bytesFreed = 0;
+    int     count = 0;
+
+    SkGlyphCache* cache = SkGlyphCache::FindTail(shard->fHead);
+    while (cache != NULL && bytesFreed < bytesNeeded) {
+        SkGlyphCache* prev = cache->fPrev;
+        bytesFreed += cache->fMemoryUsed;
+
+        this->detachFromShard(shard, cache);
+        SkDELETE(cache);
+        cache = prev;
+        count += 1;
+    }
+
+    this->validate(*shard);
+
+#ifdef SPEW_PURGE_STATUS
+    if (count && !gSkSuppressFontCachePurgeSpew) {
+        SkDebugf("purging %dK from font cache [%d entries]\n",
+                 (int)(bytesFreed >> 10), count);
+    }
+#endif
+
+    return bytesFreed;
 }
 
 // Returns the shared globals
@@ -507,22 +620,23 @@ static SkGlyphCache_Globals& getGlobals() {
 void SkGlyphCache::VisitAllCaches(bool (*proc)(SkGlyphCache*, void*),
                                   void* context) {
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
-    SkGlyphCache*         cache;
 
-    globals.validate();
+    for (int i = 0; i < SkGlyphCache_Globals::kShardCount; i++) {
+        SkGlyphCache_Globals::Shard& shard = globals.shardAt(i);
+        SkAutoMutexAcquire    ac(globals.mutex(&shard));
+
+        globals.validate(shard);
 
-    for (cache = globals.fHead; cache != NULL; cache = cache->fNext) {
-        if (proc(cache, context)) {
-            break;
+        for (SkGlyphCache* cache = shard.fHead; cache != NULL; cache = cache->fNext) {
+            if (proc(cache, context)) {
+                return;
+            }
         }
     }
-
-    globals.validate();
 }
 
-/*  This guy calls the visitor from within the mutext lock, so the visitor
-    cannot:
+/*  This guy calls the visitor from within the shard's mutex lock, so the
+    visitor cannot:
     - take too much time
     - try to acquire the mutext again
     - call a fontscaler (which might call into the cache)
@@ -537,25 +651,16 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
     SkASSERT(desc);
 
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
+    SkGlyphCache_Globals::Shard& shard = globals.shardFor(desc);
+    SkAutoMutexAcquire    ac(globals.mutex(&shard));
     SkGlyphCache*         cache;
     bool                  insideMutex = true;
 
-    globals.validate();
-
-#ifdef USE_CACHE_HASH
-    SkGlyphCache** hash = globals.fHash;
-    unsigned index = desc_to_hashindex(desc);
-    cache = hash[index];
-    if (cache && *cache->fDesc == *desc) {
-        cache->detach(&globals.fHead);
-        goto FOUND_IT;
-    }
-#endif
+    globals.validate(shard);
 
-    for (cache = globals.fHead; cache != NULL; cache = cache->fNext) {
+    for (cache = shard.fHead; cache != NULL; cache = cache->fNext) {
         if (cache->fDesc->equals(*desc)) {
-            cache->detach(&globals.fHead);
+            globals.detachFromShard(&shard, cache);
             goto FOUND_IT;
         }
     }
@@ -564,7 +669,7 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
         side-effects like trying to access the cache/mutex (yikes!)
     */
     ac.release();           // release the mutex now
-    insideMutex = false;    // can't use globals anymore
+    insideMutex = false;    // can't use the shard anymore
 
     cache = SkNEW_ARGS(SkGlyphCache, (typeface, desc));
 
@@ -572,25 +677,15 @@ FOUND_IT:
 
     AutoValidate av(cache);
 
-    if (proc(cache, context)) {   // stay detached
-        if (insideMutex) {
-            SkASSERT(globals.fTotalMemoryUsed >= cache->fMemoryUsed);
-            globals.fTotalMemoryUsed -= cache->fMemoryUsed;
-#ifdef USE_CACHE_HASH
-            hash[index] = NULL;
-#endif
-        }
-    } else {                        // reattach
+    if (!proc(cache, context)) {    // reattach
         if (insideMutex) {
-            cache->attachToHead(&globals.fHead);
-#ifdef USE_CACHE_HASH
-            hash[index] = cache;
-#endif
+            globals.attachToShard(&shard, cache);
         } else {
             AttachCache(cache);
         }
         cache = NULL;
     }
+    // otherwise stay detached
     return cache;
 }
 
@@ -599,30 +694,27 @@ void SkGlyphCache::AttachCache(SkGlyphCache* cache) {
     SkASSERT(cache->fNext == NULL);
 
     SkGlyphCache_Globals& globals = getGlobals();
-    SkAutoMutexAcquire    ac(globals.fMutex);
 
-    globals.validate();
     cache->validate();
 
-    // if we have a fixed budget for our cache, do a purge here
+    // if we have a fixed budget for our cache, do a purge here, before the
+    // strike is back in a list where the purge could find it
     {
-        size_t allocated = globals.fTotalMemoryUsed + cache->fMemoryUsed;
+        size_t allocated = globals.getTotalMemoryUsed() + cache->fMemoryUsed;
         size_t budgeted = globals.getFontCacheLimit();
         if (allocated > budgeted) {
-            (void)InternalFreeCache(&globals, allocated - budgeted);
+            size_t target = budgeted > cache->fMemoryUsed ?
+                            budgeted - cache->fMemoryUsed : 0;
+            (void)globals.purgeDownTo(target);
         }
     }
 
-    cache->attachToHead(&globals.fHead);
-    globals.fTotalMemoryUsed += cache->fMemoryUsed;
-
-#ifdef USE_CACHE_HASH
-    unsigned index = desc_to_hashindex(cache->fDesc);
-    SkASSERT(globals.fHash[index] != cache);
-    globals.fHash[index] = cache;
-#endif
+    SkGlyphCache_Globals::Shard& shard = globals.shardFor(cache->fDesc);
+    SkAutoMutexAcquire    ac(globals.mutex(&shard));
 
-    globals.validate();
+    globals.validate(shard);
+    globals.attachToShard(&shard, cache);
+    globals.validate(shard);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -637,66 +729,22 @@ SkGlyphCache* SkGlyphCache::FindTail(SkGlyphCache* cache) {
 }
 
 #ifdef SK_DEBUG
-void SkGlyphCache_Globals::validate() const {
+void SkGlyphCache_Globals::validate(const Shard& shard) const {
     size_t computed = 0;
 
-    const SkGlyphCache* head = fHead;
+    const SkGlyphCache* head = shard.fHead;
     while (head != NULL) {
         computed += head->fMemoryUsed;
         head = head->fNext;
     }
 
-    if (fTotalMemoryUsed != computed) {
-        printf("total %d, computed %d\n", (int)fTotalMemoryUsed, (int)computed);
+    if (shard.fMemoryUsed != computed) {
+        printf("total %d, computed %d\n", (int)shard.fMemoryUsed, (int)computed);
     }
-    SkASSERT(fTotalMemoryUsed == computed);
+    SkASSERT(shard.fMemoryUsed == computed);
 }
 #endif
 
-size_t SkGlyphCache::InternalFreeCache(SkGlyphCache_Globals* globals,
-                                       size_t bytesNeeded) {
-    globals->validate();
-
-    size_t  bytesFreed = 0;
-    int     count = 0;
-
-    // don't do any "small" purges
-    size_t minToPurge = globals->fTotalMemoryUsed >> 2;
-    if (bytesNeeded < minToPurge)
-        bytesNeeded = minToPurge;
-
-    SkGlyphCache* cache = FindTail(globals->fHead);
-    while (cache != NULL && bytesFreed < bytesNeeded) {
-        SkGlyphCache* prev = cache->fPrev;
-        bytesFreed += cache->fMemoryUsed;
-
-#ifdef USE_CACHE_HASH
-        unsigned index = desc_to_hashindex(cache->fDesc);
-        if (cache == globals->fHash[index]) {
-            globals->fHash[index] = NULL;
-        }
-#endif
-
-        cache->detach(&globals->fHead);
-        SkDELETE(cache);
-        cache = prev;
-        count += 1;
-    }
-
-    SkASSERT(bytesFreed <= globals->fTotalMemoryUsed);
-    globals->fTotalMemoryUsed -= bytesFreed;
-    globals->validate();
-
-#ifdef SPEW_PURGE_STATUS
-    if (count && !gSkSuppressFontCachePurgeSpew) {
-        SkDebugf("purging %dK from font cache [%d entries]\n",
-                 (int)(bytesFreed >> 10), count);
-    }
-#endif
-
-    return bytesFreed;
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifdef SK_DEBUG
@@ -729,7 +777,7 @@ size_t SkGraphics::SetFontCacheLimit(size_t bytes) {
 }
 
 size_t SkGraphics::GetFontCacheUsed() {
-    return getSharedGlobals().fTotalMemoryUsed;
+    return getSharedGlobals().getTotalMemoryUsed();
 }
 
 void SkGraphics::PurgeFontCache() {
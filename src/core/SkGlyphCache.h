@@ -31,8 +31,11 @@ class SkGlyphCache_Globals;
     either instantly if it is already cahced, or by first generating it and then
     adding it to the strike.
 
-    The strikes are held in a global list, available to all threads. To interact
-    with one, call either VisitCache() or DetachCache().
+    The strikes are held in global lists, available to all threads. To interact
+    with one, call either VisitCache() or DetachCache(). The lists are sharded
+    by descriptor, each shard with its own lock, so threads working with
+    different strikes don't contend. A detached strike belongs to the calling
+    thread alone, so reading its glyphs, images and paths takes no lock at all.
 */
 class SkGlyphCache {
 public:
@@ -127,7 +130,7 @@ public:
 
     /** Call proc on all cache entries, stopping early if proc returns true.
         The proc should not create or delete caches, since it could produce
-        deadlock.
+        deadlock. Each shard is locked only while its entries are visited.
     */
     static void VisitAllCaches(bool (*proc)(SkGlyphCache*, void*), void* ctx);
 
@@ -263,9 +266,6 @@ private:
     AuxProcRec* fAuxProcList;
     void invokeAndRemoveAuxProcs();
 
-    // This relies on the caller to have already acquired the mutex to access the global cache
-    static size_t InternalFreeCache(SkGlyphCache_Globals*, size_t bytesNeeded);
-
     inline static SkGlyphCache* FindTail(SkGlyphCache* head);
 
     friend class SkGlyphCache_Globals;
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradientCache.h"
+#include "SkGraphics.h"
+#include "SkMallocPixelRef.h"
+#include "SkTKeyedLRUCache.h"
+
+#include <new>
+
+#ifndef SK_DEFAULT_GRADIENT_CACHE_LIMIT
+    #define SK_DEFAULT_GRADIENT_CACHE_LIMIT     (256 * 1024)
+#endif
+
+namespace {
+
+/**
+ *  One cached table. The entry and its key share one allocation, laid out in
+ *  that order; the entry holds a reference on the table.
+ */
+class Entry {
+public:
+    static Entry* Create(const uint32_t key[], int keyCount, SkMallocPixelRef* table) {
+        size_t size = sizeof(Entry) + keyCount * sizeof(uint32_t);
+        Entry* entry = SkNEW_PLACEMENT(sk_malloc_throw(size), Entry);
+        entry->fKeyCount = keyCount;
+        entry->fTable = SkRef(table);
+        entry->fSize = size + table->getSize();
+        memcpy(entry->key(), key, keyCount * sizeof(uint32_t));
+        return entry;
+    }
+
+    static void Destroy(Entry* entry) {
+        entry->fTable->unref();
+        entry->~Entry();
+        sk_free(entry);
+    }
+
+    const uint32_t* key() const { return (const uint32_t*)(this + 1); }
+    uint32_t* key() { return (uint32_t*)(this + 1); }
+    int keyCount() const { return fKeyCount; }
+
+    void get(SkMallocPixelRef** table) const {
+        *table = SkRef(fTable);
+    }
+
+    uint32_t            fHash;
+    size_t              fSize;
+    Entry*              fNextInBucket;
+
+private:
+    int                 fKeyCount;
+    SkMallocPixelRef*   fTable;
+
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+};
+
+}  // namespace
+
+typedef SkTKeyedLRUCache<Entry> SkGradientCache_Globals;
+
+static SkGradientCache_Globals& getGlobals() {
+    // we leak this, so we don't incur any shutdown cost of the destructor
+    static SkGradientCache_Globals* gGlobals =
+            SkNEW_ARGS(SkGradientCache_Globals, (SK_DEFAULT_GRADIENT_CACHE_LIMIT));
+    return *gGlobals;
+}
+
+SkMallocPixelRef* SkGradientCache::Find(const uint32_t key[], int keyCount) {
+    SkMallocPixelRef* table;
+    return getGlobals().find(key, keyCount, &table) ? table : NULL;
+}
+
+void SkGradientCache::Add(const uint32_t key[], int keyCount, SkMallocPixelRef* table) {
+    SkASSERT(NULL != table && table->isImmutable());
+    getGlobals().add(Entry::Create(key, keyCount, table));
+}
+
+size_t SkGradientCache::GetByteLimit() {
+    return getGlobals().getByteLimit();
+}
+
+size_t SkGradientCache::SetByteLimit(size_t bytes) {
+    return getGlobals().setByteLimit(bytes);
+}
+
+size_t SkGradientCache::GetBytesUsed() {
+    return getGlobals().getBytesUsed();
+}
+
+void SkGradientCache::Purge() {
+    getGlobals().purge();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetGradientCacheLimit() {
+    return SkGradientCache::GetByteLimit();
+}
+
+size_t SkGraphics::SetGradientCacheLimit(size_t bytes) {
+    return SkGradientCache::SetByteLimit(bytes);
+}
+
+size_t SkGraphics::GetGradientCacheUsed() {
+    return SkGradientCache::GetBytesUsed();
+}
+
+void SkGraphics::PurgeGradientCache() {
+    SkGradientCache::Purge();
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradientCache_DEFINED
+#define SkGradientCache_DEFINED
+
+#include "SkTypes.h"
+
+class SkMallocPixelRef;
+
+/**
+ *  A process-wide, thread-safe cache of gradient lookup tables, so that
+ *  gradient shaders with the same colors and positions (e.g. one per button
+ *  of a UI, each made by its own paint) build their tables once and share
+ *  them.
+ *
+ *  Tables are looked up by an opaque key, which must capture everything the
+ *  table depends on, and start with a four-byte tag naming whoever built it
+ *  (see SkSetFourByteTag) so that keys of different kinds never collide. A
+ *  table must not change once it has been added, since any number of shaders
+ *  may be reading it.
+ *
+ *  The cache keeps the most recently used tables that fit in its byte budget
+ *  (see SkGraphics::SetGradientCacheLimit). A limit of 0 disables it.
+ */
+class SkGradientCache {
+public:
+    /**
+     *  Return the table that was added with this key, with a reference that
+     *  the caller must unref, or NULL if there is none.
+     *  @param key      keyCount words of key data
+     */
+    static SkMallocPixelRef* Find(const uint32_t key[], int keyCount);
+
+    /**
+     *  Add table under this key, replacing any existing entry for it. The
+     *  cache takes its own reference, and table must already be immutable.
+     *  Does nothing if the entry is larger than the budget.
+     */
+    static void Add(const uint32_t key[], int keyCount, SkMallocPixelRef* table);
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void Purge();
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradient_opts_DEFINED
+#define SkGradient_opts_DEFINED
+
+#include "SkShader.h"
+
+/** Span procs that the linear and radial gradients can call to shade a span
+    of 32bit pixels, rather than looking up one pixel at a time.
+
+    cache is the gradient's 32bit table: 256 colors, followed by the dithered
+    rows, each kDitherStride entries after the one before. toggle is the
+    offset of the row to use for dst[0]; each pixel after that uses
+    toggle ^ kDitherStride, then toggle again, and so on. The index into the
+    row is the 16.16 gradient position, tiled into [0, 0xFFFF], shifted right
+    by 8.
+*/
+class SkGradientSpanProcs {
+public:
+    enum {
+        // Must match SkGradientShaderBase::kDitherStride32.
+        kDitherStride = 256
+    };
+
+    /** The position of dst[i] is fx + i * dx. For clamp, the caller makes sure
+        that it stays within [0, 0xFFFF] for the whole span, as it does within
+        the middle of an SkClampRange. Gives exactly the scalar result.
+    */
+    typedef void (*LinearProc)(SkFixed fx, SkFixed dx, SkPMColor* SK_RESTRICT dst,
+                               const SkPMColor* SK_RESTRICT cache, int toggle, int count);
+
+    /** The position of dst[i] is the distance of (fx + i * dx, fy + i * dy)
+        from the origin. It is computed in float, so it can land on the next
+        table entry over from the scalar procs, which use fixed point or a
+        table of square roots.
+    */
+    typedef void (*RadialProc)(float fx, float dx, float fy, float dy,
+                               SkPMColor* SK_RESTRICT dst, const SkPMColor* SK_RESTRICT cache,
+                               int toggle, int count);
+
+    /** Return the platform's proc for the tile mode, or NULL if there is
+        none. These are implemented in src/opts for the CPU we're running on.
+    */
+    static LinearProc PlatformLinear(SkShader::TileMode);
+    static RadialProc PlatformRadial(SkShader::TileMode);
+};
+
+#endif
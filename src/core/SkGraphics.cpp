@@ -14,6 +14,7 @@
 #include "SkCanvas.h"
 #include "SkFloat.h"
 #include "SkGeometry.h"
+#include "SkImageFilterThreads.h"
 #include "SkMath.h"
 #include "SkMatrix.h"
 #include "SkPath.h"
@@ -128,20 +129,78 @@ void SkGraphics::Init() {
 
 void SkGraphics::Term() {
     PurgeFontCache();
+    PurgeBlurMaskCache();
+    PurgeImageFilterCache();
+    PurgePictureCache();
+    PurgeGradientCache();
+    PurgeImageFilterThreads();
     SkPaint::Term();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static int gImageFilterThreadCount = 1;
+
+int SkGraphics::GetImageFilterThreadCount() {
+    return gImageFilterThreadCount;
+}
+
+int SkGraphics::SetImageFilterThreadCount(int count) {
+    int prev = gImageFilterThreadCount;
+    gImageFilterThreadCount = SkMax32(count, 1);
+    if (gImageFilterThreadCount < prev) {
+        PurgeImageFilterThreads();
+    }
+    return prev;
+}
+
+void SkGraphics::PurgeImageFilterThreads() {
+    SkImageFilterThreads::Purge();
+}
+
+static bool gAnalyticAntiAlias = false;
+
+bool SkGraphics::GetAnalyticAntiAlias() {
+    return gAnalyticAntiAlias;
+}
+
+bool SkGraphics::SetAnalyticAntiAlias(bool analytic) {
+    bool prev = gAnalyticAntiAlias;
+    gAnalyticAntiAlias = analytic;
+    return prev;
+}
+
+static size_t set_analytic_aa(size_t analytic) {
+    return SkGraphics::SetAnalyticAntiAlias(0 != analytic);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 static const char kFontCacheLimitStr[] = "font-cache-limit";
 static const size_t kFontCacheLimitLen = sizeof(kFontCacheLimitStr) - 1;
+static const char kBlurMaskCacheLimitStr[] = "blur-mask-cache-limit";
+static const size_t kBlurMaskCacheLimitLen = sizeof(kBlurMaskCacheLimitStr) - 1;
+static const char kImageFilterCacheLimitStr[] = "image-filter-cache-limit";
+static const size_t kImageFilterCacheLimitLen = sizeof(kImageFilterCacheLimitStr) - 1;
+static const char kPictureCacheLimitStr[] = "picture-cache-limit";
+static const size_t kPictureCacheLimitLen = sizeof(kPictureCacheLimitStr) - 1;
+static const char kGradientCacheLimitStr[] = "gradient-cache-limit";
+static const size_t kGradientCacheLimitLen = sizeof(kGradientCacheLimitStr) - 1;
+static const char kAnalyticAAStr[] = "analytic-aa";
+static const size_t kAnalyticAALen = sizeof(kAnalyticAAStr) - 1;
 
 static const struct {
     const char* fStr;
     size_t fLen;
     size_t (*fFunc)(size_t);
 } gFlags[] = {
-    { kFontCacheLimitStr, kFontCacheLimitLen, SkGraphics::SetFontCacheLimit }
+    { kFontCacheLimitStr, kFontCacheLimitLen, SkGraphics::SetFontCacheLimit },
+    { kBlurMaskCacheLimitStr, kBlurMaskCacheLimitLen, SkGraphics::SetBlurMaskCacheLimit },
+    { kImageFilterCacheLimitStr, kImageFilterCacheLimitLen,
+      SkGraphics::SetImageFilterCacheLimit },
+    { kPictureCacheLimitStr, kPictureCacheLimitLen, SkGraphics::SetPictureCacheLimit },
+    { kGradientCacheLimitStr, kGradientCacheLimitLen, SkGraphics::SetGradientCacheLimit },
+    { kAnalyticAAStr, kAnalyticAALen, set_analytic_aa }
 };
 
 /* flags are of the form param; or param=value; */
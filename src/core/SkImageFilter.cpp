@@ -9,7 +9,9 @@
 
 #include "SkBitmap.h"
 #include "SkFlattenableBuffers.h"
+#include "SkImageFilterCache.h"
 #include "SkRect.h"
+#include "SkThread.h"
 #if SK_SUPPORT_GPU
 #include "GrContext.h"
 #include "GrTexture.h"
@@ -18,8 +20,20 @@
 
 SK_DEFINE_INST_COUNT(SkImageFilter)
 
+uint32_t SkImageFilter::NextUniqueID() {
+    static int32_t gUniqueID;
+
+    // never return 0;
+    uint32_t id;
+    do {
+        id = sk_atomic_inc(&gUniqueID) + 1;
+    } while (0 == id);
+    return id;
+}
+
 SkImageFilter::SkImageFilter(int inputCount, SkImageFilter** inputs)
-  : fInputCount(inputCount), fInputs(new SkImageFilter*[inputCount]) {
+  : fInputCount(inputCount), fInputs(new SkImageFilter*[inputCount])
+  , fUniqueID(NextUniqueID()) {
     for (int i = 0; i < inputCount; ++i) {
         fInputs[i] = inputs[i];
         SkSafeRef(fInputs[i]);
@@ -27,13 +41,13 @@ SkImageFilter::SkImageFilter(int inputCount, SkImageFilter** inputs)
 }
 
 SkImageFilter::SkImageFilter(SkImageFilter* input)
-  : fInputCount(1), fInputs(new SkImageFilter*[1]) {
+  : fInputCount(1), fInputs(new SkImageFilter*[1]), fUniqueID(NextUniqueID()) {
     fInputs[0] = input;
     SkSafeRef(fInputs[0]);
 }
 
 SkImageFilter::SkImageFilter(SkImageFilter* input1, SkImageFilter* input2)
-  : fInputCount(2), fInputs(new SkImageFilter*[2]) {
+  : fInputCount(2), fInputs(new SkImageFilter*[2]), fUniqueID(NextUniqueID()) {
     fInputs[0] = input1;
     fInputs[1] = input2;
     SkSafeRef(fInputs[0]);
@@ -48,7 +62,8 @@ SkImageFilter::~SkImageFilter() {
 }
 
 SkImageFilter::SkImageFilter(SkFlattenableReadBuffer& buffer)
-    : fInputCount(buffer.readInt()), fInputs(new SkImageFilter*[fInputCount]) {
+    : fInputCount(buffer.readInt()), fInputs(new SkImageFilter*[fInputCount])
+    , fUniqueID(NextUniqueID()) {
     for (int i = 0; i < fInputCount; i++) {
         if (buffer.readBool()) {
             fInputs[i] = static_cast<SkImageFilter*>(buffer.readFlattenable());
@@ -88,12 +103,61 @@ bool SkImageFilter::filterImage(Proxy* proxy, const SkBitmap& src,
                                 SkBitmap* result, SkIPoint* loc) {
     SkASSERT(result);
     SkASSERT(loc);
+    /*
+     *  Results computed on the CPU may be cached, so that a node which is
+     *  reached again (from another parent, or in a later draw of the same
+     *  source) isn't evaluated again.
+     */
+    SkImageFilterCache::Key key;
+    bool cacheable = !(proxy && proxy->canHandleImageFilter(this)) &&
+                     key.set(this, src, ctm);
+    if (cacheable && SkImageFilterCache::Find(key, result, loc)) {
+        return true;
+    }
+    const SkIPoint srcLoc = *loc;
+
     /*
      *  Give the proxy first shot at the filter. If it returns false, ask
      *  the filter to do it.
      */
-    return (proxy && proxy->filterImage(this, src, ctm, result, loc)) ||
-           this->onFilterImage(proxy, src, ctm, result, loc);
+    if (!(proxy && proxy->filterImage(this, src, ctm, result, loc)) &&
+        !this->onFilterImage(proxy, src, ctm, result, loc)) {
+        return false;
+    }
+    // A filter which passes its source through has nothing worth caching.
+    if (cacheable && result->pixelRef() != src.pixelRef()) {
+        SkImageFilterCache::Add(key, *result,
+                                SkIPoint::Make(loc->fX - srcLoc.fX, loc->fY - srcLoc.fY));
+    }
+    return true;
+}
+
+bool SkImageFilter::filterImage(Proxy* proxy, const SkBitmap& src, const SkMatrix& ctm,
+                                const SkIRect& clipBounds, SkBitmap* result, SkIPoint* loc) {
+    /*
+     *  Narrow src down to what reaches the clip. Texture-backed sources are
+     *  filtered whole, since taking a subset of a texture makes a copy.
+     */
+    SkIRect needed;
+    if (NULL == src.getTexture() && this->filterSourceBounds(clipBounds, ctm, &needed)) {
+        const SkIRect srcBounds = SkIRect::MakeXYWH(loc->fX, loc->fY,
+                                                    src.width(), src.height());
+        if (!needed.intersect(srcBounds)) {
+            return false;
+        }
+        SkIRect subsetBounds = needed;
+        subsetBounds.offset(-loc->fX, -loc->fY);
+        SkBitmap subset;
+        if (needed != srcBounds && src.extractSubset(&subset, subsetBounds)) {
+            SkIPoint subsetLoc = SkIPoint::Make(needed.fLeft, needed.fTop);
+            if (!this->filterImage(proxy, subset, ctm, result, &subsetLoc)) {
+                return false;
+            }
+            *loc = subsetLoc;
+            return true;
+        }
+    }
+    return this->filterImage(proxy, src, ctm, result, loc);
 }
 
 bool SkImageFilter::filterBounds(const SkIRect& src, const SkMatrix& ctm,
@@ -103,6 +167,26 @@ bool SkImageFilter::filterBounds(const SkIRect& src, const SkMatrix& ctm,
     return this->onFilterBounds(src, ctm, dst);
 }
 
+bool SkImageFilter::filterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                       SkIRect* src) {
+    SkASSERT(src);
+    return this->onFilterSourceBounds(dst, ctm, src);
+}
+
+bool SkImageFilter::getInputsSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                          SkIRect* src) {
+    SkIRect total = SkIRect::MakeEmpty();
+    for (int i = 0; i < fInputCount; ++i) {
+        SkIRect r = dst;
+        if (fInputs[i] && !fInputs[i]->filterSourceBounds(dst, ctm, &r)) {
+            return false;
+        }
+        total.join(r);
+    }
+    *src = 0 == fInputCount ? dst : total;
+    return true;
+}
+
 bool SkImageFilter::onFilterImage(Proxy*, const SkBitmap&, const SkMatrix&,
                                   SkBitmap*, SkIPoint*) {
     return false;
@@ -156,6 +240,10 @@ bool SkImageFilter::onFilterBounds(const SkIRect& src, const SkMatrix& ctm,
     return true;
 }
 
+bool SkImageFilter::onFilterSourceBounds(const SkIRect&, const SkMatrix&, SkIRect*) {
+    return false;
+}
+
 bool SkImageFilter::asNewEffect(GrEffectRef**, GrTexture*) const {
     return false;
 }
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkImageFilterCache.h"
+#include "SkBitmap.h"
+#include "SkFloatBits.h"
+#include "SkGraphics.h"
+#include "SkImageFilter.h"
+#include "SkMatrix.h"
+#include "SkTKeyedLRUCache.h"
+
+#ifndef SK_DEFAULT_IMAGE_FILTER_CACHE_LIMIT
+    #define SK_DEFAULT_IMAGE_FILTER_CACHE_LIMIT     0
+#endif
+
+bool SkImageFilterCache::Key::set(const SkImageFilter* filter, const SkBitmap& src,
+                                  const SkMatrix& ctm) {
+    if (NULL == src.pixelRef() || NULL != src.getTexture() ||
+        0 == SkImageFilterCache::GetByteLimit()) {
+        return false;
+    }
+    fWords[0] = filter->uniqueID();
+    fWords[1] = src.getGenerationID();
+    fWords[2] = (uint32_t)src.pixelRefOffset();
+    fWords[3] = src.config();
+    fWords[4] = src.width();
+    fWords[5] = src.height();
+    for (int i = 0; i < kMatrixCount; ++i) {
+        fWords[kWordCount - kMatrixCount + i] = SkFloat2Bits(SkScalarToFloat(ctm.get(i)));
+    }
+    return true;
+}
+
+namespace {
+
+// Where find() puts the cached result, and the offset it moves.
+struct Found {
+    SkBitmap*   fResult;
+    SkIPoint*   fOffset;
+};
+
+class Entry {
+public:
+    Entry(const SkImageFilterCache::Key& key, const SkBitmap& result, const SkIPoint& move)
+        : fSize(sizeof(Entry) + result.getSize())
+        , fKey(key)
+        , fResult(result)
+        , fMove(move) {
+    }
+
+    static void Destroy(Entry* entry) {
+        SkDELETE(entry);
+    }
+
+    const uint32_t* key() const { return fKey.fWords; }
+    int keyCount() const { return SkImageFilterCache::Key::kWordCount; }
+
+    void get(Found* found) const {
+        *found->fResult = fResult;
+        found->fOffset->fX += fMove.fX;
+        found->fOffset->fY += fMove.fY;
+    }
+
+    uint32_t                fHash;
+    size_t                  fSize;
+    Entry*                  fNextInBucket;
+
+private:
+    SkImageFilterCache::Key fKey;
+    SkBitmap                fResult;
+    SkIPoint                fMove;     // how far the filter moved the result from its source
+
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+};
+
+}  // namespace
+
+typedef SkTKeyedLRUCache<Entry> SkImageFilterCache_Globals;
+
+static SkImageFilterCache_Globals& getGlobals() {
+    // we leak this, so we don't incur any shutdown cost of the destructor
+    static SkImageFilterCache_Globals* gGlobals =
+            SkNEW_ARGS(SkImageFilterCache_Globals, (SK_DEFAULT_IMAGE_FILTER_CACHE_LIMIT));
+    return *gGlobals;
+}
+
+bool SkImageFilterCache::Find(const Key& key, SkBitmap* result, SkIPoint* offset) {
+    Found found = { result, offset };
+    return getGlobals().find(key.fWords, Key::kWordCount, &found);
+}
+
+void SkImageFilterCache::Add(const Key& key, const SkBitmap& result, const SkIPoint& move) {
+    if (NULL == result.pixelRef() || NULL != result.getTexture()) {
+        return;
+    }
+    getGlobals().add(SkNEW_ARGS(Entry, (key, result, move)));
+}
+
+size_t SkImageFilterCache::GetByteLimit() {
+    return getGlobals().getByteLimit();
+}
+
+size_t SkImageFilterCache::SetByteLimit(size_t bytes) {
+    return getGlobals().setByteLimit(bytes);
+}
+
+size_t SkImageFilterCache::GetBytesUsed() {
+    return getGlobals().getBytesUsed();
+}
+
+void SkImageFilterCache::Purge() {
+    getGlobals().purge();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetImageFilterCacheLimit() {
+    return SkImageFilterCache::GetByteLimit();
+}
+
+size_t SkGraphics::SetImageFilterCacheLimit(size_t bytes) {
+    return SkImageFilterCache::SetByteLimit(bytes);
+}
+
+size_t SkGraphics::GetImageFilterCacheUsed() {
+    return SkImageFilterCache::GetBytesUsed();
+}
+
+void SkGraphics::PurgeImageFilterCache() {
+    SkImageFilterCache::Purge();
+}
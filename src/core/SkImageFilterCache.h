@@ -0,0 +1,77 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkImageFilterCache_DEFINED
+#define SkImageFilterCache_DEFINED
+
+#include "SkPoint.h"
+
+class SkBitmap;
+class SkImageFilter;
+class SkMatrix;
+
+/**
+ *  A process-wide, thread-safe cache of image filter results, consulted by
+ *  SkImageFilter::filterImage(). Each node of a filter graph is cached on its
+ *  own, so a node that is reached more than once (a filter which is the input
+ *  of several others, or a graph drawn again with the same source) is only
+ *  evaluated once.
+ *
+ *  A result is identified by the filter's uniqueID(), the generation ID,
+ *  subset and size of the source bitmap, and the matrix. Filters only place
+ *  their result relative to where the source is, so the offset passed in is
+ *  not part of the key: a graph drawn somewhere else reuses its results, and
+ *  the cache returns how far each one moved from its source.
+ *
+ *  Results hold a ref on their pixels rather than a copy, so they must be
+ *  treated as read-only, which is how filters already treat their inputs.
+ *  Drawing into a bitmap through a canvas changes its generation ID, so such
+ *  sources miss; code which writes to a source's pixels directly must call
+ *  notifyPixelsChanged() before filtering it again.
+ *
+ *  The cache keeps the most recently used results that fit in its byte
+ *  budget (see SkGraphics::SetImageFilterCacheLimit). The default limit is
+ *  0, which disables it.
+ */
+class SkImageFilterCache {
+public:
+    struct Key {
+        /**
+         *  Fill in the key for filtering src, or return false if the result
+         *  should not be cached (the cache is off, or src is not a raster
+         *  bitmap).
+         */
+        bool set(const SkImageFilter*, const SkBitmap& src, const SkMatrix& ctm);
+
+        enum {
+            kMatrixCount = 9,
+            kWordCount = 6 + kMatrixCount,
+        };
+        uint32_t fWords[kWordCount];
+    };
+
+    /**
+     *  Look for the result added with this key. If found, result shares the
+     *  cached pixels and offset (the source's position on the way in) is
+     *  moved by the cached amount.
+     */
+    static bool Find(const Key&, SkBitmap* result, SkIPoint* offset);
+
+    /**
+     *  Add result under this key, with how far the filter moved it from its
+     *  source, replacing any existing entry. Does nothing if result is not a
+     *  raster bitmap, or larger than the budget.
+     */
+    static void Add(const Key&, const SkBitmap& result, const SkIPoint& move);
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void Purge();
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkImageFilterThreads.h"
+#include "SkGraphics.h"
+#include "SkRefCnt.h"
+#include "SkTaskScheduler.h"
+#include "SkThread.h"
+
+// Slices thinner than this cost more to hand out than they save.
+static const int kMinSliceSize = 16;
+static const int kMaxThreadCount = 32;
+
+namespace {
+
+class Pool : public SkRefCnt {
+public:
+    explicit Pool(int workerCount) : fScheduler(workerCount) {}
+
+    SkTaskScheduler* scheduler() { return &fScheduler; }
+
+private:
+    SkTaskScheduler fScheduler;
+
+    typedef SkRefCnt INHERITED;
+};
+
+struct Slices {
+    SkImageFilterThreads::SliceProc fProc;
+    void*                           fContext;
+    int                             fCount;
+    int                             fSliceCount;
+};
+
+}
+
+SK_DECLARE_STATIC_MUTEX(gPoolMutex);
+static Pool* gPool;
+
+// Returns a ref on a pool with at least workerCount threads. A pool which is
+// too small is replaced, and goes away once the filters using it finish.
+static Pool* ref_pool(int workerCount) {
+    SkAutoMutexAcquire lock(gPoolMutex);
+    if (NULL == gPool || gPool->scheduler()->countThreads() < workerCount) {
+        SkSafeUnref(gPool);
+        gPool = SkNEW_ARGS(Pool, (workerCount));
+    }
+    gPool->ref();
+    return gPool;
+}
+
+static void run_slice(Slices* slices, int index) {
+    int start = (int)(((int64_t)slices->fCount * index) / slices->fSliceCount);
+    int stop = (int)(((int64_t)slices->fCount * (index + 1)) / slices->fSliceCount);
+    slices->fProc(slices->fContext, start, stop);
+}
+
+void SkImageFilterThreads::Purge() {
+    Pool* pool;
+    {
+        SkAutoMutexAcquire lock(gPoolMutex);
+        pool = gPool;
+        gPool = NULL;
+    }
+    // Joins the threads, outside the lock, unless a filter still holds a ref.
+    SkSafeUnref(pool);
+}
+
+int SkImageFilterThreads::Resolve(int filterThreadCount) {
+    return filterThreadCount > 0 ? filterThreadCount : SkGraphics::GetImageFilterThreadCount();
+}
+
+void SkImageFilterThreads::Run(int threadCount, int count, SliceProc proc, void* context) {
+    threadCount = SkMin32(threadCount, kMaxThreadCount);
+    int sliceCount = SkMin32(threadCount, count / kMinSliceSize);
+    if (sliceCount <= 1) {
+        proc(context, 0, count);
+        return;
+    }
+
+    // The calling thread works through the slices too while it waits.
+    SkAutoTUnref<Pool> pool(ref_pool(sliceCount - 1));
+    Slices slices = { proc, context, count, sliceCount };
+    SkParallelFor(pool->scheduler(), sliceCount, run_slice, &slices);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkImageFilterThreads_DEFINED
+#define SkImageFilterThreads_DEFINED
+
+#include "SkTypes.h"
+
+/** Splits the passes of the raster image filters across a pool of worker
+    threads shared by every filter.
+
+    A pass is split into contiguous slices of rows (or columns), each written
+    by exactly one thread from pixels that no slice writes, so the result
+    does not depend on how many threads ran it.
+*/
+class SkImageFilterThreads {
+public:
+    /** Called with a range [start, stop) of the rows or columns of a pass. */
+    typedef void (*SliceProc)(void* context, int start, int stop);
+
+    /** Return the number of threads a filter should use, given its own
+        setting: 0 means SkGraphics::GetImageFilterThreadCount().
+    */
+    static int Resolve(int filterThreadCount);
+
+    /** Calls proc for slices covering [0, count), on up to threadCount
+        threads including the calling one, and returns once they have all
+        finished. With threadCount <= 1, or too little work to be worth
+        splitting, proc(context, 0, count) is called on this thread.
+    */
+    static void Run(int threadCount, int count, SliceProc proc, void* context);
+
+    /** Releases the worker threads. Filters that are running keep them until
+        they finish; the next filter to need threads starts new ones.
+    */
+    static void Purge();
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMaskCache.h"
+#include "SkGraphics.h"
+#include "SkTKeyedLRUCache.h"
+
+#include <new>
+
+#ifndef SK_DEFAULT_BLUR_MASK_CACHE_LIMIT
+    #define SK_DEFAULT_BLUR_MASK_CACHE_LIMIT    (2 * 1024 * 1024)
+#endif
+
+namespace {
+
+// Where find() puts a copy of the cached mask and its margin.
+struct Found {
+    SkMask*     fMask;
+    SkIPoint*   fMargin;
+};
+
+/**
+ *  One cached mask. The entry, its key and its image share one allocation,
+ *  laid out in that order.
+ */
+class Entry {
+public:
+    static Entry* Create(const uint32_t key[], int keyCount, const SkMask& mask,
+                         const SkIPoint& margin) {
+        size_t imageSize = mask.computeImageSize();
+        size_t size = AllocSize(keyCount, imageSize);
+        Entry* entry = SkNEW_PLACEMENT(sk_malloc_throw(size), Entry);
+        entry->fKeyCount = keyCount;
+        entry->fMask = mask;
+        entry->fMask.fImage = (uint8_t*)(entry->key() + keyCount);
+        entry->fMargin = margin;
+        entry->fSize = size;
+        memcpy(entry->key(), key, keyCount * sizeof(uint32_t));
+        memcpy(entry->fMask.fImage, mask.fImage, imageSize);
+        return entry;
+    }
+
+    static void Destroy(Entry* entry) {
+        entry->~Entry();
+        sk_free(entry);
+    }
+
+    static size_t AllocSize(int keyCount, size_t imageSize) {
+        return sizeof(Entry) + keyCount * sizeof(uint32_t) + imageSize;
+    }
+
+    const uint32_t* key() const { return (const uint32_t*)(this + 1); }
+    uint32_t* key() { return (uint32_t*)(this + 1); }
+    int keyCount() const { return fKeyCount; }
+
+    void get(Found* found) const {
+        size_t imageSize = fMask.computeImageSize();
+        *found->fMask = fMask;
+        found->fMask->fImage = SkMask::AllocImage(imageSize);
+        memcpy(found->fMask->fImage, fMask.fImage, imageSize);
+        *found->fMargin = fMargin;
+    }
+
+    uint32_t    fHash;
+    size_t      fSize;
+    Entry*      fNextInBucket;
+
+private:
+    int         fKeyCount;
+    SkMask      fMask;
+    SkIPoint    fMargin;
+
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+};
+
+}  // namespace
+
+typedef SkTKeyedLRUCache<Entry> SkMaskCache_Globals;
+
+static SkMaskCache_Globals& getGlobals() {
+    // we leak this, so we don't incur any shutdown cost of the destructor
+    static SkMaskCache_Globals* gGlobals =
+            SkNEW_ARGS(SkMaskCache_Globals, (SK_DEFAULT_BLUR_MASK_CACHE_LIMIT));
+    return *gGlobals;
+}
+
+bool SkMaskCache::Find(const uint32_t key[], int keyCount, SkMask* mask, SkIPoint* margin) {
+    Found found = { mask, margin };
+    return getGlobals().find(key, keyCount, &found);
+}
+
+void SkMaskCache::Add(const uint32_t key[], int keyCount, const SkMask& mask,
+                      const SkIPoint& margin) {
+    SkASSERT(NULL != mask.fImage);
+    // Don't copy a mask the cache would only throw away.
+    SkMaskCache_Globals& globals = getGlobals();
+    if (Entry::AllocSize(keyCount, mask.computeImageSize()) > globals.getByteLimit()) {
+        return;
+    }
+    globals.add(Entry::Create(key, keyCount, mask, margin));
+}
+
+size_t SkMaskCache::GetByteLimit() {
+    return getGlobals().getByteLimit();
+}
+
+size_t SkMaskCache::SetByteLimit(size_t bytes) {
+    return getGlobals().setByteLimit(bytes);
+}
+
+size_t SkMaskCache::GetBytesUsed() {
+    return getGlobals().getBytesUsed();
+}
+
+void SkMaskCache::Purge() {
+    getGlobals().purge();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetBlurMaskCacheLimit() {
+    return SkMaskCache::GetByteLimit();
+}
+
+size_t SkGraphics::SetBlurMaskCacheLimit(size_t bytes) {
+    return SkMaskCache::SetByteLimit(bytes);
+}
+
+size_t SkGraphics::GetBlurMaskCacheUsed() {
+    return SkMaskCache::GetBytesUsed();
+}
+
+void SkGraphics::PurgeBlurMaskCache() {
+    SkMaskCache::Purge();
+}
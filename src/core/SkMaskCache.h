@@ -0,0 +1,53 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMaskCache_DEFINED
+#define SkMaskCache_DEFINED
+
+#include "SkMask.h"
+#include "SkPoint.h"
+
+/**
+ *  A process-wide, thread-safe cache of mask filter results, so that drawing
+ *  the same shape with the same filter over and over (e.g. a blurred shadow
+ *  behind every button of a UI) becomes a copy and a blit.
+ *
+ *  Entries are looked up by an opaque key, which must capture everything the
+ *  result depends on, and start with a four-byte tag naming whoever built it
+ *  (see SkSetFourByteTag) so that keys of different kinds never collide.
+ *  Keys should be relative to the integer device translation, so that a shape
+ *  hits the cache wherever it is drawn; the caller offsets the returned bounds
+ *  back into place.
+ *
+ *  The cache keeps the most recently used entries that fit in its byte
+ *  budget (see SkGraphics::SetBlurMaskCacheLimit). A limit of 0 disables it.
+ */
+class SkMaskCache {
+public:
+    /**
+     *  Look for the mask that was added with this key. If found, mask is set
+     *  to a copy of it, whose fImage the caller must free with
+     *  SkMask::FreeImage(), and margin to the margin it was added with.
+     *  @param key      keyCount words of key data
+     */
+    static bool Find(const uint32_t key[], int keyCount, SkMask* mask, SkIPoint* margin);
+
+    /**
+     *  Add a copy of mask, and margin, under this key, replacing any existing
+     *  entry for it. Does nothing if the entry is larger than the budget.
+     *  mask must have an image.
+     */
+    static void Add(const uint32_t key[], int keyCount, const SkMask& mask,
+                    const SkIPoint& margin);
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void Purge();
+};
+
+#endif
@@ -11,6 +11,8 @@
 #include "SkBlitter.h"
 #include "SkBounder.h"
 #include "SkDraw.h"
+#include "SkFloatBits.h"
+#include "SkMaskCache.h"
 #include "SkRasterClip.h"
 
 
@@ -221,17 +223,32 @@ bool SkMaskFilter::filterPath(const SkPath& devPath, const SkMatrix& matrix,
         }
     }
 
-    SkMask  srcM, dstM;
-
-    if (!SkDraw::DrawToMask(devPath, &clip.getBounds(), this, &matrix, &srcM,
-                            SkMask::kComputeBoundsAndRenderImage_CreateMode,
-                            style)) {
-        return false;
-    }
-    SkAutoMaskFreeImage autoSrc(srcM.fImage);
+    SkMask  dstM;
+    SkTDArray<uint32_t> key;
+    SkIPoint origin;
+    bool cacheable = this->makePathCacheKey(devPath, matrix, clip.getBounds(), style,
+                                            &key, &origin);
+    SkIPoint margin;
+    if (cacheable && SkMaskCache::Find(key.begin(), key.count(), &dstM, &margin)) {
+        dstM.fBounds.offset(origin.fX, origin.fY);
+    } else {
+        SkMask  srcM;
+        if (!SkDraw::DrawToMask(devPath, &clip.getBounds(), this, &matrix, &srcM,
+                                SkMask::kComputeBoundsAndRenderImage_CreateMode,
+                                style)) {
+            return false;
+        }
+        SkAutoMaskFreeImage autoSrc(srcM.fImage);
 
-    if (!this->filterMask(&dstM, srcM, matrix, NULL)) {
-        return false;
+        if (!this->filterMask(&dstM, srcM, matrix, &margin)) {
+            return false;
+        }
+        if (cacheable && NULL != dstM.fImage) {
+            SkASSERT(srcM.fBounds.fLeft == origin.fX && srcM.fBounds.fTop == origin.fY);
+            SkMask relative = dstM;
+            relative.fBounds.offset(-origin.fX, -origin.fY);
+            SkMaskCache::Add(key.begin(), key.count(), relative, margin);
+        }
     }
     SkAutoMaskFreeImage autoDst(dstM.fImage);
 
@@ -258,6 +275,91 @@ SkMaskFilter::filterRectsToNine(const SkRect[], int count, const SkMatrix&,
     return kUnimplemented_FilterReturn;
 }
 
+bool SkMaskFilter::asCacheKey(const SkMatrix&, SkTDArray<uint32_t>*) const {
+    return false;
+}
+
+/*  Filtered paths are cached by their geometry, relative to the device
+    position of the mask they are drawn into. That position is always a whole
+    pixel, so a path hits the cache wherever it is drawn, as long as only the
+    integer part of its position changes.
+
+    We only cache when it is safe to: the filter has a key, the mask was not
+    trimmed by the clip, and every point is exactly origin + offset, so that
+    rasterizing at the origin sees the same offsets that are in the key.
+*/
+bool SkMaskFilter::makePathCacheKey(const SkPath& devPath, const SkMatrix& matrix,
+                                    const SkIRect& clipBounds, SkPaint::Style style,
+                                    SkTDArray<uint32_t>* key, SkIPoint* origin) const {
+    if (0 == SkMaskCache::GetByteLimit()) {
+        return false;
+    }
+    key->append()[0] = SkSetFourByteTag('p', 'a', 't', 'h');
+    if (!this->asCacheKey(matrix, key)) {
+        return false;
+    }
+
+    // The unfiltered mask's bounds, as SkDraw::DrawToMask computes them before
+    // trimming them to the clip.
+    if (devPath.isEmpty()) {
+        return false;
+    }
+    SkRect pathBounds = devPath.getBounds();
+    pathBounds.outset(SK_ScalarHalf, SK_ScalarHalf);
+    SkMask srcM, dstM;
+    pathBounds.roundOut(&srcM.fBounds);
+    srcM.fFormat = SkMask::kA8_Format;
+    srcM.fImage = NULL;
+    srcM.fRowBytes = 0;
+
+    // DrawToMask trims the mask to the clip plus the filter's margin (but no
+    // more than kMaxClipMargin, as in SkDraw.cpp); a trimmed mask is not
+    // cacheable. Without an image, filterMask() only computes the margin.
+    static const int kMaxClipMargin = 128;
+    SkIPoint margin;
+    if (!this->filterMask(&dstM, srcM, matrix, &margin)) {
+        return false;
+    }
+    SkIRect slop = clipBounds;
+    slop.inset(-SkMin32(margin.fX, kMaxClipMargin), -SkMin32(margin.fY, kMaxClipMargin));
+    if (!slop.contains(srcM.fBounds)) {
+        return false;
+    }
+    origin->set(srcM.fBounds.fLeft, srcM.fBounds.fTop);
+
+    const int verbCount = devPath.countVerbs();
+    const int pointCount = devPath.countPoints();
+    if (0 == verbCount) {
+        return false;
+    }
+    uint32_t* header = key->append(4);
+    header[0] = style;
+    header[1] = devPath.getFillType();
+    header[2] = verbCount;
+    header[3] = pointCount;
+
+    const int verbWords = SkAlign4(verbCount) >> 2;
+    uint32_t* verbs = key->append(verbWords);
+    verbs[verbWords - 1] = 0;   // zero the padding
+    devPath.getVerbs((uint8_t*)verbs, verbCount);
+
+    SkAutoSTMalloc<32, SkPoint> points(pointCount);
+    devPath.getPoints(points.get(), pointCount);
+    const SkScalar ox = SkIntToScalar(origin->fX);
+    const SkScalar oy = SkIntToScalar(origin->fY);
+    uint32_t* coords = key->append(2 * pointCount);
+    for (int i = 0; i < pointCount; ++i) {
+        SkScalar x = points[i].fX - ox;
+        SkScalar y = points[i].fY - oy;
+        if (x + ox != points[i].fX || y + oy != points[i].fY) {
+            return false;
+        }
+        coords[2 * i] = SkFloat2Bits(SkScalarToFloat(x));
+        coords[2 * i + 1] = SkFloat2Bits(SkScalarToFloat(y));
+    }
+    return true;
+}
+
 SkMaskFilter::BlurType SkMaskFilter::asABlur(BlurInfo*) const {
     return kNone_BlurType;
 }
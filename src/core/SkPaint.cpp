@@ -249,7 +249,40 @@ void SkPaint::setDevKernText(bool doDevKern) {
 }
 
 void SkPaint::setFilterBitmap(bool doFilter) {
-    this->setFlags(SkSetClearMask(fFlags, doFilter, kFilterBitmap_Flag));
+    this->setFilterLevel(doFilter ? kLow_FilterLevel : kNone_FilterLevel);
+}
+
+static const uint32_t kFilterLevelFlags = SkPaint::kFilterBitmap_Flag |
+                                          SkPaint::kMediumQualityFilterBitmap_Flag |
+                                          SkPaint::kHighQualityFilterBitmap_Flag;
+
+SkPaint::FilterLevel SkPaint::getFilterLevel() const {
+    if (!(fFlags & kFilterBitmap_Flag)) {
+        return kNone_FilterLevel;
+    }
+    if (fFlags & kHighQualityFilterBitmap_Flag) {
+        return kHigh_FilterLevel;
+    }
+    if (fFlags & kMediumQualityFilterBitmap_Flag) {
+        return kMedium_FilterLevel;
+    }
+    return kLow_FilterLevel;
+}
+
+void SkPaint::setFilterLevel(FilterLevel level) {
+    static const uint32_t gLevelFlags[] = {
+        0,
+        kFilterBitmap_Flag,
+        kFilterBitmap_Flag | kMediumQualityFilterBitmap_Flag,
+        kFilterBitmap_Flag | kHighQualityFilterBitmap_Flag,
+    };
+    if ((unsigned)level < SK_ARRAY_COUNT(gLevelFlags)) {
+        this->setFlags((fFlags & ~kFilterLevelFlags) | gLevelFlags[level]);
+    } else {
+#ifdef SK_REPORT_API_RANGE_CHECK
+        SkDebugf("SkPaint::setFilterLevel(%d) out of range\n", level);
+#endif
+    }
 }
 
 void SkPaint::setStyle(Style style) {
@@ -2350,6 +2383,10 @@ void SkPaint::toString(SkString* str) const {
         bool needSeparator = false;
         SkAddFlagToString(str, this->isAntiAlias(), "AntiAlias", &needSeparator);
         SkAddFlagToString(str, this->isFilterBitmap(), "FilterBitmap", &needSeparator);
+        SkAddFlagToString(str, kMedium_FilterLevel == this->getFilterLevel(),
+                          "MediumQualityFilterBitmap", &needSeparator);
+        SkAddFlagToString(str, kHigh_FilterLevel == this->getFilterLevel(),
+                          "HighQualityFilterBitmap", &needSeparator);
         SkAddFlagToString(str, this->isDither(), "Dither", &needSeparator);
         SkAddFlagToString(str, this->isUnderlineText(), "UnderlineText", &needSeparator);
         SkAddFlagToString(str, this->isStrikeThruText(), "StrikeThruText", &needSeparator);
@@ -36,6 +36,11 @@ public:
         return *fPaths[index];
     }
 
+    // called when a picture decodes its paths on first use
+    SkPath* writablePath(int index) {
+        return fPaths[index];
+    }
+
     void flatten(SkFlattenableWriteBuffer&) const;
 
 private:
@@ -253,6 +253,10 @@ void SkPicture::endRecording() {
     SkASSERT(NULL == fRecord);
 }
 
+uint32_t SkPicture::uniqueID() const {
+    return NULL != fPlayback ? fPlayback->uniqueID() : 0;
+}
+
 void SkPicture::draw(SkCanvas* surface) {
     this->endRecording();
     if (fPlayback) {
@@ -272,7 +276,23 @@ SkPicture::SkPicture(SkStream* stream, bool* success, InstallPixelRefProc proc)
     this->initFromStream(stream, success, proc);
 }
 
-void SkPicture::initFromStream(SkStream* stream, bool* success, InstallPixelRefProc proc) {
+SkPicture* SkPicture::CreateFromData(SkData* data, InstallPixelRefProc proc) {
+    if (NULL == data) {
+        return NULL;
+    }
+    SkMemoryStream stream(data);
+    bool success;
+    SkPicture* picture = SkNEW(SkPicture);
+    picture->initFromStream(&stream, &success, proc, &stream);
+    if (!success) {
+        picture->unref();
+        return NULL;
+    }
+    return picture;
+}
+
+void SkPicture::initFromStream(SkStream* stream, bool* success, InstallPixelRefProc proc,
+                               SkMemoryStream* backing) {
     if (success) {
         *success = false;
     }
@@ -282,15 +302,28 @@ void SkPicture::initFromStream(SkStream* stream, bool* success, InstallPixelRefP
 
     SkPictInfo info;
 
-    if (!stream->read(&info, sizeof(info))) {
+    if (sizeof(info) != stream->read(&info, sizeof(info))) {
         return;
     }
-    if (PICTURE_VERSION != info.fVersion) {
+    bool hasPlayback;
+    if (IN_PLACE_PICTURE_VERSION == info.fVersion) {
+        hasPlayback = 0 != stream->readU32();
+    } else if (PICTURE_VERSION == info.fVersion) {
+        // Only the in-place format can be shared.
+        backing = NULL;
+        hasPlayback = stream->readBool();
+    } else {
         return;
     }
 
-    if (stream->readBool()) {
-        fPlayback = SkNEW_ARGS(SkPicturePlayback, (stream, info, proc));
+    if (hasPlayback) {
+        bool isValid;
+        fPlayback = SkNEW_ARGS(SkPicturePlayback, (stream, info, &isValid, proc, backing));
+        if (!isValid) {
+            SkDELETE(fPlayback);
+            fPlayback = NULL;
+            return;
+        }
     }
 
     // do this at the end, so that they will be zero if we hit an error.
@@ -302,6 +335,14 @@ void SkPicture::initFromStream(SkStream* stream, bool* success, InstallPixelRefP
 }
 
 void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
+    this->serialize(stream, encoder, false);
+}
+
+void SkPicture::serializeForInPlacePlayback(SkWStream* stream, EncodeBitmap encoder) const {
+    this->serialize(stream, encoder, true);
+}
+
+void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder, bool inPlace) const {
     SkPicturePlayback* playback = fPlayback;
 
     if (NULL == playback && fRecord) {
@@ -310,7 +351,7 @@ void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
 
     SkPictInfo info;
 
-    info.fVersion = PICTURE_VERSION;
+    info.fVersion = inPlace ? IN_PLACE_PICTURE_VERSION : PICTURE_VERSION;
     info.fWidth = fWidth;
     info.fHeight = fHeight;
     info.fFlags = SkPictInfo::kCrossProcess_Flag;
@@ -322,15 +363,17 @@ void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
     }
 
     stream->write(&info, sizeof(info));
+    if (inPlace) {
+        stream->write32(NULL != playback);
+    } else {
+        stream->writeBool(NULL != playback);
+    }
     if (playback) {
-        stream->writeBool(true);
-        playback->serialize(stream, encoder);
+        playback->serialize(stream, encoder, inPlace);
         // delete playback if it is a local version (i.e. cons'd up just now)
         if (playback != fPlayback) {
             SkDELETE(playback);
         }
-    } else {
-        stream->writeBool(false);
     }
 }
 
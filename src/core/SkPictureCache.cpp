@@ -0,0 +1,147 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureCache.h"
+#include "SkBitmap.h"
+#include "SkFloatBits.h"
+#include "SkGraphics.h"
+#include "SkMatrix.h"
+#include "SkPicture.h"
+#include "SkTKeyedLRUCache.h"
+
+#ifndef SK_DEFAULT_PICTURE_CACHE_LIMIT
+    #define SK_DEFAULT_PICTURE_CACHE_LIMIT  0
+#endif
+
+bool SkPictureCache::Key::set(const SkPicture& picture, const SkMatrix& matrix,
+                              SkIPoint* translate) {
+    if (matrix.hasPerspective()) {
+        return false;
+    }
+    SkScalar tx = matrix.getTranslateX();
+    SkScalar ty = matrix.getTranslateY();
+    translate->set(SkScalarFloorToInt(tx), SkScalarFloorToInt(ty));
+
+    fWords[0] = picture.uniqueID();
+    fWords[1] = picture.width();
+    fWords[2] = picture.height();
+    fWords[3] = SkFloat2Bits(SkScalarToFloat(matrix.getScaleX()));
+    fWords[4] = SkFloat2Bits(SkScalarToFloat(matrix.getSkewX()));
+    fWords[5] = SkFloat2Bits(SkScalarToFloat(matrix.getSkewY()));
+    fWords[6] = SkFloat2Bits(SkScalarToFloat(matrix.getScaleY()));
+    // Only the fractional part of the translation changes the raster.
+    fWords[7] = SkFloat2Bits(SkScalarToFloat(tx - SkIntToScalar(translate->fX)));
+    fWords[8] = SkFloat2Bits(SkScalarToFloat(ty - SkIntToScalar(translate->fY)));
+    return true;
+}
+
+namespace {
+
+// Where find() puts the cached raster and its offset.
+struct Found {
+    SkBitmap*   fRaster;
+    SkIPoint*   fOffset;
+};
+
+class Entry {
+public:
+    Entry(const SkPictureCache::Key& key, const SkBitmap& raster, const SkIPoint& offset)
+        : fSize(sizeof(Entry) + raster.getSize())
+        , fKey(key)
+        , fRaster(raster)
+        , fOffset(offset) {
+    }
+
+    static void Destroy(Entry* entry) {
+        SkDELETE(entry);
+    }
+
+    const uint32_t* key() const { return fKey.fWords; }
+    int keyCount() const { return SkPictureCache::Key::kWordCount; }
+
+    void get(Found* found) const {
+        *found->fRaster = fRaster;
+        *found->fOffset = fOffset;
+    }
+
+    uint32_t            fHash;
+    size_t              fSize;
+    Entry*              fNextInBucket;
+
+private:
+    SkPictureCache::Key fKey;
+    SkBitmap            fRaster;
+    SkIPoint            fOffset;
+
+    SK_DECLARE_INTERNAL_LLIST_INTERFACE(Entry);
+};
+
+}  // namespace
+
+typedef SkTKeyedLRUCache<Entry> SkPictureCache_Globals;
+
+static SkPictureCache_Globals& getGlobals() {
+    // we leak this, so we don't incur any shutdown cost of the destructor
+    static SkPictureCache_Globals* gGlobals =
+            SkNEW_ARGS(SkPictureCache_Globals, (SK_DEFAULT_PICTURE_CACHE_LIMIT));
+    return *gGlobals;
+}
+
+// Mirrors whether the byte limit is not 0, so that IsEnabled() need not take
+// the mutex. Only written by SetByteLimit().
+static int32_t gEnabled = 0 != SK_DEFAULT_PICTURE_CACHE_LIMIT;
+
+bool SkPictureCache::IsEnabled() {
+    return 0 != gEnabled;
+}
+
+bool SkPictureCache::Find(const Key& key, SkBitmap* raster, SkIPoint* offset) {
+    Found found = { raster, offset };
+    return getGlobals().find(key.fWords, Key::kWordCount, &found);
+}
+
+void SkPictureCache::Add(const Key& key, const SkBitmap& raster, const SkIPoint& offset) {
+    if (NULL == raster.pixelRef()) {
+        return;
+    }
+    getGlobals().add(SkNEW_ARGS(Entry, (key, raster, offset)));
+}
+
+size_t SkPictureCache::GetByteLimit() {
+    return getGlobals().getByteLimit();
+}
+
+size_t SkPictureCache::SetByteLimit(size_t bytes) {
+    gEnabled = 0 != bytes;
+    return getGlobals().setByteLimit(bytes);
+}
+
+size_t SkPictureCache::GetBytesUsed() {
+    return getGlobals().getBytesUsed();
+}
+
+void SkPictureCache::Purge() {
+    getGlobals().purge();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetPictureCacheLimit() {
+    return SkPictureCache::GetByteLimit();
+}
+
+size_t SkGraphics::SetPictureCacheLimit(size_t bytes) {
+    return SkPictureCache::SetByteLimit(bytes);
+}
+
+size_t SkGraphics::GetPictureCacheUsed() {
+    return SkPictureCache::GetBytesUsed();
+}
+
+void SkGraphics::PurgePictureCache() {
+    SkPictureCache::Purge();
+}
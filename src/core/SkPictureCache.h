@@ -0,0 +1,74 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureCache_DEFINED
+#define SkPictureCache_DEFINED
+
+#include "SkPoint.h"
+
+class SkBitmap;
+class SkMatrix;
+class SkPicture;
+
+/**
+ *  A process-wide, thread-safe cache of rasterized pictures, consulted when a
+ *  picture nested inside another one is played back into a raster canvas. A
+ *  picture which is drawn many times at the same scale (an icon, a piece of
+ *  window chrome) is only played back once, and then blitted.
+ *
+ *  A raster is identified by the picture's uniqueID() and size, and by the
+ *  matrix it is drawn with, except for the integer part of its translation,
+ *  so that the raster can be reused wherever the picture is moved to. It
+ *  covers the picture's bounds, whatever the clip.
+ *
+ *  The cache keeps the most recently used rasters that fit in its byte
+ *  budget (see SkGraphics::SetPictureCacheLimit). The default limit is 0,
+ *  which disables it.
+ */
+class SkPictureCache {
+public:
+    struct Key {
+        /**
+         *  Fill in the key for drawing picture with matrix, and set
+         *  translate to the integer part of the matrix's translation, which
+         *  is left out of the key. Returns false if the raster should not be
+         *  cached (matrix has perspective).
+         */
+        bool set(const SkPicture& picture, const SkMatrix& matrix, SkIPoint* translate);
+
+        enum {
+            kWordCount = 9,
+        };
+        uint32_t fWords[kWordCount];
+    };
+
+    /**
+     *  Look for the raster added with this key. If found, raster shares the
+     *  cached pixels and offset is set to where its top left corner goes,
+     *  relative to the integer translation left out of the key.
+     */
+    static bool Find(const Key&, SkBitmap* raster, SkIPoint* offset);
+
+    /**
+     *  Add raster and offset under this key, replacing any existing entry.
+     *  Does nothing if raster is larger than the budget.
+     */
+    static void Add(const Key&, const SkBitmap& raster, const SkIPoint& offset);
+
+    /**
+     *  Return true if the byte limit is not 0. This does not take the cache's
+     *  mutex, so that playback costs nothing extra while the cache is off.
+     */
+    static bool IsEnabled();
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t bytes);
+    static size_t GetBytesUsed();
+    static void Purge();
+};
+
+#endif
@@ -63,7 +63,8 @@ SkRefCnt* SkTypefacePlayback::set(int index, SkRefCnt* obj) {
 ///////////////////////////////////////////////////////////////////////////////
 
 SkFlatController::SkFlatController()
-: fBitmapHeap(NULL)
+: fMutex(NULL)
+, fBitmapHeap(NULL)
 , fTypefaceSet(NULL)
 , fTypefacePlayback(NULL)
 , fFactorySet(NULL)
@@ -23,6 +23,7 @@
 #include "SkRegion.h"
 #include "SkTRefArray.h"
 #include "SkTSearch.h"
+#include "SkThread.h"
 
 enum DrawType {
     UNUSED,
@@ -68,6 +69,8 @@ enum DrawType {
 
 // In the 'match' method, this constant will match any flavor of DRAW_BITMAP*
 static const int kDRAW_BITMAP_FLAVOR = LAST_DRAWTYPE_ENUM+1;
+// and this one will match DRAW_OVAL, DRAW_PATH, DRAW_RECT and DRAW_RRECT
+static const int kDRAW_SHAPE_FLAVOR = LAST_DRAWTYPE_ENUM+2;
 
 enum DrawVertexFlags {
     DRAW_VERTICES_HAS_TEXS    = 0x01,
@@ -106,6 +109,11 @@ public:
     void setCount(int count);
     SkRefCnt* set(int index, SkRefCnt*);
 
+    void swap(SkTypefacePlayback& other) {
+        SkTSwap(fCount, other.fCount);
+        SkTSwap(fArray, other.fArray);
+    }
+
     void setupBuffer(SkOrderedReadBuffer& buffer) const {
         buffer.setTypefaceArray((SkTypeface**)fArray, fCount);
     }
@@ -151,7 +159,8 @@ private:
 //                   searchable set of SkFlataData objects of type T.
 // SkFlatController: is an interface provided to SkFlatDictionary which handles
 //                   allocation and unallocation in some cases. It also holds
-//                   ref count recorders and the like.
+//                   ref count recorders and the like, and optionally a mutex
+//                   which makes the dictionaries using it thread-safe.
 //
 // NOTE: any class that wishes to be used in conjunction with SkFlatDictionary
 // must subclass the dictionary and provide the necessary flattening procs.
@@ -218,6 +227,13 @@ public:
      */
     uint32_t getWriteBufferFlags() { return fWriteBufferFlags; }
 
+    /**
+     * The mutex that SkFlatDictionary holds while it uses this controller, so
+     * that dictionaries sharing the controller can be used from several
+     * threads. NULL, the default, when they are only used from one thread.
+     */
+    SkBaseMutex* getMutex() { return fMutex; }
+
 protected:
     /**
      * Set an SkBitmapHeap to be used to store/read SkBitmaps. Ref counted.
@@ -249,7 +265,13 @@ protected:
      */
     void setWriteBufferFlags(uint32_t flags) { fWriteBufferFlags = flags; }
 
+    /**
+     * Set the mutex to be returned by getMutex(). Not ref counted.
+     */
+    void setMutex(SkBaseMutex* mutex) { fMutex = mutex; }
+
 private:
+    SkBaseMutex*        fMutex;
     SkBitmapHeap*       fBitmapHeap;
     SkRefCntSet*        fTypefaceSet;
     SkTypefacePlayback* fTypefacePlayback;
@@ -403,11 +425,10 @@ public:
         fUnflattenProc = NULL;
         SkASSERT(controller);
         fController->ref();
-        // set to 1 since returning a zero from find() indicates failure
-        fNextIndex = 1;
-        sk_bzero(fHash, sizeof(fHash));
         // index 0 is always empty since it is used as a signal that find failed
         fIndexedData.push(NULL);
+        fTable.setCount(kInitialTableCapacity);
+        sk_bzero(fTable.begin(), fTable.count() * sizeof(fTable[0]));
     }
 
     virtual ~SkFlatDictionary() {
@@ -415,13 +436,16 @@ public:
     }
 
     int count() const {
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
-        return fSortedData.count();
+        SkAutoMutexAcquire lock(fController->getMutex());
+        return fIndexedData.count() - 1;
     }
 
+    /**
+     * Returns the entry whose 1-based index is index + 1.
+     */
     const SkFlatData*  operator[](int index) const {
-        SkASSERT(index >= 0 && index < fSortedData.count());
-        return fSortedData[index];
+        SkASSERT(index >= 0 && index < fIndexedData.count() - 1);
+        return fIndexedData[index + 1];
     }
 
     /**
@@ -429,12 +453,11 @@ public:
      * memory that was allocated for each entry.
      */
     void reset() {
-        fSortedData.reset();
+        SkAutoMutexAcquire lock(fController->getMutex());
         fIndexedData.rewind();
         // index 0 is always empty since it is used as a signal that find failed
         fIndexedData.push(NULL);
-        fNextIndex = 1;
-        sk_bzero(fHash, sizeof(fHash));
+        sk_bzero(fTable.begin(), fTable.count() * sizeof(fTable[0]));
     }
 
     /**
@@ -448,33 +471,25 @@ public:
                                      const SkFlatData* toReplace, bool* added,
                                      bool* replaced) {
         SkASSERT(added != NULL && replaced != NULL);
-        int oldCount = fSortedData.count();
-        const SkFlatData* flat = this->findAndReturnFlat(element);
-        *added = fSortedData.count() == oldCount + 1;
+        SkAutoMutexAcquire lock(fController->getMutex());
+        int oldCount = fIndexedData.count();
+        const SkFlatData* flat = this->findAndReturnFlatLocked(element);
+        *added = fIndexedData.count() == oldCount + 1;
         *replaced = false;
         if (*added && toReplace != NULL) {
-            // First, find the index of the one to replace
-            int indexToReplace = fSortedData.find(toReplace);
-            if (indexToReplace >= 0) {
-                // findAndReturnFlat set the index to fNextIndex and increased
-                // fNextIndex by one. Reuse the index from the one being
-                // replaced and reset fNextIndex to the proper value.
-                int oldIndex = flat->index();
+            // First, find the slot of the one to replace
+            int slotToReplace = this->findSlot(toReplace);
+            if (slotToReplace >= 0) {
+                // findAndReturnFlat gave the new entry the next index. Reuse
+                // the index from the one being replaced instead.
+                SkASSERT(flat->index() == fIndexedData.count() - 1);
                 const_cast<SkFlatData*>(flat)->setIndex(toReplace->index());
                 fIndexedData[toReplace->index()] = flat;
-                fNextIndex--;
-                // Remove from the arrays.
-                fSortedData.remove(indexToReplace);
-                fIndexedData.remove(oldIndex);
-                // Remove from the hash table.
-                int oldHash = ChecksumToHashIndex(toReplace->checksum());
-                if (fHash[oldHash] == toReplace) {
-                    fHash[oldHash] = NULL;
-                }
+                fIndexedData.pop();
+                this->removeSlot(slotToReplace);
                 // Delete the actual object.
                 fController->unalloc((void*)toReplace);
                 *replaced = true;
-                SkASSERT(fIndexedData.count() == fSortedData.count()+1);
             }
         }
         return flat;
@@ -486,7 +501,7 @@ public:
      * added.
      *
      * To make the Compare function fast, we write a sentinel value at the end
-     * of each block. The blocks in our fSortedData[] all have a 0 sentinel. The
+     * of each block. The blocks in our hash table all have a 0 sentinel. The
      * newly created block we're comparing against has a -1 in the sentinel.
      *
      * This trick allows Compare to always loop until failure. If it fails on
@@ -501,7 +516,8 @@ public:
      *  if there no objects (instead of an empty array).
      */
     SkTRefArray<T>* unflattenToArray() const {
-        int count = fSortedData.count();
+        SkAutoMutexAcquire lock(fController->getMutex());
+        int count = fIndexedData.count() - 1;
         SkTRefArray<T>* array = NULL;
         if (count > 0) {
             array = SkTRefArray<T>::Create(count);
@@ -514,7 +530,7 @@ public:
      * Unflatten the specific object at the given index
      */
     T* unflatten(int index) const {
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
+        SkAutoMutexAcquire lock(fController->getMutex());
         const SkFlatData* element = fIndexedData[index];
         SkASSERT(index == element->index());
 
@@ -524,40 +540,91 @@ public:
     }
 
     const SkFlatData* findAndReturnFlat(const T& element) {
-        SkFlatData* flat = SkFlatData::Create(fController, &element, fNextIndex, fFlattenProc);
+        SkAutoMutexAcquire lock(fController->getMutex());
+        return this->findAndReturnFlatLocked(element);
+    }
 
-        int hashIndex = ChecksumToHashIndex(flat->checksum());
-        const SkFlatData* candidate = fHash[hashIndex];
-        if (candidate && !SkFlatData::Compare(flat, candidate)) {
-            fController->unalloc(flat);
-            return candidate;
-        }
+protected:
+    void (*fFlattenProc)(SkOrderedWriteBuffer&, const void*);
+    void (*fUnflattenProc)(SkOrderedReadBuffer&, void*);
 
-        int index = SkTSearch<SkFlatData>((const SkFlatData**) fSortedData.begin(),
-                                          fSortedData.count(), flat, sizeof(flat),
-                                          &SkFlatData::Compare);
-        if (index >= 0) {
-            fController->unalloc(flat);
-            fHash[hashIndex] = fSortedData[index];
-            return fSortedData[index];
+private:
+    // Called with the controller's mutex held, if it has one.
+    const SkFlatData* findAndReturnFlatLocked(const T& element) {
+        SkFlatData* flat = SkFlatData::Create(fController, &element, fIndexedData.count(),
+                                              fFlattenProc);
+
+        const int mask = fTable.count() - 1;
+        int slot = ChecksumToSlot(flat->checksum(), mask);
+        for (const SkFlatData* candidate; (candidate = fTable[slot]) != NULL;
+             slot = (slot + 1) & mask) {
+            if (!SkFlatData::Compare(flat, candidate)) {
+                fController->unalloc(flat);
+                return candidate;
+            }
         }
 
-        index = ~index;
-        *fSortedData.insert(index) = flat;
-        *fIndexedData.insert(flat->index()) = flat;
-        SkASSERT(fSortedData.count() == fNextIndex);
-        fNextIndex++;
         flat->setSentinelInCache();
-        fHash[hashIndex] = flat;
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
+        fIndexedData.push(flat);
+        fTable[slot] = flat;
+        // Keep the table at most 3/4 full, so that probe sequences stay short.
+        if (4 * (fIndexedData.count() - 1) > 3 * fTable.count()) {
+            this->growTable();
+        }
         return flat;
     }
 
-protected:
-    void (*fFlattenProc)(SkOrderedWriteBuffer&, const void*);
-    void (*fUnflattenProc)(SkOrderedReadBuffer&, void*);
+    // Returns the slot holding exactly this entry, or -1.
+    int findSlot(const SkFlatData* flat) const {
+        const int mask = fTable.count() - 1;
+        int slot = ChecksumToSlot(flat->checksum(), mask);
+        for (const SkFlatData* candidate; (candidate = fTable[slot]) != NULL;
+             slot = (slot + 1) & mask) {
+            if (candidate == flat) {
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    // Empties the slot, then moves later entries of its probe run back so
+    // that every remaining entry can still be reached from its home slot.
+    void removeSlot(int slot) {
+        const int mask = fTable.count() - 1;
+        int next = slot;
+        for (;;) {
+            next = (next + 1) & mask;
+            const SkFlatData* flat = fTable[next];
+            if (NULL == flat) {
+                break;
+            }
+            // The entry may fill the hole unless its home slot lies
+            // cyclically in (slot, next].
+            int home = ChecksumToSlot(flat->checksum(), mask);
+            if (((next - home) & mask) >= ((next - slot) & mask)) {
+                fTable[slot] = flat;
+                slot = next;
+            }
+        }
+        fTable[slot] = NULL;
+    }
+
+    void growTable() {
+        const int newCount = fTable.count() * 2;
+        const int mask = newCount - 1;
+        fTable.setCount(newCount);
+        sk_bzero(fTable.begin(), newCount * sizeof(fTable[0]));
+        // fIndexedData holds every entry, so rehash from it.
+        for (int i = 1; i < fIndexedData.count(); ++i) {
+            const SkFlatData* flat = fIndexedData[i];
+            int slot = ChecksumToSlot(flat->checksum(), mask);
+            while (fTable[slot] != NULL) {
+                slot = (slot + 1) & mask;
+            }
+            fTable[slot] = flat;
+        }
+    }
 
-private:
     void unflatten(T* dst, const SkFlatData* element) const {
         element->unflatten(dst, fUnflattenProc,
                            fController->getBitmapHeap(),
@@ -565,52 +632,40 @@ private:
     }
 
     void unflattenIntoArray(T* array) const {
-        const int count = fSortedData.count();
-        SkASSERT(fIndexedData.count() == fSortedData.count()+1);
-        const SkFlatData* const* iter = fSortedData.begin();
-        for (int i = 0; i < count; ++i) {
-            const SkFlatData* element = iter[i];
-            int index = element->index() - 1;
-            SkASSERT((unsigned)index < (unsigned)count);
-            unflatten(&array[index], element);
+        const int count = fIndexedData.count();
+        for (int i = 1; i < count; ++i) {
+            const SkFlatData* element = fIndexedData[i];
+            SkASSERT(i == element->index());
+            unflatten(&array[i - 1], element);
         }
     }
 
     SkFlatController * const     fController;
-    int                          fNextIndex;
 
-    // SkFlatDictionary has two copies of the data one indexed by the
-    // SkFlatData's index and the other sorted. The sorted data is used
-    // for finding and uniquification while the indexed copy is used
-    // for standard array-style lookups based on the SkFlatData's index
-    // (as in 'unflatten').
+    // Every entry, by its 1-based index. Index 0 is NULL. This is used for
+    // standard array-style lookups based on the SkFlatData's index (as in
+    // 'unflatten'). An entry keeps its index for the life of the dictionary.
     SkTDArray<const SkFlatData*> fIndexedData;
-    // fSortedData is sorted by checksum/size/data.
-    SkTDArray<const SkFlatData*> fSortedData;
+
+    // Every entry again, in an open addressing hash table keyed on the
+    // checksum and probed linearly. This is used for finding and
+    // uniquification, in constant time no matter how many entries there are.
+    // Its count is a power of two and empty slots are NULL.
+    SkTDArray<const SkFlatData*> fTable;
 
     enum {
-        // Determined by trying diff values on picture-recording benchmarks
-        // (e.g. PictureRecordBench.cpp), choosing the smallest value that
-        // showed a big improvement. Even better would be to benchmark diff
-        // values on recording representative web-pages or other "real" content.
-        HASH_BITS   = 7,
-        HASH_MASK   = (1 << HASH_BITS) - 1,
-        HASH_COUNT  = 1 << HASH_BITS
+        // Large enough for the paints, matrices and regions of most pictures
+        // without growing.
+        kInitialTableCapacity = 128
     };
-    const SkFlatData* fHash[HASH_COUNT];
 
-    static int ChecksumToHashIndex(uint32_t checksum) {
-        int n = checksum;
-        if (HASH_BITS < 32) {
-            n ^= n >> 16;
-        }
-        if (HASH_BITS < 16) {
-            n ^= n >> 8;
-        }
-        if (HASH_BITS < 8) {
-            n ^= n >> 4;
-        }
-        return n & HASH_MASK;
+    static int ChecksumToSlot(uint32_t checksum, int mask) {
+        // SkChecksum folds the data into the low bits unevenly, so mix them
+        // before masking.
+        checksum ^= checksum >> 16;
+        checksum *= 0x85EBCA6B;
+        checksum ^= checksum >> 13;
+        return checksum & mask;
     }
 };
 
@@ -657,7 +712,16 @@ public:
         this->setBitmapHeap(heap);
     }
 
+    /**
+     * Make the dictionaries using this controller safe to share between
+     * threads.
+     */
+    void setThreadSafe() {
+        this->setMutex(&fMutex);
+    }
+
 private:
+    SkMutex                    fMutex;
     SkChunkAlloc               fHeap;
     SkRefCntSet*               fTypefaceSet;
     mutable SkTypefacePlayback fTypefacePlayback;
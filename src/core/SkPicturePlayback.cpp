@@ -6,24 +6,175 @@
  * found in the LICENSE file.
  */
 #include "SkPicturePlayback.h"
+#include "SkPictureCache.h"
 #include "SkPictureRecord.h"
 #include "SkTypeface.h"
+#include "SkDevice.h"
 #include "SkOrderedReadBuffer.h"
 #include "SkOrderedWriteBuffer.h"
 #include <new>
 #include "SkBBoxHierarchy.h"
 #include "SkPictureStateTree.h"
 #include "SkTSort.h"
+#include "SkThread.h"
+#include "SkXfermode.h"
 
 template <typename T> int SafeCount(const T* obj) {
     return obj ? obj->count() : 0;
 }
 
+/**
+ *  Decodes the paints and paths of a picture made with
+ *  SkPicture::CreateFromData() the first time each one is used. Loading only
+ *  records where each flattened paint and path starts in the (shared) buffer
+ *  of the picture's arrays, and the decoded objects are written in place into
+ *  the picture's paint array and path heap.
+ *
+ *  Several clones of a picture may be drawn at once, so decoding is done
+ *  under a mutex, and each flat is published with an atomic increment that
+ *  readers pair with an acquire barrier, as SkWeakRefCnt does.
+ */
+class SkPicturePlayback::LazyFlats : public SkRefCnt {
+public:
+    LazyFlats(SkData* data, uint32_t readFlags, SkPicture::InstallPixelRefProc proc)
+        : fData(SkRef(data))
+        , fReadFlags(readFlags)
+        , fProc(proc)
+        , fFactoryPlayback(NULL)
+        , fPaints(NULL)
+        , fPathHeap(NULL) {
+    }
+
+    virtual ~LazyFlats() {
+        fData->unref();
+        SkDELETE(fFactoryPlayback);
+        SkSafeUnref(fPaints);
+        SkSafeUnref(fPathHeap);
+    }
+
+    /**
+     *  Take over the factories and typefaces which the flats refer to. The
+     *  playback that loaded them has no more use for them once its arrays
+     *  are parsed.
+     */
+    void adoptPlaybacks(SkFactoryPlayback** factoryPlayback, SkTypefacePlayback* tfPlayback) {
+        SkASSERT(NULL == fFactoryPlayback);
+        fFactoryPlayback = *factoryPlayback;
+        *factoryPlayback = NULL;
+        fTFPlayback.swap(*tfPlayback);
+    }
+
+    void setPaints(SkTRefArray<SkPaint>* paints) {
+        SkRefCnt_SafeAssign(fPaints, paints);
+        fPaintFlats.setCount(0);
+    }
+
+    void setPathHeap(SkPathHeap* pathHeap) {
+        SkRefCnt_SafeAssign(fPathHeap, pathHeap);
+        fPathFlats.setCount(0);
+    }
+
+    // Record where the next paint or path lives in the buffer.
+    void appendPaint(uint32_t offset, uint32_t size) { AppendFlat(&fPaintFlats, offset, size); }
+    void appendPath(uint32_t offset, uint32_t size) { AppendFlat(&fPathFlats, offset, size); }
+
+    void decodePaint(int index) {
+        if (!IsDecoded(fPaintFlats[index])) {
+            // The array is shared with our clones, who all look for the
+            // paint through us, so it is fine to fill it in place.
+            SkPaint* paint = const_cast<SkPaint*>(&fPaints->at(index));
+            this->decode(&fPaintFlats[index], paint, NULL);
+        }
+    }
+
+    void decodePath(int index) {
+        if (!IsDecoded(fPathFlats[index])) {
+            this->decode(&fPathFlats[index], NULL, fPathHeap->writablePath(index));
+        }
+    }
+
+    void decodeAll() {
+        for (int i = 0; i < fPaintFlats.count(); ++i) {
+            this->decodePaint(i);
+        }
+        for (int i = 0; i < fPathFlats.count(); ++i) {
+            this->decodePath(i);
+        }
+    }
+
+private:
+    struct Flat {
+        uint32_t fOffset;
+        uint32_t fSize;
+        int32_t  fDecoded;
+    };
+
+    static void AppendFlat(SkTDArray<Flat>* flats, uint32_t offset, uint32_t size) {
+        Flat* flat = flats->append();
+        flat->fOffset = offset;
+        flat->fSize = size;
+        flat->fDecoded = 0;
+    }
+
+    static bool IsDecoded(const Flat& flat) {
+        bool decoded = 0 != *(const volatile int32_t*)&flat.fDecoded;
+        sk_membar_aquire__after_atomic_conditional_inc();
+        return decoded;
+    }
+
+    void decode(Flat* flat, SkPaint* paint, SkPath* path) {
+        SkAutoMutexAcquire ac(fMutex);
+        if (0 != flat->fDecoded) {
+            return;
+        }
+        SkOrderedReadBuffer buffer(fData->bytes() + flat->fOffset, flat->fSize);
+        buffer.setFlags(fReadFlags);
+        if (NULL != fFactoryPlayback) {
+            fFactoryPlayback->setupBuffer(buffer);
+        }
+        fTFPlayback.setupBuffer(buffer);
+        buffer.setBitmapDecoder(fProc);
+        if (NULL != paint) {
+            buffer.readPaint(paint);
+        } else {
+            buffer.readPath(path);
+            path->updateBoundsCache();
+        }
+        sk_atomic_inc(&flat->fDecoded);
+    }
+
+    SkData*                         fData;
+    uint32_t                        fReadFlags;
+    SkPicture::InstallPixelRefProc  fProc;
+    SkFactoryPlayback*              fFactoryPlayback;
+    SkTypefacePlayback              fTFPlayback;
+
+    SkTRefArray<SkPaint>*           fPaints;
+    SkPathHeap*                     fPathHeap;
+    SkTDArray<Flat>                 fPaintFlats;
+    SkTDArray<Flat>                 fPathFlats;
+
+    SkMutex                         fMutex;
+
+    typedef SkRefCnt INHERITED;
+};
+
 /*  Define this to spew out a debug statement whenever we skip the remainder of
     a save/restore block because a clip... command returned false (empty).
  */
 #define SPEW_CLIP_SKIPPINGx
 
+static uint32_t NextUniqueID() {
+    static int32_t gUniqueID;
+
+    // never return 0;
+    uint32_t id;
+    do {
+        id = sk_atomic_inc(&gUniqueID) + 1;
+    } while (0 == id);
+    return id;
+}
+
 SkPicturePlayback::SkPicturePlayback() {
     this->init();
 }
@@ -166,6 +317,7 @@ static bool needs_deep_copy(const SkPaint& paint) {
 
 SkPicturePlayback::SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInfo* deepCopyInfo) {
     this->init();
+    fUniqueID = src.fUniqueID;
 
     fBitmapHeap.reset(SkSafeRef(src.fBitmapHeap.get()));
     fPathHeap.reset(SkSafeRef(src.fPathHeap.get()));
@@ -181,6 +333,11 @@ SkPicturePlayback::SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInf
     SkSafeRef(fStateTree);
 
     if (deepCopyInfo) {
+        // The copy gets paints of its own, so finish decoding the ones we share.
+        if (NULL != src.fLazyFlats) {
+            src.fLazyFlats->decodeAll();
+        }
+
         int paintCount = SafeCount(src.fPaints);
 
         if (src.fBitmaps) {
@@ -245,6 +402,7 @@ SkPicturePlayback::SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInf
     } else {
         fBitmaps = SkSafeRef(src.fBitmaps);
         fPaints = SkSafeRef(src.fPaints);
+        fLazyFlats = SkSafeRef(src.fLazyFlats);
     }
 
     fPictureCount = src.fPictureCount;
@@ -267,9 +425,12 @@ void SkPicturePlayback::init() {
     fRegions = NULL;
     fPictureCount = 0;
     fOpData = NULL;
+    fLazyFlats = NULL;
     fFactoryPlayback = NULL;
     fBoundingHierarchy = NULL;
     fStateTree = NULL;
+    fUniqueID = NextUniqueID();
+    fRasterCacheable = kUnknown_RasterCacheable;
 }
 
 SkPicturePlayback::~SkPicturePlayback() {
@@ -279,6 +440,7 @@ SkPicturePlayback::~SkPicturePlayback() {
     SkSafeUnref(fMatrices);
     SkSafeUnref(fPaints);
     SkSafeUnref(fRegions);
+    SkSafeUnref(fLazyFlats);
     SkSafeUnref(fBoundingHierarchy);
     SkSafeUnref(fStateTree);
 
@@ -290,6 +452,14 @@ SkPicturePlayback::~SkPicturePlayback() {
     SkDELETE(fFactoryPlayback);
 }
 
+void SkPicturePlayback::decodePaint(int index) {
+    fLazyFlats->decodePaint(index);
+}
+
+void SkPicturePlayback::decodePath(int index) {
+    fLazyFlats->decodePath(index);
+}
+
 void SkPicturePlayback::dumpSize() const {
     SkDebugf("--- picture size: ops=%d bitmaps=%d [%d] matrices=%d [%d] paints=%d [%d] paths=%d regions=%d\n",
              fOpData->size(),
@@ -334,7 +504,12 @@ static void writeTagSize(SkWStream* stream, uint32_t tag,
     stream->write32(size);
 }
 
-static void writeFactories(SkWStream* stream, const SkFactorySet& rec) {
+static void writePad(SkWStream* stream, size_t length) {
+    static const uint32_t kZero = 0;
+    stream->write(&kZero, SkAlign4(length) - length);
+}
+
+static void writeFactories(SkWStream* stream, const SkFactorySet& rec, bool inPlace) {
     int count = rec.count();
 
     writeTagSize(stream, PICT_FACTORY_TAG, count);
@@ -347,16 +522,26 @@ static void writeFactories(SkWStream* stream, const SkFactorySet& rec) {
         const char* name = SkFlattenable::FactoryToName(array[i]);
 //        SkDebugf("---- write factories [%d] %p <%s>\n", i, array[i], name);
         if (NULL == name || 0 == *name) {
-            stream->writePackedUInt(0);
+            if (inPlace) {
+                stream->write32(0);
+            } else {
+                stream->writePackedUInt(0);
+            }
         } else {
             uint32_t len = strlen(name);
-            stream->writePackedUInt(len);
-            stream->write(name, len);
+            if (inPlace) {
+                stream->write32(len);
+                stream->write(name, len);
+                writePad(stream, len);
+            } else {
+                stream->writePackedUInt(len);
+                stream->write(name, len);
+            }
         }
     }
 }
 
-static void writeTypefaces(SkWStream* stream, const SkRefCntSet& rec) {
+static void writeTypefaces(SkWStream* stream, const SkRefCntSet& rec, bool inPlace) {
     int count = rec.count();
 
     writeTagSize(stream, PICT_TYPEFACE_TAG, count);
@@ -365,12 +550,38 @@ static void writeTypefaces(SkWStream* stream, const SkRefCntSet& rec) {
     SkTypeface** array = (SkTypeface**)storage.get();
     rec.copyToArray((SkRefCnt**)array);
 
+    // In place, each typeface is preceded by its size and padded, to keep the
+    // stream 4-byte aligned.
     for (int i = 0; i < count; i++) {
-        array[i]->serialize(stream);
+        if (!inPlace) {
+            array[i]->serialize(stream);
+            continue;
+        }
+        SkDynamicMemoryWStream typefaceStream;
+        array[i]->serialize(&typefaceStream);
+        stream->write32(typefaceStream.bytesWritten());
+        typefaceStream.padToAlign4();
+        SkAutoDataUnref data(typefaceStream.copyToData());
+        stream->write(data->data(), data->size());
     }
 }
 
-void SkPicturePlayback::flattenToBuffer(SkOrderedWriteBuffer& buffer) const {
+/**
+ *  In place, each paint and path in the buffer is preceded by its size, so
+ *  that a picture loaded with SkPicture::CreateFromData() can skip over them,
+ *  and decode each one on first use.
+ */
+static uint32_t beginSizedFlat(SkOrderedWriteBuffer& buffer) {
+    uint32_t offset = buffer.size();
+    buffer.writeUInt(0);
+    return offset;
+}
+
+static void endSizedFlat(SkOrderedWriteBuffer& buffer, uint32_t offset) {
+    *buffer.getWriter32()->peek32(offset) = buffer.size() - offset - sizeof(uint32_t);
+}
+
+void SkPicturePlayback::flattenToBuffer(SkOrderedWriteBuffer& buffer, bool inPlace) const {
     int i, n;
 
     if ((n = SafeCount(fBitmaps)) > 0) {
@@ -388,16 +599,34 @@ void SkPicturePlayback::flattenToBuffer(SkOrderedWriteBuffer& buffer) const {
 
     }
 
+    if (NULL != fLazyFlats) {
+        fLazyFlats->decodeAll();
+    }
+
     if ((n = SafeCount(fPaints)) > 0) {
         writeTagSize(buffer, PICT_PAINT_BUFFER_TAG, n);
         for (i = 0; i < n; i++) {
-            buffer.writePaint((*fPaints)[i]);
+            if (inPlace) {
+                uint32_t offset = beginSizedFlat(buffer);
+                buffer.writePaint((*fPaints)[i]);
+                endSizedFlat(buffer, offset);
+            } else {
+                buffer.writePaint((*fPaints)[i]);
+            }
         }
     }
 
     if ((n = SafeCount(fPathHeap.get())) > 0) {
         writeTagSize(buffer, PICT_PATH_BUFFER_TAG, n);
-        fPathHeap->flatten(buffer);
+        if (inPlace) {
+            for (i = 0; i < n; i++) {
+                uint32_t offset = beginSizedFlat(buffer);
+                buffer.writePath((*fPathHeap.get())[i]);
+                endSizedFlat(buffer, offset);
+            }
+        } else {
+            fPathHeap->flatten(buffer);
+        }
     }
 
     if ((n = SafeCount(fRegions)) > 0) {
@@ -409,14 +638,14 @@ void SkPicturePlayback::flattenToBuffer(SkOrderedWriteBuffer& buffer) const {
 }
 
 void SkPicturePlayback::serialize(SkWStream* stream,
-                                  SkPicture::EncodeBitmap encoder) const {
+                                  SkPicture::EncodeBitmap encoder, bool inPlace) const {
     writeTagSize(stream, PICT_READER_TAG, fOpData->size());
     stream->write(fOpData->bytes(), fOpData->size());
 
     if (fPictureCount > 0) {
         writeTagSize(stream, PICT_PICTURE_TAG, fPictureCount);
         for (int i = 0; i < fPictureCount; i++) {
-            fPictureRefs[i]->serialize(stream, encoder);
+            fPictureRefs[i]->serialize(stream, encoder, inPlace);
         }
     }
 
@@ -433,13 +662,13 @@ void SkPicturePlayback::serialize(SkWStream* stream,
         buffer.setFactoryRecorder(&factSet);
         buffer.setBitmapEncoder(encoder);
 
-        this->flattenToBuffer(buffer);
+        this->flattenToBuffer(buffer, inPlace);
 
         // We have to write these to sets into the stream *before* we write
         // the buffer, since parsing that buffer will require that we already
         // have these sets available to use.
-        writeFactories(stream, factSet);
-        writeTypefaces(stream, typefaceSet);
+        writeFactories(stream, factSet, inPlace);
+        writeTypefaces(stream, typefaceSet, inPlace);
 
         writeTagSize(stream, PICT_BUFFER_SIZE_TAG, buffer.size());
         buffer.writeToStream(stream);
@@ -473,8 +702,53 @@ static uint32_t pictInfoFlagsToReadBufferFlags(uint32_t pictInfoFlags) {
     return rbMask;
 }
 
-void SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info, uint32_t tag,
-                                       size_t size, SkPicture::InstallPixelRefProc proc) {
+/**
+ *  If we are reading from backing, return the next size bytes of its data
+ *  without copying them, and skip over them. Returns NULL, consuming nothing,
+ *  if we are not, or the bytes are not 4-byte aligned (which SkReader32
+ *  requires), or there are not that many bytes left.
+ */
+static SkData* shareStreamData(SkStream* stream, SkMemoryStream* backing, size_t size) {
+    if (NULL == backing || stream != backing) {
+        return NULL;
+    }
+    SkAutoDataUnref data(backing->copyToData());
+    size_t offset = backing->peek();
+    if (!SkIsAlign4((uintptr_t)data->bytes() + offset) || offset > data->size() ||
+        size > data->size() - offset) {
+        return NULL;
+    }
+    backing->seek(offset + size);
+    return SkData::NewSubset(data, offset, size);
+}
+
+static void skipPad(SkStream* stream, size_t length) {
+    size_t pad = SkAlign4(length) - length;
+    if (pad > 0) {
+        stream->skip(pad);
+    }
+}
+
+/**
+ *  Return the next size bytes of the stream, shared with backing where
+ *  possible, or NULL if the stream ends first.
+ */
+static SkData* readStreamData(SkStream* stream, SkMemoryStream* backing, size_t size) {
+    SkData* data = shareStreamData(stream, backing, size);
+    if (NULL == data) {
+        void* storage = sk_malloc_throw(size);
+        if (stream->read(storage, size) != size) {
+            sk_free(storage);
+            return NULL;
+        }
+        data = SkData::NewFromMalloc(storage, size);
+    }
+    return data;
+}
+
+bool SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info, uint32_t tag,
+                                       size_t size, SkPicture::InstallPixelRefProc proc,
+                                       SkMemoryStream* backing) {
     /*
      *  By the time we encounter BUFFER_SIZE_TAG, we need to have already seen
      *  its dependents: FACTORY_TAG and TYPEFACE_TAG. These two are not required
@@ -485,22 +759,29 @@ void SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info,
      *  factories or typefaces.
      */
     SkDEBUGCODE(bool haveBuffer = false;)
+    const bool inPlace = SkPicture::IN_PLACE_PICTURE_VERSION == info.fVersion;
 
     switch (tag) {
         case PICT_READER_TAG: {
-            void* storage = sk_malloc_throw(size);
-            stream->read(storage, size);
             SkASSERT(NULL == fOpData);
-            fOpData = SkData::NewFromMalloc(storage, size);
+            fOpData = readStreamData(stream, backing, size);
+            if (NULL == fOpData) {
+                return false;
+            }
         } break;
         case PICT_FACTORY_TAG: {
             SkASSERT(!haveBuffer);
             fFactoryPlayback = SkNEW_ARGS(SkFactoryPlayback, (size));
             for (size_t i = 0; i < size; i++) {
                 SkString str;
-                int len = stream->readPackedUInt();
+                size_t len = inPlace ? stream->readU32() : stream->readPackedUInt();
                 str.resize(len);
-                stream->read(str.writable_str(), len);
+                if (stream->read(str.writable_str(), len) != len) {
+                    return false;
+                }
+                if (inPlace) {
+                    skipPad(stream, len);
+                }
                 fFactoryPlayback->base()[i] = SkFlattenable::NameToFactory(str.c_str());
             }
         } break;
@@ -508,46 +789,74 @@ void SkPicturePlayback::parseStreamTag(SkStream* stream, const SkPictInfo& info,
             SkASSERT(!haveBuffer);
             fTFPlayback.setCount(size);
             for (size_t i = 0; i < size; i++) {
-                SkSafeUnref(fTFPlayback.set(i, SkTypeface::Deserialize(stream)));
+                if (!inPlace) {
+                    SkSafeUnref(fTFPlayback.set(i, SkTypeface::Deserialize(stream)));
+                    continue;
+                }
+                size_t len = stream->readU32();
+                SkAutoDataUnref data(readStreamData(stream, NULL, len));
+                if (NULL == data.get()) {
+                    return false;
+                }
+                skipPad(stream, len);
+                SkMemoryStream typefaceStream(data);
+                SkSafeUnref(fTFPlayback.set(i, SkTypeface::Deserialize(&typefaceStream)));
             }
         } break;
         case PICT_PICTURE_TAG: {
             fPictureCount = size;
             fPictureRefs = SkNEW_ARRAY(SkPicture*, fPictureCount);
-            bool success;
+            bool success = true;
             for (int i = 0; i < fPictureCount; i++) {
-                fPictureRefs[i] = SkNEW_ARGS(SkPicture, (stream, &success, proc));
-                // Success can only be false if PICTURE_VERSION does not match
-                // (which should never happen from here, since a sub picture will
-                // have the same PICTURE_VERSION as its parent) or if stream->read
-                // returns 0. In the latter case, we have a bug when writing the
-                // picture to begin with, which will be alerted to here.
-                SkASSERT(success);
+                fPictureRefs[i] = SkNEW(SkPicture);
+                if (success) {
+                    fPictureRefs[i]->initFromStream(stream, &success, proc, backing);
+                }
+            }
+            // Success can only be false if the version does not match (which
+            // should never happen from here, since a sub picture has the same
+            // version as its parent) or if the stream is short.
+            if (!success) {
+                return false;
             }
         } break;
         case PICT_BUFFER_SIZE_TAG: {
-            SkAutoMalloc storage(size);
-            stream->read(storage.get(), size);
+            SkAutoDataUnref data(readStreamData(stream, backing, size));
+            if (NULL == data.get()) {
+                return false;
+            }
 
-            SkOrderedReadBuffer buffer(storage.get(), size);
+            SkOrderedReadBuffer buffer(data->data(), size);
             buffer.setFlags(pictInfoFlagsToReadBufferFlags(info.fFlags));
 
             fFactoryPlayback->setupBuffer(buffer);
             fTFPlayback.setupBuffer(buffer);
             buffer.setBitmapDecoder(proc);
 
+            // Paints and paths of a shared picture are decoded straight from
+            // the buffer on first use, so it has to outlive us.
+            if (NULL != backing) {
+                SkASSERT(NULL == fLazyFlats);
+                fLazyFlats = SkNEW_ARGS(LazyFlats, (data, buffer.getFlags(), proc));
+            }
+
             while (!buffer.eof()) {
                 tag = buffer.readUInt();
                 size = buffer.readUInt();
-                this->parseBufferTag(buffer, tag, size);
+                this->parseBufferTag(buffer, tag, size, inPlace);
+            }
+
+            if (NULL != fLazyFlats) {
+                fLazyFlats->adoptPlaybacks(&fFactoryPlayback, &fTFPlayback);
             }
             SkDEBUGCODE(haveBuffer = true;)
         } break;
     }
+    return true;
 }
 
 void SkPicturePlayback::parseBufferTag(SkOrderedReadBuffer& buffer,
-                                       uint32_t tag, size_t size) {
+                                       uint32_t tag, size_t size, bool inPlace) {
     switch (tag) {
         case PICT_BITMAP_BUFFER_TAG: {
             fBitmaps = SkTRefArray<SkBitmap>::Create(size);
@@ -565,15 +874,51 @@ void SkPicturePlayback::parseBufferTag(SkOrderedReadBuffer& buffer,
             break;
         case PICT_PAINT_BUFFER_TAG: {
             fPaints = SkTRefArray<SkPaint>::Create(size);
+            if (NULL != fLazyFlats) {
+                fLazyFlats->setPaints(fPaints);
+            }
             for (size_t i = 0; i < size; ++i) {
-                buffer.readPaint(&fPaints->writableAt(i));
+                if (!inPlace) {
+                    buffer.readPaint(&fPaints->writableAt(i));
+                    continue;
+                }
+                uint32_t length = buffer.readUInt();
+                if (NULL != fLazyFlats) {
+                    fLazyFlats->appendPaint(buffer.offset(), length);
+                    buffer.skip(length);
+                } else {
+                    SkDEBUGCODE(uint32_t start = buffer.offset();)
+                    buffer.readPaint(&fPaints->writableAt(i));
+                    SkASSERT(buffer.offset() - start == length);
+                }
             }
         } break;
-        case PICT_PATH_BUFFER_TAG:
-            if (size > 0) {
-                fPathHeap.reset(SkNEW_ARGS(SkPathHeap, (buffer)));
+        case PICT_PATH_BUFFER_TAG: {
+            if (!inPlace) {
+                if (size > 0) {
+                    fPathHeap.reset(SkNEW_ARGS(SkPathHeap, (buffer)));
+                }
+                break;
             }
-            break;
+            fPathHeap.reset(SkNEW(SkPathHeap));
+            if (NULL != fLazyFlats) {
+                fLazyFlats->setPathHeap(fPathHeap);
+            }
+            SkPath path;
+            for (size_t i = 0; i < size; ++i) {
+                uint32_t length = buffer.readUInt();
+                if (NULL != fLazyFlats) {
+                    fLazyFlats->appendPath(buffer.offset(), length);
+                    buffer.skip(length);
+                    fPathHeap->append(path);
+                } else {
+                    SkDEBUGCODE(uint32_t start = buffer.offset();)
+                    buffer.readPath(&path);
+                    SkASSERT(buffer.offset() - start == length);
+                    fPathHeap->append(path);
+                }
+            }
+        } break;
         case PICT_REGION_BUFFER_TAG: {
             fRegions = SkTRefArray<SkRegion>::Create(size);
             for (size_t i = 0; i < size; ++i) {
@@ -583,19 +928,28 @@ void SkPicturePlayback::parseBufferTag(SkOrderedReadBuffer& buffer,
     }
 }
 
-SkPicturePlayback::SkPicturePlayback(SkStream* stream, const SkPictInfo& info,
-                                     SkPicture::InstallPixelRefProc proc) {
+SkPicturePlayback::SkPicturePlayback(SkStream* stream, const SkPictInfo& info, bool* isValid,
+                                     SkPicture::InstallPixelRefProc proc,
+                                     SkMemoryStream* backing) {
     this->init();
+    *isValid = false;
 
     for (;;) {
-        uint32_t tag = stream->readU32();
+        uint32_t tag;
+        if (sizeof(tag) != stream->read(&tag, sizeof(tag))) {
+            return;
+        }
         if (PICT_EOF_TAG == tag) {
             break;
         }
 
-        uint32_t size = stream->readU32();
-        this->parseStreamTag(stream, info, tag, size, proc);
+        uint32_t size;
+        if (sizeof(size) != stream->read(&size, sizeof(size)) ||
+            !this->parseStreamTag(stream, info, tag, size, proc, backing)) {
+            return;
+        }
     }
+    *isValid = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -650,6 +1004,108 @@ static DrawType read_op_and_size(SkReader32* reader, uint32_t* size) {
     return (DrawType) op;
 }
 
+bool SkPicturePlayback::isRasterCacheable() {
+    if (kUnknown_RasterCacheable != fRasterCacheable) {
+        return kYes_RasterCacheable == fRasterCacheable;
+    }
+
+    bool cacheable = true;
+    for (int i = 0; cacheable && i < SafeCount(fPaints); ++i) {
+        if (NULL != fLazyFlats) {
+            this->decodePaint(i);
+        }
+        const SkPaint& paint = (*fPaints)[i];
+        cacheable = SkXfermode::IsMode(paint.getXfermode(), SkXfermode::kSrcOver_Mode) &&
+                    !(paint.isLCDRenderText() && paint.isAntiAlias());
+    }
+    for (int i = 0; cacheable && i < fPictureCount; ++i) {
+        SkPicturePlayback* nested = fPictureRefs[i]->fPlayback;
+        cacheable = NULL == nested || nested->isRasterCacheable();
+    }
+
+    SkReader32 reader(fOpData->bytes(), fOpData->size());
+    while (cacheable && !reader.eof()) {
+        size_t curOffset = reader.offset();
+        uint32_t size;
+        DrawType op = read_op_and_size(&reader, &size);
+        // Old pictures without op sizes can't be walked without decoding
+        // every op, so they aren't cached. Nor are sprites and region clips,
+        // which are in device space and so would land elsewhere in the raster.
+        cacheable = 0 != size && DRAW_CLEAR != op && DRAW_SPRITE != op && CLIP_REGION != op;
+        reader.setOffset(curOffset + size);
+    }
+
+    fRasterCacheable = cacheable ? kYes_RasterCacheable : kNo_RasterCacheable;
+    return cacheable;
+}
+
+bool SkPicturePlayback::DrawFromCache(SkCanvas& canvas, SkPicture& picture) {
+    if (!SkPictureCache::IsEnabled() || !canvas.getAllowPictureCache() ||
+        NULL != canvas.getDrawFilter() || NULL != canvas.getBounder()) {
+        return false;
+    }
+    // Only cache into raster canvases whose pixels a blit of the cached
+    // raster reproduces, rather than recording, GPU or vector canvases.
+    SkDevice* device = canvas.getTopDevice();
+    if (NULL == device) {
+        return false;
+    }
+    const SkBitmap& target = device->accessBitmap(false);
+    if (SkBitmap::kARGB_8888_Config != target.config() || NULL == target.pixelRef() ||
+        NULL != target.getTexture()) {
+        return false;
+    }
+
+    SkPictureCache::Key key;
+    SkIPoint translate;
+    const SkMatrix& matrix = canvas.getTotalMatrix();
+    if (!key.set(picture, matrix, &translate)) {
+        return false;
+    }
+    picture.endRecording();
+    if (NULL == picture.fPlayback || !picture.fPlayback->isRasterCacheable()) {
+        return false;
+    }
+
+    SkBitmap raster;
+    SkIPoint offset;
+    if (!SkPictureCache::Find(key, &raster, &offset)) {
+        SkMatrix rasterMatrix(matrix);
+        rasterMatrix.postTranslate(-SkIntToScalar(translate.fX), -SkIntToScalar(translate.fY));
+        SkRect bounds = SkRect::MakeWH(SkIntToScalar(picture.width()),
+                                       SkIntToScalar(picture.height()));
+        rasterMatrix.mapRect(&bounds);
+        SkIRect ibounds;
+        bounds.roundOut(&ibounds);
+        if (ibounds.isEmpty() ||
+            (uint64_t)ibounds.width() * ibounds.height() * sizeof(SkPMColor) >
+                SkPictureCache::GetByteLimit()) {
+            return false;
+        }
+
+        raster.setConfig(SkBitmap::kARGB_8888_Config, ibounds.width(), ibounds.height());
+        if (!raster.allocPixels()) {
+            return false;
+        }
+        raster.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas rasterCanvas(raster);
+        rasterCanvas.translate(-SkIntToScalar(ibounds.fLeft), -SkIntToScalar(ibounds.fTop));
+        rasterCanvas.concat(rasterMatrix);
+        picture.fPlayback->draw(rasterCanvas);
+        raster.setImmutable();
+
+        offset.set(ibounds.fLeft, ibounds.fTop);
+        SkPictureCache::Add(key, raster, offset);
+    }
+
+    canvas.save(SkCanvas::kMatrix_SaveFlag);
+    canvas.resetMatrix();
+    canvas.drawBitmap(raster, SkIntToScalar(translate.fX + offset.fX),
+                      SkIntToScalar(translate.fY + offset.fY));
+    canvas.restore();
+    return true;
+}
+
 void SkPicturePlayback::draw(SkCanvas& canvas) {
 #ifdef ENABLE_TIME_DRAW
     SkAutoTime  at("SkPicture::draw", 50);
@@ -676,13 +1132,26 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
         if (canvas.getClipBounds(&clipBounds)) {
             SkIRect query;
             clipBounds.roundOut(&query);
-            fBoundingHierarchy->search(query, &results);
+            // getClipBounds() allows for antialiasing, but only the pixels inside the clip
+            // itself need to be hidden for an occluder to hide a draw.
+            SkIRect visible = query;
+            SkIRect deviceBounds;
+            SkMatrix inverse;
+            if (canvas.getClipDeviceBounds(&deviceBounds) &&
+                canvas.getTotalMatrix().invert(&inverse)) {
+                SkRect localBounds;
+                inverse.mapRect(&localBounds, SkRect::MakeFromIRect(deviceBounds));
+                localBounds.roundOut(&visible);
+            }
+            fBoundingHierarchy->searchVisible(query, visible, &results);
             if (results.count() == 0) {
                 return;
             }
-            SkTQSort<SkPictureStateTree::Draw>(
-                reinterpret_cast<SkPictureStateTree::Draw**>(results.begin()),
-                reinterpret_cast<SkPictureStateTree::Draw**>(results.end()-1));
+            if (!fBoundingHierarchy->searchIsOrdered()) {
+                SkTQSort<SkPictureStateTree::Draw>(
+                    reinterpret_cast<SkPictureStateTree::Draw**>(results.begin()),
+                    reinterpret_cast<SkPictureStateTree::Draw**>(results.end()-1));
+            }
         }
     }
 
@@ -852,9 +1321,12 @@ void SkPicturePlayback::draw(SkCanvas& canvas) {
                 const SkPaint& paint = *getPaint(reader);
                 canvas.drawPath(getPath(reader), paint);
             } break;
-            case DRAW_PICTURE:
-                canvas.drawPicture(getPicture(reader));
-                break;
+            case DRAW_PICTURE: {
+                SkPicture& picture = getPicture(reader);
+                if (!DrawFromCache(canvas, picture)) {
+                    canvas.drawPicture(picture);
+                }
+            } break;
             case DRAW_POINTS: {
                 const SkPaint& paint = *getPaint(reader);
                 SkCanvas::PointMode mode = (SkCanvas::PointMode)reader.readInt();
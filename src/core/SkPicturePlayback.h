@@ -62,13 +62,26 @@ public:
     SkPicturePlayback();
     SkPicturePlayback(const SkPicturePlayback& src, SkPictCopyInfo* deepCopyInfo = NULL);
     explicit SkPicturePlayback(const SkPictureRecord& record, bool deepCopy = false);
-    SkPicturePlayback(SkStream*, const SkPictInfo&, SkPicture::InstallPixelRefProc);
+    /**
+     *  isValid is set to false if the stream does not hold a valid playback.
+     *  If backing is not NULL, it must be the stream itself, holding a picture
+     *  in the in-place format, and the playback refers to its bytes rather
+     *  than copying them, decoding paints and paths on first use.
+     */
+    SkPicturePlayback(SkStream*, const SkPictInfo&, bool* isValid,
+                      SkPicture::InstallPixelRefProc, SkMemoryStream* backing = NULL);
 
     virtual ~SkPicturePlayback();
 
     void draw(SkCanvas& canvas);
 
-    void serialize(SkWStream*, SkPicture::EncodeBitmap) const;
+    /**
+     *  Identifies the recorded content. Copies of a playback share its ID.
+     */
+    uint32_t uniqueID() const { return fUniqueID; }
+
+    // inPlace selects the format written by SkPicture::serializeForInPlacePlayback().
+    void serialize(SkWStream*, SkPicture::EncodeBitmap, bool inPlace) const;
 
     void dumpSize() const;
 
@@ -113,7 +126,11 @@ private:
     }
 
     const SkPath& getPath(SkReader32& reader) {
-        return (*fPathHeap)[reader.readInt() - 1];
+        int index = reader.readInt() - 1;
+        if (NULL != fLazyFlats) {
+            this->decodePath(index);
+        }
+        return (*fPathHeap)[index];
     }
 
     SkPicture& getPicture(SkReader32& reader) {
@@ -127,6 +144,9 @@ private:
         if (index == 0) {
             return NULL;
         }
+        if (NULL != fLazyFlats) {
+            this->decodePaint(index - 1);
+        }
         return &(*fPaints)[index - 1];
     }
 
@@ -156,6 +176,20 @@ private:
         text->fText = (const char*)reader.skip(length);
     }
 
+    void decodePaint(int index);
+    void decodePath(int index);
+
+    // Returns true if playing back into a transparent bitmap and compositing
+    // that onto a canvas matches playing back onto the canvas: every paint
+    // uses srcover and draws no LCD text, there is no clear(), and the same
+    // holds for every nested picture.
+    bool isRasterCacheable();
+
+    // Draws picture, which is nested inside this one, from SkPictureCache,
+    // first rasterizing and adding it if need be. Returns false if it should
+    // be played back instead.
+    static bool DrawFromCache(SkCanvas& canvas, SkPicture& picture);
+
     void init();
 
 #ifdef SK_DEBUG_SIZE
@@ -191,10 +225,10 @@ public:
 #endif
 
 private:    // these help us with reading/writing
-    void parseStreamTag(SkStream*, const SkPictInfo&, uint32_t tag, size_t size,
-                        SkPicture::InstallPixelRefProc);
-    void parseBufferTag(SkOrderedReadBuffer&, uint32_t tag, size_t size);
-    void flattenToBuffer(SkOrderedWriteBuffer&) const;
+    bool parseStreamTag(SkStream*, const SkPictInfo&, uint32_t tag, size_t size,
+                        SkPicture::InstallPixelRefProc, SkMemoryStream* backing);
+    void parseBufferTag(SkOrderedReadBuffer&, uint32_t tag, size_t size, bool inPlace);
+    void flattenToBuffer(SkOrderedWriteBuffer&, bool inPlace) const;
 
 private:
     // Only used by getBitmap() if the passed in index is SkBitmapHeap::INVALID_SLOT. This empty
@@ -211,6 +245,12 @@ private:
 
     SkData* fOpData;    // opcodes and parameters
 
+    // Set if this was loaded from shared data, in which case the paints and
+    // paths in fPaints and fPathHeap are decoded on first use. Shared with
+    // our clones.
+    class LazyFlats;
+    LazyFlats* fLazyFlats;
+
     SkPicture** fPictureRefs;
     int fPictureCount;
 
@@ -219,6 +259,16 @@ private:
 
     SkTypefacePlayback fTFPlayback;
     SkFactoryPlayback* fFactoryPlayback;
+
+    uint32_t fUniqueID;
+    enum {
+        kUnknown_RasterCacheable,
+        kNo_RasterCacheable,
+        kYes_RasterCacheable,
+    };
+    // Set by isRasterCacheable() the first time it is called. Threads drawing
+    // at once may both compute it, but they get the same answer.
+    int32_t fRasterCacheable;
 #ifdef SK_BUILD_FOR_ANDROID
     SkMutex fDrawMutex;
     bool fAbortCurrentPlayback;
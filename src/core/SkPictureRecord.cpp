@@ -26,16 +26,42 @@ static int const kUInt32Size = 4;
 static const uint32_t kSaveLayerNoBoundsSize = 4 * kUInt32Size;
 static const uint32_t kSaveLayerWithBoundsSize = 4 * kUInt32Size + sizeof(SkRect);
 
-SkPictureRecord::SkPictureRecord(uint32_t flags, SkDevice* device) :
-        INHERITED(device),
-        fBoundingHierarchy(NULL),
-        fStateTree(NULL),
+SK_DEFINE_INST_COUNT(SkPictureDictionaries)
+
+SkPictureDictionaries::SkPictureDictionaries(bool threadSafe) :
         fFlattenableHeap(HEAP_BLOCK_SIZE),
         fMatrices(&fFlattenableHeap),
         fPaints(&fFlattenableHeap),
         fRegions(&fFlattenableHeap),
+        fPathHeap(NULL) {
+    SkAutoTUnref<SkBitmapHeap> bitmapHeap(SkNEW(SkBitmapHeap));
+    fFlattenableHeap.setBitmapStorage(bitmapHeap);
+    if (threadSafe) {
+        fFlattenableHeap.setThreadSafe();
+        fPathHeap = SkNEW(SkPathHeap);
+    }
+}
+
+SkPictureDictionaries::~SkPictureDictionaries() {
+    SkSafeUnref(fPathHeap);
+    fFlattenableHeap.setBitmapStorage(NULL);
+}
+
+SkPictureRecord::SkPictureRecord(uint32_t flags, SkDevice* device,
+                                 SkPictureDictionaries* dictionaries,
+                                 uint32_t optimizations) :
+        INHERITED(device),
+        fBoundingHierarchy(NULL),
+        fStateTree(NULL),
+        fDictionaries(dictionaries ? SkRef(dictionaries)
+                                   : SkNEW_ARGS(SkPictureDictionaries, (false))),
+        fFlattenableHeap(fDictionaries->fFlattenableHeap),
+        fMatrices(fDictionaries->fMatrices),
+        fPaints(fDictionaries->fPaints),
+        fRegions(fDictionaries->fRegions),
         fWriter(MIN_WRITER_SIZE),
-        fRecordFlags(flags) {
+        fRecordFlags(flags),
+        fOptimizations(optimizations & kAll_Optimizations) {
 #ifdef SK_DEBUG_SIZE
     fPointBytes = fRectBytes = fTextBytes = 0;
     fPointWrites = fRectWrites = fTextWrites = 0;
@@ -43,9 +69,8 @@ SkPictureRecord::SkPictureRecord(uint32_t flags, SkDevice* device) :
 
     fRestoreOffsetStack.setReserve(32);
 
-    fBitmapHeap = SkNEW(SkBitmapHeap);
-    fFlattenableHeap.setBitmapStorage(fBitmapHeap);
-    fPathHeap = NULL;   // lazy allocate
+    fBitmapHeap = SkRef(fFlattenableHeap.getBitmapHeap());
+    fPathHeap = SkSafeRef(fDictionaries->fPathHeap);   // lazy allocate if NULL
     fFirstSavedLayerIndex = kNoSavedLayerIndex;
 
     fInitialSaveCount = kNoInitialSave;
@@ -56,8 +81,8 @@ SkPictureRecord::~SkPictureRecord() {
     SkSafeUnref(fPathHeap);
     SkSafeUnref(fBoundingHierarchy);
     SkSafeUnref(fStateTree);
-    fFlattenableHeap.setBitmapStorage(NULL);
     fPictureRefs.unrefAll();
+    fDictionaries->unref();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -264,6 +289,11 @@ static bool match(SkWriter32* writer, uint32_t offset,
                 DRAW_BITMAP_NINE != op && DRAW_BITMAP_RECT_TO_RECT != op) {
                 return false;
             }
+        } else if (kDRAW_SHAPE_FLAVOR == pattern[numMatched]) {
+            if (DRAW_OVAL != op && DRAW_PATH != op &&
+                DRAW_RECT != op && DRAW_RRECT != op) {
+                return false;
+            }
         } else if (op != pattern[numMatched]) {
             return false;
         }
@@ -445,6 +475,76 @@ static bool remove_save_layer2(SkWriter32* writer, int32_t offset,
                                                 result[0], result[3]);
 }
 
+/*
+ * Attempt to remove the saveLayer around the shape drawn in it. The layer
+ * must be opaque: folding a partial layer alpha into the shape's paint would
+ * blend the shape in one step rather than two, which rounds differently.
+ * The shape's paint must be a simple opaque color, and it must not be a
+ * hairline, since overlapping hairline segments would then blend with each
+ * other rather than only with what is under the layer.
+ * Return true on success; false otherwise.
+ */
+static bool remove_savelayer_around_drawshape(SkWriter32* writer,
+                                              SkPaintDictionary* paintDict,
+                                              const CommandInfo& saveLayerInfo,
+                                              const CommandInfo& shapeInfo) {
+    SkASSERT(SAVE_LAYER == saveLayerInfo.fActualOp);
+
+    uint32_t shapePaintOffset = getPaintOffset(shapeInfo.fActualOp, shapeInfo.fSize);
+    uint32_t slPaintOffset = getPaintOffset(SAVE_LAYER, saveLayerInfo.fSize);
+
+    uint32_t shapePaintId = *writer->peek32(shapeInfo.fOffset+shapePaintOffset);
+    uint32_t saveLayerPaintId = *writer->peek32(saveLayerInfo.fOffset+slPaintOffset);
+
+    SkAutoTDelete<SkPaint> shapePaint(paintDict->unflatten(shapePaintId));
+    if (NULL == shapePaint.get() || !is_simple(*shapePaint) ||
+        0xFF != shapePaint->getAlpha() ||
+        (SkPaint::kFill_Style != shapePaint->getStyle() && 0 == shapePaint->getStrokeWidth())) {
+        return false;
+    }
+
+    if (0 != saveLayerPaintId) {
+        SkAutoTDelete<SkPaint> saveLayerPaint(paintDict->unflatten(saveLayerPaintId));
+        if (NULL == saveLayerPaint.get() || !is_simple(*saveLayerPaint) ||
+            0xFF != saveLayerPaint->getAlpha()) {
+            return false;
+        }
+    }
+
+    convert_command_to_noop(writer, saveLayerInfo.fOffset);
+    return true;
+}
+
+/*
+ * Restore has just been called (but not recorded), look back at the
+ * matching save* and see if we are in the configuration:
+ *   SAVE_LAYER
+ *       DRAW_OVAL|DRAW_PATH|DRAW_RECT|DRAW_RRECT
+ *   RESTORE
+ * where the saveLayer is opaque, and so can be removed
+ */
+static bool remove_save_layer3(SkWriter32* writer, int32_t offset,
+                               SkPaintDictionary* paintDict) {
+    // back up to the save block
+    while (offset > 0) {
+        offset = *writer->peek32(offset);
+    }
+
+    int pattern[] = { SAVE_LAYER, kDRAW_SHAPE_FLAVOR, /* RESTORE */ };
+    CommandInfo result[SK_ARRAY_COUNT(pattern)];
+
+    if (!match(writer, -offset, pattern, result, SK_ARRAY_COUNT(pattern))) {
+        return false;
+    }
+
+    if (kSaveLayerWithBoundsSize == result[0].fSize) {
+        // The saveLayer's bounds can clip the shape
+        return false;
+    }
+
+    return remove_savelayer_around_drawshape(writer, paintDict, result[0], result[1]);
+}
+
 /*
  *  Restore has just been called (but not recorded), so look back at the
  *  matching save(), and see if we can eliminate the pair of them, due to no
@@ -508,18 +608,23 @@ enum PictureRecordOptType {
 };
 
 struct PictureRecordOpt {
-    PictureRecordOptProc fProc;
-    PictureRecordOptType fType;
+    PictureRecordOptProc            fProc;
+    PictureRecordOptType            fType;
+    uint32_t                        fOptimization;
 };
 /*
- * A list of the optimizations that are tried upon seeing a restore
- * TODO: add a real API for such optimizations
- *       Add the ability to fire optimizations on any op (not just RESTORE)
+ * A list of the optimizations that are tried upon seeing a restore. The ones
+ * that look at the whole command stream are in gPictureCommandOpts below.
  */
 static const PictureRecordOpt gPictureRecordOpts[] = {
-    { collapse_save_clip_restore, kRewind_OptType },
-    { remove_save_layer1,         kCollapseSaveLayer_OptType },
-    { remove_save_layer2,         kCollapseSaveLayer_OptType }
+    { collapse_save_clip_restore, kRewind_OptType,
+      SkPictureRecord::kCollapseSaveClipRestore_Optimization },
+    { remove_save_layer1,         kCollapseSaveLayer_OptType,
+      SkPictureRecord::kRemoveSaveLayer_Optimization },
+    { remove_save_layer2,         kCollapseSaveLayer_OptType,
+      SkPictureRecord::kRemoveSaveLayer_Optimization },
+    { remove_save_layer3,         kCollapseSaveLayer_OptType,
+      SkPictureRecord::kRemoveSaveLayer_Optimization }
 };
 
 // This is called after an optimization has been applied to the command stream
@@ -566,6 +671,9 @@ void SkPictureRecord::restore() {
     uint32_t initialOffset, size;
     size_t opt;
     for (opt = 0; opt < SK_ARRAY_COUNT(gPictureRecordOpts); ++opt) {
+        if (!this->shouldOptimize(gPictureRecordOpts[opt].fOptimization)) {
+            continue;
+        }
         if ((*gPictureRecordOpts[opt].fProc)(&fWriter, fRestoreOffsetStack.top(), &fPaints)) {
             // Some optimization fired so don't add the RESTORE
             size = 0;
@@ -590,6 +698,9 @@ void SkPictureRecord::restore() {
 }
 
 bool SkPictureRecord::translate(SkScalar dx, SkScalar dy) {
+    if (0 == dx && 0 == dy && this->shouldOptimize(kRemoveRedundantMatrix_Optimization)) {
+        return this->INHERITED::translate(dx, dy);
+    }
     // op + dx + dy
     uint32_t size = 1 * kUInt32Size + 2 * sizeof(SkScalar);
     uint32_t initialOffset = this->addDraw(TRANSLATE, &size);
@@ -600,6 +711,9 @@ bool SkPictureRecord::translate(SkScalar dx, SkScalar dy) {
 }
 
 bool SkPictureRecord::scale(SkScalar sx, SkScalar sy) {
+    if (SK_Scalar1 == sx && SK_Scalar1 == sy && this->shouldOptimize(kRemoveRedundantMatrix_Optimization)) {
+        return this->INHERITED::scale(sx, sy);
+    }
     // op + sx + sy
     uint32_t size = 1 * kUInt32Size + 2 * sizeof(SkScalar);
     uint32_t initialOffset = this->addDraw(SCALE, &size);
@@ -610,6 +724,9 @@ bool SkPictureRecord::scale(SkScalar sx, SkScalar sy) {
 }
 
 bool SkPictureRecord::rotate(SkScalar degrees) {
+    if (0 == degrees && this->shouldOptimize(kRemoveRedundantMatrix_Optimization)) {
+        return this->INHERITED::rotate(degrees);
+    }
     // op + degrees
     uint32_t size = 1 * kUInt32Size + sizeof(SkScalar);
     uint32_t initialOffset = this->addDraw(ROTATE, &size);
@@ -619,6 +736,9 @@ bool SkPictureRecord::rotate(SkScalar degrees) {
 }
 
 bool SkPictureRecord::skew(SkScalar sx, SkScalar sy) {
+    if (0 == sx && 0 == sy && this->shouldOptimize(kRemoveRedundantMatrix_Optimization)) {
+        return this->INHERITED::skew(sx, sy);
+    }
     // op + sx + sy
     uint32_t size = 1 * kUInt32Size + 2 * sizeof(SkScalar);
     uint32_t initialOffset = this->addDraw(SKEW, &size);
@@ -629,6 +749,9 @@ bool SkPictureRecord::skew(SkScalar sx, SkScalar sy) {
 }
 
 bool SkPictureRecord::concat(const SkMatrix& matrix) {
+    if (matrix.isIdentity() && this->shouldOptimize(kRemoveRedundantMatrix_Optimization)) {
+        return this->INHERITED::concat(matrix);
+    }
     validate(fWriter.size(), 0);
     // op + matrix index
     uint32_t size = 2 * kUInt32Size;
@@ -680,6 +803,355 @@ void SkPictureRecord::fillRestoreOffsetPlaceholdersForCurrentStackLevel(uint32_t
 #endif
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+/*
+ * The optimizations in gPictureCommandOpts run once recording is done, over a
+ * copy of the whole command stream. They only turn commands into NOOPs, so
+ * the offsets held by clips, the state tree and the bounding hierarchy stay
+ * valid.
+ */
+class CommandStream {
+public:
+    CommandStream(const SkWriter32& writer, const SkPathHeap* pathHeap)
+        : fData(writer.size())
+        , fPathHeap(pathHeap) {
+        writer.flatten(fData.get());
+
+        uint32_t offset = 0;
+        while (offset < writer.size()) {
+            const uint32_t* ptr = this->peek32(offset);
+            uint32_t op, size;
+            UNPACK_8_24(*ptr, op, size);
+            uint32_t headerSize = kUInt32Size;
+            if (MASK_24 == size) {
+                // size required its own slot right after the op code
+                size = ptr[1];
+                headerSize += kUInt32Size;
+            }
+            if (NOOP != op) {
+                Command* command = fCommands.append();
+                command->fOp = (DrawType) op;
+                command->fOffset = offset;
+                command->fSize = size;
+                command->fHeaderSize = headerSize;
+            }
+            offset += size;
+        }
+    }
+
+    int count() const { return fCommands.count(); }
+
+    // Commands which have been removed report NOOP.
+    DrawType op(int index) const { return fCommands[index].fOp; }
+
+    // The command's data after its op code and size
+    const uint32_t* data(int index) const {
+        const Command& command = fCommands[index];
+        return this->peek32(command.fOffset + command.fHeaderSize);
+    }
+
+    uint32_t dataSize(int index) const {
+        return fCommands[index].fSize - fCommands[index].fHeaderSize;
+    }
+
+    // Each recorded path gets an index of its own, even if it is the same path.
+    const SkPath& path(uint32_t pathIndex) const {
+        SkASSERT(NULL != fPathHeap);
+        return (*fPathHeap)[pathIndex - 1];
+    }
+
+    void remove(int index) {
+        fCommands[index].fOp = NOOP;
+    }
+
+    // Make the commands that were removed NOOPs in the writer too.
+    void apply(SkWriter32* writer) const {
+        for (int i = 0; i < fCommands.count(); ++i) {
+            if (NOOP == fCommands[i].fOp) {
+                convert_command_to_noop(writer, fCommands[i].fOffset);
+            }
+        }
+    }
+
+private:
+    const uint32_t* peek32(uint32_t offset) const {
+        return reinterpret_cast<const uint32_t*>(
+            reinterpret_cast<const char*>(fData.get()) + offset);
+    }
+
+    struct Command {
+        DrawType fOp;
+        uint32_t fOffset;
+        uint32_t fSize;
+        uint32_t fHeaderSize;
+    };
+
+    SkAutoMalloc fData;
+    const SkPathHeap* fPathHeap;
+    SkTDArray<Command> fCommands;
+};
+
+static bool is_draw(DrawType op) {
+    return op >= DRAW_BITMAP && op <= DRAW_VERTICES;
+}
+
+static bool is_matrix_change(DrawType op) {
+    return CONCAT == op || ROTATE == op || SCALE == op ||
+           SET_MATRIX == op || SKEW == op || TRANSLATE == op;
+}
+
+static bool is_clip(DrawType op) {
+    return op >= CLIP_PATH && op <= CLIP_RRECT;
+}
+
+static SkCanvas::SaveFlags get_save_flags(const CommandStream& stream, int index) {
+    if (SAVE == stream.op(index)) {
+        return (SkCanvas::SaveFlags) stream.data(index)[0];
+    }
+    SkASSERT(SAVE_LAYER == stream.op(index));
+    // the flags are the last thing written for a saveLayer
+    return (SkCanvas::SaveFlags) stream.data(index)[stream.dataSize(index) / kUInt32Size - 1];
+}
+
+// Returns the size of a clip's data up to and including its packed clip
+// params, leaving out the restore offset.
+static uint32_t get_clip_size(DrawType op) {
+    switch (op) {
+        case CLIP_PATH:
+        case CLIP_REGION:
+            return 2 * kUInt32Size;
+        case CLIP_RECT:
+            return sizeof(SkRect) + kUInt32Size;
+        case CLIP_RRECT:
+            return SkRRect::kSizeInMemory + kUInt32Size;
+        default:
+            SkASSERT(0);
+            return 0;
+    }
+}
+
+static uint32_t get_clip_params(const CommandStream& stream, int index) {
+    return stream.data(index)[get_clip_size(stream.op(index)) / kUInt32Size - 1];
+}
+
+static bool same_clip(const CommandStream& stream, int index1, int index2) {
+    DrawType op = stream.op(index1);
+    if (op != stream.op(index2)) {
+        return false;
+    }
+    const uint32_t* data1 = stream.data(index1);
+    const uint32_t* data2 = stream.data(index2);
+    if (CLIP_PATH == op) {
+        return data1[1] == data2[1] && stream.path(data1[0]) == stream.path(data2[0]);
+    }
+    return 0 == memcmp(data1, data2, get_clip_size(op));
+}
+
+static int previous_command(const CommandStream& stream, int index) {
+    do {
+        --index;
+    } while (index >= 0 && NOOP == stream.op(index));
+    return index;
+}
+
+/*
+ * Remove matrix changes and clips that nothing uses before the next restore
+ * undoes them, e.g.
+ *   SAVE
+ *      DRAW_RECT
+ *      TRANSLATE   <- removed
+ *      CLIP_RECT   <- removed
+ *   RESTORE
+ * and matrix changes that are replaced by a setMatrix before anything uses them.
+ */
+static void remove_unused_state(CommandStream* stream, uint32_t optimizations) {
+    bool matrix = SkToBool(optimizations & SkPictureRecord::kRemoveRedundantMatrix_Optimization);
+    bool clip = SkToBool(optimizations & SkPictureRecord::kRemoveRedundantClip_Optimization);
+
+    SkTDArray<SkCanvas::SaveFlags> saveStack;
+    for (int i = 0; i < stream->count(); ++i) {
+        DrawType op = stream->op(i);
+        if (SAVE == op || SAVE_LAYER == op) {
+            *saveStack.append() = get_save_flags(*stream, i);
+        } else if (RESTORE == op) {
+            if (saveStack.isEmpty()) {
+                continue;
+            }
+            SkCanvas::SaveFlags flags;
+            saveStack.pop(&flags);
+            bool restoresMatrix = matrix && SkToBool(flags & SkCanvas::kMatrix_SaveFlag);
+            bool restoresClip = clip && SkToBool(flags & SkCanvas::kClip_SaveFlag);
+            for (int j = previous_command(*stream, i); j >= 0; j = previous_command(*stream, j)) {
+                DrawType prevOp = stream->op(j);
+                if ((restoresMatrix && is_matrix_change(prevOp)) ||
+                    (restoresClip && is_clip(prevOp))) {
+                    stream->remove(j);
+                } else {
+                    break;
+                }
+            }
+        } else if (SET_MATRIX == op && matrix) {
+            for (int j = previous_command(*stream, i); j >= 0; j = previous_command(*stream, j)) {
+                if (is_matrix_change(stream->op(j))) {
+                    stream->remove(j);
+                } else {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Remove a setMatrix to the matrix that the last setMatrix already set,
+ * when nothing has changed the matrix since.
+ */
+static void remove_repeated_set_matrix(CommandStream* stream, uint32_t optimizations) {
+    static const uint32_t kUnknownMatrix = SK_MaxU32;
+
+    uint32_t currentMatrix = kUnknownMatrix;
+    for (int i = 0; i < stream->count(); ++i) {
+        DrawType op = stream->op(i);
+        if (SET_MATRIX == op) {
+            uint32_t matrix = stream->data(i)[0];
+            if (matrix == currentMatrix) {
+                stream->remove(i);
+            }
+            currentMatrix = matrix;
+        } else if (is_matrix_change(op) || RESTORE == op || DRAW_PICTURE == op) {
+            currentMatrix = kUnknownMatrix;
+        }
+    }
+}
+
+/*
+ * Remove a non-antialiased intersecting clip that repeats one which is still
+ * in effect, with no change to the matrix in between. Intersecting with the
+ * same shape again does not change the clip.
+ */
+static void remove_repeated_clips(CommandStream* stream, uint32_t optimizations) {
+    // Only the most recent clips are compared against, to bound the cost of
+    // long runs of clips.
+    static const int kMaxActiveClips = 8;
+
+    SkTDArray<int> activeClips;
+    for (int i = 0; i < stream->count(); ++i) {
+        DrawType op = stream->op(i);
+        if (is_clip(op)) {
+            uint32_t params = get_clip_params(*stream, i);
+            SkRegion::Op regionOp = ClipParams_unpackRegionOp(params);
+            if (SkRegion::kIntersect_Op != regionOp) {
+                if (regionOpExpands(regionOp)) {
+                    activeClips.rewind();
+                }
+                continue;
+            }
+            if (CLIP_REGION != op && ClipParams_unpackDoAA(params)) {
+                continue;
+            }
+
+            bool repeated = false;
+            for (int j = 0; j < activeClips.count(); ++j) {
+                if (same_clip(*stream, activeClips[j], i)) {
+                    repeated = true;
+                    break;
+                }
+            }
+            if (repeated) {
+                stream->remove(i);
+            } else {
+                if (kMaxActiveClips == activeClips.count()) {
+                    activeClips.remove(0);
+                }
+                *activeClips.append() = i;
+            }
+        } else if (is_matrix_change(op) || RESTORE == op || DRAW_PICTURE == op) {
+            activeClips.rewind();
+        }
+    }
+}
+
+/*
+ * Remove a save/restore pair with nothing but draws in between, e.g.
+ *   SAVE        <- removed
+ *      DRAW_RECT
+ *      DRAW_PATH
+ *   RESTORE     <- removed
+ * Pairs nested in each other are removed from the innermost out.
+ */
+static void remove_save_restore_around_draws(CommandStream* stream, uint32_t optimizations) {
+    struct Save {
+        int  fIndex;
+        bool fOnlyDraws;    // so far
+    };
+
+    SkTDArray<Save> saveStack;
+    for (int i = 0; i < stream->count(); ++i) {
+        DrawType op = stream->op(i);
+        if (SAVE == op || SAVE_LAYER == op) {
+            Save* save = saveStack.append();
+            save->fIndex = i;
+            // a layer changes how its draws are composited, so it must stay
+            save->fOnlyDraws = (SAVE == op);
+        } else if (RESTORE == op) {
+            if (saveStack.isEmpty()) {
+                continue;
+            }
+            Save save;
+            saveStack.pop(&save);
+            if (save.fOnlyDraws) {
+                stream->remove(save.fIndex);
+                stream->remove(i);
+            } else if (!saveStack.isEmpty()) {
+                saveStack.top().fOnlyDraws = false;
+            }
+        } else if (!is_draw(op) && NOOP != op && !saveStack.isEmpty()) {
+            saveStack.top().fOnlyDraws = false;
+        }
+    }
+}
+
+typedef void (*PictureCommandOptProc)(CommandStream* stream, uint32_t optimizations);
+
+struct PictureCommandOpt {
+    PictureCommandOptProc fProc;
+    uint32_t              fOptimizations;   // the proc runs if any of these are on
+};
+
+/*
+ * The optimizations run over the whole command stream by endRecording(), in
+ * order. Removing the save/restore pairs comes last, since the others can
+ * leave only draws between a save and its restore.
+ */
+static const PictureCommandOpt gPictureCommandOpts[] = {
+    { remove_unused_state,              SkPictureRecord::kRemoveRedundantMatrix_Optimization |
+                                        SkPictureRecord::kRemoveRedundantClip_Optimization },
+    { remove_repeated_set_matrix,       SkPictureRecord::kRemoveRedundantMatrix_Optimization },
+    { remove_repeated_clips,            SkPictureRecord::kRemoveRedundantClip_Optimization },
+    { remove_save_restore_around_draws, SkPictureRecord::kRemoveSaveRestore_Optimization },
+};
+
+void SkPictureRecord::optimizeCommands() {
+    uint32_t all = 0;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gPictureCommandOpts); ++i) {
+        all |= gPictureCommandOpts[i].fOptimizations;
+    }
+    if (!this->shouldOptimize(all)) {
+        return;
+    }
+
+    // The path heap may be shared with records on other threads.
+    SkAutoMutexAcquire lock(fDictionaries->getMutex());
+    CommandStream stream(fWriter, fPathHeap);
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gPictureCommandOpts); ++i) {
+        if (this->shouldOptimize(gPictureCommandOpts[i].fOptimizations)) {
+            (*gPictureCommandOpts[i].fProc)(&stream, fOptimizations);
+        }
+    }
+    stream.apply(&fWriter);
+}
+
 void SkPictureRecord::beginRecording() {
     // we have to call this *after* our constructor, to ensure that it gets
     // recorded. This is balanced by restoreToCount() call from endRecording,
@@ -690,6 +1162,76 @@ void SkPictureRecord::beginRecording() {
 void SkPictureRecord::endRecording() {
     SkASSERT(kNoInitialSave != fInitialSaveCount);
     this->restoreToCount(fInitialSaveCount);
+    this->optimizeCommands();
+}
+
+void SkPictureRecord::appendRecord(const SkPictureRecord& src, SkScalar dx, SkScalar dy) {
+    SkASSERT(fDictionaries == src.fDictionaries);
+    SkASSERT(this != &src);
+
+    uint32_t srcSize = src.fWriter.size();
+    if (0 == srcSize) {
+        return;
+    }
+
+    this->save(kMatrixClip_SaveFlag);
+    this->translate(dx, dy);
+
+    // The commands go in as they are, since they index the same dictionaries.
+    uint32_t base = fWriter.size();
+    uint32_t* commands = fWriter.reserve(srcSize);
+    src.fWriter.flatten(commands);
+
+    uint32_t offset = 0;
+    while (offset < srcSize) {
+        uint32_t* ptr = commands + offset / kUInt32Size;
+        uint32_t op, size;
+        UNPACK_8_24(*ptr, op, size);
+        uint32_t* data = ptr + 1;
+        if (MASK_24 == size) {
+            // size required its own slot right after the op code
+            size = *data++;
+        }
+        uint32_t* stop = ptr + size / kUInt32Size;
+
+        switch (op) {
+            case CLIP_PATH:
+            case CLIP_REGION:
+            case CLIP_RECT:
+            case CLIP_RRECT:
+                // A clip inside a save ends with the offset of the restore
+                // to skip to, or 0 for none.
+                if (data + get_clip_size((DrawType) op) / kUInt32Size < stop &&
+                    0 != stop[-1]) {
+                    stop[-1] += base;
+                }
+                break;
+            case DRAW_PICTURE: {
+                SkPicture* picture = src.fPictureRefs[*data - 1];
+                int index = fPictureRefs.find(picture);
+                if (index < 0) {
+                    index = fPictureRefs.count();
+                    *fPictureRefs.append() = picture;
+                    picture->ref();
+                }
+                *data = index + 1;
+            } break;
+            case SET_MATRIX:
+                // The matrix replaces the translation, so has to include it.
+                if (0 != dx || 0 != dy) {
+                    SkAutoTDelete<SkMatrix> matrix(fMatrices.unflatten(*data));
+                    matrix->postTranslate(dx, dy);
+                    *data = fMatrices.find(*matrix);
+                }
+                break;
+            default:
+                break;
+        }
+        offset += size;
+    }
+    SkASSERT(offset == srcSize);
+
+    this->restore();
 }
 
 void SkPictureRecord::recordRestoreOffsetPlaceholder(SkRegion::Op op) {
@@ -976,12 +1518,19 @@ static void computeFontMetricsTopBottom(const SkPaint& paint, SkScalar topbot[2]
 
 void SkPictureRecord::addFontMetricsTopBottom(const SkPaint& paint, const SkFlatData& flat,
                                               SkScalar minY, SkScalar maxY) {
-    if (!flat.isTopBotWritten()) {
-        computeFontMetricsTopBottom(paint, flat.writableTopBot());
-        SkASSERT(flat.isTopBotWritten());
+    SkScalar topBot[2];
+    {
+        // The flattened paint may be shared with records on other threads.
+        SkAutoMutexAcquire lock(fDictionaries->getMutex());
+        if (!flat.isTopBotWritten()) {
+            computeFontMetricsTopBottom(paint, flat.writableTopBot());
+            SkASSERT(flat.isTopBotWritten());
+        }
+        topBot[0] = flat.topBot()[0];
+        topBot[1] = flat.topBot()[1];
     }
-    addScalar(flat.topBot()[0] + minY);
-    addScalar(flat.topBot()[1] + maxY);
+    addScalar(topBot[0] + minY);
+    addScalar(topBot[1] + maxY);
 }
 
 void SkPictureRecord::drawText(const void* text, size_t byteLength, SkScalar x,
@@ -1214,7 +1763,11 @@ void SkPictureRecord::drawData(const void* data, size_t length) {
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkPictureRecord::addBitmap(const SkBitmap& bitmap) {
-    const int index = fBitmapHeap->insert(bitmap);
+    int index;
+    {
+        SkAutoMutexAcquire lock(fDictionaries->getMutex());
+        index = fBitmapHeap->insert(bitmap);
+    }
     // In debug builds, a bad return value from insert() will crash, allowing for debugging. In
     // release builds, the invalid value will be recorded so that the reader will know that there
     // was a problem.
@@ -1241,7 +1794,12 @@ void SkPictureRecord::addPath(const SkPath& path) {
     if (NULL == fPathHeap) {
         fPathHeap = SkNEW(SkPathHeap);
     }
-    addInt(fPathHeap->append(path));
+    int index;
+    {
+        SkAutoMutexAcquire lock(fDictionaries->getMutex());
+        index = fPathHeap->append(path);
+    }
+    addInt(index);
 }
 
 void SkPictureRecord::addPicture(SkPicture& picture) {
@@ -27,12 +27,79 @@ class SkBBoxHierarchy;
     large = combined & MASK_24;
 #define PACK_8_24(small, large) ((small << 24) | large)
 
+/**
+ *  The dictionaries and heaps that recorded commands refer to by index. Each
+ *  SkPictureRecord normally has its own, but records that share a thread-safe
+ *  one, as those of an SkPictureRecordGroup do, can be recorded on different
+ *  threads and have their commands spliced together with appendRecord().
+ */
+class SkPictureDictionaries : public SkRefCnt {
+public:
+    SK_DECLARE_INST_COUNT(SkPictureDictionaries)
+
+    explicit SkPictureDictionaries(bool threadSafe);
+    virtual ~SkPictureDictionaries();
+
+    // NULL unless thread-safe. Guards the path and bitmap heaps, and the
+    // font metrics cached in flattened paints; the dictionaries lock it
+    // themselves.
+    SkBaseMutex* getMutex() { return fFlattenableHeap.getMutex(); }
+
+    SkChunkFlatController fFlattenableHeap;
+
+    SkMatrixDictionary fMatrices;
+    SkPaintDictionary fPaints;
+    SkRegionDictionary fRegions;
+
+    // Only allocated here when thread-safe, since records which don't share
+    // their dictionaries allocate their path heap lazily.
+    SkPathHeap* fPathHeap;  // reference counted
+
+private:
+    typedef SkRefCnt INHERITED;
+};
+
 
 class SkPictureRecord : public SkCanvas {
 public:
-    SkPictureRecord(uint32_t recordFlags, SkDevice*);
+    /**
+     *  If dictionaries is NULL, the record allocates its own.
+     */
+    /**
+     *  optimizations is the set of Optimizations below to apply, which tests
+     *  narrow to check each of them on its own.
+     */
+    SkPictureRecord(uint32_t recordFlags, SkDevice*, SkPictureDictionaries* dictionaries = NULL,
+                    uint32_t optimizations = kAll_Optimizations);
     virtual ~SkPictureRecord();
 
+    /**
+     *  The rewrites applied to the recorded commands, each of which leaves
+     *  what the picture draws unchanged. Some are applied as each restore()
+     *  is recorded, the rest over the whole command stream in endRecording().
+     *  None are applied when the picture is recorded with
+     *  SkPicture::kDisableRecordOptimizations_RecordingFlag.
+     */
+    enum Optimizations {
+        // A save/restore with only matrix and clip changes in between is removed.
+        kCollapseSaveClipRestore_Optimization   = 0x01,
+        // A saveLayer/restore around a single bitmap draw is removed, with the
+        // layer's alpha moved into the draw's paint, as is an opaque one
+        // around a single shape draw.
+        kRemoveSaveLayer_Optimization           = 0x02,
+        // A save/restore with only draws in between is removed.
+        kRemoveSaveRestore_Optimization         = 0x04,
+        // Matrix changes that are the identity, that are replaced by a
+        // setMatrix() before anything uses them, or that are undone by the
+        // next restore() are removed, as is a setMatrix() to the current matrix.
+        kRemoveRedundantMatrix_Optimization     = 0x08,
+        // Clips that are undone by the next restore() are removed, as is a
+        // non-antialiased intersecting clip that is already in effect.
+        kRemoveRedundantClip_Optimization       = 0x10,
+
+        kAll_Optimizations                      = 0x1F
+    };
+
     virtual SkDevice* setDevice(SkDevice* device) SK_OVERRIDE;
 
     virtual int save(SaveFlags) SK_OVERRIDE;
@@ -102,7 +169,22 @@ public:
     void beginRecording();
     void endRecording();
 
+    /**
+     *  Record the commands of 'src', translated by (dx, dy), between a save and
+     *  a restore. 'src' must have ended recording and share this record's
+     *  dictionaries, so its commands are copied as they are, only adjusting
+     *  the offsets and picture indices in them.
+     */
+    void appendRecord(const SkPictureRecord& src, SkScalar dx, SkScalar dy);
+
 private:
+    // Returns true if any of the given optimizations are on.
+    bool shouldOptimize(uint32_t optimizations) const {
+        return SkToBool(fOptimizations & optimizations) &&
+               !(fRecordFlags & SkPicture::kDisableRecordOptimizations_RecordingFlag);
+    }
+    void optimizeCommands();
+
     void handleOptimization(int opt);
     void recordRestoreOffsetPlaceholder(SkRegion::Op);
     void fillRestoreOffsetPlaceholdersForCurrentStackLevel(
@@ -222,11 +304,14 @@ protected:
     SkBitmapHeap* fBitmapHeap;
 
 private:
-    SkChunkFlatController fFlattenableHeap;
+    SkPictureDictionaries* fDictionaries;  // reference counted
 
-    SkMatrixDictionary fMatrices;
-    SkPaintDictionary fPaints;
-    SkRegionDictionary fRegions;
+    // The dictionaries in fDictionaries.
+    SkChunkFlatController& fFlattenableHeap;
+
+    SkMatrixDictionary& fMatrices;
+    SkPaintDictionary& fPaints;
+    SkRegionDictionary& fRegions;
 
     SkPathHeap* fPathHeap;  // reference counted
     SkWriter32 fWriter;
@@ -235,6 +320,7 @@ private:
     SkTDArray<SkPicture*> fPictureRefs;
 
     uint32_t fRecordFlags;
+    uint32_t fOptimizations;
     int fInitialSaveCount;
 
     friend class SkPicturePlayback;
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureRecordGroup.h"
+
+#include "SkDevice.h"
+#include "SkPictureRecord.h"
+
+class SkPictureRecordGroup::Part {
+public:
+    Part() : fRecord(NULL), fEnded(false) {}
+    ~Part() { SkSafeUnref(fRecord); }
+
+    SkPictureRecord* fRecord;
+    bool             fEnded;
+};
+
+static SkDevice* create_record_device(int width, int height) {
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kNo_Config, width, height);
+    return SkNEW_ARGS(SkDevice, (bm));
+}
+
+SkPictureRecordGroup::SkPictureRecordGroup(int partCount, uint32_t recordFlags)
+    : fPartCount(partCount)
+    , fRecordFlags(recordFlags & ~(SkPicture::kOptimizeForClippedPlayback_RecordingFlag |
+                                   SkPicture::kCullOccludedDraws_RecordingFlag)) {
+    SkASSERT(partCount >= 0);
+    fDictionaries = SkNEW_ARGS(SkPictureDictionaries, (true));
+    fParts = SkNEW_ARRAY(Part, partCount);
+}
+
+SkPictureRecordGroup::~SkPictureRecordGroup() {
+    SkDELETE_ARRAY(fParts);
+    fDictionaries->unref();
+}
+
+SkCanvas* SkPictureRecordGroup::beginRecording(int part, int width, int height) {
+    SkASSERT((unsigned)part < (unsigned)fPartCount);
+    SkASSERT(NULL == fParts[part].fRecord);
+
+    SkAutoTUnref<SkDevice> dev(create_record_device(width, height));
+    SkPictureRecord* record = SkNEW_ARGS(SkPictureRecord, (fRecordFlags, dev, fDictionaries));
+    record->beginRecording();
+    fParts[part].fRecord = record;
+    return record;
+}
+
+void SkPictureRecordGroup::endRecording(int part) {
+    SkASSERT((unsigned)part < (unsigned)fPartCount);
+    Part& p = fParts[part];
+    if (NULL != p.fRecord && !p.fEnded) {
+        p.fRecord->endRecording();
+        p.fEnded = true;
+    }
+}
+
+SkPicture* SkPictureRecordGroup::createSplicedPicture(int width, int height,
+                                                      const SkPoint offsets[]) {
+    SkAutoTUnref<SkDevice> dev(create_record_device(width, height));
+    SkPictureRecord* record = SkNEW_ARGS(SkPictureRecord, (fRecordFlags, dev, fDictionaries));
+    record->beginRecording();
+    for (int i = 0; i < fPartCount; ++i) {
+        if (NULL == fParts[i].fRecord) {
+            continue;
+        }
+        this->endRecording(i);
+        record->appendRecord(*fParts[i].fRecord, offsets[i].fX, offsets[i].fY);
+        // The part's commands have been copied, so free them now.
+        fParts[i].fRecord->unref();
+        fParts[i].fRecord = NULL;
+    }
+
+    SkPicture* picture = SkNEW(SkPicture);
+    picture->fWidth = width;
+    picture->fHeight = height;
+    picture->fRecord = record;
+    picture->endRecording();
+    return picture;
+}
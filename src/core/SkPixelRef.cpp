@@ -65,6 +65,7 @@ SkPixelRef::SkPixelRef(SkBaseMutex* mutex) : fPreLocked(false) {
     fColorTable = NULL; // we do not track ownership of this
     fLockCount = 0;
     fGenerationID = 0;  // signal to rebuild
+    fMipMap = NULL;
     fIsImmutable = false;
     fPreLocked = false;
 }
@@ -77,9 +78,14 @@ SkPixelRef::SkPixelRef(SkFlattenableReadBuffer& buffer, SkBaseMutex* mutex)
     fLockCount = 0;
     fIsImmutable = buffer.readBool();
     fGenerationID = buffer.readUInt();
+    fMipMap = NULL;
     fPreLocked = false;
 }
 
+SkPixelRef::~SkPixelRef() {
+    SkBitmap::UnrefMipMap(fMipMap);
+}
+
 void SkPixelRef::setPreLocked(void* pixels, SkColorTable* ctable) {
 #ifndef SK_IGNORE_PIXELREF_SETPRELOCKED
     // only call me in your constructor, otherwise fLockCount tracking can get
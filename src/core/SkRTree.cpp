@@ -9,6 +9,10 @@
 #include "SkRTree.h"
 #include "SkTSort.h"
 
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <emmintrin.h>
+#endif
+
 static inline uint32_t get_area(const SkIRect& rect);
 static inline uint32_t get_overlap(const SkIRect& rect1, const SkIRect& rect2);
 static inline uint32_t get_margin(const SkIRect& rect);
@@ -17,6 +21,12 @@ static inline uint32_t get_overlap_increase(const SkIRect& rect1, const SkIRect&
 static inline uint32_t get_area_increase(const SkIRect& rect1, SkIRect rect2);
 static inline void join_no_empty_check(const SkIRect& joinWith, SkIRect* out);
 
+static const size_t kCacheLineSize = 64;
+
+static inline unsigned intersect_four(const int32_t lefts[], const int32_t tops[],
+                                      const int32_t rights[], const int32_t bottoms[],
+                                      const SkIRect& query);
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 SK_DEFINE_INST_COUNT(SkRTree)
@@ -35,7 +45,12 @@ SkRTree::SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio)
     , fNodeSize(sizeof(Node) + sizeof(Branch) * maxChildren)
     , fCount(0)
     , fNodes(fNodeSize * 256)
-    , fAspectRatio(aspectRatio) {
+    , fAspectRatio(aspectRatio)
+    , fPackedStride(SkAlign4(maxChildren))
+    , fPackedNodeSize((sizeof(PackedNode) + 4 * sizeof(int32_t) * fPackedStride +
+                       kCacheLineSize - 1) & ~(kCacheLineSize - 1))
+    , fPackBulkLoads(true)
+    , fPackedNodes(NULL) {
     SkASSERT(minChildren < maxChildren && minChildren > 0 && maxChildren <
              static_cast<int>(SK_MaxU16));
     SkASSERT((maxChildren + 1) / 2 >= minChildren);
@@ -65,6 +80,8 @@ void SkRTree::insert(void* data, const SkIRect& bounds, bool defer) {
             fRoot.fChild.subtree = allocateNode(0);
             fRoot.fChild.subtree->fNumChildren = 0;
         }
+    } else if (this->isPacked()) {
+        this->unpack();
     }
 
     Branch* newSibling = insert(fRoot.fChild.subtree, &newBranch);
@@ -96,6 +113,9 @@ void SkRTree::flushDeferredInserts() {
         } else {
             fRoot = this->bulkLoad(&fDeferredInserts);
         }
+        if (fPackBulkLoads) {
+            this->pack();
+        }
     } else {
         // TODO: some algorithm for bulk loading into an already populated tree
         SkASSERT(0 == fDeferredInserts.count());
@@ -110,14 +130,66 @@ void SkRTree::search(const SkIRect& query, SkTDArray<void*>* results) {
         this->flushDeferredInserts();
     }
     if (!this->isEmpty() && SkIRect::IntersectsNoEmptyCheck(fRoot.fBounds, query)) {
-        this->search(fRoot.fChild.subtree, query, results);
+        if (this->isPacked()) {
+            this->searchPacked(0, query, results);
+        } else {
+            this->search(fRoot.fChild.subtree, query, results);
+        }
     }
     this->validate();
 }
 
+void SkRTree::searchBatch(const SkIRect queries[], int count, SkTDArray<void*> results[]) {
+    if (0 != fDeferredInserts.count()) {
+        this->flushDeferredInserts();
+    }
+    if (!this->isPacked()) {
+        this->INHERITED::searchBatch(queries, count, results);
+        return;
+    }
+    this->validate();
+    // Each walk of the tree answers a batch of the queries, with a bit of a mask for each
+    QueryBatch batch;
+    for (int first = 0; first < count; first += QueryBatch::kMaxBatchCount) {
+        int batchCount = SkMin32(QueryBatch::kMaxBatchCount, count - first);
+        batch.fCount = SkAlign4(batchCount);
+        uint32_t queryMask = 0;
+        for (int i = 0; i < batch.fCount; ++i) {
+            if (i < batchCount) {
+                const SkIRect& query = queries[first + i];
+                batch.fLefts[i] = query.fLeft;
+                batch.fTops[i] = query.fTop;
+                batch.fRights[i] = query.fRight;
+                batch.fBottoms[i] = query.fBottom;
+                if (SkIRect::IntersectsNoEmptyCheck(fRoot.fBounds, query)) {
+                    queryMask |= 1u << i;
+                }
+            } else {
+                batch.fLefts[i] = batch.fTops[i] = SK_MaxS32;
+                batch.fRights[i] = batch.fBottoms[i] = SK_MinS32;
+            }
+        }
+        if (0 != queryMask) {
+            this->searchPacked(0, batch, queryMask, results + first);
+        }
+    }
+    this->validate();
+}
+
+int SkRTree::getDepth() const {
+    if (this->isEmpty()) {
+        return 0;
+    }
+    if (this->isPacked()) {
+        return this->packedNode(0)->fLevel + 1;
+    }
+    return fRoot.fChild.subtree->fLevel + 1;
+}
+
 void SkRTree::clear() {
     this->validate();
     fNodes.reset();
+    this->freePacked();
     fDeferredInserts.rewind();
     fCount = 0;
     this->validate();
@@ -316,6 +388,175 @@ void SkRTree::search(Node* root, const SkIRect query, SkTDArray<void*>* results)
     }
 }
 
+void SkRTree::searchPacked(int index, const SkIRect& query, SkTDArray<void*>* results) const {
+    const PackedNode* node = this->packedNode(index);
+    const int32_t* lefts = node->bounds();
+    const int32_t* tops = lefts + fPackedStride;
+    const int32_t* rights = tops + fPackedStride;
+    const int32_t* bottoms = rights + fPackedStride;
+
+    // Test the children four at a time; the unused entries at the end of the arrays never
+    // intersect.
+    for (int i = 0; i < node->fNumChildren; i += 4) {
+        unsigned hits = intersect_four(lefts + i, tops + i, rights + i, bottoms + i, query);
+        for (int j = i; 0 != hits; ++j, hits >>= 1) {
+            if (hits & 1) {
+                if (node->isLeaf()) {
+                    results->push(fPackedData[node->fFirstChild + j]);
+                } else {
+                    this->searchPacked(node->fFirstChild + j, query, results);
+                }
+            }
+        }
+    }
+}
+
+void SkRTree::searchPacked(int index, const QueryBatch& batch, uint32_t queryMask,
+                           SkTDArray<void*> results[]) const {
+    const PackedNode* node = this->packedNode(index);
+    const int32_t* lefts = node->bounds();
+    const int32_t* tops = lefts + fPackedStride;
+    const int32_t* rights = tops + fPackedStride;
+    const int32_t* bottoms = rights + fPackedStride;
+
+    // Only the children which intersect the bounds of all the queries can intersect any of them
+    SkIRect queryBounds = SkIRect::MakeLTRB(SK_MaxS32, SK_MaxS32, SK_MinS32, SK_MinS32);
+    for (int q = 0; q < batch.fCount; ++q) {
+        if (queryMask & (1u << q)) {
+            join_no_empty_check(SkIRect::MakeLTRB(batch.fLefts[q], batch.fTops[q],
+                                                  batch.fRights[q], batch.fBottoms[q]),
+                                &queryBounds);
+        }
+    }
+
+    for (int i = 0; i < node->fNumChildren; i += 4) {
+        unsigned boundsHits = intersect_four(lefts + i, tops + i, rights + i, bottoms + i,
+                                             queryBounds);
+        for (int j = i; 0 != boundsHits; ++j, boundsHits >>= 1) {
+            if (0 == (boundsHits & 1)) {
+                continue;
+            }
+            // Find which of the queries that reached this node intersect the child, four at a time
+            SkIRect child = SkIRect::MakeLTRB(lefts[j], tops[j], rights[j], bottoms[j]);
+            uint32_t hits = 0;
+            for (int q = 0; q < batch.fCount; q += 4) {
+                hits |= intersect_four(batch.fLefts + q, batch.fTops + q, batch.fRights + q,
+                                       batch.fBottoms + q, child) << q;
+            }
+            hits &= queryMask;
+            if (0 == hits) {
+                continue;
+            }
+            if (node->isLeaf()) {
+                void* data = fPackedData[node->fFirstChild + j];
+                for (int q = 0; 0 != hits; ++q, hits >>= 1) {
+                    if (hits & 1) {
+                        results[q].push(data);
+                    }
+                }
+            } else {
+                this->searchPacked(node->fFirstChild + j, batch, hits, results);
+            }
+        }
+    }
+}
+
+void SkRTree::pack() {
+    SkASSERT(!this->isEmpty() && !this->isPacked());
+
+    // List the nodes breadth-first, which puts the children of each node next to each other
+    SkTDArray<Node*> nodes;
+    nodes.push(fRoot.fChild.subtree);
+    for (int i = 0; i < nodes.count(); ++i) {
+        Node* node = nodes[i];
+        if (!node->isLeaf()) {
+            for (int j = 0; j < node->fNumChildren; ++j) {
+                nodes.push(node->child(j)->fChild.subtree);
+            }
+        }
+    }
+
+    // Allocate an extra cache line, so that the nodes can all start on one
+    intptr_t storage = reinterpret_cast<intptr_t>(
+        fPackedStorage.reset(nodes.count() * fPackedNodeSize + kCacheLineSize));
+    fPackedNodes = reinterpret_cast<char*>((storage + kCacheLineSize - 1) &
+                                           ~static_cast<intptr_t>(kCacheLineSize - 1));
+    fPackedData.setReserve(fCount);
+
+    int nextChild = 1;
+    for (int i = 0; i < nodes.count(); ++i) {
+        Node* node = nodes[i];
+        PackedNode* packed = this->packedNode(i);
+        packed->fNumChildren = node->fNumChildren;
+        packed->fLevel = node->fLevel;
+        packed->fPad[0] = packed->fPad[1] = 0;
+
+        int32_t* lefts = packed->bounds();
+        int32_t* tops = lefts + fPackedStride;
+        int32_t* rights = tops + fPackedStride;
+        int32_t* bottoms = rights + fPackedStride;
+        for (int j = 0; j < fPackedStride; ++j) {
+            if (j < node->fNumChildren) {
+                const SkIRect& bounds = node->child(j)->fBounds;
+                lefts[j] = bounds.fLeft;
+                tops[j] = bounds.fTop;
+                rights[j] = bounds.fRight;
+                bottoms[j] = bounds.fBottom;
+            } else {
+                lefts[j] = tops[j] = SK_MaxS32;
+                rights[j] = bottoms[j] = SK_MinS32;
+            }
+        }
+
+        if (node->isLeaf()) {
+            packed->fFirstChild = fPackedData.count();
+            for (int j = 0; j < node->fNumChildren; ++j) {
+                fPackedData.push(node->child(j)->fChild.data);
+            }
+        } else {
+            packed->fFirstChild = nextChild;
+            nextChild += node->fNumChildren;
+        }
+    }
+    SkASSERT(nodes.count() == nextChild);
+
+    fNodes.reset();
+    fRoot.fChild.subtree = NULL;
+}
+
+void SkRTree::unpack() {
+    SkASSERT(this->isPacked());
+    fRoot.fChild.subtree = this->unpackSubtree(0);
+    this->freePacked();
+}
+
+SkRTree::Node* SkRTree::unpackSubtree(int index) {
+    const PackedNode* packed = this->packedNode(index);
+    const int32_t* lefts = packed->bounds();
+    const int32_t* tops = lefts + fPackedStride;
+    const int32_t* rights = tops + fPackedStride;
+    const int32_t* bottoms = rights + fPackedStride;
+
+    Node* node = this->allocateNode(packed->fLevel);
+    node->fNumChildren = packed->fNumChildren;
+    for (int i = 0; i < packed->fNumChildren; ++i) {
+        Branch* branch = node->child(i);
+        branch->fBounds.set(lefts[i], tops[i], rights[i], bottoms[i]);
+        if (packed->isLeaf()) {
+            branch->fChild.data = fPackedData[packed->fFirstChild + i];
+        } else {
+            branch->fChild.subtree = this->unpackSubtree(packed->fFirstChild + i);
+        }
+    }
+    return node;
+}
+
+void SkRTree::freePacked() {
+    fPackedStorage.free();
+    fPackedNodes = NULL;
+    fPackedData.reset();
+}
+
 SkRTree::Branch SkRTree::bulkLoad(SkTDArray<Branch>* branches, int level) {
     if (branches->count() == 1) {
         // Only one branch: it will be the root
@@ -397,7 +638,12 @@ void SkRTree::validate() {
     if (this->isEmpty()) {
         return;
     }
-    SkASSERT(fCount == (size_t)this->validateSubtree(fRoot.fChild.subtree, fRoot.fBounds, true));
+    if (this->isPacked()) {
+        SkASSERT(fCount == (size_t)this->validatePackedSubtree(0, fRoot.fBounds, true));
+    } else {
+        SkASSERT(fCount == (size_t)this->validateSubtree(fRoot.fChild.subtree, fRoot.fBounds,
+                                                         true));
+    }
 #endif
 }
 
@@ -434,6 +680,47 @@ int SkRTree::validateSubtree(Node* root, SkIRect bounds, bool isRoot) {
     }
 }
 
+int SkRTree::validatePackedSubtree(int index, SkIRect bounds, bool isRoot) {
+    const PackedNode* node = this->packedNode(index);
+    SkASSERT(0 == (reinterpret_cast<intptr_t>(node) & (kCacheLineSize - 1)));
+
+    if (isRoot) {
+        if (node->isLeaf()) {
+            SkASSERT(node->fNumChildren >= 1 && node->fNumChildren <= fMaxChildren);
+        } else {
+            SkASSERT(node->fNumChildren >= 2 && node->fNumChildren <= fMaxChildren);
+        }
+    } else {
+        SkASSERT(node->fNumChildren >= fMinChildren && node->fNumChildren <= fMaxChildren);
+    }
+
+    const int32_t* lefts = node->bounds();
+    const int32_t* tops = lefts + fPackedStride;
+    const int32_t* rights = tops + fPackedStride;
+    const int32_t* bottoms = rights + fPackedStride;
+    for (int i = 0; i < fPackedStride; ++i) {
+        if (i < node->fNumChildren) {
+            SkASSERT(bounds.contains(lefts[i], tops[i], rights[i], bottoms[i]));
+        } else {
+            SkASSERT(SK_MaxS32 == lefts[i] && SK_MinS32 == rights[i]);
+        }
+    }
+
+    if (node->isLeaf()) {
+        SkASSERT(node->fFirstChild + node->fNumChildren <= fPackedData.count());
+        return node->fNumChildren;
+    } else {
+        int childCount = 0;
+        for (int i = 0; i < node->fNumChildren; ++i) {
+            int child = node->fFirstChild + i;
+            SkASSERT(this->packedNode(child)->fLevel == node->fLevel - 1);
+            SkIRect childBounds = SkIRect::MakeLTRB(lefts[i], tops[i], rights[i], bottoms[i]);
+            childCount += this->validatePackedSubtree(child, childBounds);
+        }
+        return childCount;
+    }
+}
+
 void SkRTree::rewindInserts() {
     SkASSERT(this->isEmpty()); // Currently only supports deferred inserts
     while (!fDeferredInserts.isEmpty() &&
@@ -470,6 +757,33 @@ static inline uint32_t get_area_increase(const SkIRect& rect1, SkIRect rect2) {
     return get_area(rect2) - get_area(rect1);
 }
 
+// Returns a mask with bit i set if the i'th of the four rects whose sides are given intersects
+// 'query'.
+static inline unsigned intersect_four(const int32_t lefts[], const int32_t tops[],
+                                      const int32_t rights[], const int32_t bottoms[],
+                                      const SkIRect& query) {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    __m128i inX = _mm_and_si128(
+        _mm_cmplt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lefts)),
+                        _mm_set1_epi32(query.fRight)),
+        _mm_cmplt_epi32(_mm_set1_epi32(query.fLeft),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(rights))));
+    __m128i inY = _mm_and_si128(
+        _mm_cmplt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tops)),
+                        _mm_set1_epi32(query.fBottom)),
+        _mm_cmplt_epi32(_mm_set1_epi32(query.fTop),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottoms))));
+    return _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(inX, inY)));
+#else
+    unsigned hits = 0;
+    for (int i = 0; i < 4; ++i) {
+        hits |= ((lefts[i] < query.fRight) & (query.fLeft < rights[i]) &
+                 (tops[i] < query.fBottom) & (query.fTop < bottoms[i])) << i;
+    }
+    return hits;
+#endif
+}
+
 // Expand 'out' to include 'joinWith'
 static inline void join_no_empty_check(const SkIRect& joinWith, SkIRect* out) {
     // since we check for empty bounds on insert, we know we'll never have empty rects
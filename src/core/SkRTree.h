@@ -39,6 +39,13 @@
  * It also supports bulk-loading from a batch of bounds and values; if you don't require the tree
  * to be usable in its intermediate states while it is being constructed, this is significantly
  * quicker than individual insertions and produces more consistent trees.
+ *
+ * A bulk-loaded tree is then packed into a single flat array of nodes, in breadth-first order
+ * with each node aligned to a cache line, and the bounds of a node's children stored as separate
+ * arrays of lefts, tops, rights and bottoms so that several children can be tested against a query
+ * at once. Searching the packed tree touches far less memory than chasing the pointers between
+ * separately allocated nodes, which matters for pictures with a great many draws. The tree is
+ * unpacked again if anything is later inserted into it one at a time.
  */
 class SkRTree : public SkBBoxHierarchy {
 public:
@@ -78,9 +85,24 @@ public:
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results);
 
+    /**
+     * Searches a packed tree for up to 32 queries at a time in a single walk, visiting each node
+     * once however many of them it intersects. This pays off when the queries are close together,
+     * like a block of neighbouring tiles.
+     */
+    virtual void searchBatch(const SkIRect queries[], int count,
+                             SkTDArray<void*> results[]) SK_OVERRIDE;
+
     virtual void clear();
     bool isEmpty() const { return 0 == fCount; }
-    int getDepth() const { return this->isEmpty() ? 0 : fRoot.fChild.subtree->fLevel + 1; }
+    int getDepth() const;
+
+    /**
+     * Whether bulk-loaded trees get packed, which they do by default. Only useful for comparing
+     * the two layouts.
+     */
+    void setPackBulkLoads(bool pack) { fPackBulkLoads = pack; }
+    bool isPacked() const { return NULL != fPackedNodes; }
 
     /**
      * This gets the insertion count (rather than the node count)
@@ -130,20 +152,56 @@ private:
         const SkRTree::SortSide fSide;
     };
 
+    // Helpers for sorting by the centers of rects, for the bulk load
     struct RectLessX {
         bool operator()(const SkRTree::Branch lhs, const SkRTree::Branch rhs) {
-            return ((lhs.fBounds.fRight - lhs.fBounds.fLeft) >> 1) <
-                   ((rhs.fBounds.fRight - lhs.fBounds.fLeft) >> 1);
+            return ((lhs.fBounds.fRight + lhs.fBounds.fLeft) >> 1) <
+                   ((rhs.fBounds.fRight + rhs.fBounds.fLeft) >> 1);
         }
     };
 
     struct RectLessY {
         bool operator()(const SkRTree::Branch lhs, const SkRTree::Branch rhs) {
-            return ((lhs.fBounds.fBottom - lhs.fBounds.fTop) >> 1) <
-                   ((rhs.fBounds.fBottom - lhs.fBounds.fTop) >> 1);
+            return ((lhs.fBounds.fBottom + lhs.fBounds.fTop) >> 1) <
+                   ((rhs.fBounds.fBottom + rhs.fBounds.fTop) >> 1);
         }
     };
 
+    /**
+     * A node of the packed tree. It is followed in memory by the bounds of its children, as four
+     * arrays of fPackedStride int32_ts: the lefts, the tops, the rights and then the bottoms. The
+     * unused entries at the end of each array hold bounds which intersect nothing.
+     */
+    struct PackedNode {
+        uint16_t fNumChildren;
+        uint16_t fLevel;
+        // For an interior node, the index of its first child node, which its other children
+        // directly follow. For a leaf, the index of its first data value in fPackedData.
+        int32_t fFirstChild;
+        // Keeps the bounds arrays 16 byte aligned
+        int32_t fPad[2];
+
+        bool isLeaf() const { return 0 == fLevel; }
+        const int32_t* bounds() const { return reinterpret_cast<const int32_t*>(this + 1); }
+        int32_t* bounds() { return reinterpret_cast<int32_t*>(this + 1); }
+    };
+
+    /**
+     * Up to kMaxBatchCount queries, with their sides stored the same way as the bounds of the
+     * children of a packed node, so that a child can be tested against four of them at once.
+     */
+    struct QueryBatch {
+        enum {
+            kMaxBatchCount = 32
+        };
+        int32_t fLefts[kMaxBatchCount];
+        int32_t fTops[kMaxBatchCount];
+        int32_t fRights[kMaxBatchCount];
+        int32_t fBottoms[kMaxBatchCount];
+        // The number of queries, rounded up to a multiple of 4
+        int fCount;
+    };
+
     SkRTree(int minChildren, int maxChildren, SkScalar aspectRatio);
 
     /**
@@ -157,6 +215,27 @@ private:
     int distributeChildren(Branch* children);
     void search(Node* root, const SkIRect query, SkTDArray<void*>* results) const;
 
+    /**
+     * Copies the tree into the packed layout, and frees the nodes it was copied from.
+     */
+    void pack();
+    /**
+     * Copies the packed tree back into separately allocated nodes, so that it can be inserted into.
+     */
+    void unpack();
+    Node* unpackSubtree(int index);
+    void freePacked();
+
+    const PackedNode* packedNode(int index) const {
+        return reinterpret_cast<const PackedNode*>(fPackedNodes + index * fPackedNodeSize);
+    }
+    PackedNode* packedNode(int index) {
+        return reinterpret_cast<PackedNode*>(fPackedNodes + index * fPackedNodeSize);
+    }
+    void searchPacked(int index, const SkIRect& query, SkTDArray<void*>* results) const;
+    void searchPacked(int index, const QueryBatch& batch, uint32_t queryMask,
+                      SkTDArray<void*> results[]) const;
+
     /**
      * This performs a bottom-up bulk load using the STR (sort-tile-recursive) algorithm, this
      * seems to generally produce better, more consistent trees at significantly lower cost than
@@ -172,6 +251,7 @@ private:
 
     void validate();
     int validateSubtree(Node* root, SkIRect bounds, bool isRoot = false);
+    int validatePackedSubtree(int index, SkIRect bounds, bool isRoot = false);
 
     const int fMinChildren;
     const int fMaxChildren;
@@ -185,6 +265,17 @@ private:
     SkTDArray<Branch> fDeferredInserts;
     SkScalar fAspectRatio;
 
+    // The number of entries in each of a packed node's bounds arrays, fMaxChildren rounded up to a
+    // multiple of 4, and the size of a packed node, rounded up to a cache line.
+    const int fPackedStride;
+    const size_t fPackedNodeSize;
+    bool fPackBulkLoads;
+    // While the tree is packed, fRoot.fBounds holds the bounds of its root and fRoot.fChild is
+    // unused.
+    SkAutoMalloc fPackedStorage;
+    char* fPackedNodes;
+    SkTDArray<void*> fPackedData;
+
     Node* allocateNode(uint16_t level);
 
     typedef SkBBoxHierarchy INHERITED;
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkScanPriv.h"
+#include "SkBlitter.h"
+#include "SkPath.h"
+#include "SkRegion.h"
+#include "SkTDArray.h"
+#include "SkTSort.h"
+
+/** @file
+    An antialiasing path filler which computes the area of each pixel that is
+    inside the path, rather than counting covered samples as the supersampler
+    in SkScan_AntiPath.cpp does.
+
+    The path is flattened into lines. Where a line crosses a row of pixels, it
+    adds its signed height in that row (positive going down, negative going
+    up) to the row's cells, spread so that the running sum of the cells from
+    the left equals that height times the part of each pixel which lies to the
+    right of the line. Summing every line's contributions along the row then
+    gives each pixel's winding number weighted by area: exactly its coverage
+    wherever the path's contours do not overlap within the pixel.
+
+    Rows are accumulated a strip at a time, so that the cells of a tall path
+    need not all be kept at once.
+ */
+
+// How far, in pixels, the lines flattening a curve may stray from it.
+static const float kTolerance = 0.125f;
+static const int kMaxCurveSegments = 256;
+
+static const int kStripHeight = 16;
+
+namespace {
+
+struct Line {
+    float   fX0, fY0;   // top end
+    float   fX1, fY1;   // bottom end; fY1 > fY0
+    float   fDXDY;
+    float   fDir;       // 1 if the path runs down the line, -1 if up
+};
+
+bool operator<(const Line& a, const Line& b) {
+    return a.fY0 < b.fY0;
+}
+
+/**
+ *  Collects the lines of the path, offset so that (0, 0) is the top left of
+ *  the pixels being filled, and dropping those that cannot reach them.
+ */
+class LineBuilder {
+public:
+    LineBuilder(const SkIRect& bounds)
+        : fDX(-SkIntToScalar(bounds.fLeft))
+        , fDY(-SkIntToScalar(bounds.fTop))
+        , fHeight((float)bounds.height()) {}
+
+    void addLine(const SkPoint& p0, const SkPoint& p1) {
+        this->addLine(SkScalarToFloat(p0.fX + fDX), SkScalarToFloat(p0.fY + fDY),
+                      SkScalarToFloat(p1.fX + fDX), SkScalarToFloat(p1.fY + fDY));
+    }
+
+    void addQuad(const SkPoint pts[3]) {
+        float x0 = SkScalarToFloat(pts[0].fX + fDX), y0 = SkScalarToFloat(pts[0].fY + fDY);
+        float x1 = SkScalarToFloat(pts[1].fX + fDX), y1 = SkScalarToFloat(pts[1].fY + fDY);
+        float x2 = SkScalarToFloat(pts[2].fX + fDX), y2 = SkScalarToFloat(pts[2].fY + fDY);
+
+        // A chord spanning dt of the curve strays at most |B''| dt^2 / 8 from it.
+        float ddx = x0 - 2 * x1 + x2;
+        float ddy = y0 - 2 * y1 + y2;
+        int n = segment_count(sqrtf(ddx * ddx + ddy * ddy) / (4 * kTolerance));
+
+        float dt = 1.0f / n;
+        float prevX = x0, prevY = y0;
+        for (int i = 1; i < n; ++i) {
+            float t = i * dt;
+            float mt = 1 - t;
+            float x = mt * mt * x0 + 2 * t * mt * x1 + t * t * x2;
+            float y = mt * mt * y0 + 2 * t * mt * y1 + t * t * y2;
+            this->addLine(prevX, prevY, x, y);
+            prevX = x;
+            prevY = y;
+        }
+        this->addLine(prevX, prevY, x2, y2);
+    }
+
+    void addCubic(const SkPoint pts[4]) {
+        float x0 = SkScalarToFloat(pts[0].fX + fDX), y0 = SkScalarToFloat(pts[0].fY + fDY);
+        float x1 = SkScalarToFloat(pts[1].fX + fDX), y1 = SkScalarToFloat(pts[1].fY + fDY);
+        float x2 = SkScalarToFloat(pts[2].fX + fDX), y2 = SkScalarToFloat(pts[2].fY + fDY);
+        float x3 = SkScalarToFloat(pts[3].fX + fDX), y3 = SkScalarToFloat(pts[3].fY + fDY);
+
+        // |B''| is at most 6 times the larger second difference of the points.
+        float ddx0 = x0 - 2 * x1 + x2, ddy0 = y0 - 2 * y1 + y2;
+        float ddx1 = x1 - 2 * x2 + x3, ddy1 = y1 - 2 * y2 + y3;
+        float dd0 = ddx0 * ddx0 + ddy0 * ddy0;
+        float dd1 = ddx1 * ddx1 + ddy1 * ddy1;
+        float dd = sqrtf(dd0 > dd1 ? dd0 : dd1);
+        int n = segment_count(3 * dd / (4 * kTolerance));
+
+        float dt = 1.0f / n;
+        float prevX = x0, prevY = y0;
+        for (int i = 1; i < n; ++i) {
+            float t = i * dt;
+            float mt = 1 - t;
+            float a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t, d = t * t * t;
+            float x = a * x0 + b * x1 + c * x2 + d * x3;
+            float y = a * y0 + b * y1 + c * y2 + d * y3;
+            this->addLine(prevX, prevY, x, y);
+            prevX = x;
+            prevY = y;
+        }
+        this->addLine(prevX, prevY, x3, y3);
+    }
+
+    SkTDArray<Line>& lines() { return fLines; }
+
+private:
+    // n segments keep the error under kTolerance if n^2 >= nSquared.
+    static int segment_count(float nSquared) {
+        if (!(nSquared < (float)(kMaxCurveSegments * kMaxCurveSegments))) {
+            return kMaxCurveSegments;
+        }
+        int n = (int)ceilf(sqrtf(nSquared));
+        return n < 1 ? 1 : n;
+    }
+
+    void addLine(float x0, float y0, float x1, float y1) {
+        float dir = 1;
+        if (y0 > y1) {
+            SkTSwap(x0, x1);
+            SkTSwap(y0, y1);
+            dir = -1;
+        }
+        // Horizontal lines cover nothing; lines above or below the pixels
+        // are never crossed by their rows.
+        if (y0 == y1 || y1 <= 0 || y0 >= fHeight) {
+            return;
+        }
+        Line* line = fLines.append();
+        line->fX0 = x0;
+        line->fY0 = y0;
+        line->fX1 = x1;
+        line->fY1 = y1;
+        line->fDXDY = (x1 - x0) / (y1 - y0);
+        line->fDir = dir;
+    }
+
+    SkScalar        fDX, fDY;
+    float           fHeight;
+    SkTDArray<Line> fLines;
+};
+
+}  // namespace
+
+/**
+ *  Add the part of a line within one row, running from x0 at its top to x1
+ *  at its bottom, with signed height d, to the row's cells, which span
+ *  [0, width] and have 2 more entries than that for the spill of the last.
+ */
+static void accumulate(float cells[], int width, float x0, float x1, float d) {
+    // Whatever lies left of the pixels covers all of them, and whatever lies
+    // to their right none, so split the line where it crosses either side.
+    if ((x0 < 0 && x1 > 0) || (x0 > 0 && x1 < 0)) {
+        float part = d * (0 - x0) / (x1 - x0);
+        accumulate(cells, width, x0, 0, part);
+        accumulate(cells, width, 0, x1, d - part);
+        return;
+    }
+    if ((x0 < width && x1 > width) || (x0 > width && x1 < width)) {
+        float part = d * (width - x0) / (x1 - x0);
+        accumulate(cells, width, x0, (float)width, part);
+        accumulate(cells, width, (float)width, x1, d - part);
+        return;
+    }
+    if (x0 <= 0 && x1 <= 0) {
+        cells[0] += d;
+        return;
+    }
+    if (x0 >= width && x1 >= width) {
+        return;
+    }
+
+    float xMin = x0 < x1 ? x0 : x1;
+    float xMax = x0 < x1 ? x1 : x0;
+    int xMinI = (int)xMin;
+    int xMaxI = (int)ceilf(xMax);
+    if (xMaxI <= xMinI + 1) {
+        // Within one pixel: the area right of the line is a trapezoid.
+        float mid = 0.5f * (x0 + x1) - xMinI;
+        cells[xMinI] += d - d * mid;
+        cells[xMinI + 1] += d * mid;
+        return;
+    }
+
+    // Across several pixels: a triangle in the first and last, and an equal
+    // share of the height in each one between.
+    float s = 1 / (xMax - xMin);
+    float first = xMin - xMinI;
+    float a0 = 0.5f * s * (1 - first) * (1 - first);
+    float last = xMax - xMaxI + 1;
+    float aLast = 0.5f * s * last * last;
+    cells[xMinI] += d * a0;
+    if (xMaxI == xMinI + 2) {
+        cells[xMinI + 1] += d * (1 - a0 - aLast);
+    } else {
+        float a1 = s * (1.5f - first);
+        cells[xMinI + 1] += d * (a1 - a0);
+        for (int x = xMinI + 2; x < xMaxI - 1; ++x) {
+            cells[x] += d * s;
+        }
+        float a2 = a1 + (xMaxI - xMinI - 3) * s;
+        cells[xMaxI - 1] += d * (1 - a2 - aLast);
+    }
+    cells[xMaxI] += d * aLast;
+}
+
+/** Add the part of line within rows [top, bottom) to their cells. */
+static void accumulate_line(const Line& line, float* cells, int stride, int width,
+                            int top, int bottom) {
+    float y0 = line.fY0 > top ? line.fY0 : (float)top;
+    float y1 = line.fY1 < bottom ? line.fY1 : (float)bottom;
+    if (y0 >= y1) {
+        return;
+    }
+    int y = (int)y0;
+    float x = line.fX0 + (y0 - line.fY0) * line.fDXDY;
+    float* row = cells + (y - top) * stride;
+    while (y < y1) {
+        float rowTop = y > y0 ? (float)y : y0;
+        float rowBottom = y + 1 < y1 ? (float)(y + 1) : y1;
+        float dy = rowBottom - rowTop;
+        float nextX = x + dy * line.fDXDY;
+        accumulate(row, width, x, nextX, dy * line.fDir);
+        x = nextX;
+        row += stride;
+        ++y;
+    }
+}
+
+static inline SkAlpha winding_alpha(float area) {
+    float coverage = fabsf(area);
+    return coverage >= 1 ? 0xFF : (SkAlpha)(coverage * 255 + 0.5f);
+}
+
+static inline SkAlpha even_odd_alpha(float area) {
+    // Fold the winding count, so that 1 covers, 2 does not, 3 does again...
+    float coverage = fabsf(area);
+    coverage -= 2 * floorf(coverage * 0.5f);
+    if (coverage > 1) {
+        coverage = 2 - coverage;
+    }
+    return (SkAlpha)(coverage * 255 + 0.5f);
+}
+
+/** Sum a row of cells into alphas, and blit its runs of nonzero coverage. */
+static void blit_row(SkBlitter* blitter, int left, int y, const float cells[], int width,
+                     bool evenOdd, SkAlpha alphas[], int16_t runs[]) {
+    float area = 0;
+    int first = width;
+    int last = -1;
+    for (int x = 0; x < width; ++x) {
+        area += cells[x];
+        SkAlpha alpha = evenOdd ? even_odd_alpha(area) : winding_alpha(area);
+        alphas[x] = alpha;
+        if (alpha) {
+            if (first > x) {
+                first = x;
+            }
+            last = x;
+        }
+    }
+    if (last < first) {
+        return;
+    }
+
+    int start = first;
+    for (int x = first + 1; x <= last + 1; ++x) {
+        if (x > last || alphas[x] != alphas[start]) {
+            runs[start] = SkToS16(x - start);
+            start = x;
+        }
+    }
+    runs[last + 1] = 0;
+    blitter->blitAntiH(left + first, y, alphas + first, runs + first);
+}
+
+void SkScan::AnalyticFillPath(const SkPath& path, const SkRegion& origClip,
+                              SkBlitter* blitter) {
+    SkASSERT(!path.isInverseFillType());
+    if (origClip.isEmpty() || !path.isFinite()) {
+        return;
+    }
+
+    // The runs[] passed to blitAntiH use int16_t for their index, so limit
+    // the clip as SkScan::AntiFillPath does.
+    SkRegion tmpClipStorage;
+    const SkRegion* clipRgn = &origClip;
+    {
+        static const int32_t kMaxClipCoord = 32767;
+        const SkIRect& bounds = origClip.getBounds();
+        if (bounds.fRight > kMaxClipCoord || bounds.fBottom > kMaxClipCoord) {
+            SkIRect limit = { 0, 0, kMaxClipCoord, kMaxClipCoord };
+            tmpClipStorage.op(origClip, limit, SkRegion::kIntersect_Op);
+            clipRgn = &tmpClipStorage;
+        }
+    }
+
+    // Intersect before rounding, so that huge paths do not overflow.
+    SkRect bounds = path.getBounds();
+    if (!bounds.intersect(SkRect::Make(clipRgn->getBounds()))) {
+        return;
+    }
+    SkIRect ir;
+    bounds.roundOut(&ir);
+    if (!ir.intersect(clipRgn->getBounds())) {
+        return;
+    }
+
+    SkScanClipper clipper(blitter, clipRgn, ir);
+    if (NULL == clipper.getBlitter()) {
+        return;
+    }
+    blitter = clipper.getBlitter();
+
+    LineBuilder builder(ir);
+    SkPath::Iter iter(path, true);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    while ((verb = iter.next(pts)) != SkPath::kDone_Verb) {
+        switch (verb) {
+            case SkPath::kLine_Verb:
+                builder.addLine(pts[0], pts[1]);
+                break;
+            case SkPath::kQuad_Verb:
+                builder.addQuad(pts);
+                break;
+            case SkPath::kCubic_Verb:
+                builder.addCubic(pts);
+                break;
+            default:
+                break;
+        }
+    }
+    SkTDArray<Line>& lines = builder.lines();
+    if (lines.isEmpty()) {
+        return;
+    }
+    SkTQSort<Line>(lines.begin(), lines.end() - 1);
+
+    const int width = ir.width();
+    const int height = ir.height();
+    const int stripHeight = height < kStripHeight ? height : kStripHeight;
+    const int stride = width + 2;
+    const size_t cellBytes = stride * stripHeight * sizeof(float);
+    SkAutoSMalloc<8 * 1024> storage(cellBytes + (width + 1) * (sizeof(SkAlpha) + sizeof(int16_t)));
+    float* cells = static_cast<float*>(storage.get());
+    int16_t* runs = reinterpret_cast<int16_t*>(cells + stride * stripHeight);
+    SkAlpha* alphas = reinterpret_cast<SkAlpha*>(runs + width + 1);
+
+    const bool evenOdd = SkPath::kEvenOdd_FillType == path.getFillType();
+    SkTDArray<const Line*> active;
+    int nextLine = 0;
+    for (int top = 0; top < height; top += stripHeight) {
+        int bottom = top + stripHeight < height ? top + stripHeight : height;
+
+        for (int i = active.count() - 1; i >= 0; --i) {
+            if (active[i]->fY1 <= top) {
+                active.removeShuffle(i);
+            }
+        }
+        while (nextLine < lines.count() && lines[nextLine].fY0 < bottom) {
+            *active.append() = &lines[nextLine++];
+        }
+        if (active.isEmpty()) {
+            continue;
+        }
+
+        sk_bzero(cells, stride * (bottom - top) * sizeof(float));
+        for (int i = 0; i < active.count(); ++i) {
+            accumulate_line(*active[i], cells, stride, width, top, bottom);
+        }
+        for (int y = top; y < bottom; ++y) {
+            blit_row(blitter, ir.fLeft, ir.fTop + y, cells + (y - top) * stride, width,
+                     evenOdd, alphas, runs);
+        }
+    }
+}
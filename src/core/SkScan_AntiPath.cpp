@@ -13,6 +13,8 @@
 #include "SkBlitter.h"
 #include "SkRegion.h"
 #include "SkAntiRun.h"
+#include "SkCoverage_opts.h"
+#include "SkGraphics.h"
 
 #define SHIFT   2
 #define SCALE   (1 << SHIFT)
@@ -101,14 +103,19 @@ BaseSuperBlitter::BaseSuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
 }
 
 /// Run-length-encoded supersampling antialiased blitter.
+/// In dense mode, it accumulates each scanline as the change in coverage
+/// from one pixel to the next, which costs the same for every span however
+/// many runs the scanline already has, and only run-length-encodes it to
+/// flush it. Blocks of pixels that no span began or ended in are skipped.
 class SuperBlitter : public BaseSuperBlitter {
 public:
     SuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
-                 const SkRegion& clip);
+                 const SkRegion& clip, bool dense = false);
 
     virtual ~SuperBlitter() {
         this->flush();
         sk_free(fRuns.fRuns);
+        sk_free(fDeltas);   // and fDenseAlpha and fDirtyBlocks
     }
 
     /// Once fRuns contains a complete supersampled row, flush() blits
@@ -123,12 +130,100 @@ public:
     virtual void blitRect(int x, int y, int width, int height) SK_OVERRIDE;
 
 private:
+    enum {
+        kBlockShift = 4,
+        kBlockSize = 1 << kBlockShift
+    };
+
+    void addDelta(int x, int delta) {
+        fDeltas[x] += delta;
+        fDirtyBlocks[x >> kBlockShift] = true;
+    }
+    void addDense(int x, int startAlpha, int middleCount, int stopAlpha, int maxValue);
+    void flushDense();
+
     SkAlphaRuns fRuns;
     int         fOffsetX;
+
+    // Dense mode only: fDeltas[x] is the coverage of pixel x minus that of
+    // pixel x - 1. It is zero in each block of kBlockSize pixels whose entry
+    // in fDirtyBlocks is false, and fDirtyBlocks is false outside
+    // [fDirtyLeft, fDirtyRight].
+    int16_t*    fDeltas;
+    uint8_t*    fDenseAlpha;
+    bool*       fDirtyBlocks;
+    int         fDirtyLeft;
+    int         fDirtyRight;
+    SkCoverageProcs::DeltasToAlphaProc fDeltasToAlpha;
 };
 
+static int deltas_to_alpha(uint8_t* SK_RESTRICT dst, int16_t* SK_RESTRICT deltas, int count,
+                           int sum) {
+    for (int i = 0; i < count; ++i) {
+        sum += deltas[i];
+        deltas[i] = 0;
+        dst[i] = SkToU8(sum - (sum >> 8));
+    }
+    return sum;
+}
+
+namespace {
+
+/// Builds the runs of a scanline from its alpha, pixel by pixel, dropping
+/// the transparent runs at either end.
+class DenseRunBuilder {
+public:
+    DenseRunBuilder(int16_t runs[], uint8_t alpha[], int x)
+        : fRuns(runs), fAlpha(alpha), fStart(x), fValue(0), fFirst(-1), fEnd(x) {}
+
+    /// Pixel x has alpha value; the pixels since the last call share the
+    /// alpha of that call.
+    void setAlpha(int x, U8CPU value) {
+        if (value != fValue) {
+            this->endRun(x);
+            fStart = x;
+            fValue = value;
+        }
+    }
+
+    /// Ends the runs at x, and returns the index of the first one, or -1
+    /// if every run was transparent.
+    int finish(int x) {
+        this->endRun(x);
+        if (fFirst >= 0) {
+            fRuns[fEnd] = 0;
+        }
+        return fFirst;
+    }
+
+private:
+    void endRun(int x) {
+        if (0 == fValue || x <= fStart) {
+            return;
+        }
+        if (fFirst < 0) {
+            fFirst = fStart;
+        } else if (fEnd < fStart) {
+            fRuns[fEnd] = SkToS16(fStart - fEnd);
+            fAlpha[fEnd] = 0;
+        }
+        fRuns[fStart] = SkToS16(x - fStart);
+        fAlpha[fStart] = SkToU8(fValue);
+        fEnd = x;
+    }
+
+    int16_t*    fRuns;
+    uint8_t*    fAlpha;
+    int         fStart;     // where the current run began
+    U8CPU       fValue;     // its alpha
+    int         fFirst;     // the first run that is not transparent
+    int         fEnd;       // the end of the last one that is not
+};
+
+}  // namespace
+
 SuperBlitter::SuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
-                           const SkRegion& clip)
+                           const SkRegion& clip, bool dense)
         : BaseSuperBlitter(realBlitter, ir, clip) {
     const int width = fWidth;
 
@@ -138,11 +233,99 @@ SuperBlitter::SuperBlitter(SkBlitter* realBlitter, const SkIRect& ir,
     fRuns.reset(width);
 
     fOffsetX = 0;
+
+    fDeltas = NULL;
+    fDenseAlpha = NULL;
+    fDirtyBlocks = NULL;
+    fDeltasToAlpha = NULL;
+    if (dense) {
+        // the delta after the last pixel may be written too
+        const int blocks = (width + kBlockSize) >> kBlockShift;
+        const int count = blocks << kBlockShift;
+        fDeltas = (int16_t*)sk_malloc_throw(count * (sizeof(int16_t) + sizeof(uint8_t)) +
+                                            blocks * sizeof(bool));
+        fDenseAlpha = (uint8_t*)(fDeltas + count);
+        fDirtyBlocks = (bool*)(fDenseAlpha + count);
+        sk_bzero(fDeltas, count * sizeof(int16_t));
+        sk_bzero(fDirtyBlocks, blocks * sizeof(bool));
+        fDeltasToAlpha = SkCoverageProcs::PlatformDeltasToAlpha();
+        if (NULL == fDeltasToAlpha) {
+            fDeltasToAlpha = deltas_to_alpha;
+        }
+    }
+    fDirtyLeft = width;
+    fDirtyRight = -1;
+}
+
+void SuperBlitter::addDense(int x, int startAlpha, int middleCount, int stopAlpha,
+                            int maxValue) {
+    SkASSERT(x >= 0 && x + (startAlpha != 0) + middleCount + (stopAlpha != 0) <= fWidth);
+
+    const int left = x;
+    if (startAlpha) {
+        this->addDelta(x, startAlpha);
+        this->addDelta(x + 1, -startAlpha);
+        x += 1;
+    }
+    if (middleCount) {
+        this->addDelta(x, maxValue);
+        this->addDelta(x + middleCount, -maxValue);
+        x += middleCount;
+    }
+    if (stopAlpha) {
+        this->addDelta(x, stopAlpha);
+        this->addDelta(x + 1, -stopAlpha);
+        x += 1;
+    }
+    fDirtyLeft = SkMin32(fDirtyLeft, left >> kBlockShift);
+    fDirtyRight = SkMax32(fDirtyRight, x >> kBlockShift);
+}
+
+void SuperBlitter::flushDense() {
+    if (fDirtyLeft > fDirtyRight) {
+        return;
+    }
+    const int lastBlock = fDirtyRight;
+    int block = fDirtyLeft;
+    fDirtyLeft = fWidth;
+    fDirtyRight = -1;
+
+    uint8_t* alpha = fDenseAlpha;
+    DenseRunBuilder builder(fRuns.fRuns, alpha, block << kBlockShift);
+    int sum = 0;
+    while (block <= lastBlock) {
+        if (!fDirtyBlocks[block]) {
+            // No span began or ended here, so the coverage stays the same.
+            block += 1;
+            continue;
+        }
+        int stop = block + 1;
+        while (stop <= lastBlock && fDirtyBlocks[stop]) {
+            stop += 1;
+        }
+        const int start = block << kBlockShift;
+        const int end = stop << kBlockShift;
+        sum = fDeltasToAlpha(alpha + start, fDeltas + start, end - start, sum);
+        memset(fDirtyBlocks + block, 0, (stop - block) * sizeof(bool));
+        for (int x = start; x < end; ++x) {
+            builder.setAlpha(x, alpha[x]);
+        }
+        block = stop;
+    }
+    // Every span ends by the end of the scanline.
+    SkASSERT(0 == sum);
+
+    int first = builder.finish(SkMin32((lastBlock + 1) << kBlockShift, fWidth));
+    if (first >= 0) {
+        fRealBlitter->blitAntiH(fLeft + first, fCurrIY, alpha + first, fRuns.fRuns + first);
+    }
 }
 
 void SuperBlitter::flush() {
     if (fCurrIY >= fTop) {
-        if (!fRuns.empty()) {
+        if (NULL != fDeltas) {
+            this->flushDense();
+        } else if (!fRuns.empty()) {
         //  SkDEBUGCODE(fRuns.dump();)
             fRealBlitter->blitAntiH(fLeft, fCurrIY, fRuns.fAlpha, fRuns.fRuns);
             fRuns.reset(fWidth);
@@ -224,13 +407,20 @@ void SuperBlitter::blitH(int x, int y, int width) {
         }
     }
 
-    fOffsetX = fRuns.add(x >> SHIFT, coverage_to_partial_alpha(fb),
-                         n, coverage_to_partial_alpha(fe),
-                         (1 << (8 - SHIFT)) - (((y & MASK) + 1) >> SHIFT),
-                         fOffsetX);
+    const int maxValue = (1 << (8 - SHIFT)) - (((y & MASK) + 1) >> SHIFT);
+    if (NULL != fDeltas) {
+        this->addDense(x >> SHIFT, coverage_to_partial_alpha(fb),
+                       n, coverage_to_partial_alpha(fe), maxValue);
+    } else {
+        fOffsetX = fRuns.add(x >> SHIFT, coverage_to_partial_alpha(fb),
+                             n, coverage_to_partial_alpha(fe), maxValue,
+                             fOffsetX);
+#ifdef SK_DEBUG
+        fRuns.assertValid(y & MASK, (1 << (8 - SHIFT)));
+#endif
+    }
 
 #ifdef SK_DEBUG
-    fRuns.assertValid(y & MASK, (1 << (8 - SHIFT)));
     fCurrX = x + width;
 #endif
 }
@@ -603,11 +793,26 @@ static bool safeRoundOut(const SkRect& src, SkIRect* dst, int32_t maxInt) {
     return false;
 }
 
+/** SkAlphaRuns costs little per span while a scanline has only a few runs,
+    but more as they multiply, while dense accumulation costs about the same
+    per span and a little per block of pixels. So use the latter for paths
+    like lines of text, which cross each scanline many times. For convex
+    shapes, the runs are faster however large the shape.
+*/
+static bool use_dense_coverage(const SkPath& path, const SkIRect& bounds) {
+    static const int kDensePointsPerScanline = 8;
+    return path.countPoints() >= kDensePointsPerScanline * bounds.height();
+}
+
 void SkScan::AntiFillPath(const SkPath& path, const SkRegion& origClip,
                           SkBlitter* blitter, bool forceRLE) {
     if (origClip.isEmpty()) {
         return;
     }
+    if (SkGraphics::GetAnalyticAntiAlias() && !path.isInverseFillType()) {
+        SkScan::AnalyticFillPath(path, origClip, blitter);
+        return;
+    }
 
     SkIRect ir;
 
@@ -696,7 +901,7 @@ void SkScan::AntiFillPath(const SkPath& path, const SkRegion& origClip,
         SkASSERT(SkIntToScalar(ir.fTop) <= path.getBounds().fTop);
         sk_fill_path(path, superClipRect, &superBlit, ir.fTop, ir.fBottom, SHIFT, *clipRgn);
     } else {
-        SuperBlitter    superBlit(blitter, ir, *clipRgn);
+        SuperBlitter    superBlit(blitter, ir, *clipRgn, use_dense_coverage(path, ir));
         sk_fill_path(path, superClipRect, &superBlit, ir.fTop, ir.fBottom, SHIFT, *clipRgn);
     }
 
@@ -847,3 +847,24 @@ SkStream* SkStream::NewFromFile(const char path[]) {
     }
     return stream;
 }
+
+// This lives here, rather than in SkData.cpp, to share mmap_filename().
+SkData* SkData::NewFromFileName(const char path[]) {
+    void* addr;
+    size_t size;
+    if (mmap_filename(path, &addr, &size)) {
+        return SkData::NewFromMMap(addr, size);
+    }
+
+    SkFILEStream stream(path);
+    if (!stream.isValid()) {
+        return NULL;
+    }
+    size_t length = stream.getLength();
+    void* storage = sk_malloc_throw(length);
+    if (stream.read(storage, length) != length) {
+        sk_free(storage);
+        return NULL;
+    }
+    return SkData::NewFromMalloc(storage, length);
+}
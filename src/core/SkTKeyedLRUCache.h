@@ -0,0 +1,232 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTKeyedLRUCache_DEFINED
+#define SkTKeyedLRUCache_DEFINED
+
+#include "SkChecksum.h"
+#include "SkMath.h"
+#include "SkTInternalLList.h"
+#include "SkThread.h"
+
+/**
+ *  A thread-safe hash table of entries keyed by arrays of words, which keeps
+ *  the most recently used entries that fit in a byte budget. This is the
+ *  storage behind the process-wide result caches (SkMaskCache,
+ *  SkImageFilterCache, SkPictureCache and SkGradientCache), which each wrap
+ *  one of these in their own static API.
+ *
+ *  T is the cache's entry type. The cache owns its entries, and uses these
+ *  members of T:
+ *
+ *      uint32_t        fHash;          // set by the cache
+ *      size_t          fSize;          // bytes charged against the budget
+ *      T*              fNextInBucket;  // set by the cache
+ *      const uint32_t* key() const;
+ *      int             keyCount() const;
+ *      void            get(R*) const;  // for each result type R passed to find()
+ *      static void     Destroy(T*);
+ *      SK_DECLARE_INTERNAL_LLIST_INTERFACE(T);
+ *
+ *  Entries are destroyed outside of the mutex, since dropping the last ref
+ *  on something they hold (a pixel ref, say) can call back into Skia.
+ */
+template <typename T> class SkTKeyedLRUCache : SkNoncopyable {
+public:
+    explicit SkTKeyedLRUCache(size_t byteLimit)
+        : fBuckets(NULL)
+        , fBucketCount(0)
+        , fCount(0)
+        , fBytesUsed(0)
+        , fByteLimit(byteLimit) {
+    }
+
+    ~SkTKeyedLRUCache() {
+        this->purge();
+        sk_free(fBuckets);
+    }
+
+    /**
+     *  Look for the entry added with this key. If found, it becomes the most
+     *  recently used, and result is filled in by entry->get(result), which is
+     *  called with the mutex held.
+     */
+    template <typename R> bool find(const uint32_t key[], int keyCount, R* result) {
+        uint32_t hash = Hash(key, keyCount);
+
+        SkAutoMutexAcquire ac(fMutex);
+        T* entry = this->lookup(hash, key, keyCount, NULL);
+        if (NULL == entry) {
+            return false;
+        }
+        if (entry != fLRU.head()) {
+            fLRU.remove(entry);
+            fLRU.addToHead(entry);
+        }
+        entry->get(result);
+        return true;
+    }
+
+    /**
+     *  Add entry, replacing any existing entry with its key. The cache takes
+     *  ownership, and destroys entry at once if it is larger than the budget.
+     */
+    void add(T* entry) {
+        entry->fHash = Hash(entry->key(), entry->keyCount());
+        entry->fNextInBucket = NULL;
+
+        SkTInternalLList<T> purged;
+        {
+            SkAutoMutexAcquire ac(fMutex);
+            if (entry->fSize > fByteLimit) {
+                purged.addToHead(entry);
+            } else {
+                T** prevLink;
+                T* existing = this->lookup(entry->fHash, entry->key(), entry->keyCount(),
+                                           &prevLink);
+                if (NULL != existing) {
+                    this->remove(existing, prevLink, &purged);
+                }
+                this->purgeDownTo(fByteLimit - entry->fSize, &purged);
+
+                if (fCount >= fBucketCount) {
+                    this->rehash(SkMax32(fBucketCount * 2, 64));
+                }
+                T** bucket = &fBuckets[entry->fHash & (fBucketCount - 1)];
+                entry->fNextInBucket = *bucket;
+                *bucket = entry;
+                fLRU.addToHead(entry);
+                fCount++;
+                fBytesUsed += entry->fSize;
+            }
+        }
+        FreeAll(&purged);
+    }
+
+    size_t getByteLimit() {
+        SkAutoMutexAcquire ac(fMutex);
+        return fByteLimit;
+    }
+
+    size_t setByteLimit(size_t bytes) {
+        SkTInternalLList<T> purged;
+        size_t prevLimit;
+        {
+            SkAutoMutexAcquire ac(fMutex);
+            prevLimit = fByteLimit;
+            fByteLimit = bytes;
+            this->purgeDownTo(bytes, &purged);
+        }
+        FreeAll(&purged);
+        return prevLimit;
+    }
+
+    size_t getBytesUsed() {
+        SkAutoMutexAcquire ac(fMutex);
+        return fBytesUsed;
+    }
+
+    void purge() {
+        SkTInternalLList<T> purged;
+        {
+            SkAutoMutexAcquire ac(fMutex);
+            this->purgeDownTo(0, &purged);
+        }
+        FreeAll(&purged);
+    }
+
+private:
+    static uint32_t Hash(const uint32_t key[], int keyCount) {
+        return SkChecksum::Compute(key, keyCount * sizeof(uint32_t));
+    }
+
+    static bool Matches(const T* entry, uint32_t hash, const uint32_t key[], int keyCount) {
+        return entry->fHash == hash && entry->keyCount() == keyCount &&
+               0 == memcmp(entry->key(), key, keyCount * sizeof(uint32_t));
+    }
+
+    static void FreeAll(SkTInternalLList<T>* list) {
+        while (T* entry = list->head()) {
+            list->remove(entry);
+            T::Destroy(entry);
+        }
+    }
+
+    // Returns the entry for key, or NULL. If prevLink is not NULL, it is set
+    // to the link that points at the entry. The mutex must be held.
+    T* lookup(uint32_t hash, const uint32_t key[], int keyCount, T*** prevLink) {
+        if (0 == fBucketCount) {
+            return NULL;
+        }
+        T** link = &fBuckets[hash & (fBucketCount - 1)];
+        while (NULL != *link) {
+            if (Matches(*link, hash, key, keyCount)) {
+                if (NULL != prevLink) {
+                    *prevLink = link;
+                }
+                return *link;
+            }
+            link = &(*link)->fNextInBucket;
+        }
+        return NULL;
+    }
+
+    // Unlinks entry and moves it to purged. The mutex must be held.
+    void remove(T* entry, T** prevLink, SkTInternalLList<T>* purged) {
+        SkASSERT(*prevLink == entry);
+        *prevLink = entry->fNextInBucket;
+        fLRU.remove(entry);
+        fCount--;
+        SkASSERT(fBytesUsed >= entry->fSize);
+        fBytesUsed -= entry->fSize;
+        purged->addToHead(entry);
+    }
+
+    // Removes least recently used entries until at most bytes are used. The
+    // mutex must be held.
+    void purgeDownTo(size_t bytes, SkTInternalLList<T>* purged) {
+        while (fBytesUsed > bytes) {
+            T* entry = fLRU.tail();
+            SkASSERT(NULL != entry);
+            T** prevLink;
+            SkDEBUGCODE(T* found =) this->lookup(entry->fHash, entry->key(), entry->keyCount(),
+                                                 &prevLink);
+            SkASSERT(found == entry);
+            this->remove(entry, prevLink, purged);
+        }
+    }
+
+    // The mutex must be held.
+    void rehash(int bucketCount) {
+        SkASSERT(SkIsPow2(bucketCount));
+        T** buckets = (T**)sk_malloc_throw(bucketCount * sizeof(T*));
+        sk_bzero(buckets, bucketCount * sizeof(T*));
+        for (int i = 0; i < fBucketCount; i++) {
+            T* entry = fBuckets[i];
+            while (NULL != entry) {
+                T* next = entry->fNextInBucket;
+                T** bucket = &buckets[entry->fHash & (bucketCount - 1)];
+                entry->fNextInBucket = *bucket;
+                *bucket = entry;
+                entry = next;
+            }
+        }
+        sk_free(fBuckets);
+        fBuckets = buckets;
+        fBucketCount = bucketCount;
+    }
+
+    SkMutex             fMutex;
+    SkTInternalLList<T> fLRU;       // head is the most recently used
+    T**                 fBuckets;
+    int                 fBucketCount;
+    int                 fCount;
+    size_t              fBytesUsed;
+    size_t              fByteLimit;
+};
+
+#endif
@@ -0,0 +1,375 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTaskScheduler.h"
+#include "SkRunnable.h"
+#include "SkTemplates.h"
+#include "SkThread.h"
+#include "SkThreadUtils.h"
+
+/**
+ * A growable ring buffer of tasks guarded by its own mutex. The owning worker pushes and pops at
+ * the back, so its most recently queued (and most likely cache-warm) work runs first; thieves
+ * take from the front, where the oldest and usually largest pieces of work are.
+ */
+class SkTaskScheduler::TaskQueue : SkNoncopyable {
+public:
+    TaskQueue() : fStorage(NULL), fHead(0), fCount(0), fCapacity(0) {}
+
+    ~TaskQueue() {
+        sk_free(fStorage);
+    }
+
+    void pushBack(const Task* tasks, int count) {
+        SkAutoMutexAcquire lock(fMutex);
+        if (fCount + count > fCapacity) {
+            this->grow(fCount + count);
+        }
+        for (int i = 0; i < count; i++) {
+            fStorage[(fHead + fCount) % fCapacity] = tasks[i];
+            fCount++;
+        }
+    }
+
+    bool popBack(Task* task) {
+        SkAutoMutexAcquire lock(fMutex);
+        if (0 == fCount) {
+            return false;
+        }
+        fCount--;
+        *task = fStorage[(fHead + fCount) % fCapacity];
+        return true;
+    }
+
+    bool popFront(Task* task) {
+        SkAutoMutexAcquire lock(fMutex);
+        if (0 == fCount) {
+            return false;
+        }
+        *task = fStorage[fHead];
+        fHead = (fHead + 1) % fCapacity;
+        fCount--;
+        return true;
+    }
+
+private:
+    void grow(int minCapacity) {
+        int capacity = SkMax32(fCapacity * 2, 16);
+        while (capacity < minCapacity) {
+            capacity *= 2;
+        }
+        Task* storage = (Task*)sk_malloc_throw(capacity * sizeof(Task));
+        // Unroll the ring so the live tasks start at index 0 again.
+        for (int i = 0; i < fCount; i++) {
+            storage[i] = fStorage[(fHead + i) % fCapacity];
+        }
+        sk_free(fStorage);
+        fStorage = storage;
+        fHead = 0;
+        fCapacity = capacity;
+    }
+
+    SkMutex fMutex;
+    Task*   fStorage;
+    int     fHead;
+    int     fCount;
+    int     fCapacity;
+    // Keep neighbouring queues off each other's cache lines.
+    char    fPadding[64];
+};
+
+struct SkTaskScheduler::Worker {
+    SkTaskScheduler* fScheduler;
+    int              fIndex;
+    SkThread*        fThread;
+};
+
+SkTaskScheduler::SkTaskScheduler(int count)
+    : fThreadCount(SkMax32(count, 0))
+    , fQueues(NULL)
+    , fWorkers(NULL)
+    , fNextQueue(0)
+    , fPending(0)
+    , fSleepers(0)
+    , fDone(false) {
+    if (0 == fThreadCount) {
+        return;
+    }
+    fQueues = SkNEW_ARRAY(TaskQueue, fThreadCount);
+    fWorkers = SkNEW_ARRAY(Worker, fThreadCount);
+    // Create count threads, all running SkTaskScheduler::Loop, each with its own queue.
+    for (int i = 0; i < fThreadCount; i++) {
+        fWorkers[i].fScheduler = this;
+        fWorkers[i].fIndex = i;
+        fWorkers[i].fThread = SkNEW_ARGS(SkThread, (&SkTaskScheduler::Loop, &fWorkers[i]));
+    }
+    for (int i = 0; i < fThreadCount; i++) {
+        fWorkers[i].fThread->start();
+    }
+}
+
+SkTaskScheduler::~SkTaskScheduler() {
+    if (0 == fThreadCount) {
+        return;
+    }
+    fWake.lock();
+    fDone = true;
+    fWake.broadcast();
+    fWake.unlock();
+
+    // Workers only exit once every queue is empty, so this also drains any remaining work.
+    for (int i = 0; i < fThreadCount; i++) {
+        fWorkers[i].fThread->join();
+        SkDELETE(fWorkers[i].fThread);
+    }
+    SkDELETE_ARRAY(fWorkers);
+    SkDELETE_ARRAY(fQueues);
+}
+
+void SkTaskScheduler::Run(const Task& task) {
+    task.fRunnable->run();
+    if (NULL != task.fGroup) {
+        task.fGroup->finishOne();
+    }
+}
+
+void SkTaskScheduler::add(SkRunnable* runnable, SkTaskGroup* group) {
+    if (NULL == runnable) {
+        return;
+    }
+    Task task = { runnable, group };
+
+    // If we don't have any threads, obligingly just run the thing now.
+    if (0 == fThreadCount) {
+        Run(task);
+        return;
+    }
+
+    int queue = (sk_atomic_inc(&fNextQueue) & SK_MaxS32) % fThreadCount;
+    fQueues[queue].pushBack(&task, 1);
+    sk_atomic_inc(&fPending);
+    this->wake(1);
+}
+
+void SkTaskScheduler::addBatch(SkRunnable* const runnables[], int count, SkTaskGroup* group) {
+    if (count <= 0) {
+        return;
+    }
+    if (0 == fThreadCount) {
+        for (int i = 0; i < count; i++) {
+            if (NULL != runnables[i]) {
+                Task task = { runnables[i], group };
+                Run(task);
+            }
+        }
+        return;
+    }
+
+    SkAutoSTMalloc<64, Task> tasks(count);
+    int taskCount = 0;
+    for (int i = 0; i < count; i++) {
+        if (NULL != runnables[i]) {
+            tasks[taskCount].fRunnable = runnables[i];
+            tasks[taskCount].fGroup = group;
+            taskCount++;
+        }
+    }
+    if (0 == taskCount) {
+        return;
+    }
+
+    // Hand each queue one contiguous slice, starting from the round-robin position so that
+    // small batches do not always land on the first workers.
+    int queues = SkMin32(taskCount, fThreadCount);
+    int first = (sk_atomic_add(&fNextQueue, queues) & SK_MaxS32) % fThreadCount;
+    int start = 0;
+    for (int i = 0; i < queues; i++) {
+        int end = (taskCount * (i + 1)) / queues;
+        fQueues[(first + i) % fThreadCount].pushBack(tasks.get() + start, end - start);
+        start = end;
+    }
+    sk_atomic_add(&fPending, taskCount);
+    this->wake(taskCount);
+}
+
+void SkTaskScheduler::wake(int count) {
+    // fPending was bumped with a full barrier before we read fSleepers, and a worker bumps
+    // fSleepers before it re-reads fPending, so at least one side always sees the other.
+    if (fSleepers > 0) {
+        fWake.lock();
+        if (1 == count) {
+            fWake.signal();
+        } else {
+            fWake.broadcast();
+        }
+        fWake.unlock();
+    }
+}
+
+bool SkTaskScheduler::pop(int home, Task* task) {
+    if (fQueues[home].popBack(task)) {
+        sk_atomic_dec(&fPending);
+        return true;
+    }
+    for (int i = 1; i < fThreadCount; i++) {
+        if (fQueues[(home + i) % fThreadCount].popFront(task)) {
+            sk_atomic_dec(&fPending);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SkTaskScheduler::runOne() {
+    if (0 == fThreadCount || fPending <= 0) {
+        return false;
+    }
+    // Threads outside the pool have no queue of their own; start stealing at a rotating victim.
+    int home = (sk_atomic_inc(&fNextQueue) & SK_MaxS32) % fThreadCount;
+    Task task;
+    if (this->pop(home, &task)) {
+        Run(task);
+        return true;
+    }
+    return false;
+}
+
+/*static*/ void SkTaskScheduler::Loop(void* arg) {
+    Worker* worker = static_cast<Worker*>(arg);
+    SkTaskScheduler* scheduler = worker->fScheduler;
+    const int home = worker->fIndex;
+
+    while (true) {
+        Task task;
+        if (scheduler->pop(home, &task)) {
+            Run(task);
+            continue;
+        }
+
+        // Nothing to run anywhere. Sleep until more work is added or it's time to die.
+        scheduler->fWake.lock();
+        sk_atomic_inc(&scheduler->fSleepers);
+        while (scheduler->fPending <= 0) {
+            if (scheduler->fDone) {
+                sk_atomic_dec(&scheduler->fSleepers);
+                scheduler->fWake.unlock();
+                return;
+            }
+            // wait yields the lock while waiting, but will have it again when awoken.
+            scheduler->fWake.wait();
+        }
+        sk_atomic_dec(&scheduler->fSleepers);
+        scheduler->fWake.unlock();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkTaskGroup::SkTaskGroup(SkTaskScheduler* scheduler)
+    : fScheduler(scheduler)
+    , fPending(0) {
+    SkASSERT(NULL != scheduler);
+}
+
+void SkTaskGroup::add(SkRunnable* runnable) {
+    if (NULL == runnable) {
+        return;
+    }
+    sk_atomic_inc(&fPending);
+    fScheduler->add(runnable, this);
+}
+
+void SkTaskGroup::addBatch(SkRunnable* const runnables[], int count) {
+    int nonNull = 0;
+    for (int i = 0; i < count; i++) {
+        if (NULL != runnables[i]) {
+            nonNull++;
+        }
+    }
+    if (0 == nonNull) {
+        return;
+    }
+    sk_atomic_add(&fPending, nonNull);
+    fScheduler->addBatch(runnables, count, this);
+}
+
+void SkTaskGroup::finishOne() {
+    // The decrement happens under the lock so that wait() cannot return, and the group cannot
+    // be destroyed, while the last task to finish is still touching fDone.
+    fDone.lock();
+    if (1 == sk_atomic_dec(&fPending)) {
+        fDone.broadcast();
+    }
+    fDone.unlock();
+}
+
+void SkTaskGroup::wait() {
+    // Help out while there is queued work; any of it may belong to this group.
+    while (fPending > 0 && fScheduler->runOne()) {}
+
+    fDone.lock();
+    while (fPending > 0) {
+        fDone.wait();
+    }
+    fDone.unlock();
+}
+
+namespace {
+
+class ForChunk : public SkRunnable {
+public:
+    void init(void (*proc)(void*, int), void* context, int start, int end) {
+        fProc = proc;
+        fContext = context;
+        fStart = start;
+        fEnd = end;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        for (int i = fStart; i < fEnd; i++) {
+            fProc(fContext, i);
+        }
+    }
+
+private:
+    void (*fProc)(void*, int);
+    void*  fContext;
+    int    fStart;
+    int    fEnd;
+};
+
+}  // namespace
+
+void SkTaskGroup::parallelFor(int count, void (*proc)(void*, int), void* context, int grain) {
+    if (count <= 0) {
+        return;
+    }
+    grain = SkMax32(grain, 1);
+
+    // Aim for a few chunks per thread so that stealing can even out uneven work, but never
+    // split more finely than the caller's grain.
+    int threads = SkMax32(fScheduler->countThreads(), 1);
+    int chunks = SkMin32((count + grain - 1) / grain, threads * 4);
+    if (chunks <= 1) {
+        for (int i = 0; i < count; i++) {
+            proc(context, i);
+        }
+        return;
+    }
+
+    SkAutoTArray<ForChunk> storage(chunks);
+    SkAutoSTMalloc<32, SkRunnable*> runnables(chunks);
+    int start = 0;
+    for (int i = 0; i < chunks; i++) {
+        int end = (int)(((int64_t)count * (i + 1)) / chunks);
+        storage[i].init(proc, context, start, end);
+        runnables[i] = &storage[i];
+        start = end;
+    }
+    this->addBatch(runnables.get(), chunks);
+    this->wait();
+}
@@ -7,9 +7,115 @@
  */
 
 #include "SkTileGrid.h"
+#include "SkThread.h"
 
-SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridPicture::TileGridInfo& info,
-    SkTileGridNextDatumFunctionPtr nextDatumFunction)
+// The number of data that searches have skipped because they were hidden, for all tile grids.
+static int32_t gOccludedDrawCount;
+
+int32_t SkTileGridPicture::GetOccludedDrawCount() {
+    return gOccludedDrawCount;
+}
+
+void SkTileGridPicture::ResetOccludedDrawCount() {
+    gOccludedDrawCount = 0;
+}
+
+// Adds 'index', which must be greater than any index already there, to the end of a bucket.
+static void append_index(SkTDArray<int32_t>* cell, int32_t index) {
+    int count = cell->count();
+    if (count > 0) {
+        int32_t last = (*cell)[count - 1];
+        if (last < 0) {
+            // Extend the run, if the index follows on from its end.
+            SkASSERT(count >= 2);
+            if ((*cell)[count - 2] - last + 1 == index) {
+                (*cell)[count - 1] = last - 1;
+                return;
+            }
+        } else if (last + 1 == index) {
+            cell->push(-1);
+            return;
+        }
+    }
+    cell->push(index);
+}
+
+// Removes the indices from 'count' on from the end of a bucket.
+static void truncate_indices(SkTDArray<int32_t>* cell, int32_t count) {
+    while (!cell->isEmpty()) {
+        int32_t last = cell->top();
+        if (last >= 0) {
+            if (last < count) {
+                return;
+            }
+            cell->pop();
+        } else {
+            int32_t start = (*cell)[cell->count() - 2];
+            if (start - last < count) {
+                return;
+            }
+            if (start < count) {
+                // Shorten the run to end just before 'count'.
+                int32_t runCount = count - 1 - start;
+                if (0 == runCount) {
+                    cell->pop();
+                } else {
+                    cell->top() = -runCount;
+                }
+                return;
+            }
+            cell->pop();
+            cell->pop();
+        }
+    }
+}
+
+class SkTileGrid::Cursor {
+public:
+    void init(const SkTDArray<int32_t>& cell, int32_t firstVisible) {
+        fPos = cell.begin();
+        fStop = cell.end();
+        fFirstVisible = firstVisible;
+        this->nextRun();
+    }
+
+    bool done() const { return fStart == SK_MaxS32; }
+
+    // The current run of indices, end exclusive.
+    int32_t start() const { return fStart; }
+    int32_t end() const { return fEnd; }
+    int32_t firstVisible() const { return fFirstVisible; }
+
+    // Skip the indices of the current run before 'index'.
+    void skipTo(int32_t index) {
+        SkASSERT(index > fStart && index <= fEnd);
+        fStart = index;
+        if (fStart == fEnd) {
+            this->nextRun();
+        }
+    }
+
+private:
+    void nextRun() {
+        if (fPos == fStop) {
+            fStart = SK_MaxS32;
+            return;
+        }
+        fStart = *fPos++;
+        fEnd = fStart + 1;
+        if (fPos != fStop && *fPos < 0) {
+            fEnd -= *fPos++;
+        }
+    }
+
+    const int32_t* fPos;
+    const int32_t* fStop;
+    int32_t fStart;
+    int32_t fEnd;
+    int32_t fFirstVisible;
+};
+
+SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridPicture::TileGridInfo& info)
 {
     fXTileCount = xTileCount;
     fYTileCount = yTileCount;
@@ -19,23 +125,60 @@ SkTileGrid::SkTileGrid(int xTileCount, int yTileCount, const SkTileGridPicture::
     fInfo.fMargin.fHeight++;
     fInfo.fMargin.fWidth++;
     fTileCount = fXTileCount * fYTileCount;
-    fInsertionCount = 0;
     fGridBounds = SkIRect::MakeXYWH(0, 0, fInfo.fTileInterval.width() * fXTileCount,
         fInfo.fTileInterval.height() * fYTileCount);
-    fNextDatumFunction = nextDatumFunction;
-    fTileData = SkNEW_ARRAY(SkTDArray<void *>, fTileCount);
+    fLastInsertTiles.setEmpty();
+    fOccluders = NULL;
+
+    // Add levels until one bucket covers the whole grid.
+    fLevelCount = 1;
+    while ((fXTileCount - 1) >> (fLevelCount - 1) > 0 ||
+           (fYTileCount - 1) >> (fLevelCount - 1) > 0) {
+        fLevelCount++;
+    }
+    fLevels = SkNEW_ARRAY(Level, fLevelCount);
+    for (int i = 0; i < fLevelCount; ++i) {
+        Level& level = fLevels[i];
+        level.fXCellCount = ((fXTileCount - 1) >> i) + 1;
+        level.fYCellCount = ((fYTileCount - 1) >> i) + 1;
+        level.fCells = SkNEW_ARRAY(SkTDArray<int32_t>, level.fXCellCount * level.fYCellCount);
+    }
 }
 
 SkTileGrid::~SkTileGrid() {
-    SkDELETE_ARRAY(fTileData);
+    for (int i = 0; i < fLevelCount; ++i) {
+        SkDELETE_ARRAY(fLevels[i].fCells);
+    }
+    SkDELETE_ARRAY(fLevels);
+    SkDELETE_ARRAY(fOccluders);
 }
 
-SkTDArray<void *>& SkTileGrid::tile(int x, int y) {
-    return fTileData[y * fXTileCount + x];
+SkIRect SkTileGrid::tileArea(int x, int y) const {
+    SkIRect area = SkIRect::MakeXYWH(x * fInfo.fTileInterval.width(),
+                                     y * fInfo.fTileInterval.height(),
+                                     fInfo.fTileInterval.width(),
+                                     fInfo.fTileInterval.height());
+    area.offset(-fInfo.fOffset.fX, -fInfo.fOffset.fY);
+    area.outset(fInfo.fMargin.width(), fInfo.fMargin.height());
+    // Data beyond the edges of the grid end up in the tiles along them.
+    if (0 == x) {
+        area.fLeft = SK_MinS32;
+    }
+    if (fXTileCount - 1 == x) {
+        area.fRight = SK_MaxS32;
+    }
+    if (0 == y) {
+        area.fTop = SK_MinS32;
+    }
+    if (fYTileCount - 1 == y) {
+        area.fBottom = SK_MaxS32;
+    }
+    return area;
 }
 
 void SkTileGrid::insert(void* data, const SkIRect& bounds, bool) {
     SkASSERT(!bounds.isEmpty());
+    fLastInsertTiles.setEmpty();
     SkIRect dilatedBounds = bounds;
     dilatedBounds.outset(fInfo.fMargin.width(), fInfo.fMargin.height());
     dilatedBounds.offset(fInfo.fOffset);
@@ -53,16 +196,110 @@ void SkTileGrid::insert(void* data, const SkIRect& bounds, bool) {
         fYTileCount -1), 0);
     int maxTileY = SkMax32(SkMin32((dilatedBounds.bottom() -1) / fInfo.fTileInterval.height(),
         fYTileCount -1), 0);
+    SkIRect tiles = SkIRect::MakeLTRB(minTileX, minTileY, maxTileX + 1, maxTileY + 1);
+
+    // Start from the smallest bucket that covers all the tiles.
+    int level = 0;
+    while ((minTileX >> level) != (maxTileX >> level) ||
+           (minTileY >> level) != (maxTileY >> level)) {
+        level++;
+    }
+    this->insertCells(level, minTileX >> level, minTileY >> level, tiles, fData.count());
+
+    fData.push(data);
+    fLastInsertTiles = tiles;
+}
+
+void SkTileGrid::insertCells(int level, int x, int y, const SkIRect& tiles, int32_t index) {
+    SkIRect cellTiles = SkIRect::MakeLTRB(x << level, y << level,
+                                          (x + 1) << level, (y + 1) << level);
+    if (!cellTiles.intersect(0, 0, fXTileCount, fYTileCount) ||
+        !SkIRect::Intersects(cellTiles, tiles)) {
+        return;
+    }
+    if (tiles.contains(cellTiles)) {
+        append_index(&fLevels[level].cell(x, y), index);
+        return;
+    }
+    // A bucket of the first level covers a single tile, so it is either in or out.
+    SkASSERT(level > 0);
+    for (int i = 0; i < 4; ++i) {
+        this->insertCells(level - 1, 2 * x + (i & 1), 2 * y + (i >> 1), tiles, index);
+    }
+}
+
+void SkTileGrid::insertOccluder(void* data, const SkIRect& bounds) {
+    // The datum may not have reached the grid, if it is outside of it.
+    if (fData.isEmpty() || fData.top() != data) {
+        return;
+    }
+    SkIRect deviceGrid = fGridBounds;
+    deviceGrid.offset(-fInfo.fOffset.fX, -fInfo.fOffset.fY);
+    deviceGrid.outset(fInfo.fMargin.width(), fInfo.fMargin.height());
+    SkIRect clipped = bounds;
+    if (!clipped.intersect(deviceGrid)) {
+        return;
+    }
+
+    int minTileX = SkPin32((clipped.left() + fInfo.fOffset.fX) / fInfo.fTileInterval.width(),
+                           0, fXTileCount - 1);
+    int maxTileX = SkPin32((clipped.right() - 1 + fInfo.fOffset.fX) /
+                           fInfo.fTileInterval.width(), 0, fXTileCount - 1);
+    int minTileY = SkPin32((clipped.top() + fInfo.fOffset.fY) / fInfo.fTileInterval.height(),
+                           0, fYTileCount - 1);
+    int maxTileY = SkPin32((clipped.bottom() - 1 + fInfo.fOffset.fY) /
+                           fInfo.fTileInterval.height(), 0, fYTileCount - 1);
 
-    for (int x = minTileX; x <= maxTileX; x++) {
-        for (int y = minTileY; y <= maxTileY; y++) {
-            this->tile(x, y).push(data);
+    // The datum may not have reached all of those tiles, if its bounds are smaller than the
+    // area it hides.
+    SkIRect tiles = SkIRect::MakeLTRB(minTileX, minTileY, maxTileX + 1, maxTileY + 1);
+    if (!tiles.intersect(fLastInsertTiles)) {
+        return;
+    }
+    int index = fData.count() - 1;
+
+    for (int x = tiles.fLeft; x < tiles.fRight; x++) {
+        for (int y = tiles.fTop; y < tiles.fBottom; y++) {
+            // Which part of the tile has to be hidden depends on what is drawn to, so that is
+            // left for firstVisible() to check. Here, only replace an occluder with one that
+            // hides at least as much of the tile.
+            SkIRect area = this->tileArea(x, y);
+            SkIRect hidden = bounds;
+            if (!hidden.intersect(area)) {
+                continue;
+            }
+            if (NULL == fOccluders) {
+                fOccluders = SkNEW_ARRAY(Occluder, fTileCount);
+                for (int i = 0; i < fTileCount; ++i) {
+                    fOccluders[i].fIndex = 0;
+                }
+            }
+            Occluder& occluder = fOccluders[y * fXTileCount + x];
+            if (0 != occluder.fIndex && !hidden.contains(occluder.fBounds)) {
+                continue;
+            }
+            occluder.fIndex = index;
+            occluder.fBounds = hidden;
         }
     }
-    fInsertionCount++;
 }
 
-void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
+int SkTileGrid::firstVisible(int x, int y, const SkIRect& visible) const {
+    if (NULL == fOccluders) {
+        return 0;
+    }
+    const Occluder& occluder = fOccluders[y * fXTileCount + x];
+    if (0 == occluder.fIndex) {
+        return 0;
+    }
+    SkIRect area = this->tileArea(x, y);
+    if (!area.intersect(visible) || !occluder.fBounds.contains(area)) {
+        return 0;
+    }
+    return occluder.fIndex;
+}
+
+SkIRect SkTileGrid::queryTiles(const SkIRect& query) const {
     SkIRect adjustedQuery = query;
     // The inset is to counteract the outset that was applied in 'insert'
     // The outset/inset is to optimize for lookups of size
@@ -80,55 +317,185 @@ void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
     int tileEndY = (adjustedQuery.bottom() + fInfo.fTileInterval.height() - 1) /
         fInfo.fTileInterval.height();
 
-    tileStartX = SkPin32(tileStartX, 0, fXTileCount - 1);
-    tileEndX = SkPin32(tileEndX, 1, fXTileCount);
-    tileStartY = SkPin32(tileStartY, 0, fYTileCount - 1);
-    tileEndY = SkPin32(tileEndY, 1, fYTileCount);
-
-    int queryTileCount = (tileEndX - tileStartX) * (tileEndY - tileStartY);
-    SkASSERT(queryTileCount);
-    if (queryTileCount == 1) {
-        *results = this->tile(tileStartX, tileStartY);
-    } else {
-        results->reset();
-        SkTDArray<int> curPositions;
-        curPositions.setCount(queryTileCount);
-        // Note: Reserving space for 1024 tile pointers on the stack. If the
-        // malloc becomes a bottleneck, we may consider increasing that number.
-        // Typical large web page, say 2k x 16k, would require 512 tiles of
-        // size 256 x 256 pixels.
-        SkAutoSTArray<1024, SkTDArray<void *>*> storage(queryTileCount);
-        SkTDArray<void *>** tileRange = storage.get();
-        int tile = 0;
-        for (int x = tileStartX; x < tileEndX; ++x) {
-            for (int y = tileStartY; y < tileEndY; ++y) {
-                tileRange[tile] = &this->tile(x, y);
-                curPositions[tile] = tileRange[tile]->count() ? 0 : kTileFinished;
-                ++tile;
+    return SkIRect::MakeLTRB(SkPin32(tileStartX, 0, fXTileCount - 1),
+                             SkPin32(tileStartY, 0, fYTileCount - 1),
+                             SkPin32(tileEndX, 1, fXTileCount),
+                             SkPin32(tileEndY, 1, fYTileCount));
+}
+
+void SkTileGrid::search(const SkIRect& query, SkTDArray<void*>* results) {
+    this->searchVisible(query, query, results);
+}
+
+void SkTileGrid::searchVisible(const SkIRect& query, const SkIRect& visible,
+                               SkTDArray<void*>* results) {
+    SkIRect tiles = this->queryTiles(query);
+    SkASSERT(!tiles.isEmpty());
+    results->reset();
+
+    // Find the first visible datum of each tile. A datum hidden in one tile is still returned
+    // if it shows in another one.
+    SkAutoSTMalloc<64, int32_t> tileFirstVisible(NULL != fOccluders ?
+                                                 tiles.width() * tiles.height() : 0);
+    if (NULL != fOccluders) {
+        for (int y = tiles.fTop; y < tiles.fBottom; ++y) {
+            for (int x = tiles.fLeft; x < tiles.fRight; ++x) {
+                tileFirstVisible[(y - tiles.fTop) * tiles.width() + x - tiles.fLeft] =
+                    this->firstVisible(x, y, visible);
+            }
+        }
+    }
+
+    // Read every bucket that covers part of the query; a datum there is hidden if it comes
+    // before the first visible datum of every tile in that part.
+    int cursorCount = 0;
+    for (int level = 0; level < fLevelCount; ++level) {
+        cursorCount += (((tiles.fRight - 1) >> level) - (tiles.fLeft >> level) + 1) *
+                       (((tiles.fBottom - 1) >> level) - (tiles.fTop >> level) + 1);
+    }
+    SkAutoSTArray<16, Cursor> cursors(cursorCount);
+    int active = 0;
+    for (int level = 0; level < fLevelCount; ++level) {
+        for (int y = tiles.fTop >> level; y <= (tiles.fBottom - 1) >> level; ++y) {
+            for (int x = tiles.fLeft >> level; x <= (tiles.fRight - 1) >> level; ++x) {
+                const SkTDArray<int32_t>& cell = fLevels[level].cell(x, y);
+                if (cell.isEmpty()) {
+                    continue;
+                }
+                int32_t cellFirstVisible = 0;
+                if (NULL != fOccluders) {
+                    SkIRect cellTiles = SkIRect::MakeLTRB(x << level, y << level,
+                                                          (x + 1) << level, (y + 1) << level);
+                    cellTiles.intersect(tiles);
+                    cellFirstVisible = SK_MaxS32;
+                    for (int ty = cellTiles.fTop; ty < cellTiles.fBottom; ++ty) {
+                        for (int tx = cellTiles.fLeft; tx < cellTiles.fRight; ++tx) {
+                            int i = (ty - tiles.fTop) * tiles.width() + tx - tiles.fLeft;
+                            cellFirstVisible = SkMin32(cellFirstVisible, tileFirstVisible[i]);
+                        }
+                    }
+                }
+                cursors[active++].init(cell, cellFirstVisible);
+            }
+        }
+    }
+
+    // Merge the runs of the buckets, in order. A datum stored in several buckets comes out of
+    // all of them at once.
+    int hidden = 0;
+    while (active > 0) {
+        // Drop the buckets that have run out.
+        for (int i = 0; i < active; ++i) {
+            if (cursors[i].done()) {
+                cursors[i--] = cursors[--active];
             }
         }
-        void *nextElement;
-        while(NULL != (nextElement = fNextDatumFunction(tileRange, curPositions))) {
-            results->push(nextElement);
+        if (1 == active) {
+            // Nothing left to merge with.
+            Cursor& cursor = cursors[0];
+            while (!cursor.done()) {
+                int32_t visibleStart = SkPin32(cursor.firstVisible(), cursor.start(),
+                                               cursor.end());
+                hidden += visibleStart - cursor.start();
+                results->append(cursor.end() - visibleStart, fData.begin() + visibleStart);
+                cursor.skipTo(cursor.end());
+            }
+            break;
+        }
+
+        int32_t start = SK_MaxS32;
+        for (int i = 0; i < active; ++i) {
+            start = SkMin32(start, cursors[i].start());
+        }
+        // The run ends where any of the runs starting with it ends, or another run starts.
+        int32_t end = SK_MaxS32;
+        int32_t firstVisibleInRun = SK_MaxS32;
+        for (int i = 0; i < active; ++i) {
+            if (cursors[i].start() == start) {
+                end = SkMin32(end, cursors[i].end());
+                firstVisibleInRun = SkMin32(firstVisibleInRun, cursors[i].firstVisible());
+            } else {
+                end = SkMin32(end, cursors[i].start());
+            }
+        }
+        int32_t visibleStart = SkPin32(firstVisibleInRun, start, end);
+        hidden += visibleStart - start;
+        results->append(end - visibleStart, fData.begin() + visibleStart);
+        for (int i = 0; i < active; ++i) {
+            if (cursors[i].start() == start) {
+                cursors[i].skipTo(end);
+            }
+        }
+    }
+    if (hidden > 0) {
+        sk_atomic_add(&gOccludedDrawCount, hidden);
+    }
+}
+
+int SkTileGrid::countTileData(int x, int y) const {
+    int count = 0;
+    for (int level = 0; level < fLevelCount; ++level) {
+        const SkTDArray<int32_t>& cell = fLevels[level].cell(x >> level, y >> level);
+        for (int i = 0; i < cell.count(); ++i) {
+            count += cell[i] < 0 ? -cell[i] : 1;
+        }
+    }
+    return count;
+}
+
+size_t SkTileGrid::getStorageSize() const {
+    size_t size = fData.count() * sizeof(void*);
+    for (int level = 0; level < fLevelCount; ++level) {
+        int cellCount = fLevels[level].fXCellCount * fLevels[level].fYCellCount;
+        size += cellCount * sizeof(SkTDArray<int32_t>);
+        for (int i = 0; i < cellCount; ++i) {
+            size += fLevels[level].fCells[i].count() * sizeof(int32_t);
         }
     }
+    return size;
 }
 
 void SkTileGrid::clear() {
-    for (int i = 0; i < fTileCount; i++) {
-        fTileData[i].reset();
+    for (int level = 0; level < fLevelCount; ++level) {
+        int cellCount = fLevels[level].fXCellCount * fLevels[level].fYCellCount;
+        for (int i = 0; i < cellCount; ++i) {
+            fLevels[level].fCells[i].reset();
+        }
     }
+    fData.reset();
+    fLastInsertTiles.setEmpty();
+    SkDELETE_ARRAY(fOccluders);
+    fOccluders = NULL;
 }
 
 int SkTileGrid::getCount() const {
-    return fInsertionCount;
+    return fData.count();
 }
 
 void SkTileGrid::rewindInserts() {
     SkASSERT(fClient);
-    for (int i = 0; i < fTileCount; ++i) {
-        while (!fTileData[i].isEmpty() && fClient->shouldRewind(fTileData[i].top())) {
-            fTileData[i].pop();
+    int count = fData.count();
+    while (!fData.isEmpty() && fClient->shouldRewind(fData.top())) {
+        fData.pop();
+    }
+    if (fData.count() == count) {
+        return;
+    }
+    count = fData.count();
+    fLastInsertTiles.setEmpty();
+    for (int level = 0; level < fLevelCount; ++level) {
+        int cellCount = fLevels[level].fXCellCount * fLevels[level].fYCellCount;
+        for (int i = 0; i < cellCount; ++i) {
+            truncate_indices(&fLevels[level].fCells[i], count);
+        }
+    }
+    // If an occluder was rewound, forget it. An earlier one may still hide the tile, but that
+    // can only mean drawing more than needed.
+    if (NULL != fOccluders) {
+        for (int i = 0; i < fTileCount; ++i) {
+            if (fOccluders[i].fIndex >= count) {
+                fOccluders[i].fIndex = 0;
+            }
         }
     }
 }
@@ -10,7 +10,6 @@
 #define SkTileGrid_DEFINED
 
 #include "SkBBoxHierarchy.h"
-#include "SkPictureStateTree.h"
 #include "SkTileGridPicture.h" // for TileGridInfo
 
 /**
@@ -19,16 +18,21 @@
  * structure that will be use in search() calls is known prior to insertion.
  * Calls to search will return in constant time.
  *
+ * The buckets are kept at several levels: the first has a bucket per tile, and
+ * each level after it has a bucket per square of 2x2 buckets of the level
+ * before. An element is stored in the fewest buckets which exactly cover the
+ * tiles it overlaps, so that one which spans many tiles, like a background, is
+ * stored a handful of times rather than once per tile. Each bucket holds the
+ * indices of its elements in insertion order, with runs of consecutive indices
+ * stored as ranges, and search() returns elements in insertion order.
+ *
  * Note: Current implementation of search() only supports looking-up regions
  * that are an exact match to a single tile.  Implementation could be augmented
  * to support arbitrary rectangles, but performance would be sub-optimal.
  */
 class SkTileGrid : public SkBBoxHierarchy {
 public:
-    typedef void* (*SkTileGridNextDatumFunctionPtr)(SkTDArray<void*>** tileData, SkTDArray<int>& tileIndices);
-
-    SkTileGrid(int xTileCount, int yTileCount, const SkTileGridPicture::TileGridInfo& info,
-        SkTileGridNextDatumFunctionPtr nextDatumFunction);
+    SkTileGrid(int xTileCount, int yTileCount, const SkTileGridPicture::TileGridInfo& info);
 
     virtual ~SkTileGrid();
 
@@ -42,12 +46,28 @@ public:
 
     virtual void flushDeferredInserts() SK_OVERRIDE {};
 
+    /**
+     * Remember 'data' as the occluder of the tiles it overlaps, so that searches for which it
+     * hides all that is visible of such a tile can leave out whatever was inserted before it
+     * there.
+     */
+    virtual void insertOccluder(void* data, const SkIRect& bounds) SK_OVERRIDE;
+
     /**
      * Populate 'results' with data pointers corresponding to bounding boxes that intersect 'query'
      * The query argument is expected to be an exact match to a tile of the grid
      */
     virtual void search(const SkIRect& query, SkTDArray<void*>* results) SK_OVERRIDE;
 
+    /**
+     * Same as search(), but leaves out the data that occluders hide in every pixel of 'visible'
+     * that falls in their tiles. search() itself does so for the whole query.
+     */
+    virtual void searchVisible(const SkIRect& query, const SkIRect& visible,
+                               SkTDArray<void*>* results) SK_OVERRIDE;
+
+    virtual bool searchIsOrdered() const SK_OVERRIDE { return true; }
+
     virtual void clear() SK_OVERRIDE;
 
     /**
@@ -57,74 +77,59 @@ public:
 
     virtual void rewindInserts() SK_OVERRIDE;
 
-    // Used by search() and in SkTileGridHelper implementations
-    enum {
-        kTileFinished = -1,
-    };
+    /**
+     * The number of bytes used to store the inserted data.
+     */
+    size_t getStorageSize() const;
+
 private:
-    SkTDArray<void*>& tile(int x, int y);
+    /**
+     * The buckets of one level. Each bucket covers a square of (1 << level) by (1 << level) tiles,
+     * and holds increasing data indices: a non-negative entry is an index, and a negative entry
+     * -n means that the n indices following the one before it are in the bucket too.
+     */
+    struct Level {
+        int fXCellCount;
+        int fYCellCount;
+        SkTDArray<int32_t>* fCells;
+
+        SkTDArray<int32_t>& cell(int x, int y) { return fCells[y * fXCellCount + x]; }
+    };
+
+    // Reads the indices in a bucket, as runs of consecutive indices.
+    class Cursor;
+
+    // The range of tiles, right and bottom exclusive, that a query rect maps to.
+    SkIRect queryTiles(const SkIRect& query) const;
+    // Adds 'index' to the buckets which exactly cover 'tiles', starting from the one at
+    // 'level', x, y.
+    void insertCells(int level, int x, int y, const SkIRect& tiles, int32_t index);
+    // The number of data that a search of the tile would find, for tests.
+    int countTileData(int x, int y) const;
+    // The device space area for which a tile holds data, margins included.
+    SkIRect tileArea(int x, int y) const;
+    // The index of the first datum that can show in the tile when only 'visible' will be drawn
+    // to; those before it are hidden.
+    int firstVisible(int x, int y, const SkIRect& visible) const;
+
+    // The last datum known to hide (part of) a tile: its index, and the part of the tile's area
+    // that it hides. An index of 0 means there is nothing to skip.
+    struct Occluder {
+        int     fIndex;
+        SkIRect fBounds;
+    };
 
     int fXTileCount, fYTileCount, fTileCount;
     SkTileGridPicture::TileGridInfo fInfo;
-    SkTDArray<void*>* fTileData;
-    int fInsertionCount;
+    Level* fLevels;
+    int fLevelCount;
+    SkTDArray<void*> fData;  // in insertion order
+    SkIRect fLastInsertTiles;  // the tiles the last inserted datum overlaps, right/bottom exclusive
     SkIRect fGridBounds;
-    SkTileGridNextDatumFunctionPtr fNextDatumFunction;
+    Occluder* fOccluders; // one per tile, allocated by the first call to insertOccluder()
 
     friend class TileGridTest;
     typedef SkBBoxHierarchy INHERITED;
 };
 
-/**
- * Generic implementation for SkTileGridNextDatumFunctionPtr. user code may instantiate
- * this template to get a valid SkTileGridNextDatumFunction implementation
- *
- * Returns the next element of tileData[i][tileIndices[i]] for all i and advances
- * tileIndices[] past them. The order in which data are returned by successive
- * calls to this method must reflect the order in which the were originally
- * recorded into the tile grid.
- *
- * \param tileData array of pointers to arrays of tile data
- * \param tileIndices per-tile data indices, indices are incremented for tiles that contain
- *     the next datum.
- * \tparam T a type to which it is safe to cast a datum and that has an operator <
- *     such that 'a < b' is true if 'a' was inserted into the tile grid before 'b'.
- */
-template <typename T>
-void* SkTileGridNextDatum(SkTDArray<void*>** tileData, SkTDArray<int>& tileIndices) {
-    T* minVal = NULL;
-    int tileCount = tileIndices.count();
-    int minIndex = tileCount;
-    int maxIndex = 0;
-    // Find the next Datum; track where it's found so we reduce the size of the second loop.
-    for (int tile = 0; tile < tileCount; ++tile) {
-        int pos = tileIndices[tile];
-        if (pos != SkTileGrid::kTileFinished) {
-            T* candidate = (T*)(*tileData[tile])[pos];
-            if (NULL == minVal || (*candidate) < (*minVal)) {
-                minVal = candidate;
-                minIndex = tile;
-                maxIndex = tile;
-            } else if (!((*minVal) < (*candidate))) {
-                // We don't require operator==; if !(candidate<minVal) && !(minVal<candidate),
-                // candidate==minVal and we have to add this tile to the range searched.
-                maxIndex = tile;
-            }
-        }
-    }
-    // Increment indices past the next datum
-    if (minVal != NULL) {
-        for (int tile = minIndex; tile <= maxIndex; ++tile) {
-            int pos = tileIndices[tile];
-            if (pos != SkTileGrid::kTileFinished && (*tileData[tile])[pos] == minVal) {
-                if (++(tileIndices[tile]) >= tileData[tile]->count()) {
-                    tileIndices[tile] = SkTileGrid::kTileFinished;
-                }
-            }
-        }
-        return minVal;
-    }
-    return NULL;
-}
-
 #endif
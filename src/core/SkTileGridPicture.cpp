@@ -7,7 +7,6 @@
 
 #include "SkTileGridPicture.h"
 
-#include "SkPictureStateTree.h"
 #include "SkTileGrid.h"
 
 SkTileGridPicture::SkTileGridPicture(int width, int height, const TileGridInfo& info) {
@@ -23,6 +22,5 @@ SkTileGridPicture::SkTileGridPicture(int width, int height, const TileGridInfo&
 }
 
 SkBBoxHierarchy* SkTileGridPicture::createBBoxHierarchy() const {
-    return SkNEW_ARGS(SkTileGrid, (fXTileCount, fYTileCount, fInfo,
-         SkTileGridNextDatum<SkPictureStateTree::Draw>));
+    return SkNEW_ARGS(SkTileGrid, (fXTileCount, fYTileCount, fInfo));
 }
@@ -8,6 +8,7 @@
 
 
 #include "SkXfermode.h"
+#include "SkXfermode_opts.h"
 #include "SkColorPriv.h"
 #include "SkFlattenableBuffers.h"
 #include "SkMathPriv.h"
@@ -1039,8 +1040,15 @@ public:
         // these may be valid, or may be CANNOT_USE_COEFF
         fSrcCoeff = rec.fSC;
         fDstCoeff = rec.fDC;
+        fRowProc32 = SkXfermodeRowProcs::PlatformProcs32(mode);
+        fRowProcA8 = SkXfermodeRowProcs::PlatformProcsA8(mode);
     }
 
+    virtual void xfer32(SkPMColor dst[], const SkPMColor src[], int count,
+                        const SkAlpha aa[]) const SK_OVERRIDE;
+    virtual void xferA8(SkAlpha dst[], const SkPMColor src[], int count,
+                        const SkAlpha aa[]) const SK_OVERRIDE;
+
     virtual bool asMode(Mode* mode) const SK_OVERRIDE {
         if (mode) {
             *mode = fMode;
@@ -1093,6 +1101,8 @@ protected:
         fDstCoeff = rec.fDC;
         // now update our function-ptr in the super class
         this->INHERITED::setProc(rec.fProc);
+        fRowProc32 = SkXfermodeRowProcs::PlatformProcs32(fMode);
+        fRowProcA8 = SkXfermodeRowProcs::PlatformProcsA8(fMode);
     }
 
     virtual void flatten(SkFlattenableWriteBuffer& buffer) const SK_OVERRIDE {
@@ -1103,10 +1113,33 @@ protected:
 private:
     Mode    fMode;
     Coeff   fSrcCoeff, fDstCoeff;
+    // platform versions of fProc for a whole row, or NULL
+    SkXfermodeRowProcs::Proc32 fRowProc32;
+    SkXfermodeRowProcs::ProcA8 fRowProcA8;
 
     typedef SkProcXfermode INHERITED;
 };
 
+void SkProcCoeffXfermode::xfer32(SkPMColor* SK_RESTRICT dst,
+                                 const SkPMColor* SK_RESTRICT src, int count,
+                                 const SkAlpha* SK_RESTRICT aa) const {
+    if (NULL != fRowProc32) {
+        fRowProc32(dst, src, count, aa);
+    } else {
+        this->INHERITED::xfer32(dst, src, count, aa);
+    }
+}
+
+void SkProcCoeffXfermode::xferA8(SkAlpha* SK_RESTRICT dst,
+                                 const SkPMColor* SK_RESTRICT src, int count,
+                                 const SkAlpha* SK_RESTRICT aa) const {
+    if (NULL != fRowProcA8) {
+        fRowProcA8(dst, src, count, aa);
+    } else {
+        this->INHERITED::xferA8(dst, src, count, aa);
+    }
+}
+
 const char* SkXfermode::ModeName(Mode mode) {
     SkASSERT((unsigned) mode <= (unsigned)kLastMode);
     const char* gModeStrings[] = {
@@ -1379,9 +1412,16 @@ SkXfermode* SkXfermode::Create(Mode mode) {
         case kSrcOver_Mode:
             return NULL;
         case kDstIn_Mode:
-            return SkNEW_ARGS(SkDstInXfermode, (rec));
         case kDstOut_Mode:
-            return SkNEW_ARGS(SkDstOutXfermode, (rec));
+            // The portable loops of these two are no match for the platform's
+            // row procs, which the general class below picks up.
+            if (NULL == SkXfermodeRowProcs::PlatformProcs32(mode)) {
+                if (kDstIn_Mode == mode) {
+                    return SkNEW_ARGS(SkDstInXfermode, (rec));
+                }
+                return SkNEW_ARGS(SkDstOutXfermode, (rec));
+            }
+            return SkNEW_ARGS(SkProcCoeffXfermode, (rec, mode));
         default:
             return SkNEW_ARGS(SkProcCoeffXfermode, (rec, mode));
     }
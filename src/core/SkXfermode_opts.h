@@ -0,0 +1,33 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_DEFINED
+#define SkXfermode_opts_DEFINED
+
+#include "SkXfermode.h"
+
+/** Row procs that the xfermode for a given mode can call instead of its
+    SkXfermodeProc, one row at a time. They must give exactly the result of
+    calling that proc on every pixel, including the coverage (aa) lerp.
+*/
+class SkXfermodeRowProcs {
+public:
+    typedef void (*Proc32)(SkPMColor* SK_RESTRICT dst,
+                           const SkPMColor* SK_RESTRICT src, int count,
+                           const SkAlpha* SK_RESTRICT aa);
+    typedef void (*ProcA8)(SkAlpha* SK_RESTRICT dst,
+                           const SkPMColor* SK_RESTRICT src, int count,
+                           const SkAlpha* SK_RESTRICT aa);
+
+    /** Return the platform's row procs for the mode, or NULL if there are
+        none. These are implemented in src/opts for the CPU we're running on.
+    */
+    static Proc32 PlatformProcs32(SkXfermode::Mode);
+    static ProcA8 PlatformProcsA8(SkXfermode::Mode);
+};
+
+#endif
@@ -89,6 +89,11 @@ bool SkBlendImageFilter::onFilterImage(Proxy* proxy,
     return true;
 }
 
+bool SkBlendImageFilter::onFilterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                              SkIRect* src) {
+    return this->getInputsSourceBounds(dst, ctm, src);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #if SK_SUPPORT_GPU
@@ -9,19 +9,21 @@
 #include "SkBlurImageFilter.h"
 #include "SkColorPriv.h"
 #include "SkFlattenableBuffers.h"
+#include "SkImageFilterThreads.h"
+#include "SkRect.h"
 #if SK_SUPPORT_GPU
 #include "GrContext.h"
 #include "SkImageFilterUtils.h"
 #endif
 
 SkBlurImageFilter::SkBlurImageFilter(SkFlattenableReadBuffer& buffer)
-  : INHERITED(buffer) {
+  : INHERITED(buffer), fThreadCount(0) {
     fSigma.fWidth = buffer.readScalar();
     fSigma.fHeight = buffer.readScalar();
 }
 
 SkBlurImageFilter::SkBlurImageFilter(SkScalar sigmaX, SkScalar sigmaY, SkImageFilter* input)
-    : INHERITED(input), fSigma(SkSize::Make(sigmaX, sigmaY)) {
+    : INHERITED(input), fSigma(SkSize::Make(sigmaX, sigmaY)), fThreadCount(0) {
     SkASSERT(sigmaX >= 0 && sigmaY >= 0);
 }
 
@@ -31,12 +33,27 @@ void SkBlurImageFilter::flatten(SkFlattenableWriteBuffer& buffer) const {
     buffer.writeScalar(fSigma.fHeight);
 }
 
-static void boxBlurX(const SkBitmap& src, SkBitmap* dst, int kernelSize,
-                     int leftOffset, int rightOffset)
+// Each row of a pass in X, and each column of a pass in Y, is blurred on its
+// own, so a pass can be split into slices of rows or columns on several
+// threads without changing the result.
+struct BoxBlurPass {
+    const SkBitmap* fSrc;
+    SkBitmap*       fDst;
+    int             fKernelSize;
+    int             fLowOffset;
+    int             fHighOffset;
+};
+
+static void boxBlurRows(void* context, int startY, int stopY)
 {
-    int width = src.width(), height = src.height();
+    const BoxBlurPass& pass = *static_cast<const BoxBlurPass*>(context);
+    const SkBitmap& src = *pass.fSrc;
+    SkBitmap* dst = pass.fDst;
+    int kernelSize = pass.fKernelSize;
+    int leftOffset = pass.fLowOffset, rightOffset = pass.fHighOffset;
+    int width = src.width();
     int rightBorder = SkMin32(rightOffset + 1, width);
-    for (int y = 0; y < height; ++y) {
+    for (int y = startY; y < stopY; ++y) {
         int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
         SkPMColor* p = src.getAddr32(0, y);
         for (int i = 0; i < rightBorder; ++i) {
@@ -74,14 +91,18 @@ static void boxBlurX(const SkBitmap& src, SkBitmap* dst, int kernelSize,
     }
 }
 
-static void boxBlurY(const SkBitmap& src, SkBitmap* dst, int kernelSize,
-                     int topOffset, int bottomOffset)
+static void boxBlurColumns(void* context, int startX, int stopX)
 {
-    int width = src.width(), height = src.height();
+    const BoxBlurPass& pass = *static_cast<const BoxBlurPass*>(context);
+    const SkBitmap& src = *pass.fSrc;
+    SkBitmap* dst = pass.fDst;
+    int kernelSize = pass.fKernelSize;
+    int topOffset = pass.fLowOffset, bottomOffset = pass.fHighOffset;
+    int height = src.height();
     int bottomBorder = SkMin32(bottomOffset + 1, height);
     int srcStride = src.rowBytesAsPixels();
     int dstStride = dst->rowBytesAsPixels();
-    for (int x = 0; x < width; ++x) {
+    for (int x = startX; x < stopX; ++x) {
         int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
         SkColor* p = src.getAddr32(x, 0);
         for (int i = 0; i < bottomBorder; ++i) {
@@ -119,6 +140,20 @@ static void boxBlurY(const SkBitmap& src, SkBitmap* dst, int kernelSize,
     }
 }
 
+static void boxBlurX(const SkBitmap& src, SkBitmap* dst, int kernelSize,
+                     int leftOffset, int rightOffset, int threadCount)
+{
+    BoxBlurPass pass = { &src, dst, kernelSize, leftOffset, rightOffset };
+    SkImageFilterThreads::Run(threadCount, src.height(), boxBlurRows, &pass);
+}
+
+static void boxBlurY(const SkBitmap& src, SkBitmap* dst, int kernelSize,
+                     int topOffset, int bottomOffset, int threadCount)
+{
+    BoxBlurPass pass = { &src, dst, kernelSize, topOffset, bottomOffset };
+    SkImageFilterThreads::Run(threadCount, src.width(), boxBlurColumns, &pass);
+}
+
 static void getBox3Params(SkScalar s, int *kernelSize, int* kernelSize3, int *lowOffset, int *highOffset)
 {
     float pi = SkScalarToFloat(SK_ScalarPI);
@@ -169,25 +204,42 @@ bool SkBlurImageFilter::onFilterImage(Proxy* proxy,
         return false;
     }
 
+    int threads = SkImageFilterThreads::Resolve(fThreadCount);
     if (kernelSizeX > 0 && kernelSizeY > 0) {
-        boxBlurX(src,  &temp, kernelSizeX,  lowOffsetX, highOffsetX);
-        boxBlurY(temp, dst,   kernelSizeY,  lowOffsetY, highOffsetY);
-        boxBlurX(*dst, &temp, kernelSizeX,  highOffsetX,  lowOffsetX);
-        boxBlurY(temp, dst,   kernelSizeY,  highOffsetY,  lowOffsetY);
-        boxBlurX(*dst, &temp, kernelSizeX3, highOffsetX, highOffsetX);
-        boxBlurY(temp, dst,   kernelSizeY3, highOffsetY, highOffsetY);
+        boxBlurX(src,  &temp, kernelSizeX,  lowOffsetX, highOffsetX, threads);
+        boxBlurY(temp, dst,   kernelSizeY,  lowOffsetY, highOffsetY, threads);
+        boxBlurX(*dst, &temp, kernelSizeX,  highOffsetX,  lowOffsetX, threads);
+        boxBlurY(temp, dst,   kernelSizeY,  highOffsetY,  lowOffsetY, threads);
+        boxBlurX(*dst, &temp, kernelSizeX3, highOffsetX, highOffsetX, threads);
+        boxBlurY(temp, dst,   kernelSizeY3, highOffsetY, highOffsetY, threads);
     } else if (kernelSizeX > 0) {
-        boxBlurX(src,  dst,   kernelSizeX,  lowOffsetX, highOffsetX);
-        boxBlurX(*dst, &temp, kernelSizeX,  highOffsetX,  lowOffsetX);
-        boxBlurX(temp, dst,   kernelSizeX3, highOffsetX, highOffsetX);
+        boxBlurX(src,  dst,   kernelSizeX,  lowOffsetX, highOffsetX, threads);
+        boxBlurX(*dst, &temp, kernelSizeX,  highOffsetX,  lowOffsetX, threads);
+        boxBlurX(temp, dst,   kernelSizeX3, highOffsetX, highOffsetX, threads);
     } else if (kernelSizeY > 0) {
-        boxBlurY(src,  dst,   kernelSizeY,  lowOffsetY, highOffsetY);
-        boxBlurY(*dst, &temp, kernelSizeY,  highOffsetY, lowOffsetY);
-        boxBlurY(temp, dst,   kernelSizeY3, highOffsetY, highOffsetY);
+        boxBlurY(src,  dst,   kernelSizeY,  lowOffsetY, highOffsetY, threads);
+        boxBlurY(*dst, &temp, kernelSizeY,  highOffsetY, lowOffsetY, threads);
+        boxBlurY(temp, dst,   kernelSizeY3, highOffsetY, highOffsetY, threads);
     }
     return true;
 }
 
+bool SkBlurImageFilter::onFilterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                             SkIRect* src) {
+    int kernelSizeX, kernelSizeX3, lowOffsetX, highOffsetX;
+    int kernelSizeY, kernelSizeY3, lowOffsetY, highOffsetY;
+    getBox3Params(fSigma.width(), &kernelSizeX, &kernelSizeX3, &lowOffsetX, &highOffsetX);
+    getBox3Params(fSigma.height(), &kernelSizeY, &kernelSizeY3, &lowOffsetY, &highOffsetY);
+    if (kernelSizeX < 0 || kernelSizeY < 0) {
+        return false;
+    }
+
+    // Each of the three box passes reaches at most highOffset either way.
+    SkIRect r = dst;
+    r.outset(3 * highOffsetX, 3 * highOffsetY);
+    return this->getInputsSourceBounds(r, ctm, src);
+}
+
 bool SkBlurImageFilter::filterImageGPU(Proxy* proxy, const SkBitmap& src, SkBitmap* result) {
 #if SK_SUPPORT_GPU
     SkBitmap input;
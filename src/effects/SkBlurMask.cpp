@@ -8,6 +8,7 @@
 
 
 #include "SkBlurMask.h"
+#include "SkBlurMask_opts.h"
 #include "SkMath.h"
 #include "SkTemplates.h"
 #include "SkEndian.h"
@@ -22,6 +23,10 @@
 
 #define UNROLL_SEPARABLE_LOOPS
 
+// The platform column blurs keep their running sums in 16 bits, which holds
+// 255 * kernelSize for kernels up to this size.
+static const int kMaxColumnKernelSize = 257;
+
 /**
  * This function performs a box blur in X, of the given radius.  If the
  * "transpose" parameter is true, it will transpose the pixels on write,
@@ -404,6 +409,111 @@ static int boxBlurInterp(const uint8_t* src, int src_y_stride, uint8_t* dst,
     return new_width;
 }
 
+/**
+ * These give exactly the results of boxBlur() and boxBlurInterp() with
+ * transpose set, when given the transpose of their src. They blur down the
+ * columns of src, which is height rows of width pixels, one row at a time
+ * with the platform's SkBlurMaskProcs, so a whole row of columns is summed in
+ * parallel. The rows of src and dst are contiguous. sums must hold width
+ * values (two sets of them for boxBlurInterpColumns).
+ */
+static int boxBlurColumns(SkBlurMaskProcs::BoxBlurRowProc proc,
+                          const uint8_t* src, uint8_t* dst,
+                          int leftRadius, int rightRadius, int width, int height,
+                          uint16_t* sums)
+{
+    int diameter = leftRadius + rightRadius;
+    int kernelSize = diameter + 1;
+    int border = SkMin32(height, diameter);
+    uint32_t scale = (1 << 24) / kernelSize;
+    int new_height = height + SkMax32(leftRadius, rightRadius) * 2;
+#ifndef SK_DISABLE_BLUR_ROUNDING
+    uint32_t half = 1 << 23;
+#else
+    uint32_t half = 0;
+#endif
+    SkASSERT(kernelSize <= kMaxColumnKernelSize);
+    sk_bzero(sums, width * sizeof(uint16_t));
+    const uint8_t* right = src;
+    const uint8_t* left = src;
+    for (int y = 0; y < rightRadius - leftRadius; ++y) {
+        memset(dst, 0, width);
+        dst += width;
+    }
+    for (int y = 0; y < border; ++y) {
+        proc(dst, right, NULL, sums, width, scale, half);
+        right += width;
+        dst += width;
+    }
+    for (int y = height; y < diameter; ++y) {
+        proc(dst, NULL, NULL, sums, width, scale, half);
+        dst += width;
+    }
+    for (int y = diameter; y < height; ++y) {
+        proc(dst, right, left, sums, width, scale, half);
+        right += width;
+        left += width;
+        dst += width;
+    }
+    for (int y = 0; y < border; ++y) {
+        proc(dst, NULL, left, sums, width, scale, half);
+        left += width;
+        dst += width;
+    }
+    for (int y = 0; y < leftRadius - rightRadius; ++y) {
+        memset(dst, 0, width);
+        dst += width;
+    }
+    return new_height;
+}
+
+static int boxBlurInterpColumns(SkBlurMaskProcs::BoxBlurInterpRowProc proc,
+                                const uint8_t* src, uint8_t* dst,
+                                int radius, int width, int height,
+                                uint8_t outer_weight, uint16_t* sums)
+{
+    int diameter = radius * 2;
+    int kernelSize = diameter + 1;
+    int border = SkMin32(height, diameter);
+    int inner_weight = 255 - outer_weight;
+    outer_weight += outer_weight >> 7;
+    inner_weight += inner_weight >> 7;
+    uint32_t outer_scale = (outer_weight << 16) / kernelSize;
+    uint32_t inner_scale = (inner_weight << 16) / (kernelSize - 2);
+#ifndef SK_DISABLE_BLUR_ROUNDING
+    uint32_t half = 1 << 23;
+#else
+    uint32_t half = 0;
+#endif
+    SkASSERT(kernelSize <= kMaxColumnKernelSize);
+    uint16_t* outer_sums = sums;
+    uint16_t* inner_sums = sums + width;
+    sk_bzero(sums, 2 * width * sizeof(uint16_t));
+    const uint8_t* right = src;
+    const uint8_t* left = src;
+    for (int y = 0; y < border; ++y) {
+        proc(dst, right, NULL, outer_sums, inner_sums, width, outer_scale, inner_scale, half);
+        right += width;
+        dst += width;
+    }
+    for (int y = height; y < diameter; ++y) {
+        proc(dst, NULL, NULL, outer_sums, inner_sums, width, outer_scale, inner_scale, half);
+        dst += width;
+    }
+    for (int y = diameter; y < height; ++y) {
+        proc(dst, right, left, outer_sums, inner_sums, width, outer_scale, inner_scale, half);
+        right += width;
+        left += width;
+        dst += width;
+    }
+    for (int y = 0; y < border; ++y) {
+        proc(dst, NULL, left, outer_sums, inner_sums, width, outer_scale, inner_scale, half);
+        left += width;
+        dst += width;
+    }
+    return height + diameter;
+}
+
 static void get_adjusted_radii(SkScalar passRadius, int *loRadius, int *hiRadius)
 {
     *loRadius = *hiRadius = SkScalarCeil(passRadius);
@@ -1010,8 +1120,59 @@ bool SkBlurMask::Blur(SkMask* dst, const SkMask& src,
         uint8_t*        dp = SkMask::AllocImage(dstSize);
         SkAutoTCallVProc<uint8_t, SkMask_FreeImage> autoCall(dp);
 
+        SkBlurMaskProcs::BoxBlurRowProc blurRow = NULL;
+        SkBlurMaskProcs::BoxBlurInterpRowProc blurInterpRow = NULL;
+        SkBlurMaskProcs::TransposeProc transpose = NULL;
+        if (separable && 2 * rx + 1 <= kMaxColumnKernelSize) {
+            blurRow = SkBlurMaskProcs::PlatformBoxBlurRow();
+            blurInterpRow = SkBlurMaskProcs::PlatformBoxBlurInterpRow();
+            transpose = SkBlurMaskProcs::PlatformTranspose();
+        }
+
         // build the blurry destination
-        if (separable) {
+        if (NULL != blurRow && NULL != blurInterpRow && NULL != transpose) {
+            // The same passes as below, but each blur in X is a transpose and
+            // a blur down the columns.
+            SkAutoTMalloc<uint8_t>  tmpBuffer(dstSize);
+            uint8_t*                tp = tmpBuffer.get();
+            SkAutoTMalloc<uint16_t> sumBuffer(2 * SkMax32(dst->fBounds.width(),
+                                                          dst->fBounds.height()));
+            uint16_t*               sums = sumBuffer.get();
+            int w = sw, h = sh;
+
+            transpose(tp, h, sp, src.fRowBytes, w, h);
+            if (outerWeight == 255) {
+                int loRadius, hiRadius;
+                get_adjusted_radii(passRadius, &loRadius, &hiRadius);
+                if (kHigh_Quality == quality) {
+                    w = boxBlurColumns(blurRow, tp, dp, loRadius, hiRadius, h, w, sums);
+                    w = boxBlurColumns(blurRow, dp, tp, hiRadius, loRadius, h, w, sums);
+                    w = boxBlurColumns(blurRow, tp, dp, hiRadius, hiRadius, h, w, sums);
+                    transpose(tp, w, dp, h, h, w);
+                    h = boxBlurColumns(blurRow, tp, dp, loRadius, hiRadius, w, h, sums);
+                    h = boxBlurColumns(blurRow, dp, tp, hiRadius, loRadius, w, h, sums);
+                    h = boxBlurColumns(blurRow, tp, dp, hiRadius, hiRadius, w, h, sums);
+                } else {
+                    w = boxBlurColumns(blurRow, tp, dp, rx, rx, h, w, sums);
+                    transpose(tp, w, dp, h, h, w);
+                    h = boxBlurColumns(blurRow, tp, dp, ry, ry, w, h, sums);
+                }
+            } else {
+                if (kHigh_Quality == quality) {
+                    w = boxBlurInterpColumns(blurInterpRow, tp, dp, rx, h, w, outerWeight, sums);
+                    w = boxBlurInterpColumns(blurInterpRow, dp, tp, rx, h, w, outerWeight, sums);
+                    w = boxBlurInterpColumns(blurInterpRow, tp, dp, rx, h, w, outerWeight, sums);
+                    transpose(tp, w, dp, h, h, w);
+                    h = boxBlurInterpColumns(blurInterpRow, tp, dp, ry, w, h, outerWeight, sums);
+                    h = boxBlurInterpColumns(blurInterpRow, dp, tp, ry, w, h, outerWeight, sums);
+                    h = boxBlurInterpColumns(blurInterpRow, tp, dp, ry, w, h, outerWeight, sums);
+                } else {
+                    w = boxBlurInterpColumns(blurInterpRow, tp, dp, rx, h, w, outerWeight, sums);
+                    transpose(tp, w, dp, h, h, w);
+                    h = boxBlurInterpColumns(blurInterpRow, tp, dp, ry, w, h, outerWeight, sums);
+                }
+            }
+        } else if (separable) {
             SkAutoTMalloc<uint8_t>  tmpBuffer(dstSize);
             uint8_t*                tp = tmpBuffer.get();
             int w = sw, h = sh;
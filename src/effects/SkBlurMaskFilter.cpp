@@ -9,6 +9,8 @@
 #include "SkBlurMaskFilter.h"
 #include "SkBlurMask.h"
 #include "SkFlattenableBuffers.h"
+#include "SkFloatBits.h"
+#include "SkMaskCache.h"
 #include "SkMaskFilter.h"
 #include "SkBounder.h"
 #include "SkRasterClip.h"
@@ -36,10 +38,15 @@ protected:
                                            const SkIRect& clipBounds,
                                            NinePatch*) const SK_OVERRIDE;
 
+    virtual bool asCacheKey(const SkMatrix&, SkTDArray<uint32_t>* key) const SK_OVERRIDE;
+
     bool filterRectMask(SkMask* dstM, const SkRect& r, const SkMatrix& matrix,
                         SkIPoint* margin, SkMask::CreateMode createMode) const;
 
 private:
+    SkScalar computeXformedRadius(const SkMatrix&) const;
+    SkBlurMask::Quality getQuality() const;
+
     SkScalar                    fRadius;
     SkBlurMaskFilter::BlurStyle fBlurStyle;
     uint32_t                    fBlurFlags;
@@ -87,9 +94,7 @@ SkMask::Format SkBlurMaskFilterImpl::getFormat() const {
     return SkMask::kA8_Format;
 }
 
-bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
-                                      const SkMatrix& matrix,
-                                      SkIPoint* margin) const{
+SkScalar SkBlurMaskFilterImpl::computeXformedRadius(const SkMatrix& matrix) const {
     SkScalar radius;
     if (fBlurFlags & SkBlurMaskFilter::kIgnoreTransform_BlurFlag) {
         radius = fRadius;
@@ -101,10 +106,19 @@ bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
     // handset) we limit the radius so something manageable. (as opposed to
     // a request like 10,000)
     static const SkScalar MAX_RADIUS = SkIntToScalar(128);
-    radius = SkMinScalar(radius, MAX_RADIUS);
-    SkBlurMask::Quality blurQuality =
-        (fBlurFlags & SkBlurMaskFilter::kHighQuality_BlurFlag) ?
+    return SkMinScalar(radius, MAX_RADIUS);
+}
+
+SkBlurMask::Quality SkBlurMaskFilterImpl::getQuality() const {
+    return (fBlurFlags & SkBlurMaskFilter::kHighQuality_BlurFlag) ?
             SkBlurMask::kHigh_Quality : SkBlurMask::kLow_Quality;
+}
+
+bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
+                                      const SkMatrix& matrix,
+                                      SkIPoint* margin) const{
+    SkScalar radius = this->computeXformedRadius(matrix);
+    SkBlurMask::Quality blurQuality = this->getQuality();
 
 #ifndef SK_DISABLE_SEPARABLE_MASK_BLUR
     return SkBlurMask::BlurSeparable(dst, src, radius, (SkBlurMask::Style)fBlurStyle,
@@ -115,24 +129,72 @@ bool SkBlurMaskFilterImpl::filterMask(SkMask* dst, const SkMask& src,
 #endif
 }
 
+static uint32_t scalar_to_key(SkScalar value) {
+    return SkFloat2Bits(SkScalarToFloat(value));
+}
+
+bool SkBlurMaskFilterImpl::asCacheKey(const SkMatrix& matrix,
+                                      SkTDArray<uint32_t>* key) const {
+    uint32_t* data = key->append(4);
+    data[0] = SkSetFourByteTag('b', 'l', 'u', 'r');
+    data[1] = scalar_to_key(this->computeXformedRadius(matrix));
+    data[2] = fBlurStyle;
+    data[3] = this->getQuality();
+    return true;
+}
+
 bool SkBlurMaskFilterImpl::filterRectMask(SkMask* dst, const SkRect& r,
                                           const SkMatrix& matrix,
                                           SkIPoint* margin, SkMask::CreateMode createMode) const{
-    SkScalar radius;
-    if (fBlurFlags & SkBlurMaskFilter::kIgnoreTransform_BlurFlag) {
-        radius = fRadius;
-    } else {
-        radius = matrix.mapRadius(fRadius);
+    SkScalar radius = this->computeXformedRadius(matrix);
+
+    if (SkMask::kComputeBoundsAndRenderImage_CreateMode != createMode ||
+        0 == SkMaskCache::GetByteLimit()) {
+        return SkBlurMask::BlurRect(dst, r, radius, (SkBlurMask::Style)fBlurStyle,
+                                    margin, createMode);
     }
 
-    // To avoid unseemly allocation requests (esp. for finite platforms like
-    // handset) we limit the radius so something manageable. (as opposed to
-    // a request like 10,000)
-    static const SkScalar MAX_RADIUS = SkIntToScalar(128);
-    radius = SkMinScalar(radius, MAX_RADIUS);
+    // Analytic rect blurs are cached by the rect, relative to its integer
+    // position, so the nine-patch for a rect that only moves by whole pixels
+    // is blurred once. The rect blur has no quality setting.
+    SkIPoint origin = { SkScalarFloorToInt(r.fLeft), SkScalarFloorToInt(r.fTop) };
+    SkRect relative = r;
+    relative.offset(-SkIntToScalar(origin.fX), -SkIntToScalar(origin.fY));
+    SkRect restored = relative;
+    restored.offset(SkIntToScalar(origin.fX), SkIntToScalar(origin.fY));
+    if (restored != r) {
+        // too far from the origin to move without rounding
+        return SkBlurMask::BlurRect(dst, r, radius, (SkBlurMask::Style)fBlurStyle,
+                                    margin, createMode);
+    }
+    uint32_t key[] = {
+        SkSetFourByteTag('b', 'r', 'c', 't'),
+        scalar_to_key(radius),
+        fBlurStyle,
+        scalar_to_key(relative.fLeft),
+        scalar_to_key(relative.fTop),
+        scalar_to_key(relative.fRight),
+        scalar_to_key(relative.fBottom),
+    };
 
-    return SkBlurMask::BlurRect(dst, r, radius, (SkBlurMask::Style)fBlurStyle,
-                                margin, createMode);
+    SkIPoint blurMargin;
+    if (SkMaskCache::Find(key, SK_ARRAY_COUNT(key), dst, &blurMargin)) {
+        dst->fBounds.offset(origin.fX, origin.fY);
+    } else {
+        if (!SkBlurMask::BlurRect(dst, r, radius, (SkBlurMask::Style)fBlurStyle,
+                                  &blurMargin, createMode)) {
+            return false;
+        }
+        if (NULL != dst->fImage) {
+            SkMask cached = *dst;
+            cached.fBounds.offset(-origin.fX, -origin.fY);
+            SkMaskCache::Add(key, SK_ARRAY_COUNT(key), cached, blurMargin);
+        }
+    }
+    if (NULL != margin) {
+        *margin = blurMargin;
+    }
+    return true;
 }
 
 #include "SkCanvas.h"
@@ -111,6 +111,11 @@ bool SkColorFilterImageFilter::onFilterImage(Proxy* proxy, const SkBitmap& sourc
     return true;
 }
 
+bool SkColorFilterImageFilter::onFilterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                                   SkIRect* src) {
+    return this->getInputsSourceBounds(dst, ctm, src);
+}
+
 bool SkColorFilterImageFilter::asColorFilter(SkColorFilter** filter) const {
     if (filter) {
         *filter = fColorFilter;
@@ -92,6 +92,14 @@ bool SkMergeImageFilter::onFilterBounds(const SkIRect& src, const SkMatrix& ctm,
     return true;
 }
 
+bool SkMergeImageFilter::onFilterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                              SkIRect* src) {
+    if (countInputs() < 1) {
+        return false;
+    }
+    return this->getInputsSourceBounds(dst, ctm, src);
+}
+
 bool SkMergeImageFilter::onFilterImage(Proxy* proxy, const SkBitmap& src,
                                        const SkMatrix& ctm,
                                        SkBitmap* result, SkIPoint* loc) {
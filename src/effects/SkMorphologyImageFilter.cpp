@@ -9,6 +9,7 @@
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
 #include "SkFlattenableBuffers.h"
+#include "SkImageFilterThreads.h"
 #include "SkRect.h"
 #if SK_SUPPORT_GPU
 #include "GrContext.h"
@@ -21,13 +22,13 @@
 #endif
 
 SkMorphologyImageFilter::SkMorphologyImageFilter(SkFlattenableReadBuffer& buffer)
-  : INHERITED(buffer) {
+  : INHERITED(buffer), fThreadCount(0) {
     fRadius.fWidth = buffer.readInt();
     fRadius.fHeight = buffer.readInt();
 }
 
 SkMorphologyImageFilter::SkMorphologyImageFilter(int radiusX, int radiusY, SkImageFilter* input)
-    : INHERITED(input), fRadius(SkISize::Make(radiusX, radiusY)) {
+    : INHERITED(input), fRadius(SkISize::Make(radiusX, radiusY)), fThreadCount(0) {
 }
 
 
@@ -37,6 +38,16 @@ void SkMorphologyImageFilter::flatten(SkFlattenableWriteBuffer& buffer) const {
     buffer.writeInt(fRadius.fHeight);
 }
 
+bool SkMorphologyImageFilter::onFilterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                                   SkIRect* src) {
+    if (fRadius.width() < 0 || fRadius.height() < 0) {
+        return false;
+    }
+    SkIRect r = dst;
+    r.outset(fRadius.width(), fRadius.height());
+    return this->getInputsSourceBounds(r, ctm, src);
+}
+
 static void erode(const SkPMColor* src, SkPMColor* dst,
                   int radius, int width, int height,
                   int srcStrideX, int srcStrideY,
@@ -71,20 +82,6 @@ static void erode(const SkPMColor* src, SkPMColor* dst,
     }
 }
 
-static void erodeX(const SkBitmap& src, SkBitmap* dst, int radiusX)
-{
-    erode(src.getAddr32(0, 0), dst->getAddr32(0, 0),
-          radiusX, src.width(), src.height(),
-          1, src.rowBytesAsPixels(), 1, dst->rowBytesAsPixels());
-}
-
-static void erodeY(const SkBitmap& src, SkBitmap* dst, int radiusY)
-{
-    erode(src.getAddr32(0, 0), dst->getAddr32(0, 0),
-          radiusY, src.height(), src.width(),
-          src.rowBytesAsPixels(), 1, dst->rowBytesAsPixels(), 1);
-}
-
 static void dilate(const SkPMColor* src, SkPMColor* dst,
                    int radius, int width, int height,
                    int srcStrideX, int srcStrideY,
@@ -119,18 +116,48 @@ static void dilate(const SkPMColor* src, SkPMColor* dst,
     }
 }
 
-static void dilateX(const SkBitmap& src, SkBitmap* dst, int radiusX)
+typedef void (*MorphologyProc)(const SkPMColor* src, SkPMColor* dst,
+                               int radius, int width, int height,
+                               int srcStrideX, int srcStrideY,
+                               int dstStrideX, int dstStrideY);
+
+// Every line of a pass (each row for a pass in X, each column for a pass in
+// Y) is filtered on its own, so the lines can be split into slices on several
+// threads without changing the result.
+struct MorphologyPass {
+    MorphologyProc   fProc;
+    const SkPMColor* fSrc;
+    SkPMColor*       fDst;
+    int              fRadius;
+    int              fWidth;
+    int              fSrcStrideX, fSrcStrideY;
+    int              fDstStrideX, fDstStrideY;
+};
+
+static void morphologySlice(void* context, int startY, int stopY)
+{
+    const MorphologyPass& pass = *static_cast<const MorphologyPass*>(context);
+    pass.fProc(pass.fSrc + startY * pass.fSrcStrideY, pass.fDst + startY * pass.fDstStrideY,
+               pass.fRadius, pass.fWidth, stopY - startY,
+               pass.fSrcStrideX, pass.fSrcStrideY, pass.fDstStrideX, pass.fDstStrideY);
+}
+
+static void morphologyX(MorphologyProc proc, const SkBitmap& src, SkBitmap* dst,
+                        int radiusX, int threadCount)
 {
-    dilate(src.getAddr32(0, 0), dst->getAddr32(0, 0),
-           radiusX, src.width(), src.height(),
-           1, src.rowBytesAsPixels(), 1, dst->rowBytesAsPixels());
+    MorphologyPass pass = { proc, src.getAddr32(0, 0), dst->getAddr32(0, 0),
+                            radiusX, src.width(),
+                            1, src.rowBytesAsPixels(), 1, dst->rowBytesAsPixels() };
+    SkImageFilterThreads::Run(threadCount, src.height(), morphologySlice, &pass);
 }
 
-static void dilateY(const SkBitmap& src, SkBitmap* dst, int radiusY)
+static void morphologyY(MorphologyProc proc, const SkBitmap& src, SkBitmap* dst,
+                        int radiusY, int threadCount)
 {
-    dilate(src.getAddr32(0, 0), dst->getAddr32(0, 0),
-           radiusY, src.height(), src.width(),
-           src.rowBytesAsPixels(), 1, dst->rowBytesAsPixels(), 1);
+    MorphologyPass pass = { proc, src.getAddr32(0, 0), dst->getAddr32(0, 0),
+                            radiusY, src.height(),
+                            src.rowBytesAsPixels(), 1, dst->rowBytesAsPixels(), 1 };
+    SkImageFilterThreads::Run(threadCount, src.width(), morphologySlice, &pass);
 }
 
 bool SkErodeImageFilter::onFilterImage(Proxy* proxy,
@@ -167,13 +194,14 @@ bool SkErodeImageFilter::onFilterImage(Proxy* proxy,
         return false;
     }
 
+    int threads = SkImageFilterThreads::Resolve(this->getThreadCount());
     if (width > 0 && height > 0) {
-        erodeX(src, &temp, width);
-        erodeY(temp, dst, height);
+        morphologyX(erode, src, &temp, width, threads);
+        morphologyY(erode, temp, dst, height, threads);
     } else if (width > 0) {
-        erodeX(src, dst, width);
+        morphologyX(erode, src, dst, width, threads);
     } else if (height > 0) {
-        erodeY(src, dst, height);
+        morphologyY(erode, src, dst, height, threads);
     }
     return true;
 }
@@ -212,13 +240,14 @@ bool SkDilateImageFilter::onFilterImage(Proxy* proxy,
         return false;
     }
 
+    int threads = SkImageFilterThreads::Resolve(this->getThreadCount());
     if (width > 0 && height > 0) {
-        dilateX(src, &temp, width);
-        dilateY(temp, dst, height);
+        morphologyX(dilate, src, &temp, width, threads);
+        morphologyY(dilate, temp, dst, height, threads);
     } else if (width > 0) {
-        dilateX(src, dst, width);
+        morphologyX(dilate, src, dst, width, threads);
     } else if (height > 0) {
-        dilateY(src, dst, height);
+        morphologyY(dilate, src, dst, height, threads);
     }
     return true;
 }
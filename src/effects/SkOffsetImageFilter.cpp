@@ -34,6 +34,16 @@ bool SkOffsetImageFilter::onFilterBounds(const SkIRect& src, const SkMatrix& ctm
     return true;
 }
 
+bool SkOffsetImageFilter::onFilterSourceBounds(const SkIRect& dst, const SkMatrix& ctm,
+                                               SkIRect* src) {
+    SkVector vec;
+    ctm.mapVectors(&vec, &fOffset, 1);
+
+    SkIRect moved = dst;
+    moved.offset(-SkScalarRoundToInt(vec.fX), -SkScalarRoundToInt(vec.fY));
+    return this->getInputsSourceBounds(moved, ctm, src);
+}
+
 void SkOffsetImageFilter::flatten(SkFlattenableWriteBuffer& buffer) const {
     this->INHERITED::flatten(buffer);
     buffer.writePoint(fOffset);
@@ -63,6 +63,25 @@ bool SkComposeImageFilter::onFilterBounds(const SkIRect& src,
            outer->filterBounds(tmp, ctm, dst);
 }
 
+bool SkComposeImageFilter::onFilterSourceBounds(const SkIRect& dst,
+                                                const SkMatrix& ctm,
+                                                SkIRect* src) {
+    SkImageFilter* outer = getInput(0);
+    SkImageFilter* inner = getInput(1);
+
+    if (!outer && !inner) {
+        return false;
+    }
+
+    if (!outer || !inner) {
+        return (outer ? outer : inner)->filterSourceBounds(dst, ctm, src);
+    }
+
+    SkIRect tmp;
+    return outer->filterSourceBounds(dst, ctm, &tmp) &&
+           inner->filterSourceBounds(tmp, ctm, src);
+}
+
 SkComposeImageFilter::SkComposeImageFilter(SkFlattenableReadBuffer& buffer) : INHERITED(buffer) {
 }
 
@@ -6,6 +6,7 @@
  */
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradientCache.h"
 #include "SkLinearGradient.h"
 #include "SkRadialGradient.h"
 #include "SkTwoPointRadialGradient.h"
@@ -26,8 +27,9 @@ SkGradientShaderBase::SkGradientShaderBase(const SkColor colors[], const SkScala
     fTileMode = mode;
     fTileProc = gTileProcs[mode];
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
     fCache32 = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 
     /*  Note: we let the caller skip the first and/or last position.
@@ -135,8 +137,9 @@ SkGradientShaderBase::SkGradientShaderBase(SkFlattenableReadBuffer& buffer) :
 
     fMapper = buffer.readFlattenableT<SkUnitMapper>();
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
     fCache32 = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 
     int colorCount = fColorCount = buffer.getArrayCount();
@@ -164,9 +167,7 @@ SkGradientShaderBase::SkGradientShaderBase(SkFlattenableReadBuffer& buffer) :
 }
 
 SkGradientShaderBase::~SkGradientShaderBase() {
-    if (fCache16Storage) {
-        sk_free(fCache16Storage);
-    }
+    SkSafeUnref(fCache16PixelRef);
     SkSafeUnref(fCache32PixelRef);
     if (fOrigColors != fStorage) {
         sk_free(fOrigColors);
@@ -239,16 +240,12 @@ bool SkGradientShaderBase::setContext(const SkBitmap& device,
 
 void SkGradientShaderBase::setCacheAlpha(U8CPU alpha) const {
     // if the new alpha differs from the previous time we were called, inval our cache
-    // this will trigger the cache to be rebuilt.
-    // we don't care about the first time, since the cache ptrs will already be NULL
+    // this will trigger the cache to be rebuilt (or found in SkGradientCache).
+    // we don't care about the first time, since the cache ptrs will already be NULL.
+    // The 16bit cache ignores alpha, so it stays.
     if (fCacheAlpha != alpha) {
-        fCache16 = NULL;            // inval the cache
         fCache32 = NULL;            // inval the cache
         fCacheAlpha = alpha;        // record the new alpha
-        // inform our subclasses
-        if (fCache32PixelRef) {
-            fCache32PixelRef->notifyPixelsChanged();
-        }
     }
 }
 
@@ -408,95 +405,166 @@ static inline U16CPU bitsTo16(unsigned x, const unsigned bits) {
     return 0;
 }
 
-const uint16_t* SkGradientShaderBase::getCache16() const {
-    if (fCache16 == NULL) {
-        // double the count for dither entries
-        const int entryCount = kCache16Count * 2;
-        const size_t allocSize = sizeof(uint16_t) * entryCount;
+/*
+ *  Our tables depend only on our colors and their positions, and for the
+ *  32bit one, the paint's alpha, so shaders which agree on those can share
+ *  them. Dithering is not part of the key, since every table holds its
+ *  dithered entries too. We have no way to put fMapper in the key, so a
+ *  shader with one keeps its tables to itself.
+ */
+int SkGradientShaderBase::cacheKeyCount() const {
+    if (fMapper) {
+        return 0;
+    }
+    // [tag, alpha, numColors, colors[], {positions[]}]
+    int count = 3 + fColorCount;
+    if (fColorCount > 2) {
+        count += fColorCount - 1;    // fRecs[].fPos
+    }
+    return count;
+}
 
-        if (fCache16Storage == NULL) { // set the storage and our working ptr
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
+void SkGradientShaderBase::makeCacheKey(uint32_t tag, unsigned alpha, uint32_t key[]) const {
+    SkDEBUGCODE(const uint32_t* start = key;)
+    *key++ = tag;
+    *key++ = alpha;
+    *key++ = fColorCount;
+    memcpy(key, fOrigColors, fColorCount * sizeof(SkColor));
+    key += fColorCount;
+    if (fColorCount > 2) {
+        for (int i = 1; i < fColorCount; i++) {
+            *key++ = fRecs[i].fPos;
         }
-        fCache16 = fCache16Storage;
-        if (fColorCount == 2) {
-            Build16bitCache(fCache16, fOrigColors[0], fOrigColors[1],
-                            kCache16Count);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
-                SkASSERT(nextIndex < kCache16Count);
-
-                if (nextIndex > prevIndex)
-                    Build16bitCache(fCache16 + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
-                prevIndex = nextIndex;
-            }
+    }
+    SkASSERT(key - start == this->cacheKeyCount());
+}
+
+SkMallocPixelRef* SkGradientShaderBase::buildCache16() const {
+    // double the count for dither entries
+    const int entryCount = kCache16Count * 2;
+    const size_t allocSize = sizeof(uint16_t) * entryCount;
+
+    SkMallocPixelRef* table = SkNEW_ARGS(SkMallocPixelRef, (NULL, allocSize, NULL));
+    uint16_t* cache = (uint16_t*)table->getAddr();
+    if (fColorCount == 2) {
+        Build16bitCache(cache, fOrigColors[0], fOrigColors[1], kCache16Count);
+    } else {
+        Rec* rec = fRecs;
+        int prevIndex = 0;
+        for (int i = 1; i < fColorCount; i++) {
+            int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
+            SkASSERT(nextIndex < kCache16Count);
+
+            if (nextIndex > prevIndex)
+                Build16bitCache(cache + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
+            prevIndex = nextIndex;
         }
+    }
 
-        if (fMapper) {
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
-            uint16_t* linear = fCache16;         // just computed linear data
-            uint16_t* mapped = fCache16Storage;  // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kCache16Count; i++) {
-                int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
-                mapped[i] = linear[index];
-                mapped[i + kCache16Count] = linear[index + kCache16Count];
-            }
-            sk_free(fCache16);
-            fCache16 = fCache16Storage;
+    if (fMapper) {
+        SkMallocPixelRef* mappedTable = SkNEW_ARGS(SkMallocPixelRef, (NULL, allocSize, NULL));
+        uint16_t* linear = cache;                                // just computed linear data
+        uint16_t* mapped = (uint16_t*)mappedTable->getAddr();    // storage for mapped data
+        SkUnitMapper* map = fMapper;
+        for (int i = 0; i < kCache16Count; i++) {
+            int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
+            mapped[i] = linear[index];
+            mapped[i + kCache16Count] = linear[index + kCache16Count];
         }
+        table->unref();
+        table = mappedTable;
     }
-    return fCache16;
+    return table;
 }
 
-const SkPMColor* SkGradientShaderBase::getCache32() const {
-    if (fCache32 == NULL) {
-        // double the count for dither entries
-        const int entryCount = kCache32Count * 4;
-        const size_t allocSize = sizeof(SkPMColor) * entryCount;
+SkMallocPixelRef* SkGradientShaderBase::buildCache32() const {
+    // double the count for dither entries
+    const int entryCount = kCache32Count * 4;
+    const size_t allocSize = sizeof(SkPMColor) * entryCount;
+
+    SkMallocPixelRef* table = SkNEW_ARGS(SkMallocPixelRef, (NULL, allocSize, NULL));
+    SkPMColor* cache = (SkPMColor*)table->getAddr();
+    if (fColorCount == 2) {
+        Build32bitCache(cache, fOrigColors[0], fOrigColors[1],
+                        kCache32Count, fCacheAlpha);
+    } else {
+        Rec* rec = fRecs;
+        int prevIndex = 0;
+        for (int i = 1; i < fColorCount; i++) {
+            int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
+            SkASSERT(nextIndex < kCache32Count);
+
+            if (nextIndex > prevIndex)
+                Build32bitCache(cache + prevIndex, fOrigColors[i-1],
+                                fOrigColors[i],
+                                nextIndex - prevIndex + 1, fCacheAlpha);
+            prevIndex = nextIndex;
+        }
+    }
 
-        if (NULL == fCache32PixelRef) {
-            fCache32PixelRef = SkNEW_ARGS(SkMallocPixelRef,
-                                          (NULL, allocSize, NULL));
+    if (fMapper) {
+        SkMallocPixelRef* mappedTable = SkNEW_ARGS(SkMallocPixelRef, (NULL, allocSize, NULL));
+        SkPMColor* linear = cache;                                // just computed linear data
+        SkPMColor* mapped = (SkPMColor*)mappedTable->getAddr();   // storage for mapped data
+        SkUnitMapper* map = fMapper;
+        for (int i = 0; i < kCache32Count; i++) {
+            int index = map->mapUnit16((i << 8) | i) >> 8;
+            mapped[i + kCache32Count*0] = linear[index + kCache32Count*0];
+            mapped[i + kCache32Count*1] = linear[index + kCache32Count*1];
+            mapped[i + kCache32Count*2] = linear[index + kCache32Count*2];
+            mapped[i + kCache32Count*3] = linear[index + kCache32Count*3];
         }
-        fCache32 = (SkPMColor*)fCache32PixelRef->getAddr();
-        if (fColorCount == 2) {
-            Build32bitCache(fCache32, fOrigColors[0], fOrigColors[1],
-                            kCache32Count, fCacheAlpha);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
-                SkASSERT(nextIndex < kCache32Count);
-
-                if (nextIndex > prevIndex)
-                    Build32bitCache(fCache32 + prevIndex, fOrigColors[i-1],
-                                    fOrigColors[i],
-                                    nextIndex - prevIndex + 1, fCacheAlpha);
-                prevIndex = nextIndex;
+        table->unref();
+        table = mappedTable;
+    }
+    return table;
+}
+
+static const uint32_t kCache16_Tag = SkSetFourByteTag('g', 'r', '1', '6');
+static const uint32_t kCache32_Tag = SkSetFourByteTag('g', 'r', '3', '2');
+
+const uint16_t* SkGradientShaderBase::getCache16() const {
+    if (fCache16 == NULL) {
+        const int keyCount = this->cacheKeyCount();
+        SkAutoSTMalloc<16, uint32_t> key(keyCount);
+        SkMallocPixelRef* table = NULL;
+        if (keyCount > 0) {
+            this->makeCacheKey(kCache16_Tag, 0, key.get());
+            table = SkGradientCache::Find(key.get(), keyCount);
+        }
+        if (NULL == table) {
+            table = this->buildCache16();
+            if (keyCount > 0) {
+                table->setImmutable();
+                SkGradientCache::Add(key.get(), keyCount, table);
             }
         }
+        SkSafeUnref(fCache16PixelRef);
+        fCache16PixelRef = table;
+        fCache16 = (uint16_t*)table->getAddr();
+    }
+    return fCache16;
+}
 
-        if (fMapper) {
-            SkMallocPixelRef* newPR = SkNEW_ARGS(SkMallocPixelRef,
-                                                 (NULL, allocSize, NULL));
-            SkPMColor* linear = fCache32;           // just computed linear data
-            SkPMColor* mapped = (SkPMColor*)newPR->getAddr();    // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kCache32Count; i++) {
-                int index = map->mapUnit16((i << 8) | i) >> 8;
-                mapped[i + kCache32Count*0] = linear[index + kCache32Count*0];
-                mapped[i + kCache32Count*1] = linear[index + kCache32Count*1];
-                mapped[i + kCache32Count*2] = linear[index + kCache32Count*2];
-                mapped[i + kCache32Count*3] = linear[index + kCache32Count*3];
+const SkPMColor* SkGradientShaderBase::getCache32() const {
+    if (fCache32 == NULL) {
+        const int keyCount = this->cacheKeyCount();
+        SkAutoSTMalloc<16, uint32_t> key(keyCount);
+        SkMallocPixelRef* table = NULL;
+        if (keyCount > 0) {
+            this->makeCacheKey(kCache32_Tag, fCacheAlpha, key.get());
+            table = SkGradientCache::Find(key.get(), keyCount);
+        }
+        if (NULL == table) {
+            table = this->buildCache32();
+            if (keyCount > 0) {
+                table->setImmutable();
+                SkGradientCache::Add(key.get(), keyCount, table);
             }
-            fCache32PixelRef->unref();
-            fCache32PixelRef = newPR;
-            fCache32 = (SkPMColor*)newPR->getAddr();
         }
+        SkSafeUnref(fCache32PixelRef);
+        fCache32PixelRef = table;
+        fCache32 = (SkPMColor*)table->getAddr();
     }
     return fCache32;
 }
@@ -153,13 +153,20 @@ private:
     mutable uint16_t*   fCache16;   // working ptr. If this is NULL, we need to recompute the cache values
     mutable SkPMColor*  fCache32;   // working ptr. If this is NULL, we need to recompute the cache values
 
-    mutable uint16_t*   fCache16Storage;    // storage for fCache16, allocated on demand
+    // The tables behind fCache16 and fCache32. Once built, they may be shared
+    // with other shaders through SkGradientCache, so they are never changed:
+    // a different table is made (or found) instead.
+    mutable SkMallocPixelRef* fCache16PixelRef;
     mutable SkMallocPixelRef* fCache32PixelRef;
     mutable unsigned    fCacheAlpha;        // the alpha value we used when we computed the cache. larger than 8bits so we can store uninitialized value
 
     static void Build16bitCache(uint16_t[], SkColor c0, SkColor c1, int count);
     static void Build32bitCache(SkPMColor[], SkColor c0, SkColor c1, int count,
                                 U8CPU alpha);
+    SkMallocPixelRef* buildCache16() const;
+    SkMallocPixelRef* buildCache32() const;
+    int cacheKeyCount() const;
+    void makeCacheKey(uint32_t tag, unsigned alpha, uint32_t key[]) const;
     void setCacheAlpha(U8CPU alpha) const;
     void initCommon();
 
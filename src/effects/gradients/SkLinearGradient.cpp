@@ -8,6 +8,11 @@
 
 #include "SkLinearGradient.h"
 
+// The linear and radial span procs step through the dithered rows of the table.
+SK_COMPILE_ASSERT((int)SkGradientSpanProcs::kDitherStride ==
+                  (int)SkGradientShaderBase::kDitherStride32,
+                  span_procs_dither_stride_must_match_table);
+
 static inline int repeat_bits(int x, const int bits) {
     return x & ((1 << bits) - 1);
 }
@@ -70,14 +75,16 @@ SkLinearGradient::SkLinearGradient(const SkPoint pts[2],
                                    SkUnitMapper* mapper)
     : SkGradientShaderBase(colors, pos, colorCount, mode, mapper)
     , fStart(pts[0])
-    , fEnd(pts[1]) {
+    , fEnd(pts[1])
+    , fSpanProc(SkGradientSpanProcs::PlatformLinear(fTileMode)) {
     pts_to_unit_matrix(pts, &fPtsToUnit);
 }
 
 SkLinearGradient::SkLinearGradient(SkFlattenableReadBuffer& buffer)
     : INHERITED(buffer)
     , fStart(buffer.readPoint())
-    , fEnd(buffer.readPoint()) {
+    , fEnd(buffer.readPoint())
+    , fSpanProc(SkGradientSpanProcs::PlatformLinear(fTileMode)) {
 }
 
 void SkLinearGradient::flatten(SkFlattenableWriteBuffer& buffer) const {
@@ -116,9 +123,11 @@ bool SkLinearGradient::setContext(const SkBitmap& device, const SkPaint& paint,
 
 namespace {
 
+// spanProc, if not NULL, is the platform's proc for our tile mode.
 typedef void (*LinearShadeProc)(TileProc proc, SkFixed dx, SkFixed fx,
                                 SkPMColor* dstC, const SkPMColor* cache,
-                                int toggle, int count);
+                                int toggle, int count,
+                                SkGradientSpanProcs::LinearProc spanProc);
 
 // Linear interpolation (lerp) is unnecessary if there are no sharp
 // discontinuities in the gradient - which must be true if there are
@@ -126,7 +135,8 @@ typedef void (*LinearShadeProc)(TileProc proc, SkFixed dx, SkFixed fx,
 void shadeSpan_linear_vertical_lerp(TileProc proc, SkFixed dx, SkFixed fx,
                                     SkPMColor* SK_RESTRICT dstC,
                                     const SkPMColor* SK_RESTRICT cache,
-                                    int toggle, int count) {
+                                    int toggle, int count,
+                                    SkGradientSpanProcs::LinearProc) {
     // We're a vertical gradient, so no change in a span.
     // If colors change sharply across the gradient, dithering is
     // insufficient (it subsamples the color space) and we need to lerp.
@@ -149,7 +159,8 @@ void shadeSpan_linear_vertical_lerp(TileProc proc, SkFixed dx, SkFixed fx,
 void shadeSpan_linear_clamp(TileProc proc, SkFixed dx, SkFixed fx,
                             SkPMColor* SK_RESTRICT dstC,
                             const SkPMColor* SK_RESTRICT cache,
-                            int toggle, int count) {
+                            int toggle, int count,
+                            SkGradientSpanProcs::LinearProc spanProc) {
     SkClampRange range;
     range.init(fx, dx, count, 0, SkGradientShaderBase::kCache32Count - 1);
 
@@ -160,7 +171,13 @@ void shadeSpan_linear_clamp(TileProc proc, SkFixed dx, SkFixed fx,
             count);
         dstC += count;
     }
-    if ((count = range.fCount1) > 0) {
+    if ((count = range.fCount1) > 0 && NULL != spanProc) {
+        spanProc(range.fFx1, dx, dstC, cache, toggle, count);
+        dstC += count;
+        if (count & 1) {
+            toggle = next_dither_toggle(toggle);
+        }
+    } else if (count > 0) {
         int unroll = count >> 3;
         fx = range.fFx1;
         for (int i = 0; i < unroll; i++) {
@@ -186,7 +203,12 @@ void shadeSpan_linear_clamp(TileProc proc, SkFixed dx, SkFixed fx,
 void shadeSpan_linear_mirror(TileProc proc, SkFixed dx, SkFixed fx,
                              SkPMColor* SK_RESTRICT dstC,
                              const SkPMColor* SK_RESTRICT cache,
-                             int toggle, int count) {
+                             int toggle, int count,
+                             SkGradientSpanProcs::LinearProc spanProc) {
+    if (NULL != spanProc) {
+        spanProc(fx, dx, dstC, cache, toggle, count);
+        return;
+    }
     do {
         unsigned fi = mirror_8bits(fx >> 8);
         SkASSERT(fi <= 0xFF);
@@ -199,7 +221,12 @@ void shadeSpan_linear_mirror(TileProc proc, SkFixed dx, SkFixed fx,
 void shadeSpan_linear_repeat(TileProc proc, SkFixed dx, SkFixed fx,
         SkPMColor* SK_RESTRICT dstC,
         const SkPMColor* SK_RESTRICT cache,
-        int toggle, int count) {
+        int toggle, int count,
+        SkGradientSpanProcs::LinearProc spanProc) {
+    if (NULL != spanProc) {
+        spanProc(fx, dx, dstC, cache, toggle, count);
+        return;
+    }
     do {
         unsigned fi = repeat_8bits(fx >> 8);
         SkASSERT(fi <= 0xFF);
@@ -245,7 +272,7 @@ void SkLinearGradient::shadeSpan(int x, int y, SkPMColor* SK_RESTRICT dstC,
         } else {
             SkASSERT(SkShader::kRepeat_TileMode == fTileMode);
         }
-        (*shadeProc)(proc, dx, fx, dstC, cache, toggle, count);
+        (*shadeProc)(proc, dx, fx, dstC, cache, toggle, count, fSpanProc);
     } else {
         SkScalar    dstX = SkIntToScalar(x);
         SkScalar    dstY = SkIntToScalar(y);
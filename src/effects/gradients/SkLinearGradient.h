@@ -10,6 +10,7 @@
 #define SkLinearGradient_DEFINED
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradient_opts.h"
 
 class SkLinearGradient : public SkGradientShaderBase {
 public:
@@ -35,6 +36,7 @@ private:
     typedef SkGradientShaderBase INHERITED;
     const SkPoint fStart;
     const SkPoint fEnd;
+    SkGradientSpanProcs::LinearProc fSpanProc;  // may be NULL
 };
 
 #endif
@@ -157,7 +157,8 @@ SkRadialGradient::SkRadialGradient(const SkPoint& center, SkScalar radius,
                 SkShader::TileMode mode, SkUnitMapper* mapper)
     : SkGradientShaderBase(colors, pos, colorCount, mode, mapper),
       fCenter(center),
-      fRadius(radius)
+      fRadius(radius),
+      fSpanProc(SkGradientSpanProcs::PlatformRadial(fTileMode))
 {
     // make sure our table is insync with our current #define for kSQRT_TABLE_SIZE
     SkASSERT(sizeof(gSqrt8Table) == kSQRT_TABLE_SIZE);
@@ -250,7 +251,8 @@ SkShader::GradientType SkRadialGradient::asAGradient(GradientInfo* info) const {
 SkRadialGradient::SkRadialGradient(SkFlattenableReadBuffer& buffer)
     : INHERITED(buffer),
       fCenter(buffer.readPoint()),
-      fRadius(buffer.readScalar()) {
+      fRadius(buffer.readScalar()),
+      fSpanProc(SkGradientSpanProcs::PlatformRadial(fTileMode)) {
 }
 
 void SkRadialGradient::flatten(SkFlattenableWriteBuffer& buffer) const {
@@ -300,18 +302,27 @@ inline bool no_need_for_radial_pin(int fx, int dx,
     fx += dx; \
     fy += dy;
 
+// spanProc, if not NULL, is the platform's proc for our tile mode.
 typedef void (* RadialShadeProc)(SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* dstC, const SkPMColor* cache,
-        int count, int toggle);
+        int count, int toggle, SkGradientSpanProcs::RadialProc spanProc);
+
+static inline void call_span_proc(SkGradientSpanProcs::RadialProc spanProc,
+        SkScalar sfx, SkScalar sdx, SkScalar sfy, SkScalar sdy,
+        SkPMColor* dstC, const SkPMColor* cache, int count, int toggle) {
+    spanProc(SkScalarToFloat(sfx), SkScalarToFloat(sdx),
+             SkScalarToFloat(sfy), SkScalarToFloat(sdy), dstC, cache, toggle, count);
+}
 
 // On Linux, this is faster with SkPMColor[] params than SkPMColor* SK_RESTRICT
 void shadeSpan_radial_clamp(SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
-        int count, int toggle) {
+        int count, int toggle, SkGradientSpanProcs::RadialProc spanProc) {
     // Floating point seems to be slower than fixed point,
-    // even when we have float hardware.
+    // even when we have float hardware (unless we have the platform's proc,
+    // which takes several square roots at once).
     const uint8_t* SK_RESTRICT sqrt_table = gSqrt8Table;
     SkFixed fx = SkScalarToFixed(sfx) >> 1;
     SkFixed dx = SkScalarToFixed(sdx) >> 1;
@@ -323,6 +334,8 @@ void shadeSpan_radial_clamp(SkScalar sfx, SkScalar sdx,
             cache[toggle + fi],
             cache[next_dither_toggle(toggle) + fi],
             count);
+    } else if (NULL != spanProc) {
+        call_span_proc(spanProc, sfx, sdx, sfy, sdy, dstC, cache, count, toggle);
     } else if ((count > 4) &&
                no_need_for_radial_pin(fx, dx, fy, dy, count)) {
         unsigned fi;
@@ -371,7 +384,11 @@ void shadeSpan_radial_clamp(SkScalar sfx, SkScalar sdx,
 void shadeSpan_radial_mirror(SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
-        int count, int toggle) {
+        int count, int toggle, SkGradientSpanProcs::RadialProc spanProc) {
+    if (NULL != spanProc) {
+        call_span_proc(spanProc, sfx, sdx, sfy, sdy, dstC, cache, count, toggle);
+        return;
+    }
     do {
 #ifdef SK_SCALAR_IS_FLOAT
         float fdist = sk_float_sqrt(sfx*sfx + sfy*sfy);
@@ -395,7 +412,11 @@ void shadeSpan_radial_mirror(SkScalar sfx, SkScalar sdx,
 void shadeSpan_radial_repeat(SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
-        int count, int toggle) {
+        int count, int toggle, SkGradientSpanProcs::RadialProc spanProc) {
+    if (NULL != spanProc) {
+        call_span_proc(spanProc, sfx, sdx, sfy, sdy, dstC, cache, count, toggle);
+        return;
+    }
     SkFixed fx = SkScalarToFixed(sfx);
     SkFixed dx = SkScalarToFixed(sdx);
     SkFixed fy = SkScalarToFixed(sfy);
@@ -450,7 +471,7 @@ void SkRadialGradient::shadeSpan(int x, int y,
         } else {
             SkASSERT(SkShader::kRepeat_TileMode == fTileMode);
         }
-        (*shadeProc)(srcPt.fX, sdx, srcPt.fY, sdy, dstC, cache, count, toggle);
+        (*shadeProc)(srcPt.fX, sdx, srcPt.fY, sdy, dstC, cache, count, toggle, fSpanProc);
     } else {    // perspective case
         SkScalar dstX = SkIntToScalar(x);
         SkScalar dstY = SkIntToScalar(y);
@@ -10,6 +10,7 @@
 #define SkRadialGradient_DEFINED
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradient_opts.h"
 
 class SkRadialGradient : public SkGradientShaderBase {
 public:
@@ -37,6 +38,7 @@ private:
     typedef SkGradientShaderBase INHERITED;
     const SkPoint fCenter;
     const SkScalar fRadius;
+    SkGradientSpanProcs::RadialProc fSpanProc;  // may be NULL
 };
 
 #endif
@@ -9,6 +9,7 @@
 
 #include <emmintrin.h>
 #include "SkBitmapProcState_opts_SSE2.h"
+#include "SkBitmapProcState_bicubic.h"
 #include "SkUtils.h"
 
 void S32_opaque_D32_filter_DX_SSE2(const SkBitmapProcState& s,
@@ -763,3 +764,52 @@ void S32_D16_filter_DX_SSE2(const SkBitmapProcState& s,
 
     } while (--count > 0);
 }
+
+// Unpacks a pixel into four floats, in the order of its bytes in memory.
+static inline __m128 bicubic_unpack(SkPMColor c, __m128i zero) {
+    __m128i pixel = _mm_cvtsi32_si128(c);
+    pixel = _mm_unpacklo_epi8(pixel, zero);
+    pixel = _mm_unpacklo_epi16(pixel, zero);
+    return _mm_cvtepi32_ps(pixel);
+}
+
+// Same as S32_D32_bicubic_shaderproc, with the four components of each
+// pixel blended at once.
+void S32_D32_bicubic_shaderproc_SSE2(const SkBitmapProcState& s, int x, int y,
+                                     SkPMColor* SK_RESTRICT colors, int count) {
+    SkASSERT(count > 0 && colors != NULL);
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 fzero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 alphaScale = _mm_set1_ps(s.fAlphaScale * (1.0f / 256));
+
+    SkBicubicTaps taps(s, x, y);
+    for (int n = 0; n < count; ++n) {
+        __m128 sum = fzero;
+        for (int j = 0; j < 4; ++j) {
+            const SkPMColor* row = taps.fRow[j];
+            __m128 rowSum = fzero;
+            for (int i = 0; i < 4; ++i) {
+                __m128 pixel = bicubic_unpack(row[taps.fX[i]], zero);
+                rowSum = _mm_add_ps(rowSum, _mm_mul_ps(_mm_set1_ps(taps.fWeightX[i]), pixel));
+            }
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(taps.fWeightY[j]), rowSum));
+        }
+
+        // The filter overshoots; pin back to a valid premultiplied color.
+        sum = _mm_max_ps(sum, fzero);
+        __m128 alpha = _mm_min_ps(sum, max);
+        alpha = _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(SK_A32_SHIFT / 8, SK_A32_SHIFT / 8,
+                                                         SK_A32_SHIFT / 8, SK_A32_SHIFT / 8));
+        sum = _mm_min_ps(sum, alpha);
+
+        sum = _mm_add_ps(_mm_mul_ps(sum, alphaScale), half);
+        __m128i result = _mm_cvttps_epi32(sum);
+        result = _mm_packs_epi32(result, zero);
+        result = _mm_packus_epi16(result, zero);
+        colors[n] = _mm_cvtsi128_si32(result);
+        taps.next();
+    }
+}
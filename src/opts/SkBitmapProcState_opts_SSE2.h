@@ -28,3 +28,5 @@ void ClampX_ClampY_nofilter_affine_SSE2(const SkBitmapProcState& s,
 void S32_D16_filter_DX_SSE2(const SkBitmapProcState& s,
                                   const uint32_t* xy,
                                   int count, uint16_t* colors);
+void S32_D32_bicubic_shaderproc_SSE2(const SkBitmapProcState& s, int x, int y,
+                                     SkPMColor colors[], int count);
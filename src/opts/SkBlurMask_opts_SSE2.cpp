@@ -0,0 +1,225 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurMask_opts_SSE2.h"
+
+#include <emmintrin.h>
+
+/*  The running sums are at most 255 * kernelSize, and SkBlurMask only calls
+    these for kernels of up to 257 pixels, so they fit in 16 bits and a
+    register holds eight of them.
+
+    The scalar blurs compute (sum * scale + half) >> 24 in uint32_t. Split
+    scale into 16-bit halves, hi and lo. Then
+
+        sum * scale + half = (sum * hi + ((sum * lo) >> 16) + (half >> 16)) << 16
+                             + ((sum * lo) & 0xFFFF)
+
+    as half has no low bits, and the last term can't carry into bit 16. The
+    products never reach 2^32, so the part in parentheses is less than 2^16,
+    and we can compute it, and take its top 8 bits, in 16-bit lanes.
+*/
+
+static inline __m128i scale_sums(const __m128i& sums, const __m128i& scaleLo,
+                                 const __m128i& scaleHi) {
+    return _mm_add_epi16(_mm_mullo_epi16(sums, scaleHi), _mm_mulhi_epu16(sums, scaleLo));
+}
+
+static inline __m128i load_sums(const uint16_t* sums) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums));
+}
+
+static inline void store_sums(uint16_t* sums, const __m128i& value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), value);
+}
+
+static inline void load_row(const uint8_t* row, __m128i* lo, __m128i* hi) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+    *lo = _mm_unpacklo_epi8(pixels, zero);
+    *hi = _mm_unpackhi_epi8(pixels, zero);
+}
+
+void SkBoxBlurRow_SSE2(uint8_t* SK_RESTRICT dst, const uint8_t* SK_RESTRICT right,
+                       const uint8_t* SK_RESTRICT left, uint16_t* SK_RESTRICT sums,
+                       int width, uint32_t scale, uint32_t half) {
+    SkASSERT(0 == (half & 0xFFFF));
+    const __m128i scaleLo = _mm_set1_epi16((short)(scale & 0xFFFF));
+    const __m128i scaleHi = _mm_set1_epi16((short)(scale >> 16));
+    const __m128i halfV = _mm_set1_epi16((short)(half >> 16));
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i s0 = load_sums(sums + x);
+        __m128i s1 = load_sums(sums + x + 8);
+        __m128i lo, hi;
+        if (NULL != right) {
+            load_row(right + x, &lo, &hi);
+            s0 = _mm_add_epi16(s0, lo);
+            s1 = _mm_add_epi16(s1, hi);
+        }
+
+        __m128i d0 = _mm_srli_epi16(_mm_add_epi16(scale_sums(s0, scaleLo, scaleHi), halfV), 8);
+        __m128i d1 = _mm_srli_epi16(_mm_add_epi16(scale_sums(s1, scaleLo, scaleHi), halfV), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(d0, d1));
+
+        if (NULL != left) {
+            load_row(left + x, &lo, &hi);
+            s0 = _mm_sub_epi16(s0, lo);
+            s1 = _mm_sub_epi16(s1, hi);
+        }
+        store_sums(sums + x, s0);
+        store_sums(sums + x + 8, s1);
+    }
+
+    for (; x < width; ++x) {
+        uint32_t sum = sums[x];
+        if (NULL != right) {
+            sum += right[x];
+        }
+        dst[x] = (sum * scale + half) >> 24;
+        if (NULL != left) {
+            sum -= left[x];
+        }
+        sums[x] = sum;
+    }
+}
+
+/*  As scale_sums(), but for the sum of two products. Their low 16 bits can
+    now carry into bit 16: we add one wherever the saturating sum of the low
+    bits differs from the wrapping one.
+*/
+static inline __m128i interp_sums(const __m128i& outer, const __m128i& inner,
+                                  const __m128i& outerLo, const __m128i& outerHi,
+                                  const __m128i& innerLo, const __m128i& innerHi,
+                                  const __m128i& half) {
+    __m128i outerBits = _mm_mullo_epi16(outer, outerLo);
+    __m128i innerBits = _mm_mullo_epi16(inner, innerLo);
+    __m128i noCarry = _mm_cmpeq_epi16(_mm_adds_epu16(outerBits, innerBits),
+                                      _mm_add_epi16(outerBits, innerBits));
+    __m128i top = _mm_add_epi16(scale_sums(outer, outerLo, outerHi),
+                                scale_sums(inner, innerLo, innerHi));
+    // noCarry is -1 where there is no carry, and 0 where there is.
+    top = _mm_add_epi16(top, _mm_add_epi16(half, _mm_set1_epi16(1)));
+    top = _mm_add_epi16(top, noCarry);
+    return _mm_srli_epi16(top, 8);
+}
+
+void SkBoxBlurInterpRow_SSE2(uint8_t* SK_RESTRICT dst, const uint8_t* SK_RESTRICT right,
+                             const uint8_t* SK_RESTRICT left,
+                             uint16_t* SK_RESTRICT outerSums,
+                             uint16_t* SK_RESTRICT innerSums, int width,
+                             uint32_t outerScale, uint32_t innerScale, uint32_t half) {
+    const __m128i outerLo = _mm_set1_epi16((short)(outerScale & 0xFFFF));
+    const __m128i outerHi = _mm_set1_epi16((short)(outerScale >> 16));
+    const __m128i innerLo = _mm_set1_epi16((short)(innerScale & 0xFFFF));
+    const __m128i innerHi = _mm_set1_epi16((short)(innerScale >> 16));
+    SkASSERT(0 == (half & 0xFFFF));
+    const __m128i halfV = _mm_set1_epi16((short)(half >> 16));
+    const bool update = NULL != right || NULL != left;
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i outer0 = load_sums(outerSums + x);
+        __m128i outer1 = load_sums(outerSums + x + 8);
+        __m128i inner0, inner1;
+        __m128i leftLo = _mm_setzero_si128();
+        __m128i leftHi = _mm_setzero_si128();
+        if (update) {
+            if (NULL != left) {
+                load_row(left + x, &leftLo, &leftHi);
+            }
+            inner0 = _mm_sub_epi16(outer0, leftLo);
+            inner1 = _mm_sub_epi16(outer1, leftHi);
+            if (NULL != right) {
+                __m128i lo, hi;
+                load_row(right + x, &lo, &hi);
+                outer0 = _mm_add_epi16(outer0, lo);
+                outer1 = _mm_add_epi16(outer1, hi);
+            }
+            store_sums(innerSums + x, inner0);
+            store_sums(innerSums + x + 8, inner1);
+        } else {
+            inner0 = load_sums(innerSums + x);
+            inner1 = load_sums(innerSums + x + 8);
+        }
+
+        __m128i d0 = interp_sums(outer0, inner0, outerLo, outerHi, innerLo, innerHi, halfV);
+        __m128i d1 = interp_sums(outer1, inner1, outerLo, outerHi, innerLo, innerHi, halfV);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(d0, d1));
+
+        if (update) {
+            store_sums(outerSums + x, _mm_sub_epi16(outer0, leftLo));
+            store_sums(outerSums + x + 8, _mm_sub_epi16(outer1, leftHi));
+        }
+    }
+
+    for (; x < width; ++x) {
+        uint32_t outer = outerSums[x];
+        uint32_t inner = innerSums[x];
+        uint32_t l = NULL != left ? left[x] : 0;
+        if (update) {
+            inner = outer - l;
+            if (NULL != right) {
+                outer += right[x];
+            }
+        }
+        dst[x] = (outer * outerScale + inner * innerScale + half) >> 24;
+        outerSums[x] = outer - l;
+        innerSums[x] = inner;
+    }
+}
+
+/*  Transposes a 16x16 block. Interleaving row i with row i + 8, four times
+    over, moves every byte to its transposed position.
+*/
+static inline void transpose16x16(__m128i rows[16]) {
+    for (int pass = 0; pass < 4; ++pass) {
+        __m128i t[16];
+        for (int i = 0; i < 8; ++i) {
+            t[2 * i]     = _mm_unpacklo_epi8(rows[i], rows[i + 8]);
+            t[2 * i + 1] = _mm_unpackhi_epi8(rows[i], rows[i + 8]);
+        }
+        for (int i = 0; i < 16; ++i) {
+            rows[i] = t[i];
+        }
+    }
+}
+
+/*  Works in 16x16 blocks, so that the reads and the writes of a block each
+    touch just 16 cache lines, however large the image is.
+*/
+void SkTransposeA8_SSE2(uint8_t* SK_RESTRICT dst, int dstRB,
+                        const uint8_t* SK_RESTRICT src, int srcRB,
+                        int width, int height) {
+    int y = 0;
+    for (; y + 16 <= height; y += 16) {
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i rows[16];
+            for (int i = 0; i < 16; ++i) {
+                rows[i] = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(src + (y + i) * srcRB + x));
+            }
+            transpose16x16(rows);
+            for (int i = 0; i < 16; ++i) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (x + i) * dstRB + y),
+                                 rows[i]);
+            }
+        }
+        for (; x < width; ++x) {
+            for (int i = 0; i < 16; ++i) {
+                dst[x * dstRB + y + i] = src[(y + i) * srcRB + x];
+            }
+        }
+    }
+    for (; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            dst[x * dstRB + y] = src[y * srcRB + x];
+        }
+    }
+}
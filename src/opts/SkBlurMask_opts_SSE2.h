@@ -0,0 +1,25 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBlurMask_opts_SSE2_DEFINED
+#define SkBlurMask_opts_SSE2_DEFINED
+
+#include "SkBlurMask_opts.h"
+
+void SkBoxBlurRow_SSE2(uint8_t* SK_RESTRICT dst, const uint8_t* SK_RESTRICT right,
+                       const uint8_t* SK_RESTRICT left, uint16_t* SK_RESTRICT sums,
+                       int width, uint32_t scale, uint32_t half);
+void SkBoxBlurInterpRow_SSE2(uint8_t* SK_RESTRICT dst, const uint8_t* SK_RESTRICT right,
+                             const uint8_t* SK_RESTRICT left,
+                             uint16_t* SK_RESTRICT outerSums,
+                             uint16_t* SK_RESTRICT innerSums, int width,
+                             uint32_t outerScale, uint32_t innerScale, uint32_t half);
+void SkTransposeA8_SSE2(uint8_t* SK_RESTRICT dst, int dstRB,
+                        const uint8_t* SK_RESTRICT src, int srcRB,
+                        int width, int height);
+
+#endif
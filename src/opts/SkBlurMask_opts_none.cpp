@@ -0,0 +1,20 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurMask_opts.h"
+
+SkBlurMaskProcs::BoxBlurRowProc SkBlurMaskProcs::PlatformBoxBlurRow() {
+    return NULL;
+}
+
+SkBlurMaskProcs::BoxBlurInterpRowProc SkBlurMaskProcs::PlatformBoxBlurInterpRow() {
+    return NULL;
+}
+
+SkBlurMaskProcs::TransposeProc SkBlurMaskProcs::PlatformTranspose() {
+    return NULL;
+}
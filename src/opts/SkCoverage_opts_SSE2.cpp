@@ -0,0 +1,61 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCoverage_opts_SSE2.h"
+
+#include <emmintrin.h>
+
+// Prefix sum of the eight lanes of v, plus the running sum in every lane of carry.
+static inline __m128i prefix_sum(__m128i v, const __m128i& carry) {
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+    return _mm_add_epi16(v, carry);
+}
+
+// Copy the last lane of v into every lane.
+static inline __m128i broadcast_last(const __m128i& v) {
+    __m128i hi = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_unpackhi_epi64(hi, hi);
+}
+
+// 256 -> 255, as alpha - (alpha >> 8).
+static inline __m128i clamp_alpha(const __m128i& v) {
+    return _mm_sub_epi16(v, _mm_srli_epi16(v, 8));
+}
+
+int SkDeltasToAlpha_SSE2(uint8_t* SK_RESTRICT dst, int16_t* SK_RESTRICT deltas, int count,
+                         int sum) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = _mm_set1_epi16(sum);
+    while (count >= 16) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(deltas), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(deltas + 8), zero);
+
+        lo = prefix_sum(lo, carry);
+        carry = broadcast_last(lo);
+        hi = prefix_sum(hi, carry);
+        carry = broadcast_last(hi);
+
+        // The sums are in [0, 256], so packing cannot saturate.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                         _mm_packus_epi16(clamp_alpha(lo), clamp_alpha(hi)));
+        dst += 16;
+        deltas += 16;
+        count -= 16;
+    }
+
+    sum = (int16_t)_mm_cvtsi128_si32(carry);
+    for (int i = 0; i < count; ++i) {
+        sum += deltas[i];
+        deltas[i] = 0;
+        dst[i] = SkToU8(sum - (sum >> 8));
+    }
+    return sum;
+}
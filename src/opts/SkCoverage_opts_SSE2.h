@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkCoverage_opts_SSE2_DEFINED
+#define SkCoverage_opts_SSE2_DEFINED
+
+#include "SkCoverage_opts.h"
+
+int SkDeltasToAlpha_SSE2(uint8_t* SK_RESTRICT dst, int16_t* SK_RESTRICT deltas, int count,
+                         int sum);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradient_opts_SSE2.h"
+
+#include <emmintrin.h>
+
+static const int kDitherStride = SkGradientSpanProcs::kDitherStride;
+
+// Look up four colors, whose indices are in the low halves of the lanes.
+static inline void lookup4(SkPMColor* SK_RESTRICT dst, const SkPMColor* SK_RESTRICT cache,
+                           const __m128i& index) {
+    dst[0] = cache[_mm_extract_epi16(index, 0)];
+    dst[1] = cache[_mm_extract_epi16(index, 2)];
+    dst[2] = cache[_mm_extract_epi16(index, 4)];
+    dst[3] = cache[_mm_extract_epi16(index, 6)];
+}
+
+// Look up the first count (< 4) of them. The other lanes may be garbage.
+static inline void lookup_partial(SkPMColor* SK_RESTRICT dst,
+                                  const SkPMColor* SK_RESTRICT cache,
+                                  const __m128i& index, int count) {
+    SkASSERT(count > 0 && count < 4);
+    int32_t indices[4];
+    _mm_storeu_si128((__m128i*)indices, index);
+    for (int i = 0; i < count; ++i) {
+        dst[i] = cache[indices[i]];
+    }
+}
+
+// The dither rows of four pixels in a row, starting with toggle.
+static inline __m128i dither_toggles(int toggle) {
+    return _mm_set_epi32(toggle ^ kDitherStride, toggle, toggle ^ kDitherStride, toggle);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Each tiler maps four 16.16 positions to indices into a row of the table,
+    exactly as the scalar tile procs in SkLinearGradient.cpp.
+*/
+struct LinearClamp_SSE2 {
+    // The position is already within [0, 0xFFFF].
+    static __m128i Index(const __m128i& fx) {
+        return _mm_srli_epi32(fx, 8);
+    }
+};
+
+struct LinearRepeat_SSE2 {
+    static __m128i Index(const __m128i& fx) {
+        return _mm_and_si128(_mm_srli_epi32(fx, 8), _mm_set1_epi32(0xFF));
+    }
+};
+
+struct LinearMirror_SSE2 {
+    static __m128i Index(const __m128i& fx) {
+        __m128i x = _mm_srai_epi32(fx, 8);
+        __m128i s = _mm_srai_epi32(_mm_slli_epi32(x, 23), 31);
+        return _mm_and_si128(_mm_xor_si128(x, s), _mm_set1_epi32(0xFF));
+    }
+};
+
+template <typename Tile>
+static void linear_span_SSE2(SkFixed fx, SkFixed dx, SkPMColor* SK_RESTRICT dst,
+                             const SkPMColor* SK_RESTRICT cache, int toggle, int count) {
+    // Unsigned, since the positions may wrap around just as the scalar
+    // fx += dx does.
+    const uint32_t udx = dx;
+    __m128i vfx = _mm_add_epi32(_mm_set1_epi32(fx),
+                                _mm_set_epi32(3 * udx, 2 * udx, udx, 0));
+    const __m128i vdx = _mm_set1_epi32(4 * udx);
+    const __m128i toggles = dither_toggles(toggle);
+
+    while (count >= 4) {
+        lookup4(dst, cache, _mm_add_epi32(Tile::Index(vfx), toggles));
+        vfx = _mm_add_epi32(vfx, vdx);
+        dst += 4;
+        count -= 4;
+    }
+    if (count > 0) {
+        lookup_partial(dst, cache, _mm_add_epi32(Tile::Index(vfx), toggles), count);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Each tiler maps four distances to indices into a row of the table. The
+    distance is pinned before it is converted to 16.16, so that it can't
+    overflow, and so that NaN (whose comparisons are all false) pins to the
+    max.
+*/
+struct RadialClamp_SSE2 {
+    static __m128i Index(const __m128& dist) {
+        __m128 fixed = _mm_min_ps(_mm_mul_ps(dist, _mm_set1_ps(65536.0f)),
+                                  _mm_set1_ps(65535.0f));
+        return _mm_srli_epi32(_mm_cvttps_epi32(fixed), 8);
+    }
+};
+
+static inline __m128i radial_to_fixed(const __m128& dist) {
+    return _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(dist, _mm_set1_ps(32767.0f)),
+                                       _mm_set1_ps(65536.0f)));
+}
+
+struct RadialRepeat_SSE2 {
+    static __m128i Index(const __m128& dist) {
+        __m128i x = radial_to_fixed(dist);
+        return _mm_and_si128(_mm_srli_epi32(x, 8), _mm_set1_epi32(0xFF));
+    }
+};
+
+struct RadialMirror_SSE2 {
+    static __m128i Index(const __m128& dist) {
+        __m128i x = radial_to_fixed(dist);
+        __m128i s = _mm_srai_epi32(_mm_slli_epi32(x, 15), 31);
+        x = _mm_and_si128(_mm_xor_si128(x, s), _mm_set1_epi32(0xFFFF));
+        return _mm_srli_epi32(x, 8);
+    }
+};
+
+template <typename Tile>
+static void radial_span_SSE2(float fx, float dx, float fy, float dy,
+                             SkPMColor* SK_RESTRICT dst, const SkPMColor* SK_RESTRICT cache,
+                             int toggle, int count) {
+    __m128 vfx = _mm_set_ps(fx + 3 * dx, fx + 2 * dx, fx + dx, fx);
+    __m128 vfy = _mm_set_ps(fy + 3 * dy, fy + 2 * dy, fy + dy, fy);
+    const __m128 vdx = _mm_set1_ps(4 * dx);
+    const __m128 vdy = _mm_set1_ps(4 * dy);
+    const __m128i toggles = dither_toggles(toggle);
+
+    while (count > 0) {
+        __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vfx, vfx), _mm_mul_ps(vfy, vfy)));
+        __m128i index = _mm_add_epi32(Tile::Index(dist), toggles);
+        if (count < 4) {
+            lookup_partial(dst, cache, index, count);
+            break;
+        }
+        lookup4(dst, cache, index);
+        vfx = _mm_add_ps(vfx, vdx);
+        vfy = _mm_add_ps(vfy, vdy);
+        dst += 4;
+        count -= 4;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkGradientSpanProcs::LinearProc SkGradientLinearProc_SSE2(SkShader::TileMode mode) {
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            return linear_span_SSE2<LinearClamp_SSE2>;
+        case SkShader::kRepeat_TileMode:
+            return linear_span_SSE2<LinearRepeat_SSE2>;
+        case SkShader::kMirror_TileMode:
+            return linear_span_SSE2<LinearMirror_SSE2>;
+        default:
+            return NULL;
+    }
+}
+
+SkGradientSpanProcs::RadialProc SkGradientRadialProc_SSE2(SkShader::TileMode mode) {
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            return radial_span_SSE2<RadialClamp_SSE2>;
+        case SkShader::kRepeat_TileMode:
+            return radial_span_SSE2<RadialRepeat_SSE2>;
+        case SkShader::kMirror_TileMode:
+            return radial_span_SSE2<RadialMirror_SSE2>;
+        default:
+            return NULL;
+    }
+}
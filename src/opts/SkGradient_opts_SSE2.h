@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradient_opts_SSE2_DEFINED
+#define SkGradient_opts_SSE2_DEFINED
+
+#include "SkGradient_opts.h"
+
+SkGradientSpanProcs::LinearProc SkGradientLinearProc_SSE2(SkShader::TileMode mode);
+SkGradientSpanProcs::RadialProc SkGradientRadialProc_SSE2(SkShader::TileMode mode);
+
+#endif
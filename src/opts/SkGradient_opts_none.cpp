@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradient_opts.h"
+
+SkGradientSpanProcs::LinearProc SkGradientSpanProcs::PlatformLinear(SkShader::TileMode) {
+    return NULL;
+}
+
+SkGradientSpanProcs::RadialProc SkGradientSpanProcs::PlatformRadial(SkShader::TileMode) {
+    return NULL;
+}
@@ -0,0 +1,622 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts_SSE2.h"
+#include "SkColorPriv.h"
+
+#include <emmintrin.h>
+
+/*  Each of these procs works on four pixels at once, one per 32-bit lane, and
+    gives exactly the same result as the matching scalar modeproc in
+    SkXfermode.cpp. They follow those functions line for line, so when
+    changing one, change the other.
+*/
+
+static inline __m128i SkGetPackedA32_SSE2(const __m128i& src) {
+    __m128i a = _mm_slli_epi32(src, (24 - SK_A32_SHIFT));
+    return _mm_srli_epi32(a, 24);
+}
+
+static inline __m128i SkGetPackedR32_SSE2(const __m128i& src) {
+    __m128i r = _mm_slli_epi32(src, (24 - SK_R32_SHIFT));
+    return _mm_srli_epi32(r, 24);
+}
+
+static inline __m128i SkGetPackedG32_SSE2(const __m128i& src) {
+    __m128i g = _mm_slli_epi32(src, (24 - SK_G32_SHIFT));
+    return _mm_srli_epi32(g, 24);
+}
+
+static inline __m128i SkGetPackedB32_SSE2(const __m128i& src) {
+    __m128i b = _mm_slli_epi32(src, (24 - SK_B32_SHIFT));
+    return _mm_srli_epi32(b, 24);
+}
+
+static inline __m128i SkPackARGB32_SSE2(const __m128i& a, const __m128i& r,
+                                        const __m128i& g, const __m128i& b) {
+    __m128i a1 = _mm_slli_epi32(a, SK_A32_SHIFT);
+    __m128i r1 = _mm_slli_epi32(r, SK_R32_SHIFT);
+    __m128i g1 = _mm_slli_epi32(g, SK_G32_SHIFT);
+    __m128i b1 = _mm_slli_epi32(b, SK_B32_SHIFT);
+    return _mm_or_si128(_mm_or_si128(a1, r1), _mm_or_si128(g1, b1));
+}
+
+// a * b, for lanes holding bytes (so the product fits in 16 unsigned bits)
+static inline __m128i SkMulBytes_SSE2(const __m128i& a, const __m128i& b) {
+    return _mm_mullo_epi16(a, b);
+}
+
+// a * b for any 32-bit lanes, keeping the low 32 bits of the product like C
+static inline __m128i SkMul32_SSE2(const __m128i& a, const __m128i& b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// a / b, truncated like C. Only exact while |a| < 2^16 and 0 < |b| < 2^8:
+// then no quotient is close enough to an integer for float rounding to reach
+// it. That covers every division the blend modes below need.
+static inline __m128i SkDiv_SSE2(const __m128i& a, const __m128i& b) {
+    return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(a), _mm_cvtepi32_ps(b)));
+}
+
+static inline __m128i SkDiv255Round_SSE2(const __m128i& a) {
+    __m128i prod = _mm_add_epi32(a, _mm_set1_epi32(128));       // prod += 128;
+    prod = _mm_add_epi32(prod, _mm_srli_epi32(prod, 8));        // prod + (prod >> 8)
+    return _mm_srli_epi32(prod, 8);                             // >> 8
+}
+
+static inline __m128i SkAlphaMulAlpha_SSE2(const __m128i& a, const __m128i& b) {
+    return SkDiv255Round_SSE2(SkMulBytes_SSE2(a, b));
+}
+
+// scale is 0..256 in each lane
+static inline __m128i SkAlphaMulQ_SSE2(const __m128i& c, const __m128i& scale) {
+    const __m128i mask = _mm_set1_epi32(0xFF00FF);
+    __m128i s = _mm_or_si128(_mm_slli_epi32(scale, 16), scale);
+
+    // uint32_t rb = ((c & mask) * scale) >> 8
+    __m128i rb = _mm_and_si128(mask, c);
+    rb = _mm_mullo_epi16(rb, s);
+    rb = _mm_srli_epi16(rb, 8);
+
+    // uint32_t ag = ((c >> 8) & mask) * scale
+    __m128i ag = _mm_srli_epi16(c, 8);
+    ag = _mm_mullo_epi16(ag, s);
+
+    // (rb & mask) | (ag & ~mask)
+    ag = _mm_andnot_si128(mask, ag);
+    return _mm_or_si128(rb, ag);
+}
+
+// mask ? a : b
+static inline __m128i select_SSE2(const __m128i& mask, const __m128i& a, const __m128i& b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline __m128i min_SSE2(const __m128i& a, const __m128i& b) {
+    return select_SSE2(_mm_cmplt_epi32(a, b), a, b);
+}
+
+static inline __m128i max_SSE2(const __m128i& a, const __m128i& b) {
+    return select_SSE2(_mm_cmpgt_epi32(a, b), a, b);
+}
+
+static inline __m128i inv_byte_SSE2(const __m128i& a) {
+    return _mm_sub_epi32(_mm_set1_epi32(255), a);
+}
+
+static inline __m128i clamp_signed_byte_SSE2(const __m128i& n) {
+    return min_SSE2(max_SSE2(n, _mm_setzero_si128()), _mm_set1_epi32(255));
+}
+
+static inline __m128i clamp_div255round_SSE2(const __m128i& prod) {
+    // SkDiv255Round(0) is 0 and SkDiv255Round(255*255) is 255, so clamping
+    // the product first gives the same answer as the scalar branches.
+    __m128i clamped = max_SSE2(prod, _mm_setzero_si128());
+    clamped = min_SSE2(clamped, _mm_set1_epi32(255 * 255));
+    return SkDiv255Round_SSE2(clamped);
+}
+
+static inline __m128i srcover_byte_SSE2(const __m128i& a, const __m128i& b) {
+    // a + b - SkAlphaMulAlpha(a, b)
+    return _mm_sub_epi32(_mm_add_epi32(a, b), SkAlphaMulAlpha_SSE2(a, b));
+}
+
+// The modeprocs are template arguments below, and C++03 only allows those to
+// have external linkage, so they live in an anonymous namespace instead of
+// being static.
+namespace {
+
+typedef __m128i (*SkXfermodeProcSIMD)(const __m128i& src, const __m128i& dst);
+
+///////////////////////////////////////////////////////////////////////////////
+
+//  kDstOver_Mode,  //!< [Sa + Da - Sa*Da, Dc + (1 - Da)*Sc]
+__m128i dstover_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i ida = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(dst));
+    return _mm_add_epi32(dst, SkAlphaMulQ_SSE2(src, ida));
+}
+
+//  kSrcIn_Mode,    //!< [Sa * Da, Sc * Da]
+__m128i srcin_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i da = _mm_add_epi32(SkGetPackedA32_SSE2(dst), _mm_set1_epi32(1));
+    return SkAlphaMulQ_SSE2(src, da);
+}
+
+//  kDstIn_Mode,    //!< [Sa * Da, Sa * Dc]
+__m128i dstin_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = _mm_add_epi32(SkGetPackedA32_SSE2(src), _mm_set1_epi32(1));
+    return SkAlphaMulQ_SSE2(dst, sa);
+}
+
+//  kSrcOut_Mode,   //!< [Sa * (1 - Da), Sc * (1 - Da)]
+__m128i srcout_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i ida = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(dst));
+    return SkAlphaMulQ_SSE2(src, ida);
+}
+
+//  kDstOut_Mode,   //!< [Da * (1 - Sa), Dc * (1 - Sa)]
+__m128i dstout_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i isa = _mm_sub_epi32(_mm_set1_epi32(256), SkGetPackedA32_SSE2(src));
+    return SkAlphaMulQ_SSE2(dst, isa);
+}
+
+//  kSrcATop_Mode,  //!< [Da, Sc * Da + (1 - Sa) * Dc]
+__m128i srcatop_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i isa = inv_byte_SSE2(SkGetPackedA32_SSE2(src));
+
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(da, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(da, r, g, b);
+}
+
+//  kDstATop_Mode,  //!< [Sa, Sa * Dc + Sc * (1 - Da)]
+__m128i dstatop_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i ida = inv_byte_SSE2(SkGetPackedA32_SSE2(dst));
+
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(sa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(sa, r, g, b);
+}
+
+//  kXor_Mode   [Sa + Da - 2 * Sa * Da, Sc * (1 - Da) + (1 - Sa) * Dc]
+__m128i xor_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i isa = inv_byte_SSE2(sa);
+    __m128i ida = inv_byte_SSE2(da);
+
+    __m128i a = _mm_sub_epi32(_mm_add_epi32(sa, da),
+                              _mm_slli_epi32(SkAlphaMulAlpha_SSE2(sa, da), 1));
+    __m128i r = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedR32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedR32_SSE2(dst)));
+    __m128i g = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedG32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedG32_SSE2(dst)));
+    __m128i b = _mm_add_epi32(SkAlphaMulAlpha_SSE2(ida, SkGetPackedB32_SSE2(src)),
+                              SkAlphaMulAlpha_SSE2(isa, SkGetPackedB32_SSE2(dst)));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// kPlus_Mode
+__m128i plus_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    // saturated_add() on every byte
+    return _mm_adds_epu8(src, dst);
+}
+
+// kModulate_Mode
+__m128i modulate_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i a = SkAlphaMulAlpha_SSE2(SkGetPackedA32_SSE2(src), SkGetPackedA32_SSE2(dst));
+    __m128i r = SkAlphaMulAlpha_SSE2(SkGetPackedR32_SSE2(src), SkGetPackedR32_SSE2(dst));
+    __m128i g = SkAlphaMulAlpha_SSE2(SkGetPackedG32_SSE2(src), SkGetPackedG32_SSE2(dst));
+    __m128i b = SkAlphaMulAlpha_SSE2(SkGetPackedB32_SSE2(src), SkGetPackedB32_SSE2(dst));
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+typedef __m128i (*SkBlendByteProcSIMD)(const __m128i& sc, const __m128i& dc,
+                                       const __m128i& sa, const __m128i& da);
+
+// The separable modes all share the srcover alpha, and apply a blend function
+// to each color channel.
+template <SkBlendByteProcSIMD blend>
+__m128i separable_modeproc_SSE2(const __m128i& src, const __m128i& dst) {
+    __m128i sa = SkGetPackedA32_SSE2(src);
+    __m128i da = SkGetPackedA32_SSE2(dst);
+    __m128i a = srcover_byte_SSE2(sa, da);
+    __m128i r = blend(SkGetPackedR32_SSE2(src), SkGetPackedR32_SSE2(dst), sa, da);
+    __m128i g = blend(SkGetPackedG32_SSE2(src), SkGetPackedG32_SSE2(dst), sa, da);
+    __m128i b = blend(SkGetPackedB32_SSE2(src), SkGetPackedB32_SSE2(dst), sa, da);
+    return SkPackARGB32_SSE2(a, r, g, b);
+}
+
+// sc * (255 - da) + dc * (255 - sa), the part every separable mode adds in
+inline __m128i blend_remainder_SSE2(const __m128i& sc, const __m128i& dc,
+                                    const __m128i& sa, const __m128i& da) {
+    return _mm_add_epi32(SkMulBytes_SSE2(sc, inv_byte_SSE2(da)),
+                         SkMulBytes_SSE2(dc, inv_byte_SSE2(sa)));
+}
+
+// kMultiply_Mode
+__m128i blendfunc_multiply_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                                     const __m128i& sa, const __m128i& da) {
+    __m128i prod = _mm_add_epi32(blend_remainder_SSE2(sc, dc, sa, da),
+                                 SkMulBytes_SSE2(sc, dc));
+    return clamp_div255round_SSE2(prod);
+}
+
+// kScreen_Mode
+__m128i screen_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                         const __m128i&, const __m128i&) {
+    return srcover_byte_SSE2(sc, dc);
+}
+
+// kOverlay_Mode
+__m128i overlay_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                          const __m128i& sa, const __m128i& da) {
+    __m128i tmp = blend_remainder_SSE2(sc, dc, sa, da);
+    // 2 * sc * dc
+    __m128i rc1 = _mm_slli_epi32(SkMulBytes_SSE2(sc, dc), 1);
+    // sa * da - 2 * (da - dc) * (sa - sc)
+    __m128i rc2 = _mm_sub_epi32(SkMulBytes_SSE2(sa, da),
+                                _mm_slli_epi32(SkMul32_SSE2(_mm_sub_epi32(da, dc),
+                                                            _mm_sub_epi32(sa, sc)), 1));
+    // if (2 * dc <= da)
+    __m128i cmp = _mm_cmpgt_epi32(_mm_slli_epi32(dc, 1), da);
+    __m128i rc = select_SSE2(cmp, rc2, rc1);
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, tmp));
+}
+
+// kDarken_Mode
+__m128i darken_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                         const __m128i& sa, const __m128i& da) {
+    __m128i sd = SkMulBytes_SSE2(sc, da);
+    __m128i ds = SkMulBytes_SSE2(dc, sa);
+    // srcover when sd < ds, otherwise dstover: either way the larger is taken off
+    return _mm_sub_epi32(_mm_add_epi32(sc, dc), SkDiv255Round_SSE2(max_SSE2(sd, ds)));
+}
+
+// kLighten_Mode
+__m128i lighten_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                          const __m128i& sa, const __m128i& da) {
+    __m128i sd = SkMulBytes_SSE2(sc, da);
+    __m128i ds = SkMulBytes_SSE2(dc, sa);
+    // srcover when sd > ds, otherwise dstover: either way the smaller is taken off
+    return _mm_sub_epi32(_mm_add_epi32(sc, dc), SkDiv255Round_SSE2(min_SSE2(sd, ds)));
+}
+
+// kColorDodge_Mode
+__m128i colordodge_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                             const __m128i& sa, const __m128i& da) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i diff = _mm_sub_epi32(sa, sc);
+    __m128i diffIsZero = _mm_cmpeq_epi32(diff, zero);
+
+    // when 0 == diff, da takes the place of min(da, dc * sa / diff)
+    __m128i quot = SkDiv_SSE2(SkMulBytes_SSE2(dc, sa), diff);
+    __m128i m = select_SSE2(diffIsZero, da, min_SSE2(da, quot));
+    __m128i rc = _mm_add_epi32(SkMul32_SSE2(sa, m), blend_remainder_SSE2(sc, dc, sa, da));
+    rc = clamp_div255round_SSE2(rc);
+
+    // if (0 == dc)
+    __m128i dcIsZero = _mm_cmpeq_epi32(dc, zero);
+    return select_SSE2(dcIsZero, SkAlphaMulAlpha_SSE2(sc, inv_byte_SSE2(da)), rc);
+}
+
+// kColorBurn_Mode
+__m128i colorburn_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                            const __m128i& sa, const __m128i& da) {
+    __m128i dcIsDa = _mm_cmpeq_epi32(dc, da);
+
+    // when dc == da, this is sa * da
+    __m128i tmp = SkDiv_SSE2(SkMul32_SSE2(_mm_sub_epi32(da, dc), sa), sc);
+    __m128i m = select_SSE2(dcIsDa, da, _mm_sub_epi32(da, min_SSE2(da, tmp)));
+    __m128i rc = _mm_add_epi32(SkMul32_SSE2(sa, m), blend_remainder_SSE2(sc, dc, sa, da));
+    rc = clamp_div255round_SSE2(rc);
+
+    // else if (0 == sc)
+    __m128i scIsZero = _mm_andnot_si128(dcIsDa, _mm_cmpeq_epi32(sc, _mm_setzero_si128()));
+    return select_SSE2(scIsZero, SkAlphaMulAlpha_SSE2(dc, inv_byte_SSE2(sa)), rc);
+}
+
+// kHardLight_Mode
+__m128i hardlight_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                            const __m128i& sa, const __m128i& da) {
+    // 2 * sc * dc
+    __m128i rc1 = _mm_slli_epi32(SkMulBytes_SSE2(sc, dc), 1);
+    // sa * da - 2 * (da - dc) * (sa - sc)
+    __m128i rc2 = _mm_sub_epi32(SkMulBytes_SSE2(sa, da),
+                                _mm_slli_epi32(SkMul32_SSE2(_mm_sub_epi32(da, dc),
+                                                            _mm_sub_epi32(sa, sc)), 1));
+    // if (2 * sc <= sa)
+    __m128i cmp = _mm_cmpgt_epi32(_mm_slli_epi32(sc, 1), sa);
+    __m128i rc = select_SSE2(cmp, rc2, rc1);
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, blend_remainder_SSE2(sc, dc, sa, da)));
+}
+
+// returns 255 * sqrt(n/255), i.e. SkSqrtBits(n, 15+4), which is floor(sqrt(n << 8))
+inline __m128i sqrt_unit_byte_SSE2(const __m128i& n) {
+    __m128i x = _mm_slli_epi32(n, 8);
+    __m128i root = _mm_cvttps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(x)));
+    // The float root can be one too big or too small once x needs more than
+    // 16 bits; nudge it to the exact floor.
+    root = _mm_add_epi32(root, _mm_cmpgt_epi32(SkMul32_SSE2(root, root), x));
+    __m128i next = _mm_add_epi32(root, _mm_set1_epi32(1));
+    __m128i nextFits = _mm_cmpgt_epi32(SkMul32_SSE2(next, next), x);
+    return _mm_sub_epi32(root, _mm_andnot_si128(nextFits, _mm_set1_epi32(-1)));
+}
+
+// kSoftLight_Mode
+__m128i softlight_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                            const __m128i& sa, const __m128i& da) {
+    const __m128i zero = _mm_setzero_si128();
+
+    // int m = da ? dc * 256 / da : 0;
+    __m128i m = SkDiv_SSE2(_mm_slli_epi32(dc, 8), da);
+    m = _mm_andnot_si128(_mm_cmpeq_epi32(da, zero), m);
+
+    __m128i twoScMinusSa = _mm_sub_epi32(_mm_slli_epi32(sc, 1), sa);
+
+    // if (2 * sc <= sa)
+    //     rc = dc * (sa + ((2 * sc - sa) * (256 - m) >> 8));
+    __m128i tmp = _mm_srai_epi32(SkMul32_SSE2(twoScMinusSa,
+                                              _mm_sub_epi32(_mm_set1_epi32(256), m)), 8);
+    __m128i rc1 = SkMul32_SSE2(dc, _mm_add_epi32(sa, tmp));
+
+    // else if (4 * dc <= da)
+    //     tmp = (4 * m * (4 * m + 256) * (m - 256) >> 16) + 7 * m;
+    __m128i m4 = _mm_slli_epi32(m, 2);
+    __m128i tmp2 = SkMul32_SSE2(SkMul32_SSE2(m4, _mm_add_epi32(m4, _mm_set1_epi32(256))),
+                                _mm_sub_epi32(m, _mm_set1_epi32(256)));
+    tmp2 = _mm_add_epi32(_mm_srai_epi32(tmp2, 16),
+                         _mm_sub_epi32(_mm_slli_epi32(m, 3), m));
+    // else
+    //     tmp = sqrt_unit_byte(m) - m;
+    __m128i tmp3 = _mm_sub_epi32(sqrt_unit_byte_SSE2(m), m);
+    tmp = select_SSE2(_mm_cmpgt_epi32(_mm_slli_epi32(dc, 2), da), tmp3, tmp2);
+    //     rc = dc * sa + (da * (2 * sc - sa) * tmp >> 8);
+    __m128i rc2 = _mm_add_epi32(SkMulBytes_SSE2(dc, sa),
+                                _mm_srai_epi32(SkMul32_SSE2(SkMul32_SSE2(da, twoScMinusSa),
+                                                            tmp), 8));
+
+    __m128i rc = select_SSE2(_mm_cmpgt_epi32(_mm_slli_epi32(sc, 1), sa), rc2, rc1);
+    return clamp_div255round_SSE2(_mm_add_epi32(rc, blend_remainder_SSE2(sc, dc, sa, da)));
+}
+
+// kDifference_Mode
+__m128i difference_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                             const __m128i& sa, const __m128i& da) {
+    __m128i tmp = min_SSE2(SkMulBytes_SSE2(sc, da), SkMulBytes_SSE2(dc, sa));
+    __m128i diff = _mm_sub_epi32(_mm_add_epi32(sc, dc),
+                                 _mm_slli_epi32(SkDiv255Round_SSE2(tmp), 1));
+    return clamp_signed_byte_SSE2(diff);
+}
+
+// kExclusion_Mode
+__m128i exclusion_byte_SSE2(const __m128i& sc, const __m128i& dc,
+                            const __m128i& sa, const __m128i& da) {
+    // sc * da + dc * sa - 2 * sc * dc + sc * (255 - da) + dc * (255 - sa)
+    __m128i r = _mm_add_epi32(SkMulBytes_SSE2(sc, da), SkMulBytes_SSE2(dc, sa));
+    r = _mm_sub_epi32(r, _mm_slli_epi32(SkMulBytes_SSE2(sc, dc), 1));
+    r = _mm_add_epi32(r, blend_remainder_SSE2(sc, dc, sa, da));
+    return clamp_div255round_SSE2(r);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// C = dst + ((res - dst) * scale >> 8) with scale = SkAlpha255To256(aa), as in
+// SkFourByteInterp. That equals (res * scale + dst * (256 - scale)) >> 8, which
+// keeps every term in unsigned 16 bits. Zero coverage leaves dst as it was.
+inline __m128i lerp_by_coverage_SSE2(const __m128i& res, const __m128i& dst,
+                                     const __m128i& coverage) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i aa = _mm_unpacklo_epi8(coverage, zero);                 // 4 x 16 bits
+    __m128i scale = _mm_add_epi16(aa, _mm_set1_epi16(1));
+    __m128i invScale = _mm_sub_epi16(_mm_set1_epi16(256), scale);
+
+    // spread each pixel's scale over its four channels
+    scale = _mm_unpacklo_epi16(scale, scale);
+    invScale = _mm_unpacklo_epi16(invScale, invScale);
+    __m128i scaleLo = _mm_unpacklo_epi32(scale, scale);
+    __m128i scaleHi = _mm_unpackhi_epi32(scale, scale);
+    __m128i invScaleLo = _mm_unpacklo_epi32(invScale, invScale);
+    __m128i invScaleHi = _mm_unpackhi_epi32(invScale, invScale);
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(res, zero), scaleLo),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), invScaleLo));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(res, zero), scaleHi),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), invScaleHi));
+    __m128i result = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+
+    __m128i noCoverage = _mm_cmpeq_epi32(_mm_unpacklo_epi16(aa, zero), zero);
+    return select_SSE2(noCoverage, dst, result);
+}
+
+inline uint32_t load_4_bytes(const SkAlpha* SK_RESTRICT aa) {
+    uint32_t coverage;
+    memcpy(&coverage, aa, sizeof(coverage));
+    return coverage;
+}
+
+template <SkXfermodeProcSIMD proc>
+void xfer32_SSE2(SkPMColor* SK_RESTRICT dst, const SkPMColor* SK_RESTRICT src,
+                 int count, const SkAlpha* SK_RESTRICT aa) {
+    SkASSERT(dst && src && count >= 0);
+
+    if (NULL == aa) {
+        while (count >= 4) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), proc(s, d));
+            src += 4;
+            dst += 4;
+            count -= 4;
+        }
+    } else {
+        while (count >= 4) {
+            uint32_t coverage = load_4_bytes(aa);
+            if (0 != coverage) {
+                __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+                __m128i result = proc(s, d);
+                if (0xFFFFFFFF != coverage) {
+                    result = lerp_by_coverage_SSE2(result, d,
+                                                   _mm_cvtsi32_si128(coverage));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), result);
+            }
+            src += 4;
+            dst += 4;
+            aa += 4;
+            count -= 4;
+        }
+    }
+
+    if (count > 0) {
+        // Run the last few pixels through the same code, so they come out
+        // just like the rest. Zero coverage leaves the padding alone.
+        SkPMColor srcTail[4] = { 0, 0, 0, 0 };
+        SkPMColor dstTail[4] = { 0, 0, 0, 0 };
+        SkAlpha aaTail[4] = { 0, 0, 0, 0 };
+        memcpy(srcTail, src, count * sizeof(SkPMColor));
+        memcpy(dstTail, dst, count * sizeof(SkPMColor));
+        if (NULL != aa) {
+            memcpy(aaTail, aa, count * sizeof(SkAlpha));
+        }
+        xfer32_SSE2<proc>(dstTail, srcTail, 4, NULL != aa ? aaTail : NULL);
+        memcpy(dst, dstTail, count * sizeof(SkPMColor));
+    }
+}
+
+template <SkXfermodeProcSIMD proc>
+void xferA8_SSE2(SkAlpha* SK_RESTRICT dst, const SkPMColor* SK_RESTRICT src,
+                 int count, const SkAlpha* SK_RESTRICT aa) {
+    SkASSERT(dst && src && count >= 0);
+
+    const __m128i zero = _mm_setzero_si128();
+    while (count >= 4) {
+        uint32_t coverage = 0xFFFFFFFF;
+        if (NULL != aa) {
+            coverage = load_4_bytes(aa);
+            aa += 4;
+        }
+        if (0 != coverage) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            // the dst alphas, one per lane
+            __m128i dstA = _mm_cvtsi32_si128(load_4_bytes(dst));
+            dstA = _mm_unpacklo_epi16(_mm_unpacklo_epi8(dstA, zero), zero);
+
+            __m128i a = SkGetPackedA32_SSE2(proc(s, _mm_slli_epi32(dstA, SK_A32_SHIFT)));
+            if (0xFFFFFFFF != coverage) {
+                // SkAlphaBlend(A, dstA, SkAlpha255To256(aa)), as in lerp_by_coverage_SSE2
+                __m128i cov = _mm_cvtsi32_si128(coverage);
+                cov = _mm_unpacklo_epi16(_mm_unpacklo_epi8(cov, zero), zero);
+                __m128i scale = _mm_add_epi32(cov, _mm_set1_epi32(1));
+                __m128i invScale = _mm_sub_epi32(_mm_set1_epi32(256), scale);
+                __m128i blended = _mm_add_epi32(SkMulBytes_SSE2(a, scale),
+                                                SkMulBytes_SSE2(dstA, invScale));
+                blended = _mm_srli_epi32(blended, 8);
+                a = select_SSE2(_mm_cmpeq_epi32(cov, zero), dstA, blended);
+            }
+
+            a = _mm_packs_epi32(a, a);
+            a = _mm_packus_epi16(a, a);
+            uint32_t result = _mm_cvtsi128_si32(a);
+            memcpy(dst, &result, sizeof(result));
+        }
+        src += 4;
+        dst += 4;
+        count -= 4;
+    }
+
+    if (count > 0) {
+        SkPMColor srcTail[4] = { 0, 0, 0, 0 };
+        SkAlpha dstTail[4] = { 0, 0, 0, 0 };
+        SkAlpha aaTail[4] = { 0, 0, 0, 0 };
+        memcpy(srcTail, src, count * sizeof(SkPMColor));
+        memcpy(dstTail, dst, count * sizeof(SkAlpha));
+        if (NULL != aa) {
+            memcpy(aaTail, aa, count * sizeof(SkAlpha));
+        }
+        xferA8_SSE2<proc>(dstTail, srcTail, 4, NULL != aa ? aaTail : NULL);
+        memcpy(dst, dstTail, count * sizeof(SkAlpha));
+    }
+}
+
+struct XfermodeRowProcs_SSE2 {
+    SkXfermodeRowProcs::Proc32 fProc32;
+    SkXfermodeRowProcs::ProcA8 fProcA8;
+};
+
+}  // namespace
+
+#define ROW_PROCS(proc)         { xfer32_SSE2<proc>, xferA8_SSE2<proc> }
+#define SEPARABLE_PROCS(blend)  ROW_PROCS(separable_modeproc_SSE2<blend>)
+#define NO_PROCS                { NULL, NULL }
+
+static const XfermodeRowProcs_SSE2 gXfermodeRowProcs_SSE2[] = {
+    NO_PROCS,                                   // kClear_Mode: a memset already
+    NO_PROCS,                                   // kSrc_Mode: a memcpy already
+    NO_PROCS,                                   // kDst_Mode: leaves dst alone
+    NO_PROCS,                                   // kSrcOver_Mode: the blitters handle this one
+    ROW_PROCS(dstover_modeproc_SSE2),
+    ROW_PROCS(srcin_modeproc_SSE2),
+    ROW_PROCS(dstin_modeproc_SSE2),
+    ROW_PROCS(srcout_modeproc_SSE2),
+    ROW_PROCS(dstout_modeproc_SSE2),
+    ROW_PROCS(srcatop_modeproc_SSE2),
+    ROW_PROCS(dstatop_modeproc_SSE2),
+    ROW_PROCS(xor_modeproc_SSE2),
+
+    ROW_PROCS(plus_modeproc_SSE2),
+    ROW_PROCS(modulate_modeproc_SSE2),
+    SEPARABLE_PROCS(screen_byte_SSE2),
+    SEPARABLE_PROCS(overlay_byte_SSE2),
+    SEPARABLE_PROCS(darken_byte_SSE2),
+    SEPARABLE_PROCS(lighten_byte_SSE2),
+    SEPARABLE_PROCS(colordodge_byte_SSE2),
+    SEPARABLE_PROCS(colorburn_byte_SSE2),
+    SEPARABLE_PROCS(hardlight_byte_SSE2),
+    SEPARABLE_PROCS(softlight_byte_SSE2),
+    SEPARABLE_PROCS(difference_byte_SSE2),
+    SEPARABLE_PROCS(exclusion_byte_SSE2),
+    SEPARABLE_PROCS(blendfunc_multiply_byte_SSE2),
+
+    // The non-separable modes work on whole colors, and stay scalar.
+    NO_PROCS,                                   // kHue_Mode
+    NO_PROCS,                                   // kSaturation_Mode
+    NO_PROCS,                                   // kColor_Mode
+    NO_PROCS,                                   // kLuminosity_Mode
+};
+
+#undef ROW_PROCS
+#undef SEPARABLE_PROCS
+#undef NO_PROCS
+
+SkXfermodeRowProcs::Proc32 SkXfermodeRowProcs32_SSE2(SkXfermode::Mode mode) {
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(gXfermodeRowProcs_SSE2) == SkXfermode::kLastMode + 1,
+                      mode_count_arm);
+    SkASSERT((unsigned)mode <= SkXfermode::kLastMode);
+    return gXfermodeRowProcs_SSE2[mode].fProc32;
+}
+
+SkXfermodeRowProcs::ProcA8 SkXfermodeRowProcsA8_SSE2(SkXfermode::Mode mode) {
+    SkASSERT((unsigned)mode <= SkXfermode::kLastMode);
+    return gXfermodeRowProcs_SSE2[mode].fProcA8;
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkXfermode_opts_SSE2_DEFINED
+#define SkXfermode_opts_SSE2_DEFINED
+
+#include "SkXfermode_opts.h"
+
+SkXfermodeRowProcs::Proc32 SkXfermodeRowProcs32_SSE2(SkXfermode::Mode mode);
+SkXfermodeRowProcs::ProcA8 SkXfermodeRowProcsA8_SSE2(SkXfermode::Mode mode);
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkXfermode_opts.h"
+
+SkXfermodeRowProcs::Proc32 SkXfermodeRowProcs::PlatformProcs32(SkXfermode::Mode) {
+    return NULL;
+}
+
+SkXfermodeRowProcs::ProcA8 SkXfermodeRowProcs::PlatformProcsA8(SkXfermode::Mode) {
+    return NULL;
+}
@@ -10,8 +10,12 @@
 #include "SkBlitMask.h"
 #include "SkBlitRow.h"
 #include "SkBlitRect_opts_SSE2.h"
+#include "SkBlurMask_opts_SSE2.h"
+#include "SkCoverage_opts_SSE2.h"
+#include "SkGradient_opts_SSE2.h"
 #include "SkBlitRow_opts_SSE2.h"
 #include "SkUtils_opts_SSE2.h"
+#include "SkXfermode_opts_SSE2.h"
 #include "SkUtils.h"
 
 #if defined(_MSC_VER) && defined(_WIN64)
@@ -142,6 +146,10 @@ void SkBitmapProcState::platformProcs() {
         } else if (fMatrixProc == ClampX_ClampY_nofilter_affine) {
             fMatrixProc = ClampX_ClampY_nofilter_affine_SSE2;
         }
+
+        if (fShaderProc32 == S32_D32_bicubic_shaderproc) {
+            fShaderProc32 = S32_D32_bicubic_shaderproc_SSE2;
+        }
     }
 }
 
@@ -244,3 +252,67 @@ SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
         return NULL;
     }
 }
+
+SkXfermodeRowProcs::Proc32 SkXfermodeRowProcs::PlatformProcs32(SkXfermode::Mode mode) {
+    if (cachedHasSSE2()) {
+        return SkXfermodeRowProcs32_SSE2(mode);
+    } else {
+        return NULL;
+    }
+}
+
+SkXfermodeRowProcs::ProcA8 SkXfermodeRowProcs::PlatformProcsA8(SkXfermode::Mode mode) {
+    if (cachedHasSSE2()) {
+        return SkXfermodeRowProcsA8_SSE2(mode);
+    } else {
+        return NULL;
+    }
+}
+
+SkBlurMaskProcs::BoxBlurRowProc SkBlurMaskProcs::PlatformBoxBlurRow() {
+    if (cachedHasSSE2()) {
+        return SkBoxBlurRow_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkBlurMaskProcs::BoxBlurInterpRowProc SkBlurMaskProcs::PlatformBoxBlurInterpRow() {
+    if (cachedHasSSE2()) {
+        return SkBoxBlurInterpRow_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkBlurMaskProcs::TransposeProc SkBlurMaskProcs::PlatformTranspose() {
+    if (cachedHasSSE2()) {
+        return SkTransposeA8_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkCoverageProcs::DeltasToAlphaProc SkCoverageProcs::PlatformDeltasToAlpha() {
+    if (cachedHasSSE2()) {
+        return SkDeltasToAlpha_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+SkGradientSpanProcs::LinearProc SkGradientSpanProcs::PlatformLinear(SkShader::TileMode mode) {
+    if (cachedHasSSE2()) {
+        return SkGradientLinearProc_SSE2(mode);
+    } else {
+        return NULL;
+    }
+}
+
+SkGradientSpanProcs::RadialProc SkGradientSpanProcs::PlatformRadial(SkShader::TileMode mode) {
+    if (cachedHasSSE2()) {
+        return SkGradientRadialProc_SSE2(mode);
+    } else {
+        return NULL;
+    }
+}
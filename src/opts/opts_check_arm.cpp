@@ -14,7 +14,11 @@
  */
 
 #include "SkBlitRow.h"
+#include "SkBlurMask_opts.h"
+#include "SkCoverage_opts.h"
+#include "SkGradient_opts.h"
 #include "SkUtils.h"
+#include "SkXfermode_opts.h"
 
 #include "SkUtilsArm.h"
 
@@ -65,3 +69,35 @@ SkMemset32Proc SkMemset32GetPlatformProc() {
 SkBlitRow::ColorRectProc PlatformColorRectProcFactory() {
     return NULL;
 }
+
+SkXfermodeRowProcs::Proc32 SkXfermodeRowProcs::PlatformProcs32(SkXfermode::Mode) {
+    return NULL;
+}
+
+SkXfermodeRowProcs::ProcA8 SkXfermodeRowProcs::PlatformProcsA8(SkXfermode::Mode) {
+    return NULL;
+}
+
+SkBlurMaskProcs::BoxBlurRowProc SkBlurMaskProcs::PlatformBoxBlurRow() {
+    return NULL;
+}
+
+SkBlurMaskProcs::BoxBlurInterpRowProc SkBlurMaskProcs::PlatformBoxBlurInterpRow() {
+    return NULL;
+}
+
+SkBlurMaskProcs::TransposeProc SkBlurMaskProcs::PlatformTranspose() {
+    return NULL;
+}
+
+SkCoverageProcs::DeltasToAlphaProc SkCoverageProcs::PlatformDeltasToAlpha() {
+    return NULL;
+}
+
+SkGradientSpanProcs::LinearProc SkGradientSpanProcs::PlatformLinear(SkShader::TileMode) {
+    return NULL;
+}
+
+SkGradientSpanProcs::RadialProc SkGradientSpanProcs::PlatformRadial(SkShader::TileMode) {
+    return NULL;
+}
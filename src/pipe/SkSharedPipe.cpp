@@ -0,0 +1,290 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkSharedPipe.h"
+#include "SkBitmap.h"
+#include "SkGPipePriv.h"
+#include "SkThread.h"
+
+#if defined(__linux__)
+    #include <limits.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(SK_BUILD_FOR_WIN)
+    #include <windows.h>
+#else
+    #include <sched.h>
+#endif
+
+/**
+ *  Both counts grow by multiples of 4 bytes, wrapping around at 2^32, and
+ *  their bit 0 is set once their side is finished with the ring. Each lives on
+ *  its own cache line, so that publishing one does not take the line the
+ *  other side is polling away from it.
+ */
+struct SkSharedPipeHeader {
+    uint32_t    fMagic;
+    uint32_t    fCapacity;
+    int32_t     fPad0[14];
+
+    int32_t     fWritten;           // bytes published by the writer
+    int32_t     fReaderSleeps;      // times the reader went to sleep on fWritten
+    int32_t     fPad1[14];
+
+    int32_t     fRead;              // bytes released by the reader
+    int32_t     fWriterSleeps;      // times the writer went to sleep on fRead
+    int32_t     fPad2[14];
+};
+
+static const uint32_t kMagic = SkSetFourByteTag('s', 'k', 'p', 'r');
+static const int32_t kFinished_Bit = 1;
+static const uint32_t kCountMask = ~3U;
+
+// How many times to poll before going to sleep.
+static const int kSpinCount = 64;
+
+// Plain reads of the shared words are only ordered by the sk_atomic_* call
+// made just before them, which is a full barrier.
+static inline int32_t read_after_barrier(int32_t* addr) {
+    return *static_cast<volatile int32_t*>(addr);
+}
+
+// Acquires (like any sk_atomic_* call) so that the data which the count
+// covers can be read after it.
+static inline int32_t read_count(int32_t* addr) {
+    return sk_atomic_add(addr, 0);
+}
+
+#if defined(__linux__)
+// No FUTEX_PRIVATE_FLAG: the other side may be in another process.
+static void wait_for_change(int32_t* addr, int32_t value) {
+    syscall(SYS_futex, addr, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+static void wake(int32_t* addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#elif defined(SK_BUILD_FOR_WIN)
+// WaitOnAddress() does not work across processes, so just yield.
+static void wait_for_change(int32_t*, int32_t) { Sleep(0); }
+static void wake(int32_t*) {}
+#else
+static void wait_for_change(int32_t*, int32_t) { sched_yield(); }
+static void wake(int32_t*) {}
+#endif
+
+/**
+ *  Wait until *count differs from value. sleeps is bumped before going to
+ *  sleep, so that the other side, which checks it after each change of *count
+ *  (see wake_if_asleep()), knows to wake us. Checking *count again after that
+ *  (with a full barrier on both sides) means that a change cannot slip in
+ *  unnoticed between the two.
+ */
+static void wait_for_count(int32_t* count, int32_t value, int32_t* sleeps, int* spins) {
+    if (++*spins < kSpinCount) {
+        return;
+    }
+    sk_atomic_inc(sleeps);
+    if (read_after_barrier(count) == value) {
+        wait_for_change(count, value);
+    }
+}
+
+/**
+ *  Called after changing *count. Wakes the other side only once per time it
+ *  went to sleep: while it waits to be scheduled, the changes keep coming, and
+ *  a system call for each would cost more than the changes themselves.
+ */
+static void wake_if_asleep(int32_t* count, int32_t* sleeps, int32_t* lastWoken) {
+    int32_t current = read_after_barrier(sleeps);
+    if (current != *lastWoken) {
+        *lastWoken = current;
+        wake(count);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkSharedPipeController::MemorySize(size_t capacity) {
+    return sizeof(SkSharedPipeHeader) + capacity;
+}
+
+SkSharedPipeController::SkSharedPipeController(void* memory, size_t size)
+    : fHeader(static_cast<SkSharedPipeHeader*>(memory))
+    , fData(static_cast<char*>(memory) + sizeof(SkSharedPipeHeader))
+    , fCapacity(0)
+    , fWritten(0)
+    , fReaderSleepsWoken(0)
+    , fClosed(false) {
+    SkASSERT(SkIsAlign4((intptr_t)memory));
+    SkASSERT(size >= sizeof(SkSharedPipeHeader));
+
+    if (size > sizeof(SkSharedPipeHeader)) {
+        // A power of 2, so that the counts map to offsets even as they wrap.
+        size_t available = size - sizeof(SkSharedPipeHeader);
+        if (available > (1 << 30)) {
+            available = 1 << 30;
+        }
+        fCapacity = 1;
+        while (fCapacity * 2 <= available) {
+            fCapacity *= 2;
+        }
+        if (fCapacity < 4) {
+            fCapacity = 0;
+        }
+    }
+
+    memset(fHeader, 0, sizeof(SkSharedPipeHeader));
+    fHeader->fMagic = kMagic;
+    fHeader->fCapacity = fCapacity;
+}
+
+SkSharedPipeController::~SkSharedPipeController() {
+    this->close();
+}
+
+void SkSharedPipeController::close() {
+    if (!fClosed) {
+        fClosed = true;
+        sk_atomic_add(&fHeader->fWritten, kFinished_Bit);
+        wake(&fHeader->fWritten);
+    }
+}
+
+void SkSharedPipeController::publish(uint32_t bytes) {
+    fWritten += bytes;
+    sk_atomic_add(&fHeader->fWritten, bytes);
+    wake_if_asleep(&fHeader->fWritten, &fHeader->fReaderSleeps, &fReaderSleepsWoken);
+}
+
+uint32_t SkSharedPipeController::waitForSpace(uint32_t bytes) {
+    int spins = 0;
+    for (;;) {
+        int32_t read = read_count(&fHeader->fRead);
+        if (read & kFinished_Bit) {
+            // The reader stopped, so the space will never be released.
+            return 0;
+        }
+        uint32_t free = fCapacity - (fWritten - (uint32_t)read);
+        if (free >= bytes) {
+            return free;
+        }
+        wait_for_count(&fHeader->fRead, read, &fHeader->fWriterSleeps, &spins);
+    }
+}
+
+// Fill the rest of the ring with ops that the reader skips, since SkGPipeReader
+// needs each command to be contiguous.
+static void write_skips(char* dst, uint32_t bytes) {
+    SkASSERT(SkIsAlign4(bytes) && bytes > 0);
+    static const uint32_t kMaxSkip = DRAWOPS_DATA_MASK & ~3;
+    while (bytes > 0) {
+        uint32_t skip = bytes - 4 < kMaxSkip ? bytes - 4 : kMaxSkip;
+        *reinterpret_cast<uint32_t*>(dst) = DrawOp_packOpFlagData(kSkip_DrawOp, 0, skip);
+        dst += 4 + skip;
+        bytes -= 4 + skip;
+    }
+}
+
+void* SkSharedPipeController::requestBlock(size_t minRequest, size_t* actual) {
+    SkASSERT(SkIsAlign4(minRequest));
+    if (fClosed || minRequest > fCapacity) {
+        this->close();
+        return NULL;
+    }
+
+    uint32_t offset = fWritten & (fCapacity - 1);
+    uint32_t tail = fCapacity - offset;
+    if (tail < minRequest) {
+        if (0 == this->waitForSpace(tail)) {
+            this->close();
+            return NULL;
+        }
+        write_skips(fData + offset, tail);
+        this->publish(tail);
+        offset = 0;
+        tail = fCapacity;
+    }
+
+    uint32_t free = this->waitForSpace(minRequest);
+    if (0 == free) {
+        this->close();
+        return NULL;
+    }
+    *actual = free < tail ? free : tail;
+    return fData + offset;
+}
+
+void SkSharedPipeController::notifyWritten(size_t bytes) {
+    SkASSERT(SkIsAlign4(bytes));
+    if (bytes > 0 && !fClosed) {
+        this->publish(SkToU32(bytes));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkSharedPipeReader::SkSharedPipeReader(void* memory, SkCanvas* target)
+    : fHeader(static_cast<SkSharedPipeHeader*>(memory))
+    , fData(static_cast<const char*>(memory) + sizeof(SkSharedPipeHeader))
+    , fCapacity(fHeader->fCapacity)
+    , fRead(0)
+    , fWriterSleepsWoken(0)
+    , fReader(target)
+    , fStatus(SkGPipeReader::kEOF_Status) {
+    if (kMagic != fHeader->fMagic) {
+        SkDEBUGFAIL("shared memory was not laid out by SkSharedPipeController");
+        fStatus = SkGPipeReader::kError_Status;
+    }
+}
+
+SkGPipeReader::Status SkSharedPipeReader::playback() {
+    return this->playback(true);
+}
+
+SkGPipeReader::Status SkSharedPipeReader::playbackAvailable() {
+    return this->playback(false);
+}
+
+void SkSharedPipeReader::release(size_t bytes) {
+    fRead += bytes;
+    sk_atomic_add(&fHeader->fRead, SkToS32(bytes));
+    wake_if_asleep(&fHeader->fRead, &fHeader->fWriterSleeps, &fWriterSleepsWoken);
+}
+
+void SkSharedPipeReader::finish(SkGPipeReader::Status status) {
+    fStatus = status;
+    // Let a writer waiting for space know that none is coming.
+    sk_atomic_add(&fHeader->fRead, kFinished_Bit);
+    wake(&fHeader->fRead);
+}
+
+SkGPipeReader::Status SkSharedPipeReader::playback(bool wait) {
+    int spins = 0;
+    while (SkGPipeReader::kEOF_Status == fStatus) {
+        int32_t written = read_count(&fHeader->fWritten);
+        uint32_t available = (written & kCountMask) - fRead;
+        if (available > 0) {
+            uint32_t offset = fRead & (fCapacity - 1);
+            uint32_t bytes = available < fCapacity - offset ? available : fCapacity - offset;
+            SkGPipeReader::Status status = fReader.playback(fData + offset, bytes);
+            this->release(bytes);
+            if (SkGPipeReader::kDone_Status == status || SkGPipeReader::kError_Status == status) {
+                this->finish(status);
+            }
+            spins = 0;
+        } else if (written & kFinished_Bit) {
+            // The writer closed without ending the stream.
+            this->finish(SkGPipeReader::kError_Status);
+        } else if (!wait) {
+            break;
+        } else {
+            wait_for_count(&fHeader->fWritten, written, &fHeader->fReaderSleeps, &spins);
+        }
+    }
+    return fStatus;
+}
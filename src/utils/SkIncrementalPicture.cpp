@@ -0,0 +1,129 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkIncrementalPicture.h"
+#include "SkCanvas.h"
+#include "SkPath.h"
+
+SkIncrementalPicture::SkIncrementalPicture(int width, int height)
+    : fWidth(width)
+    , fHeight(height)
+    , fUpdate(NULL)
+    , fRecordFlags(0) {
+}
+
+SkIncrementalPicture::SkIncrementalPicture(SkPicture* picture)
+    : fWidth(picture->width())
+    , fHeight(picture->height())
+    , fUpdate(NULL)
+    , fRecordFlags(0) {
+    this->update(SkRegion(SkIRect::MakeWH(fWidth, fHeight)), picture);
+}
+
+SkIncrementalPicture::~SkIncrementalPicture() {
+    SkSafeUnref(fUpdate);
+    for (int i = 0; i < fPieces.count(); ++i) {
+        fPieces[i].fPicture->unref();
+        SkDELETE(fPieces[i].fClip);
+    }
+}
+
+// clipRegion() ignores the matrix, so clip to the region's outline instead,
+// which the matrix applies to when the picture is drawn transformed.
+static void clip_to_region(SkCanvas* canvas, const SkRegion& region) {
+    if (region.isRect()) {
+        canvas->clipRect(SkRect::Make(region.getBounds()));
+    } else {
+        SkPath path;
+        region.getBoundaryPath(&path);
+        canvas->clipPath(path);
+    }
+}
+
+SkCanvas* SkIncrementalPicture::beginUpdate(const SkIRect& invalid, uint32_t recordFlags) {
+    SkASSERT(NULL == fUpdate);
+    fUpdate = SkNEW(SkPicture);
+    fUpdateArea = invalid;
+    fRecordFlags = recordFlags;
+    SkCanvas* canvas = fUpdate->beginRecording(fWidth, fHeight, recordFlags);
+    canvas->clipRect(SkRect::Make(invalid));
+    return canvas;
+}
+
+void SkIncrementalPicture::endUpdate() {
+    SkASSERT(NULL != fUpdate);
+    fUpdate->endRecording();
+    this->update(SkRegion(fUpdateArea), fUpdate);
+    fUpdate->unref();
+    fUpdate = NULL;
+}
+
+void SkIncrementalPicture::update(const SkRegion& invalid, SkPicture* update) {
+    SkRegion area;
+    if (!area.op(invalid, SkIRect::MakeWH(fWidth, fHeight), SkRegion::kIntersect_Op)) {
+        return;
+    }
+
+    // Take the area away from the pieces under it.
+    int count = 0;
+    for (int i = 0; i < fPieces.count(); ++i) {
+        Piece piece = fPieces[i];
+        if (piece.fClip->op(area, SkRegion::kDifference_Op)) {
+            fPieces[count++] = piece;
+        } else {
+            piece.fPicture->unref();
+            SkDELETE(piece.fClip);
+        }
+    }
+    fPieces.setCount(count);
+
+    Piece* piece = fPieces.append();
+    piece->fPicture = SkRef(update);
+    piece->fClip = SkNEW_ARGS(SkRegion, (area));
+
+    if (fPieces.count() > kMaxPieces) {
+        this->compact();
+    }
+}
+
+void SkIncrementalPicture::drawPieces(SkCanvas* canvas, bool nested) const {
+    for (int i = 0; i < fPieces.count(); ++i) {
+        canvas->save(SkCanvas::kClip_SaveFlag);
+        clip_to_region(canvas, *fPieces[i].fClip);
+        if (nested) {
+            canvas->drawPicture(*fPieces[i].fPicture);
+        } else {
+            fPieces[i].fPicture->draw(canvas);
+        }
+        canvas->restore();
+    }
+}
+
+SkPicture* SkIncrementalPicture::createPicture() const {
+    SkPicture* picture = SkNEW(SkPicture);
+    this->drawPieces(picture->beginRecording(fWidth, fHeight), true);
+    picture->endRecording();
+    return picture;
+}
+
+void SkIncrementalPicture::compact() {
+    // Play the pieces back, rather than nesting them, so that the new piece
+    // holds their ops directly.
+    SkPicture* flat = SkNEW(SkPicture);
+    this->drawPieces(flat->beginRecording(fWidth, fHeight, fRecordFlags), false);
+    flat->endRecording();
+
+    for (int i = 0; i < fPieces.count(); ++i) {
+        fPieces[i].fPicture->unref();
+        SkDELETE(fPieces[i].fClip);
+    }
+    fPieces.rewind();
+
+    Piece* piece = fPieces.append();
+    piece->fPicture = flat;
+    piece->fClip = SkNEW_ARGS(SkRegion, (SkIRect::MakeWH(fWidth, fHeight)));
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureTileCache.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkTaskScheduler.h"
+#include "SkTDArray.h"
+
+SkPictureTileCache::SkPictureTileCache(int tileWidth, int tileHeight, size_t byteLimit,
+                                       SkTaskScheduler* scheduler)
+    : fTileWidth(tileWidth)
+    , fTileHeight(tileHeight)
+    , fByteLimit(byteLimit)
+    , fBytesUsed(0)
+    , fScheduler(scheduler)
+    , fPicture(NULL)
+    , fCloneCount(0)
+    , fTilesX(0)
+    , fTilesY(0) {
+    SkASSERT(tileWidth > 0 && tileHeight > 0);
+}
+
+SkPictureTileCache::~SkPictureTileCache() {
+    SkSafeUnref(fPicture);
+}
+
+void SkPictureTileCache::setPicture(SkPicture* picture) {
+    if (NULL != picture && NULL != fPicture &&
+        picture->width() == fPicture->width() && picture->height() == fPicture->height()) {
+        this->replacePicture(picture, SkIRect::MakeWH(picture->width(), picture->height()));
+        return;
+    }
+
+    SkRefCnt_SafeAssign(fPicture, picture);
+    fClones.reset(0);
+    fCloneCount = 0;
+    if (NULL == picture) {
+        this->setTileCount(0, 0);
+    } else {
+        this->setTileCount(picture->width(), picture->height());
+    }
+}
+
+void SkPictureTileCache::replacePicture(SkPicture* picture, const SkIRect& changed) {
+    SkASSERT(NULL != picture && NULL != fPicture);
+    SkASSERT(picture->width() == fPicture->width() && picture->height() == fPicture->height());
+    if (NULL == picture || NULL == fPicture ||
+        picture->width() != fPicture->width() || picture->height() != fPicture->height()) {
+        this->setPicture(picture);
+        return;
+    }
+
+    SkRefCnt_SafeAssign(fPicture, picture);
+    fClones.reset(0);
+    fCloneCount = 0;
+    this->invalidate(changed);
+}
+
+void SkPictureTileCache::setTileCount(int width, int height) {
+    this->purge();
+    fTilesX = (width + fTileWidth - 1) / fTileWidth;
+    fTilesY = (height + fTileHeight - 1) / fTileHeight;
+    fTiles.reset(fTilesX * fTilesY);
+}
+
+SkIRect SkPictureTileCache::tileBounds(int x, int y) const {
+    SkIRect bounds = SkIRect::MakeXYWH(x * fTileWidth, y * fTileHeight, fTileWidth, fTileHeight);
+    // The last row and column are cut down to the picture.
+    bounds.fRight = SkMin32(bounds.fRight, fPicture->width());
+    bounds.fBottom = SkMin32(bounds.fBottom, fPicture->height());
+    return bounds;
+}
+
+void SkPictureTileCache::invalidate(const SkIRect& area) {
+    if (NULL == fPicture) {
+        return;
+    }
+    SkIRect bounds = area;
+    if (!bounds.intersect(0, 0, fPicture->width(), fPicture->height())) {
+        return;
+    }
+    for (int y = bounds.fTop / fTileHeight; y <= (bounds.fBottom - 1) / fTileHeight; ++y) {
+        for (int x = bounds.fLeft / fTileWidth; x <= (bounds.fRight - 1) / fTileWidth; ++x) {
+            // Keep the pixels, so rendering the tile again needs no allocation.
+            fTiles[y * fTilesX + x].fValid = false;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SkPictureTileCache::evictTile(Tile* tile) {
+    SkASSERT(!tile->fInUse);
+    fBytesUsed -= tile->fBitmap.getSize();
+    fLRU.remove(tile);
+    tile->fBitmap.reset();
+    tile->fValid = false;
+}
+
+void SkPictureTileCache::purgeAsNeeded(size_t bytesNeeded) {
+    SkTInternalLList<Tile>::Iter iter;
+    Tile* tile = iter.init(fLRU, SkTInternalLList<Tile>::Iter::kTail_IterStart);
+    while (NULL != tile && fBytesUsed + bytesNeeded > fByteLimit) {
+        Tile* prev = iter.prev();
+        if (!tile->fInUse) {
+            this->evictTile(tile);
+        }
+        tile = prev;
+    }
+}
+
+size_t SkPictureTileCache::setByteLimit(size_t newLimit) {
+    size_t prevLimit = fByteLimit;
+    fByteLimit = newLimit;
+    this->purgeAsNeeded(0);
+    return prevLimit;
+}
+
+void SkPictureTileCache::purge() {
+    while (NULL != fLRU.head()) {
+        this->evictTile(fLRU.head());
+    }
+    SkASSERT(0 == fBytesUsed);
+}
+
+bool SkPictureTileCache::allocTile(Tile* tile, const SkIRect& bounds) {
+    SkASSERT(NULL == tile->fBitmap.pixelRef());
+    tile->fBitmap.setConfig(SkBitmap::kARGB_8888_Config, bounds.width(), bounds.height());
+    this->purgeAsNeeded(tile->fBitmap.getSize());
+    if (!tile->fBitmap.allocPixels()) {
+        tile->fBitmap.reset();
+        return false;
+    }
+    fBytesUsed += tile->fBitmap.getSize();
+    fLRU.addToHead(tile);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct SkPictureTileCache::RenderState {
+    Tile* const*    fTiles;
+    const SkIRect*  fBounds;
+    int             fCount;
+    SkPicture**     fPictures;  // one per group
+    int             fGroupCount;
+};
+
+static void render_tile(SkPicture* picture, SkBitmap* bitmap, const SkIRect& bounds) {
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    canvas.translate(-SkIntToScalar(bounds.fLeft), -SkIntToScalar(bounds.fTop));
+    picture->draw(&canvas);
+}
+
+void SkPictureTileCache::RenderTiles(RenderState* state, int group) {
+    SkPicture* picture = state->fPictures[group];
+    // Interleave the tiles, so that each group gets some of every part of the area.
+    for (int i = group; i < state->fCount; i += state->fGroupCount) {
+        render_tile(picture, &state->fTiles[i]->fBitmap, state->fBounds[i]);
+    }
+}
+
+void SkPictureTileCache::renderTiles(Tile* const tiles[], const SkIRect bounds[], int count) {
+    int groupCount = 1;
+    if (NULL != fScheduler) {
+        groupCount = SkMin32(fScheduler->countThreads() + 1, count);
+    }
+
+    if (groupCount <= 1) {
+        for (int i = 0; i < count; ++i) {
+            render_tile(fPicture, &tiles[i]->fBitmap, bounds[i]);
+        }
+        return;
+    }
+
+    // SkPicture playback is not thread-safe, so every group but the first plays
+    // back a clone. The clones are kept until the picture changes.
+    if (fCloneCount < groupCount - 1) {
+        fCloneCount = fScheduler->countThreads();
+        fClones.reset(fCloneCount);
+        fPicture->clone(fClones.get(), fCloneCount);
+    }
+    SkAutoSTArray<8, SkPicture*> pictures(groupCount);
+    pictures[0] = fPicture;
+    for (int i = 1; i < groupCount; ++i) {
+        pictures[i] = &fClones[i - 1];
+    }
+
+    RenderState state;
+    state.fTiles = tiles;
+    state.fBounds = bounds;
+    state.fCount = count;
+    state.fPictures = pictures.get();
+    state.fGroupCount = groupCount;
+    SkParallelFor(fScheduler, groupCount, RenderTiles, &state);
+}
+
+int SkPictureTileCache::draw(SkCanvas* canvas) {
+    if (NULL == fPicture) {
+        return 0;
+    }
+    return this->draw(canvas, SkIRect::MakeWH(fPicture->width(), fPicture->height()));
+}
+
+int SkPictureTileCache::draw(SkCanvas* canvas, const SkIRect& area) {
+    if (NULL == fPicture) {
+        return 0;
+    }
+    SkIRect bounds = area;
+    SkRect clipBounds;
+    if (!bounds.intersect(0, 0, fPicture->width(), fPicture->height()) ||
+        !canvas->getClipBounds(&clipBounds)) {
+        return 0;
+    }
+    // Tiles which the canvas clips out entirely are neither rendered nor drawn.
+    SkIRect clip;
+    clipBounds.roundOut(&clip);
+    if (!bounds.intersect(clip)) {
+        return 0;
+    }
+
+    const int left = bounds.fLeft / fTileWidth;
+    const int top = bounds.fTop / fTileHeight;
+    const int right = (bounds.fRight - 1) / fTileWidth;
+    const int bottom = (bounds.fBottom - 1) / fTileHeight;
+
+    // Mark every tile of the area in use, so that making room for one does not
+    // evict another, and move the ones with pixels up in the LRU.
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            Tile* tile = &fTiles[y * fTilesX + x];
+            tile->fInUse = true;
+            if (NULL != tile->fBitmap.pixelRef()) {
+                fLRU.remove(tile);
+                fLRU.addToHead(tile);
+            }
+        }
+    }
+
+    SkTDArray<Tile*> renderTiles;
+    SkTDArray<SkIRect> renderBounds;
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            Tile* tile = &fTiles[y * fTilesX + x];
+            if (tile->fValid) {
+                continue;
+            }
+            SkIRect tileBounds = this->tileBounds(x, y);
+            if (NULL == tile->fBitmap.pixelRef() && !this->allocTile(tile, tileBounds)) {
+                continue;
+            }
+            *renderTiles.append() = tile;
+            *renderBounds.append() = tileBounds;
+        }
+    }
+
+    this->renderTiles(renderTiles.begin(), renderBounds.begin(), renderTiles.count());
+    for (int i = 0; i < renderTiles.count(); ++i) {
+        renderTiles[i]->fValid = true;
+    }
+
+    canvas->save(SkCanvas::kClip_SaveFlag);
+    canvas->clipRect(SkRect::Make(bounds));
+    for (int y = top; y <= bottom; ++y) {
+        for (int x = left; x <= right; ++x) {
+            Tile* tile = &fTiles[y * fTilesX + x];
+            if (tile->fValid) {
+                canvas->drawBitmap(tile->fBitmap, SkIntToScalar(x * fTileWidth),
+                                   SkIntToScalar(y * fTileHeight));
+            }
+            tile->fInUse = false;
+        }
+    }
+    canvas->restore();
+
+    // The area may have needed more than the limit.
+    this->purgeAsNeeded(0);
+    return renderTiles.count();
+}
@@ -12,6 +12,8 @@
 #include "SkPixelRef.h"
 #include "SkShader.h"
 #include "SkRRect.h"
+#include "SkTaskScheduler.h"
+#include "SkTemplates.h"
 
 class PixelRefSet {
 public:
@@ -223,3 +225,141 @@ SkData* SkPictureUtils::GatherPixelRefs(SkPicture* pict, const SkRect& area) {
     }
     return data;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Re-applies the destination canvas' clips to a band canvas. The clips arrive in device space,
+// so the band canvas' matrix must hold just the device origin translation while replaying.
+class BandClipVisitor : public SkCanvas::ClipVisitor {
+public:
+    BandClipVisitor(SkCanvas* band) : fBand(band) {}
+
+    virtual void clipRect(const SkRect& rect, SkRegion::Op op, bool antialias) SK_OVERRIDE {
+        fBand->clipRect(rect, op, antialias);
+    }
+
+    virtual void clipPath(const SkPath& path, SkRegion::Op op, bool antialias) SK_OVERRIDE {
+        fBand->clipPath(path, op, antialias);
+    }
+
+private:
+    SkCanvas* fBand;
+};
+
+struct ParallelDrawState {
+    SkCanvas*   fCanvas;        // Destination, only read from while bands are drawing.
+    SkBitmap    fDevicePixels;  // The destination device's pixels, shared by every band.
+    SkIPoint    fOrigin;        // Device origin (non-zero when drawing into a layer).
+    int         fTop;           // Rows of fDevicePixels touched by the clip, split into bands.
+    int         fBottom;
+    SkPicture*  fPicture;       // Drawn by band 0.
+    SkPicture*  fClones;        // Drawn by bands 1..n; playback state is not shared by threads.
+    int         fBandCount;
+};
+
+void draw_band(ParallelDrawState* state, int index) {
+    const int height = state->fBottom - state->fTop;
+    const int top = state->fTop + height * index / state->fBandCount;
+    const int bottom = state->fTop + height * (index + 1) / state->fBandCount;
+
+    // Every band draws into the whole device, in the device's own coordinates, and is kept to
+    // its rows by the clip alone. That way each pixel sees exactly the same geometry as it would
+    // in a serial draw, and the bands' writes never overlap.
+    SkCanvas band(state->fDevicePixels);
+    SkMatrix originOffset;
+    originOffset.setTranslate(-SkIntToScalar(state->fOrigin.fX),
+                              -SkIntToScalar(state->fOrigin.fY));
+    band.setMatrix(originOffset);
+    BandClipVisitor visitor(&band);
+    state->fCanvas->replayClips(&visitor);
+    band.resetMatrix();
+    band.clipRect(SkRect::MakeLTRB(0, SkIntToScalar(top),
+                                   SkIntToScalar(state->fDevicePixels.width()),
+                                   SkIntToScalar(bottom)));
+
+    SkMatrix matrix = state->fCanvas->getTotalMatrix();
+    if (0 != state->fOrigin.fX || 0 != state->fOrigin.fY) {
+        matrix.postConcat(originOffset);
+    }
+    band.setMatrix(matrix);
+    band.setDrawFilter(state->fCanvas->getDrawFilter());
+
+    band.drawPicture(0 == index ? *state->fPicture : state->fClones[index - 1]);
+}
+
+}  // namespace
+
+// Draws with at most cloneCount + 1 bands. A negative cloneCount means the caller has no clones,
+// so one is made for each band but the first, for just this draw.
+static void draw_parallel(SkPicture* pict, SkPicture* clones, int cloneCount, SkCanvas* canvas,
+                          SkTaskScheduler* scheduler, int bandCount) {
+    if (NULL == pict || NULL == canvas) {
+        return;
+    }
+
+    SkDevice* device = canvas->getTopDevice(true);
+    const bool isRaster = NULL != device &&
+                          NULL == device->accessRenderTarget() &&
+                          0 == (device->getDeviceCapabilities() & SkDevice::kVector_Capability);
+    SkIRect clipBounds;
+    if (!isRaster || NULL == scheduler || 0 == scheduler->countThreads() ||
+        !canvas->getClipDeviceBounds(&clipBounds)) {
+        canvas->drawPicture(*pict);
+        return;
+    }
+
+    ParallelDrawState state;
+    state.fCanvas = canvas;
+    state.fDevicePixels = device->accessBitmap(true);
+    state.fOrigin = device->getOrigin();
+
+    // Only the rows inside the clip need to be split up.
+    clipBounds.offset(-state.fOrigin.fX, -state.fOrigin.fY);
+    if (!clipBounds.intersect(0, 0, state.fDevicePixels.width(), state.fDevicePixels.height())) {
+        return;
+    }
+    state.fTop = clipBounds.fTop;
+    state.fBottom = clipBounds.fBottom;
+
+    // Very short bands cost more in per-band setup and edge walking than they save.
+    static const int kMinBandHeight = 16;
+    if (bandCount <= 0) {
+        bandCount = scheduler->countThreads() + 1;
+    }
+    bandCount = SkMin32(bandCount, clipBounds.height() / kMinBandHeight);
+    if (cloneCount >= 0) {
+        bandCount = SkMin32(bandCount, cloneCount + 1);
+    }
+    // Keep the pixels locked so that every band's subset sees the same memory.
+    SkAutoLockPixels alp(state.fDevicePixels);
+    if (bandCount <= 1 || NULL == state.fDevicePixels.getPixels()) {
+        canvas->drawPicture(*pict);
+        return;
+    }
+    state.fBandCount = bandCount;
+
+    // SkPicture playback is not thread-safe (paints with shaders and bitmaps carry per-draw
+    // state), so every band but the first gets its own clone.
+    SkAutoTArray<SkPicture> ownedClones(cloneCount < 0 ? bandCount - 1 : 0);
+    if (cloneCount < 0) {
+        pict->clone(ownedClones.get(), bandCount - 1);
+        clones = ownedClones.get();
+    }
+    state.fPicture = pict;
+    state.fClones = clones;
+
+    SkParallelFor(scheduler, bandCount, draw_band, &state);
+}
+
+void SkPictureUtils::DrawParallel(SkPicture* pict, SkCanvas* canvas,
+                                  SkTaskScheduler* scheduler, int bandCount) {
+    draw_parallel(pict, NULL, -1, canvas, scheduler, bandCount);
+}
+
+void SkPictureUtils::DrawParallel(SkPicture* pict, SkPicture clones[], int cloneCount,
+                                  SkCanvas* canvas, SkTaskScheduler* scheduler) {
+    SkASSERT(NULL != clones || 0 == cloneCount);
+    draw_parallel(pict, clones, SkMax32(cloneCount, 0), canvas, scheduler, 0);
+}
@@ -0,0 +1,431 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkSegmentedPicture.h"
+#include "SkData.h"
+#include "SkStream.h"
+
+#define SEGMENTED_PICTURE_TAG   SkSetFourByteTag('s', 'p', 'c', 't')
+
+namespace {
+
+struct Header {
+    enum {
+        kVersion = 1,
+    };
+
+    uint32_t    fTag;
+    uint32_t    fVersion;
+    int32_t     fWidth;
+    int32_t     fHeight;
+};
+
+}
+
+// A rough size of the op and the paint of any call, on top of what it draws.
+static const size_t kCallSize = 32;
+
+static size_t path_size(const SkPath& path) {
+    return path.countPoints() * sizeof(SkPoint) + path.countVerbs();
+}
+
+SkSegmentedPictureWriter::SkSegmentedPictureWriter(SkWStream* stream, int width, int height,
+                                                   size_t segmentSize,
+                                                   SkPicture::EncodeBitmap encoder)
+    : INHERITED(width, height)
+    , fStream(stream)
+    , fWidth(width)
+    , fHeight(height)
+    , fSegmentSize(segmentSize)
+    , fEncoder(encoder)
+    , fSegment(NULL)
+    , fRecordingCanvas(NULL)
+    , fRecordedSize(0)
+    , fLayerCount(0)
+    , fSegmentCount(0)
+    , fFinished(false) {
+    Header header;
+    header.fTag = SEGMENTED_PICTURE_TAG;
+    header.fVersion = Header::kVersion;
+    header.fWidth = width;
+    header.fHeight = height;
+    fSucceeded = stream->write(&header, sizeof(header));
+
+    this->beginSegment();
+}
+
+SkSegmentedPictureWriter::~SkSegmentedPictureWriter() {
+    this->finish();
+}
+
+bool SkSegmentedPictureWriter::finish() {
+    if (!fFinished) {
+        fFinished = true;
+        if (fRecordedSize > 0) {
+            this->endSegment();
+        } else {
+            // Nothing was drawn since the last segment.
+            this->removeAll();
+            fSegment->unref();
+            fSegment = NULL;
+            fRecordingCanvas = NULL;
+        }
+        fSucceeded &= fStream->write32(0);
+    }
+    return fSucceeded;
+}
+
+void SkSegmentedPictureWriter::beginSegment() {
+    SkASSERT(NULL == fSegment);
+    fSegment = SkNEW(SkPicture);
+    fRecordingCanvas = fSegment->beginRecording(fWidth, fHeight);
+    this->addCanvas(fRecordingCanvas);
+    fRecordedSize = 0;
+}
+
+void SkSegmentedPictureWriter::endSegment() {
+    this->removeAll();
+    fSegment->endRecording();
+
+    SkDynamicMemoryWStream segmentStream;
+    fSegment->serializeForInPlacePlayback(&segmentStream, fEncoder);
+    fSegment->unref();
+    fSegment = NULL;
+    fRecordingCanvas = NULL;
+
+    // Keep each segment 4-byte aligned, so that it can be played back in place.
+    segmentStream.padToAlign4();
+    SkAutoDataUnref data(segmentStream.copyToData());
+    fSucceeded &= fStream->write32(data->size());
+    fSucceeded &= fStream->write(data->data(), data->size());
+    fSegmentCount++;
+}
+
+void SkSegmentedPictureWriter::willRecord(size_t size) {
+    SkASSERT(!fFinished);
+    if (fRecordedSize >= fSegmentSize && 0 == fLayerCount) {
+        this->endSegment();
+        this->beginSegment();
+        this->replayState();
+    }
+    fRecordedSize += kCallSize + size;
+}
+
+void SkSegmentedPictureWriter::ReplayClip(SkCanvas* canvas, const ClipRec& rec) {
+    if (ClipRec::kRegion_Type == rec.fType) {
+        // Regions are in device space, whatever the matrix.
+        canvas->clipRegion(rec.fRegion, rec.fOp);
+        return;
+    }
+    canvas->setMatrix(rec.fMatrix);
+    switch (rec.fType) {
+        case ClipRec::kRect_Type:
+            canvas->clipRect(rec.fRect, rec.fOp, rec.fDoAA);
+            break;
+        case ClipRec::kRRect_Type:
+            canvas->clipRRect(rec.fRRect, rec.fOp, rec.fDoAA);
+            break;
+        default:
+            canvas->clipPath(rec.fPath, rec.fOp, rec.fDoAA);
+            break;
+    }
+}
+
+void SkSegmentedPictureWriter::replayState() {
+    SkCanvas* canvas = fRecordingCanvas;
+    int clipIndex = 0;
+    for (int i = 0; i <= fSaveStack.count(); ++i) {
+        if (i > 0) {
+            const SaveRec& rec = fSaveStack[i - 1];
+            canvas->setMatrix(rec.fMatrix);
+            canvas->save(rec.fFlags);
+        }
+        int clipCount = i < fSaveStack.count() ? fSaveStack[i].fClipCount : fClips.count();
+        for (; clipIndex < clipCount; ++clipIndex) {
+            ReplayClip(canvas, fClips[clipIndex]);
+        }
+    }
+    canvas->setMatrix(this->getTotalMatrix());
+}
+
+SkSegmentedPictureWriter::ClipRec* SkSegmentedPictureWriter::appendClip(ClipRec::Type type,
+                                                                        SkRegion::Op op,
+                                                                        bool doAA) {
+    ClipRec& rec = fClips.push_back();
+    rec.fType = type;
+    rec.fMatrix = this->getTotalMatrix();
+    rec.fOp = op;
+    rec.fDoAA = doAA;
+    return &rec;
+}
+
+void SkSegmentedPictureWriter::pushSave(SaveFlags flags, bool isLayer) {
+    SaveRec* rec = fSaveStack.append();
+    rec->fMatrix = this->getTotalMatrix();
+    rec->fFlags = flags;
+    rec->fClipCount = fClips.count();
+    rec->fIsLayer = isLayer;
+    if (isLayer) {
+        fLayerCount++;
+    }
+}
+
+int SkSegmentedPictureWriter::save(SaveFlags flags) {
+    this->willRecord(0);
+    this->pushSave(flags, false);
+    return this->INHERITED::save(flags);
+}
+
+int SkSegmentedPictureWriter::saveLayer(const SkRect* bounds, const SkPaint* paint,
+                                        SaveFlags flags) {
+    this->willRecord(0);
+    this->pushSave(flags, true);
+    return this->INHERITED::saveLayer(bounds, paint, flags);
+}
+
+void SkSegmentedPictureWriter::restore() {
+    this->willRecord(0);
+    if (fSaveStack.count() > 0) {
+        const SaveRec& rec = fSaveStack.top();
+        // Without kClip_SaveFlag, clips made since the save outlive it.
+        if (rec.fFlags & kClip_SaveFlag) {
+            while (fClips.count() > rec.fClipCount) {
+                fClips.pop_back();
+            }
+        }
+        if (rec.fIsLayer) {
+            fLayerCount--;
+        }
+        fSaveStack.pop();
+    }
+    this->INHERITED::restore();
+}
+
+bool SkSegmentedPictureWriter::translate(SkScalar dx, SkScalar dy) {
+    this->willRecord(0);
+    return this->INHERITED::translate(dx, dy);
+}
+
+bool SkSegmentedPictureWriter::scale(SkScalar sx, SkScalar sy) {
+    this->willRecord(0);
+    return this->INHERITED::scale(sx, sy);
+}
+
+bool SkSegmentedPictureWriter::rotate(SkScalar degrees) {
+    this->willRecord(0);
+    return this->INHERITED::rotate(degrees);
+}
+
+bool SkSegmentedPictureWriter::skew(SkScalar sx, SkScalar sy) {
+    this->willRecord(0);
+    return this->INHERITED::skew(sx, sy);
+}
+
+bool SkSegmentedPictureWriter::concat(const SkMatrix& matrix) {
+    this->willRecord(0);
+    return this->INHERITED::concat(matrix);
+}
+
+void SkSegmentedPictureWriter::setMatrix(const SkMatrix& matrix) {
+    this->willRecord(0);
+    this->INHERITED::setMatrix(matrix);
+}
+
+bool SkSegmentedPictureWriter::clipRect(const SkRect& rect, SkRegion::Op op, bool doAA) {
+    this->willRecord(0);
+    this->appendClip(ClipRec::kRect_Type, op, doAA)->fRect = rect;
+    return this->INHERITED::clipRect(rect, op, doAA);
+}
+
+bool SkSegmentedPictureWriter::clipRRect(const SkRRect& rrect, SkRegion::Op op, bool doAA) {
+    this->willRecord(0);
+    this->appendClip(ClipRec::kRRect_Type, op, doAA)->fRRect = rrect;
+    return this->INHERITED::clipRRect(rrect, op, doAA);
+}
+
+bool SkSegmentedPictureWriter::clipPath(const SkPath& path, SkRegion::Op op, bool doAA) {
+    this->willRecord(path_size(path));
+    this->appendClip(ClipRec::kPath_Type, op, doAA)->fPath = path;
+    return this->INHERITED::clipPath(path, op, doAA);
+}
+
+bool SkSegmentedPictureWriter::clipRegion(const SkRegion& deviceRgn, SkRegion::Op op) {
+    this->willRecord(deviceRgn.writeToMemory(NULL));
+    this->appendClip(ClipRec::kRegion_Type, op, false)->fRegion = deviceRgn;
+    return this->INHERITED::clipRegion(deviceRgn, op);
+}
+
+// SkNWayCanvas does not forward clear() or drawData(), so we pass them
+// straight to the segment being recorded.
+void SkSegmentedPictureWriter::clear(SkColor color) {
+    this->willRecord(0);
+    fRecordingCanvas->clear(color);
+}
+
+void SkSegmentedPictureWriter::drawPaint(const SkPaint& paint) {
+    this->willRecord(0);
+    this->INHERITED::drawPaint(paint);
+}
+
+void SkSegmentedPictureWriter::drawPoints(PointMode mode, size_t count, const SkPoint pts[],
+                                          const SkPaint& paint) {
+    this->willRecord(count * sizeof(SkPoint));
+    this->INHERITED::drawPoints(mode, count, pts, paint);
+}
+
+void SkSegmentedPictureWriter::drawOval(const SkRect& rect, const SkPaint& paint) {
+    this->willRecord(0);
+    this->INHERITED::drawOval(rect, paint);
+}
+
+void SkSegmentedPictureWriter::drawRect(const SkRect& rect, const SkPaint& paint) {
+    this->willRecord(0);
+    this->INHERITED::drawRect(rect, paint);
+}
+
+void SkSegmentedPictureWriter::drawRRect(const SkRRect& rrect, const SkPaint& paint) {
+    this->willRecord(0);
+    this->INHERITED::drawRRect(rrect, paint);
+}
+
+void SkSegmentedPictureWriter::drawPath(const SkPath& path, const SkPaint& paint) {
+    this->willRecord(path_size(path));
+    this->INHERITED::drawPath(path, paint);
+}
+
+// Each segment holds its own copy of the bitmaps it draws.
+void SkSegmentedPictureWriter::drawBitmap(const SkBitmap& bitmap, SkScalar x, SkScalar y,
+                                          const SkPaint* paint) {
+    this->willRecord(bitmap.getSize());
+    this->INHERITED::drawBitmap(bitmap, x, y, paint);
+}
+
+void SkSegmentedPictureWriter::drawBitmapRectToRect(const SkBitmap& bitmap, const SkRect* src,
+                                                    const SkRect& dst, const SkPaint* paint) {
+    this->willRecord(bitmap.getSize());
+    this->INHERITED::drawBitmapRectToRect(bitmap, src, dst, paint);
+}
+
+void SkSegmentedPictureWriter::drawBitmapMatrix(const SkBitmap& bitmap, const SkMatrix& m,
+                                                const SkPaint* paint) {
+    this->willRecord(bitmap.getSize());
+    this->INHERITED::drawBitmapMatrix(bitmap, m, paint);
+}
+
+void SkSegmentedPictureWriter::drawSprite(const SkBitmap& bitmap, int x, int y,
+                                          const SkPaint* paint) {
+    this->willRecord(bitmap.getSize());
+    this->INHERITED::drawSprite(bitmap, x, y, paint);
+}
+
+void SkSegmentedPictureWriter::drawText(const void* text, size_t byteLength, SkScalar x,
+                                        SkScalar y, const SkPaint& paint) {
+    this->willRecord(byteLength);
+    this->INHERITED::drawText(text, byteLength, x, y, paint);
+}
+
+void SkSegmentedPictureWriter::drawPosText(const void* text, size_t byteLength,
+                                           const SkPoint pos[], const SkPaint& paint) {
+    this->willRecord(byteLength + paint.countText(text, byteLength) * sizeof(SkPoint));
+    this->INHERITED::drawPosText(text, byteLength, pos, paint);
+}
+
+void SkSegmentedPictureWriter::drawPosTextH(const void* text, size_t byteLength,
+                                            const SkScalar xpos[], SkScalar constY,
+                                            const SkPaint& paint) {
+    this->willRecord(byteLength + paint.countText(text, byteLength) * sizeof(SkScalar));
+    this->INHERITED::drawPosTextH(text, byteLength, xpos, constY, paint);
+}
+
+void SkSegmentedPictureWriter::drawTextOnPath(const void* text, size_t byteLength,
+                                              const SkPath& path, const SkMatrix* matrix,
+                                              const SkPaint& paint) {
+    this->willRecord(byteLength + path_size(path));
+    this->INHERITED::drawTextOnPath(text, byteLength, path, matrix, paint);
+}
+
+// A nested picture is written into the segment whole, however big it is.
+void SkSegmentedPictureWriter::drawPicture(SkPicture& picture) {
+    this->willRecord(0);
+    this->INHERITED::drawPicture(picture);
+}
+
+void SkSegmentedPictureWriter::drawVertices(VertexMode vmode, int vertexCount,
+                                            const SkPoint vertices[], const SkPoint texs[],
+                                            const SkColor colors[], SkXfermode* xmode,
+                                            const uint16_t indices[], int indexCount,
+                                            const SkPaint& paint) {
+    this->willRecord(vertexCount * (2 * sizeof(SkPoint) + sizeof(SkColor)) +
+                     indexCount * sizeof(uint16_t));
+    this->INHERITED::drawVertices(vmode, vertexCount, vertices, texs, colors, xmode,
+                                  indices, indexCount, paint);
+}
+
+void SkSegmentedPictureWriter::drawData(const void* data, size_t length) {
+    this->willRecord(length);
+    fRecordingCanvas->drawData(data, length);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkSegmentedPictureReader::SkSegmentedPictureReader(SkStream* stream,
+                                                   SkPicture::InstallPixelRefProc proc)
+    : fStream(stream)
+    , fProc(proc)
+    , fWidth(0)
+    , fHeight(0)
+    , fValid(false)
+    , fAtEnd(false) {
+    Header header;
+    if (sizeof(header) != stream->read(&header, sizeof(header)) ||
+        SEGMENTED_PICTURE_TAG != header.fTag || Header::kVersion != header.fVersion) {
+        return;
+    }
+    fWidth = header.fWidth;
+    fHeight = header.fHeight;
+    fValid = true;
+}
+
+SkPicture* SkSegmentedPictureReader::readSegment() {
+    if (!fValid || fAtEnd) {
+        return NULL;
+    }
+
+    uint32_t size;
+    if (sizeof(size) != fStream->read(&size, sizeof(size))) {
+        fValid = false;
+        return NULL;
+    }
+    if (0 == size) {
+        fAtEnd = true;
+        return NULL;
+    }
+
+    // Don't trust the size enough to throw if it is too big to allocate.
+    void* storage = sk_malloc_flags(size, 0);
+    if (NULL == storage || size != fStream->read(storage, size)) {
+        sk_free(storage);
+        fValid = false;
+        return NULL;
+    }
+    SkAutoDataUnref data(SkData::NewFromMalloc(storage, size));
+    SkPicture* segment = SkPicture::CreateFromData(data, fProc);
+    if (NULL == segment) {
+        fValid = false;
+    }
+    return segment;
+}
+
+bool SkSegmentedPictureReader::draw(SkCanvas* canvas) {
+    while (SkPicture* segment = this->readSegment()) {
+        int saveCount = canvas->save();
+        canvas->drawPicture(*segment);
+        canvas->restoreToCount(saveCount);
+        segment->unref();
+    }
+    return fValid && fAtEnd;
+}
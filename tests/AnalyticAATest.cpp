@@ -0,0 +1,155 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGraphics.h"
+#include "SkPath.h"
+
+static const int kSize = 64;
+
+class AutoAnalyticAA {
+public:
+    AutoAnalyticAA(bool analytic) : fPrev(SkGraphics::SetAnalyticAntiAlias(analytic)) {}
+    ~AutoAnalyticAA() { SkGraphics::SetAnalyticAntiAlias(fPrev); }
+private:
+    bool fPrev;
+};
+
+// Fills path, antialiased, into a cleared A8 bitmap.
+static void draw_path(SkBitmap* bitmap, const SkPath& path, bool analytic,
+                      const SkRect* clip = NULL) {
+    bitmap->setConfig(SkBitmap::kA8_Config, kSize, kSize);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    if (NULL != clip) {
+        canvas.clipRect(*clip);
+    }
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    AutoAnalyticAA aaa(analytic);
+    canvas.drawPath(path, paint);
+}
+
+static int sum_alpha(const SkBitmap& bitmap) {
+    int sum = 0;
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            sum += *bitmap.getAddr8(x, y);
+        }
+    }
+    return sum;
+}
+
+static int max_difference(const SkBitmap& a, const SkBitmap& b) {
+    int maxDiff = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            maxDiff = SkMax32(maxDiff, SkAbs32(*a.getAddr8(x, y) - *b.getAddr8(x, y)));
+        }
+    }
+    return maxDiff;
+}
+
+// The pixels along a rect's fractional edges get exactly the part inside it.
+static void test_rect(skiatest::Reporter* reporter) {
+    SkPath path;
+    path.addRect(SkFloatToScalar(10.25f), SkFloatToScalar(20.5f),
+                 SkFloatToScalar(30.75f), SkFloatToScalar(40.125f));
+    SkBitmap bitmap;
+    draw_path(&bitmap, path, true);
+
+    REPORTER_ASSERT(reporter, 0xFF == *bitmap.getAddr8(20, 30));
+    REPORTER_ASSERT(reporter, 0 == *bitmap.getAddr8(9, 30));
+    REPORTER_ASSERT(reporter, 0 == *bitmap.getAddr8(31, 30));
+    REPORTER_ASSERT(reporter, 0xBF == *bitmap.getAddr8(10, 30));     // 0.75
+    REPORTER_ASSERT(reporter, 0xBF == *bitmap.getAddr8(30, 30));     // 0.75
+    REPORTER_ASSERT(reporter, 0x80 == *bitmap.getAddr8(20, 20));     // 0.5
+    REPORTER_ASSERT(reporter, 0x20 == *bitmap.getAddr8(20, 40));     // 0.125
+    REPORTER_ASSERT(reporter, 0x60 == *bitmap.getAddr8(10, 20));     // 0.75 * 0.5
+}
+
+// A circle covers pi r^2 pixels, and differs from the supersampled one only
+// by the supersampler's error.
+static void test_circle(skiatest::Reporter* reporter) {
+    SkPath path;
+    const SkScalar r = SkFloatToScalar(25.3f);
+    path.addCircle(SkFloatToScalar(32.4f), SkFloatToScalar(31.7f), r);
+
+    SkBitmap analytic, supersampled;
+    draw_path(&analytic, path, true);
+    draw_path(&supersampled, path, false);
+
+    float area = 3.14159265f * SkScalarToFloat(r) * SkScalarToFloat(r);
+    float covered = sum_alpha(analytic) / 255.0f;
+    REPORTER_ASSERT(reporter, fabsf(covered - area) < area * 0.001f);
+    REPORTER_ASSERT(reporter, max_difference(analytic, supersampled) <= 0x40);
+}
+
+// Overlapping contours are combined by the fill type.
+static void test_fill_types(skiatest::Reporter* reporter) {
+    SkPath path;
+    path.addRect(8, 8, 40, 40);
+    path.addRect(24, 24, 56, 56);
+
+    SkBitmap bitmap;
+    draw_path(&bitmap, path, true);
+    REPORTER_ASSERT(reporter, 0xFF == *bitmap.getAddr8(30, 30));
+    REPORTER_ASSERT(reporter, 0xFF == *bitmap.getAddr8(10, 10));
+
+    path.setFillType(SkPath::kEvenOdd_FillType);
+    draw_path(&bitmap, path, true);
+    REPORTER_ASSERT(reporter, 0 == *bitmap.getAddr8(30, 30));
+    REPORTER_ASSERT(reporter, 0xFF == *bitmap.getAddr8(10, 10));
+    REPORTER_ASSERT(reporter, 0xFF == *bitmap.getAddr8(50, 50));
+
+    // Inverse fills are left to the supersampler.
+    path.setFillType(SkPath::kInverseWinding_FillType);
+    SkBitmap supersampled;
+    draw_path(&bitmap, path, true);
+    draw_path(&supersampled, path, false);
+    REPORTER_ASSERT(reporter, 0 == max_difference(bitmap, supersampled));
+}
+
+// Clipping leaves the coverage inside the clip as it was, including where the
+// path extends past the left of the clip.
+static void test_clip(skiatest::Reporter* reporter) {
+    SkPath path;
+    path.moveTo(SkFloatToScalar(-20.5f), SkFloatToScalar(4.25f));
+    path.lineTo(SkFloatToScalar(60.3f), SkFloatToScalar(12.5f));
+    path.quadTo(SkFloatToScalar(80.0f), SkFloatToScalar(40.0f),
+                SkFloatToScalar(30.1f), SkFloatToScalar(60.7f));
+    path.lineTo(SkFloatToScalar(-10.0f), SkFloatToScalar(50.0f));
+
+    SkBitmap full, clipped;
+    draw_path(&full, path, true);
+    const SkRect clip = SkRect::MakeLTRB(10, 10, 50, 50);
+    draw_path(&clipped, path, true, &clip);
+
+    int maxDiff = 0;
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            int expected = clip.contains(SkIntToScalar(x), SkIntToScalar(y)) ?
+                           *full.getAddr8(x, y) : 0;
+            maxDiff = SkMax32(maxDiff, SkAbs32(expected - *clipped.getAddr8(x, y)));
+        }
+    }
+    REPORTER_ASSERT(reporter, maxDiff <= 1);
+}
+
+static void TestAnalyticAA(skiatest::Reporter* reporter) {
+    REPORTER_ASSERT(reporter, !SkGraphics::GetAnalyticAntiAlias());
+    test_rect(reporter);
+    test_circle(reporter);
+    test_fill_types(reporter);
+    test_clip(reporter);
+    REPORTER_ASSERT(reporter, !SkGraphics::GetAnalyticAntiAlias());
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("AnalyticAA", AnalyticAATestClass, TestAnalyticAA)
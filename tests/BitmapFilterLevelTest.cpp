@@ -0,0 +1,174 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmapProcState.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkPixelRef.h"
+#include "SkRandom.h"
+#include "SkShader.h"
+#include "SkXfermode.h"
+
+static void make_bitmap(SkBitmap* bm, const SkBitmap& pixels) {
+    bm->setConfig(pixels.config(), pixels.width(), pixels.height(), pixels.rowBytes());
+    bm->setPixelRef(pixels.pixelRef());
+}
+
+static const void* level_pixels(SkBitmap* bm) {
+    SkBitmap level;
+    if (bm->extractMipLevel(&level, 4 * SK_Fixed1, 0) != 2) {
+        return NULL;
+    }
+    return level.getPixels();
+}
+
+// Bitmaps of the same pixels share their mipmap levels until the pixels change.
+static void test_shared_mipmap(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, 64, 64);
+    src.allocPixels();
+    src.eraseColor(SK_ColorRED);
+
+    SkBitmap a, b;
+    make_bitmap(&a, src);
+    make_bitmap(&b, src);
+    a.buildMipMap();
+    b.buildMipMap();
+    REPORTER_ASSERT(reporter, NULL != level_pixels(&a));
+    REPORTER_ASSERT(reporter, level_pixels(&a) == level_pixels(&b));
+
+    // Once the pixels change, the levels are built again.
+    src.eraseColor(SK_ColorBLUE);
+    SkBitmap c, d;
+    make_bitmap(&c, src);
+    make_bitmap(&d, src);
+    c.buildMipMap();
+    d.buildMipMap();
+    const void* pixels = level_pixels(&c);
+    REPORTER_ASSERT(reporter, NULL != pixels);
+    REPORTER_ASSERT(reporter, pixels != level_pixels(&a));
+    REPORTER_ASSERT(reporter, pixels == level_pixels(&d));
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorBLUE) == *(const SkPMColor*)pixels);
+
+    // A subset has levels of its own.
+    SkBitmap subset;
+    SkIRect r = SkIRect::MakeXYWH(8, 8, 32, 32);
+    REPORTER_ASSERT(reporter, src.extractSubset(&subset, r));
+    subset.buildMipMap();
+    REPORTER_ASSERT(reporter, subset.hasMipMap());
+    REPORTER_ASSERT(reporter, pixels != level_pixels(&subset));
+}
+
+static void draw_scaled(SkBitmap* dst, const SkBitmap& src, const SkMatrix& matrix,
+                        SkShader::TileMode tile, SkPaint::FilterLevel level) {
+    dst->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*dst);
+    canvas.concat(matrix);
+    SkPaint paint;
+    paint.setShader(SkShader::CreateBitmapShader(src, tile, tile))->unref();
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    paint.setFilterLevel(level);
+    canvas.drawPaint(paint);
+}
+
+// Scaling a one pixel checkerboard down by 8 with mipmaps gives gray, where
+// nearest neighbor sampling only ever sees black or white.
+static void test_medium_downscale(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, 256, 256);
+    src.allocPixels();
+    for (int y = 0; y < src.height(); ++y) {
+        for (int x = 0; x < src.width(); ++x) {
+            *src.getAddr32(x, y) = (x ^ y) & 1 ? SK_ColorWHITE : SK_ColorBLACK;
+        }
+    }
+
+    SkBitmap dst;
+    dst.setConfig(SkBitmap::kARGB_8888_Config, 32, 32);
+    dst.allocPixels();
+    SkMatrix matrix;
+    matrix.setScale(SK_Scalar1 / 8, SK_Scalar1 / 8);
+
+    draw_scaled(&dst, src, matrix, SkShader::kClamp_TileMode, SkPaint::kMedium_FilterLevel);
+    for (int y = 0; y < dst.height(); ++y) {
+        for (int x = 0; x < dst.width(); ++x) {
+            unsigned g = SkGetPackedG32(*dst.getAddr32(x, y));
+            REPORTER_ASSERT(reporter, g >= 112 && g <= 144);
+        }
+    }
+
+    draw_scaled(&dst, src, matrix, SkShader::kClamp_TileMode, SkPaint::kNone_FilterLevel);
+    unsigned g = SkGetPackedG32(*dst.getAddr32(5, 7));
+    REPORTER_ASSERT(reporter, 0 == g || 255 == g);
+}
+
+// Drawing with kHigh_FilterLevel (with the platform's bicubic proc, if it has
+// one) matches the portable bicubic proc exactly.
+static void test_high_matches_portable(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, 16, 16);
+    src.allocPixels();
+    for (int y = 0; y < src.height(); ++y) {
+        for (int x = 0; x < src.width(); ++x) {
+            unsigned a = rand.nextU() & 0xFF;
+            *src.getAddr32(x, y) = SkPackARGB32(a, rand.nextULessThan(a + 1),
+                                                rand.nextULessThan(a + 1),
+                                                rand.nextULessThan(a + 1));
+        }
+    }
+
+    static const int kSize = 40;
+    SkBitmap dst;
+    dst.setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+    dst.allocPixels();
+    SkMatrix matrix;
+    matrix.setScale(SkFloatToScalar(2.3f), SkFloatToScalar(2.1f));
+    matrix.postRotate(SkIntToScalar(17));
+    matrix.postTranslate(SkIntToScalar(7), SkIntToScalar(-3));
+
+    static const SkShader::TileMode gModes[] = {
+        SkShader::kClamp_TileMode,
+        SkShader::kRepeat_TileMode,
+        SkShader::kMirror_TileMode,
+    };
+    for (size_t m = 0; m < SK_ARRAY_COUNT(gModes); ++m) {
+        draw_scaled(&dst, src, matrix, gModes[m], SkPaint::kHigh_FilterLevel);
+
+        SkBitmapProcState state;
+        state.fBitmap = &src;
+        state.fTileModeX = state.fTileModeY = gModes[m];
+        state.fAlphaScale = 256;
+        REPORTER_ASSERT(reporter, matrix.invert(&state.fHighQualityInvMatrix));
+
+        SkAutoLockPixels alp(src);
+        SkPMColor expected[kSize];
+        bool same = true;
+        for (int y = 0; y < kSize; ++y) {
+            S32_D32_bicubic_shaderproc(state, 0, y, expected, kSize);
+            same &= !memcmp(expected, dst.getAddr32(0, y), sizeof(expected));
+        }
+        REPORTER_ASSERT(reporter, same);
+
+        // ... and is not just bilinear filtering.
+        SkBitmap low;
+        low.setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+        low.allocPixels();
+        draw_scaled(&low, src, matrix, gModes[m], SkPaint::kLow_FilterLevel);
+        SkAutoLockPixels alpLow(low), alpDst(dst);
+        REPORTER_ASSERT(reporter, memcmp(low.getPixels(), dst.getPixels(), dst.getSize()));
+    }
+}
+
+static void TestBitmapFilterLevel(skiatest::Reporter* reporter) {
+    test_shared_mipmap(reporter);
+    test_medium_downscale(reporter);
+    test_high_matches_portable(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("BitmapFilterLevel", TestBitmapFilterLevelClass, TestBitmapFilterLevel)
@@ -6,10 +6,14 @@
  * found in the LICENSE file.
  */
 #include "Test.h"
+#include "SkBlurMask_opts.h"
 #include "SkBlurMaskFilter.h"
 #include "SkCanvas.h"
+#include "SkGraphics.h"
 #include "SkMath.h"
 #include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkRRect.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -157,5 +161,179 @@ static void test_blur(skiatest::Reporter* reporter) {
     }
 }
 
+// Draws a blurred rect, oval and round rect at (dx, dy). The rect takes the
+// nine-patch path, the others are blurred as masks.
+static void draw_blurred_shapes(SkBitmap* bm, SkBlurMaskFilter::BlurStyle style,
+                                SkScalar dx, SkScalar dy) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, 200, 80);
+    bm->allocPixels();
+    bm->eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(*bm);
+    canvas.translate(dx, dy);
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setColor(SK_ColorBLACK);
+    paint.setMaskFilter(SkBlurMaskFilter::Create(SkIntToScalar(4), style))->unref();
+
+    SkRect r = SkRect::MakeWH(SkIntToScalar(40), SkIntToScalar(30));
+    canvas.drawRect(r, paint);
+    r.offset(SkIntToScalar(50), 0);
+    canvas.drawOval(r, paint);
+    r.offset(SkIntToScalar(50), 0);
+    SkRRect rrect;
+    rrect.setRectXY(r, SkIntToScalar(6), SkIntToScalar(6));
+    canvas.drawRRect(rrect, paint);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpA(a), alpB(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Blurs drawn from the mask cache must match blurring from scratch, wherever
+// the shapes are drawn, and the cache must stay within its budget.
+static void test_blur_cache(skiatest::Reporter* reporter) {
+    static const SkScalar gOffsets[][2] = {
+        { SkIntToScalar(10), SkIntToScalar(10) },
+        { SkIntToScalar(10), SkIntToScalar(10) },
+        { SkIntToScalar(23), SkIntToScalar(31) },   // moved by whole pixels
+        { SkFloatToScalar(10.5f), SkFloatToScalar(10.25f) },
+        { SkFloatToScalar(23.5f), SkFloatToScalar(31.25f) },
+    };
+
+    size_t prevLimit = SkGraphics::SetBlurMaskCacheLimit(1024 * 1024);
+    SkGraphics::PurgeBlurMaskCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetBlurMaskCacheUsed());
+
+    for (int style = 0; style < SkBlurMaskFilter::kBlurStyleCount; ++style) {
+        SkBlurMaskFilter::BlurStyle blurStyle = (SkBlurMaskFilter::BlurStyle)style;
+        for (size_t i = 0; i < SK_ARRAY_COUNT(gOffsets); ++i) {
+            SkScalar dx = gOffsets[i][0], dy = gOffsets[i][1];
+
+            size_t limit = SkGraphics::SetBlurMaskCacheLimit(0);
+            SkBitmap expected;
+            draw_blurred_shapes(&expected, blurStyle, dx, dy);
+            SkGraphics::SetBlurMaskCacheLimit(limit);
+
+            SkBitmap actual;
+            draw_blurred_shapes(&actual, blurStyle, dx, dy);
+            REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+        }
+    }
+    REPORTER_ASSERT(reporter, SkGraphics::GetBlurMaskCacheUsed() > 0);
+    REPORTER_ASSERT(reporter, SkGraphics::GetBlurMaskCacheUsed() <= 1024 * 1024);
+
+    // Shrinking the budget evicts down to it, and 0 empties the cache.
+    SkGraphics::SetBlurMaskCacheLimit(4096);
+    REPORTER_ASSERT(reporter, SkGraphics::GetBlurMaskCacheUsed() <= 4096);
+    SkBitmap bm;
+    draw_blurred_shapes(&bm, SkBlurMaskFilter::kNormal_BlurStyle, 0, 0);
+    REPORTER_ASSERT(reporter, SkGraphics::GetBlurMaskCacheUsed() <= 4096);
+    SkGraphics::SetBlurMaskCacheLimit(0);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetBlurMaskCacheUsed());
+
+    SkGraphics::SetBlurMaskCacheLimit(prevLimit);
+}
+
+// The platform's blur procs, if it has any, must match the scalar math in
+// SkBlurMask.cpp bit for bit.
+static void test_blur_procs(skiatest::Reporter* reporter) {
+    SkBlurMaskProcs::BoxBlurRowProc blurRow = SkBlurMaskProcs::PlatformBoxBlurRow();
+    SkBlurMaskProcs::BoxBlurInterpRowProc interpRow = SkBlurMaskProcs::PlatformBoxBlurInterpRow();
+    SkBlurMaskProcs::TransposeProc transpose = SkBlurMaskProcs::PlatformTranspose();
+    if (NULL == blurRow || NULL == interpRow || NULL == transpose) {
+        return;
+    }
+
+    static const int kMaxWidth = 41;
+    static const uint32_t kHalf = 1 << 23;
+    SkMWCRandom rand;
+    uint8_t right[kMaxWidth], left[kMaxWidth], dst[kMaxWidth];
+    uint16_t sums[kMaxWidth], inner[kMaxWidth], expectedSums[kMaxWidth];
+    uint16_t expectedInner[kMaxWidth];
+    uint8_t expected[kMaxWidth];
+
+    // Kernels are diameter + 1 pixels, and the interpolating blur's are odd.
+    for (int kernelSize = 3; kernelSize <= 257; kernelSize += 18) {
+        uint32_t scale = (1 << 24) / kernelSize;
+        int outerWeight = rand.nextULessThan(256);
+        int innerWeight = 255 - outerWeight;
+        outerWeight += outerWeight >> 7;
+        innerWeight += innerWeight >> 7;
+        uint32_t outerScale = (outerWeight << 16) / kernelSize;
+        uint32_t innerScale = (innerWeight << 16) / (kernelSize - 2);
+
+        for (int width = 0; width <= kMaxWidth; width += 5) {
+            for (int rows = 0; rows < 4; ++rows) {
+                const uint8_t* r = (rows & 1) ? right : NULL;
+                const uint8_t* l = (rows & 2) ? left : NULL;
+                // Sums that a real blur could have: before right is added,
+                // the kernel holds at most kernelSize - 1 pixels, including
+                // left, and the inner kernel two fewer.
+                for (int i = 0; i < width; ++i) {
+                    right[i] = rand.nextULessThan(256);
+                    left[i] = rand.nextULessThan(256);
+                    sums[i] = left[i] + rand.nextULessThan(255 * (kernelSize - 3) + 1);
+                    inner[i] = rand.nextULessThan(255 * (kernelSize - 2) + 1);
+                }
+                memcpy(expectedInner, inner, width * sizeof(uint16_t));
+                memcpy(expectedSums, sums, width * sizeof(uint16_t));
+
+                for (int i = 0; i < width; ++i) {
+                    uint32_t outer = sums[i];
+                    uint32_t in = inner[i];
+                    if (r || l) {
+                        in = outer - (l ? l[i] : 0);
+                        outer += r ? r[i] : 0;
+                    }
+                    expected[i] = (outer * outerScale + in * innerScale + kHalf) >> 24;
+                    expectedSums[i] = outer - (l ? l[i] : 0);
+                    expectedInner[i] = in;
+                }
+                interpRow(dst, r, l, sums, inner, width, outerScale, innerScale, kHalf);
+                bool same = 0 == memcmp(dst, expected, width) &&
+                            0 == memcmp(sums, expectedSums, width * sizeof(uint16_t)) &&
+                            0 == memcmp(inner, expectedInner, width * sizeof(uint16_t));
+                REPORTER_ASSERT(reporter, same);
+
+                for (int i = 0; i < width; ++i) {
+                    uint32_t sum = sums[i] + (r ? r[i] : 0);
+                    expected[i] = (sum * scale + kHalf) >> 24;
+                    expectedSums[i] = sum - (l ? l[i] : 0);
+                }
+                blurRow(dst, r, l, sums, width, scale, kHalf);
+                same = 0 == memcmp(dst, expected, width) &&
+                       0 == memcmp(sums, expectedSums, width * sizeof(uint16_t));
+                REPORTER_ASSERT(reporter, same);
+            }
+        }
+    }
+
+    static const int kMaxSize = 37;
+    uint8_t src[kMaxSize * kMaxSize], transposed[kMaxSize * kMaxSize];
+    for (int i = 0; i < kMaxSize * kMaxSize; ++i) {
+        src[i] = rand.nextULessThan(256);
+    }
+    for (int height = 1; height <= kMaxSize; height += 4) {
+        for (int width = 1; width <= kMaxSize; width += 3) {
+            transpose(transposed, height, src, kMaxSize, width, height);
+            bool same = true;
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    same &= transposed[x * height + y] == src[y * kMaxSize + x];
+                }
+            }
+            REPORTER_ASSERT(reporter, same);
+        }
+    }
+}
+
+static void test_blurs(skiatest::Reporter* reporter) {
+    test_blur(reporter);
+    test_blur_cache(reporter);
+    test_blur_procs(reporter);
+}
+
 #include "TestClassDef.h"
-DEFINE_TESTCLASS("BlurMaskFilter", BlurTestClass, test_blur)
+DEFINE_TESTCLASS("BlurMaskFilter", BlurTestClass, test_blurs)
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkCoverage_opts.h"
+#include "SkPath.h"
+#include "SkRandom.h"
+
+static int deltas_to_alpha_reference(uint8_t dst[], int16_t deltas[], int count, int sum) {
+    for (int i = 0; i < count; ++i) {
+        sum += deltas[i];
+        dst[i] = sum - (sum >> 8);
+        deltas[i] = 0;
+    }
+    return sum;
+}
+
+// The platform's proc, if any, matches the reference at every length, so
+// that its vector loop and its tail both get checked.
+static void test_deltas_to_alpha(skiatest::Reporter* reporter) {
+    SkCoverageProcs::DeltasToAlphaProc proc = SkCoverageProcs::PlatformDeltasToAlpha();
+    if (NULL == proc) {
+        return;
+    }
+
+    static const int kMaxCount = 67;
+    SkRandom rand;
+    for (int count = 1; count <= kMaxCount; ++count) {
+        int16_t deltas[kMaxCount + 1], expectedDeltas[kMaxCount + 1];
+        uint8_t alpha[kMaxCount], expectedAlpha[kMaxCount];
+
+        // A random walk over [0, 256], so that every sum is valid.
+        int start = rand.nextULessThan(257);
+        int sum = start;
+        for (int i = 0; i < count; ++i) {
+            int next = rand.nextBool() ? sum : rand.nextULessThan(257);
+            if (rand.nextULessThan(8) == 0) {
+                next = 256;
+            }
+            deltas[i] = next - sum;
+            sum = next;
+        }
+        memcpy(expectedDeltas, deltas, count * sizeof(int16_t));
+        deltas[count] = expectedDeltas[count] = 0x7777;
+
+        int expectedSum = deltas_to_alpha_reference(expectedAlpha, expectedDeltas, count, start);
+        int actualSum = proc(alpha, deltas, count, start);
+
+        REPORTER_ASSERT(reporter, expectedSum == actualSum);
+        REPORTER_ASSERT(reporter, !memcmp(expectedAlpha, alpha, count));
+        REPORTER_ASSERT(reporter, !memcmp(expectedDeltas, deltas, (count + 1) * sizeof(int16_t)));
+    }
+}
+
+static const int kWidth = 160;
+static const int kHeight = 40;
+
+static void make_triangle(SkPath* path, int i, int j) {
+    // Fractional positions, at 4 pixels apart so that no two share a pixel.
+    const SkScalar left = SkIntToScalar(i * 4) + SkFloatToScalar(0.3f + 0.02f * j);
+    const SkScalar top = SkIntToScalar(j * 5) + SkFloatToScalar(0.2f + 0.015f * i);
+    path->moveTo(left, top);
+    path->lineTo(left + SkFloatToScalar(2.6f), top + SkFloatToScalar(1.1f));
+    path->lineTo(left + SkFloatToScalar(0.9f), top + SkFloatToScalar(3.7f));
+    path->close();
+}
+
+// A path crossing each scanline many times, like a line of text, accumulates
+// its coverage densely rather than as runs. Its pixels come out the same as
+// when each of its pieces is filled alone (and so through the runs).
+static void test_complex_path(skiatest::Reporter* reporter) {
+    SkBitmap whole, pieces;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+
+    whole.setConfig(SkBitmap::kA8_Config, kWidth, kHeight);
+    whole.allocPixels();
+    whole.eraseColor(SK_ColorTRANSPARENT);
+    pieces.setConfig(SkBitmap::kA8_Config, kWidth, kHeight);
+    pieces.allocPixels();
+    pieces.eraseColor(SK_ColorTRANSPARENT);
+
+    SkPath path;
+    SkCanvas wholeCanvas(whole), piecesCanvas(pieces);
+    for (int j = 0; j < kHeight / 5; ++j) {
+        for (int i = 0; i < kWidth / 4; ++i) {
+            make_triangle(&path, i, j);
+            SkPath piece;
+            make_triangle(&piece, i, j);
+            piecesCanvas.drawPath(piece, paint);
+        }
+    }
+    wholeCanvas.drawPath(path, paint);
+
+    bool same = true;
+    int covered = 0;
+    for (int y = 0; y < kHeight; ++y) {
+        same &= !memcmp(whole.getAddr8(0, y), pieces.getAddr8(0, y), kWidth);
+        for (int x = 0; x < kWidth; ++x) {
+            covered += *whole.getAddr8(x, y) != 0;
+        }
+    }
+    REPORTER_ASSERT(reporter, same);
+    REPORTER_ASSERT(reporter, covered > kWidth * kHeight / 4);
+}
+
+static void TestDenseCoverage(skiatest::Reporter* reporter) {
+    test_deltas_to_alpha(reporter);
+    test_complex_path(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("DenseCoverage", DenseCoverageTestClass, TestDenseCoverage)
@@ -10,6 +10,7 @@
 #include "SkCanvas.h"
 #include "SkColor.h"
 #include "SkColorFilter.h"
+#include "SkMatrix.h"
 #include "SkGradientShader.h"
 #include "SkPaint.h"
 #include "SkPictureFlat.h"
@@ -50,7 +51,64 @@ static void testCreate(skiatest::Reporter* reporter, const void* obj,
     REPORTER_ASSERT(reporter, SkFlatData::Compare(data1, data2) == 0);
 }
 
+/**
+ * Verify that a dictionary hands out stable, consecutive indices, finds the
+ * entries it already has once it has grown, and can replace an entry in place.
+ */
+static void testDictionary(skiatest::Reporter* reporter) {
+    static const int kCount = 1000;
+
+    Controller controller;
+    SkMatrixDictionary dictionary(&controller);
+    for (int i = 0; i < kCount; ++i) {
+        SkMatrix matrix;
+        matrix.setTranslate(SkIntToScalar(i), 0);
+        REPORTER_ASSERT(reporter, i + 1 == dictionary.find(matrix));
+    }
+    REPORTER_ASSERT(reporter, kCount == dictionary.count());
+
+    for (int i = kCount - 1; i >= 0; --i) {
+        SkMatrix matrix;
+        matrix.setTranslate(SkIntToScalar(i), 0);
+        REPORTER_ASSERT(reporter, i + 1 == dictionary.find(matrix));
+    }
+    REPORTER_ASSERT(reporter, kCount == dictionary.count());
+
+    // Replace the 11th entry with a new matrix, which takes over its index.
+    SkMatrix replacement;
+    replacement.setScale(SkIntToScalar(2), SkIntToScalar(2));
+    bool added, replaced;
+    const SkFlatData* flat = dictionary.findAndReplace(replacement, dictionary[10],
+                                                       &added, &replaced);
+    REPORTER_ASSERT(reporter, added && replaced);
+    REPORTER_ASSERT(reporter, 11 == flat->index());
+    REPORTER_ASSERT(reporter, kCount == dictionary.count());
+    REPORTER_ASSERT(reporter, 11 == dictionary.find(replacement));
+
+    // Every other entry can still be found after the removal.
+    for (int i = 0; i < kCount; ++i) {
+        if (10 == i) {
+            continue;
+        }
+        SkMatrix matrix;
+        matrix.setTranslate(SkIntToScalar(i), 0);
+        REPORTER_ASSERT(reporter, i + 1 == dictionary.find(matrix));
+    }
+
+    SkTRefArray<SkMatrix>* array = dictionary.unflattenToArray();
+    REPORTER_ASSERT(reporter, kCount == array->count());
+    REPORTER_ASSERT(reporter, replacement == (*array)[10]);
+    REPORTER_ASSERT(reporter, SkIntToScalar(kCount - 1) == (*array)[kCount - 1].getTranslateX());
+    array->unref();
+
+    dictionary.reset();
+    REPORTER_ASSERT(reporter, 0 == dictionary.count());
+    REPORTER_ASSERT(reporter, 1 == dictionary.find(replacement));
+}
+
 static void Tests(skiatest::Reporter* reporter) {
+    testDictionary(reporter);
+
     // Test flattening SkShader
     SkPoint points[2];
     points[0].set(0, 0);
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGraphics.h"
+#include "SkPaint.h"
+#include "SkTaskScheduler.h"
+
+extern bool gSkSuppressFontCachePurgeSpew;
+
+static const int kJobCount = 32;
+static const int kWidth = 128;
+static const int kHeight = 32;
+
+struct TextJob {
+    SkBitmap fBitmap;
+};
+
+// Every job cycles through enough strikes to spread over the shards and, with
+// a small budget, to keep the cache purging while other threads use it.
+static void draw_text_job(TextJob* jobs, int index) {
+    SkBitmap& bm = jobs[index].fBitmap;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    bm.allocPixels();
+    bm.eraseColor(SK_ColorWHITE);
+
+    SkCanvas canvas(bm);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 12; i++) {
+        paint.setTextSize(SkIntToScalar(8 + (index + i) % 24));
+        paint.setTextSkewX(SkScalarHalf(SkIntToScalar(i & 1)) - SK_ScalarHalf / 2);
+        canvas.drawText("Hamburgefons", 12, 0, SkIntToScalar(kHeight - 4), paint);
+    }
+}
+
+static bool bitmaps_equal(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+static void TestGlyphCache(skiatest::Reporter* reporter) {
+    bool prevSpew = gSkSuppressFontCachePurgeSpew;
+    gSkSuppressFontCachePurgeSpew = true;
+
+    // The smallest budget the cache accepts, so that purges race with lookups.
+    size_t prevLimit = SkGraphics::SetFontCacheLimit(0);
+
+    TextJob serial[kJobCount];
+    for (int i = 0; i < kJobCount; i++) {
+        draw_text_job(serial, i);
+    }
+
+    TextJob parallel[kJobCount];
+    {
+        SkTaskScheduler scheduler(4);
+        SkParallelFor(&scheduler, kJobCount, draw_text_job, parallel);
+    }
+    for (int i = 0; i < kJobCount; i++) {
+        REPORTER_ASSERT(reporter, bitmaps_equal(serial[i].fBitmap, parallel[i].fBitmap));
+    }
+
+    // Every strike is attached again, so a full purge must account for all of them.
+    SkGraphics::PurgeFontCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetFontCacheUsed());
+
+    SkGraphics::SetFontCacheLimit(prevLimit);
+    gSkSuppressFontCachePurgeSpew = prevSpew;
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("GlyphCache", GlyphCacheTestClass, TestGlyphCache)
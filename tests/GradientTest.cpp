@@ -12,6 +12,9 @@
 #include "SkColorShader.h"
 #include "SkEmptyShader.h"
 #include "SkGradientShader.h"
+#include "SkGradient_opts.h"
+#include "SkGraphics.h"
+#include "SkRandom.h"
 
 struct GradRec {
     int             fColorCount;
@@ -158,6 +161,152 @@ static void TestConstantGradient(skiatest::Reporter*) {
     }
 }
 
+static void draw_gradient(SkBitmap* bitmap, SkShader* shader, U8CPU alpha) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, 16, 4);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setAlpha(alpha);
+    SkDevice device(*bitmap);
+    SkCanvas canvas(&device);
+    canvas.drawPaint(paint);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpA(a), alpB(b);
+    return a.getSize() == b.getSize() && !memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Gradients with the same colors and positions share their tables, whatever
+// their kind, and one table is kept per paint alpha.
+static void TestGradientCache(skiatest::Reporter* reporter) {
+    size_t prevLimit = SkGraphics::SetGradientCacheLimit(1024 * 1024);
+    SkGraphics::PurgeGradientCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetGradientCacheUsed());
+
+    const SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(16), 0 } };
+    const SkColor colors[] = { SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE };
+    const SkScalar pos[] = { 0, SkFloatToScalar(0.3f), SK_Scalar1 };
+    SkAutoTUnref<SkShader> linear(SkGradientShader::CreateLinear(pts, colors, pos, 3,
+                                                                 SkShader::kClamp_TileMode));
+    SkAutoTUnref<SkShader> linear2(SkGradientShader::CreateLinear(pts, colors, pos, 3,
+                                                                  SkShader::kMirror_TileMode));
+    SkAutoTUnref<SkShader> radial(SkGradientShader::CreateRadial(pts[0], SkIntToScalar(16),
+                                                                 colors, pos, 3,
+                                                                 SkShader::kClamp_TileMode));
+
+    SkBitmap opaque, translucent, bitmap;
+    draw_gradient(&opaque, linear, 0xFF);
+    size_t used = SkGraphics::GetGradientCacheUsed();
+    REPORTER_ASSERT(reporter, used > 0);
+
+    draw_gradient(&bitmap, linear2, 0xFF);
+    draw_gradient(&bitmap, radial, 0xFF);
+    REPORTER_ASSERT(reporter, used == SkGraphics::GetGradientCacheUsed());
+
+    draw_gradient(&translucent, linear, 0x80);
+    REPORTER_ASSERT(reporter, SkGraphics::GetGradientCacheUsed() > used);
+    REPORTER_ASSERT(reporter, !same_pixels(opaque, translucent));
+
+    // Switching back to the first alpha finds its table again, unchanged.
+    used = SkGraphics::GetGradientCacheUsed();
+    draw_gradient(&bitmap, linear, 0xFF);
+    REPORTER_ASSERT(reporter, used == SkGraphics::GetGradientCacheUsed());
+    REPORTER_ASSERT(reporter, same_pixels(opaque, bitmap));
+
+    // With the cache off, each shader builds its own tables, just the same.
+    SkGraphics::SetGradientCacheLimit(0);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetGradientCacheUsed());
+    SkAutoTUnref<SkShader> uncached(SkGradientShader::CreateLinear(pts, colors, pos, 3,
+                                                                   SkShader::kClamp_TileMode));
+    draw_gradient(&bitmap, uncached, 0x80);
+    REPORTER_ASSERT(reporter, same_pixels(translucent, bitmap));
+    draw_gradient(&bitmap, uncached, 0xFF);
+    REPORTER_ASSERT(reporter, same_pixels(opaque, bitmap));
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetGradientCacheUsed());
+
+    SkGraphics::SetGradientCacheLimit(prevLimit);
+}
+
+// The tiled 16.16 position, as the scalar procs compute it.
+static int tile_position(SkFixed fx, SkShader::TileMode mode) {
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            return SkClampMax(fx, 0xFFFF);
+        case SkShader::kRepeat_TileMode:
+            return fx & 0xFFFF;
+        default: {
+            int32_t s = fx << 15 >> 31;
+            return (fx ^ s) & 0xFFFF;
+        }
+    }
+}
+
+static const SkShader::TileMode gTileModes[] = {
+    SkShader::kClamp_TileMode,
+    SkShader::kRepeat_TileMode,
+    SkShader::kMirror_TileMode,
+};
+
+// The platform span procs, run over a table whose entries are their own
+// indices, must pick the same dither row and the same (for radial, nearly the
+// same) entry as the scalar procs.
+static void TestGradientSpanProcs(skiatest::Reporter* reporter) {
+    SkPMColor cache[512];
+    for (int i = 0; i < 512; ++i) {
+        cache[i] = i;
+    }
+    SkPMColor dst[67];
+    SkRandom rand;
+
+    for (size_t m = 0; m < SK_ARRAY_COUNT(gTileModes); ++m) {
+        SkShader::TileMode mode = gTileModes[m];
+
+        SkGradientSpanProcs::LinearProc linear = SkGradientSpanProcs::PlatformLinear(mode);
+        for (int trial = 0; NULL != linear && trial < 200; ++trial) {
+            int count = rand.nextRangeU(1, SK_ARRAY_COUNT(dst));
+            int toggle = rand.nextBool() ? 256 : 0;
+            SkFixed fx, dx;
+            if (SkShader::kClamp_TileMode == mode) {
+                // Stay within [0, 0xFFFF], as the caller promises.
+                fx = rand.nextRangeU(0, 0xFFFF);
+                SkFixed end = rand.nextRangeU(0, 0xFFFF);
+                dx = (end - fx) / count;
+            } else {
+                fx = rand.nextS() >> 8;
+                dx = rand.nextS() >> 14;
+            }
+            linear(fx, dx, dst, cache, toggle, count);
+            for (int i = 0; i < count; ++i) {
+                int expected = toggle + (tile_position(fx + i * dx, mode) >> 8);
+                REPORTER_ASSERT(reporter, expected == (int)dst[i]);
+                toggle ^= 256;
+            }
+        }
+
+        SkGradientSpanProcs::RadialProc radial = SkGradientSpanProcs::PlatformRadial(mode);
+        for (int trial = 0; NULL != radial && trial < 200; ++trial) {
+            int count = rand.nextRangeU(1, SK_ARRAY_COUNT(dst));
+            int toggle = rand.nextBool() ? 256 : 0;
+            float fx = rand.nextSScalar1() * 3, dx = rand.nextSScalar1() / 16;
+            float fy = rand.nextSScalar1() * 3, dy = rand.nextSScalar1() / 16;
+            radial(fx, dx, fy, dy, dst, cache, toggle, count);
+            for (int i = 0; i < count; ++i) {
+                double x = fx + i * (double)dx, y = fy + i * (double)dy;
+                SkFixed dist = (SkFixed)(sqrt(x * x + y * y) * 65536);
+                int expected = tile_position(dist, mode) >> 8;
+                int index = (int)dst[i] - toggle;
+                REPORTER_ASSERT(reporter, index >= 0 && index < 256);
+                // Repeat wraps from the last entry to the first.
+                int diff = (index - expected) & 0xFF;
+                REPORTER_ASSERT(reporter, diff <= 1 || diff == 0xFF);
+                toggle ^= 256;
+            }
+        }
+    }
+}
+
 typedef void (*GradProc)(skiatest::Reporter* reporter, const GradRec&);
 
 static void TestGradientShaders(skiatest::Reporter* reporter) {
@@ -195,6 +344,8 @@ static void TestGradientShaders(skiatest::Reporter* reporter) {
 static void TestGradients(skiatest::Reporter* reporter) {
     TestGradientShaders(reporter);
     TestConstantGradient(reporter);
+    TestGradientCache(reporter);
+    TestGradientSpanProcs(reporter);
 }
 #include "TestClassDef.h"
 DEFINE_TESTCLASS("Gradients", TestGradientsClass, TestGradients)
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkBlurImageFilter.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkDevice.h"
+#include "SkGraphics.h"
+#include "SkMatrix.h"
+#include "SkMergeImageFilter.h"
+#include "SkOffsetImageFilter.h"
+#include "SkUnPreMultiply.h"
+#include "SkUtils.h"
+
+namespace {
+
+// Blurs its source, counting how many times it was actually evaluated.
+class CountingFilter : public SkBlurImageFilter {
+public:
+    CountingFilter() : INHERITED(SkIntToScalar(2), SkIntToScalar(2)), fCount(0) {}
+
+    int count() const { return fCount; }
+    // The size of the source the filter was last evaluated on.
+    const SkISize& lastSize() const { return fLastSize; }
+
+    SK_DECLARE_UNFLATTENABLE_OBJECT()
+
+protected:
+    virtual bool onFilterImage(Proxy* proxy, const SkBitmap& src, const SkMatrix& ctm,
+                               SkBitmap* result, SkIPoint* offset) SK_OVERRIDE {
+        fCount++;
+        fLastSize.set(src.width(), src.height());
+        return this->INHERITED::onFilterImage(proxy, src, ctm, result, offset);
+    }
+
+private:
+    int     fCount;
+    SkISize fLastSize;
+
+    typedef SkBlurImageFilter INHERITED;
+};
+
+class RasterProxy : public SkImageFilter::Proxy {
+public:
+    virtual SkDevice* createDevice(int width, int height) SK_OVERRIDE {
+        return SkNEW_ARGS(SkDevice, (SkBitmap::kARGB_8888_Config, width, height));
+    }
+    virtual bool canHandleImageFilter(SkImageFilter*) SK_OVERRIDE {
+        return false;
+    }
+    virtual bool filterImage(SkImageFilter*, const SkBitmap&, const SkMatrix&,
+                             SkBitmap*, SkIPoint*) SK_OVERRIDE {
+        return false;
+    }
+};
+
+}
+
+static void make_source(SkBitmap* bitmap, SkColor color) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, 40, 30);
+    bitmap->allocPixels();
+    bitmap->eraseColor(color);
+}
+
+static bool apply(SkImageFilter* filter, const SkBitmap& src, const SkMatrix& ctm,
+                  SkBitmap* result) {
+    RasterProxy proxy;
+    SkIPoint offset = SkIPoint::Make(0, 0);
+    return filter->filterImage(&proxy, src, ctm, result, &offset);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    if (a.width() != b.width() || a.height() != b.height()) {
+        return false;
+    }
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    for (int y = 0; y < a.height(); ++y) {
+        if (memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(SkPMColor))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_off_by_default(skiatest::Reporter* reporter) {
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetImageFilterCacheLimit());
+
+    SkBitmap src, result;
+    make_source(&src, 0xFF204080);
+    SkAutoTUnref<CountingFilter> blur(SkNEW(CountingFilter));
+    apply(blur, src, SkMatrix::I(), &result);
+    apply(blur, src, SkMatrix::I(), &result);
+    REPORTER_ASSERT(reporter, 2 == blur->count());
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetImageFilterCacheUsed());
+}
+
+static void test_reuse(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    make_source(&src, 0xFF204080);
+
+    // The blur is an input of the merge twice, but is only evaluated once.
+    SkAutoTUnref<CountingFilter> blur(SkNEW(CountingFilter));
+    SkAutoTUnref<SkImageFilter> offset(SkNEW_ARGS(SkOffsetImageFilter,
+                                                  (SkIntToScalar(3), 0, blur)));
+    SkAutoTUnref<SkImageFilter> merge(SkNEW_ARGS(SkMergeImageFilter, (blur, offset)));
+
+    SkBitmap uncached;
+    SkGraphics::SetImageFilterCacheLimit(0);
+    REPORTER_ASSERT(reporter, apply(merge, src, SkMatrix::I(), &uncached));
+    REPORTER_ASSERT(reporter, 2 == blur->count());
+
+    SkGraphics::SetImageFilterCacheLimit(1024 * 1024);
+    SkBitmap cached;
+    REPORTER_ASSERT(reporter, apply(merge, src, SkMatrix::I(), &cached));
+    REPORTER_ASSERT(reporter, 3 == blur->count());
+    REPORTER_ASSERT(reporter, same_pixels(uncached, cached));
+    REPORTER_ASSERT(reporter, SkGraphics::GetImageFilterCacheUsed() > 0);
+
+    // Filtering the same source again is served entirely from the cache.
+    SkBitmap again;
+    REPORTER_ASSERT(reporter, apply(merge, src, SkMatrix::I(), &again));
+    REPORTER_ASSERT(reporter, 3 == blur->count());
+    REPORTER_ASSERT(reporter, same_pixels(uncached, again));
+
+    // A different matrix is a different result.
+    SkMatrix scale;
+    scale.setScale(SkIntToScalar(2), SkIntToScalar(2));
+    SkBitmap scaled;
+    REPORTER_ASSERT(reporter, apply(blur, src, scale, &scaled));
+    REPORTER_ASSERT(reporter, 4 == blur->count());
+
+    // Changing the source's pixels must miss.
+    src.eraseColor(SK_ColorRED);
+    SkBitmap changed;
+    REPORTER_ASSERT(reporter, apply(blur, src, SkMatrix::I(), &changed));
+    REPORTER_ASSERT(reporter, 5 == blur->count());
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorRED) == *changed.getAddr32(20, 15));
+
+    SkGraphics::PurgeImageFilterCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetImageFilterCacheUsed());
+    SkGraphics::SetImageFilterCacheLimit(0);
+}
+
+// The cached result does not depend on where the source is; a source that
+// only moved is served from the cache, with the result moved along with it.
+static void test_moved(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    make_source(&src, 0xFF204080);
+    SkAutoTUnref<CountingFilter> blur(SkNEW(CountingFilter));
+    SkAutoTUnref<SkImageFilter> offset(SkNEW_ARGS(SkOffsetImageFilter,
+                                                  (SkIntToScalar(3), SkIntToScalar(4), blur)));
+    SkGraphics::SetImageFilterCacheLimit(1024 * 1024);
+
+    RasterProxy proxy;
+    SkBitmap first, second;
+    SkIPoint loc = SkIPoint::Make(0, 0);
+    REPORTER_ASSERT(reporter, offset->filterImage(&proxy, src, SkMatrix::I(), &first, &loc));
+    REPORTER_ASSERT(reporter, SkIPoint::Make(3, 4) == loc);
+
+    loc.set(10, -5);
+    REPORTER_ASSERT(reporter, offset->filterImage(&proxy, src, SkMatrix::I(), &second, &loc));
+    REPORTER_ASSERT(reporter, SkIPoint::Make(13, -1) == loc);
+    REPORTER_ASSERT(reporter, 1 == blur->count());
+    REPORTER_ASSERT(reporter, same_pixels(first, second));
+
+    SkGraphics::SetImageFilterCacheLimit(0);
+}
+
+// Results are keyed on the source's generation ID. Drawing into the source
+// through a canvas changes it; writing its pixels directly only does once the
+// writer calls notifyPixelsChanged().
+static void test_source_changed(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    make_source(&src, 0xFF204080);
+    SkAutoTUnref<CountingFilter> blur(SkNEW(CountingFilter));
+    SkGraphics::SetImageFilterCacheLimit(1024 * 1024);
+
+    SkBitmap result;
+    REPORTER_ASSERT(reporter, apply(blur, src, SkMatrix::I(), &result));
+    REPORTER_ASSERT(reporter, 1 == blur->count());
+
+    {
+        SkCanvas canvas(src);
+        canvas.drawColor(SK_ColorGREEN, SkXfermode::kSrc_Mode);
+    }
+    REPORTER_ASSERT(reporter, apply(blur, src, SkMatrix::I(), &result));
+    REPORTER_ASSERT(reporter, 2 == blur->count());
+    REPORTER_ASSERT(reporter, SK_ColorGREEN == SkUnPreMultiply::PMColorToColor(
+                                                   *result.getAddr32(20, 15)));
+
+    {
+        SkAutoLockPixels alp(src);
+        for (int y = 0; y < src.height(); ++y) {
+            sk_memset32(src.getAddr32(0, y), SkPreMultiplyColor(SK_ColorBLUE), src.width());
+        }
+    }
+    src.notifyPixelsChanged();
+    REPORTER_ASSERT(reporter, apply(blur, src, SkMatrix::I(), &result));
+    REPORTER_ASSERT(reporter, 3 == blur->count());
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorBLUE) == *result.getAddr32(20, 15));
+
+    SkGraphics::SetImageFilterCacheLimit(0);
+}
+
+// Filtering for a clip only evaluates the part of the source that reaches it,
+// and matches the whole result inside the clip.
+static void test_clipped(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, 100, 80);
+    src.allocPixels();
+    {
+        SkAutoLockPixels alp(src);
+        for (int y = 0; y < src.height(); ++y) {
+            for (int x = 0; x < src.width(); ++x) {
+                *src.getAddr32(x, y) = SkPackARGB32(0xFF, x * 2, y * 3, (x ^ y) & 0xFF);
+            }
+        }
+    }
+
+    SkAutoTUnref<CountingFilter> blur(SkNEW(CountingFilter));
+    SkAutoTUnref<SkImageFilter> offset(SkNEW_ARGS(SkOffsetImageFilter,
+                                                  (SkIntToScalar(5), SkIntToScalar(-2), blur)));
+    RasterProxy proxy;
+    const SkIPoint srcLoc = SkIPoint::Make(10, 20);
+
+    SkBitmap full;
+    SkIPoint fullLoc = srcLoc;
+    REPORTER_ASSERT(reporter, offset->filterImage(&proxy, src, SkMatrix::I(), &full, &fullLoc));
+    REPORTER_ASSERT(reporter, SkISize::Make(100, 80) == blur->lastSize());
+
+    const SkIRect clip = SkIRect::MakeXYWH(40, 50, 20, 10);
+    SkBitmap clipped;
+    SkIPoint clippedLoc = srcLoc;
+    REPORTER_ASSERT(reporter, offset->filterImage(&proxy, src, SkMatrix::I(), clip,
+                                                  &clipped, &clippedLoc));
+    REPORTER_ASSERT(reporter, blur->lastSize().width() < 100);
+    REPORTER_ASSERT(reporter, blur->lastSize().height() < 80);
+
+    SkAutoLockPixels alpFull(full), alpClipped(clipped);
+    bool same = true;
+    for (int y = clip.fTop; y < clip.fBottom; ++y) {
+        for (int x = clip.fLeft; x < clip.fRight; ++x) {
+            same &= *full.getAddr32(x - fullLoc.fX, y - fullLoc.fY) ==
+                    *clipped.getAddr32(x - clippedLoc.fX, y - clippedLoc.fY);
+        }
+    }
+    REPORTER_ASSERT(reporter, same);
+
+    // Nothing reaches a clip well away from the source.
+    REPORTER_ASSERT(reporter, !offset->filterImage(&proxy, src, SkMatrix::I(),
+                                                   SkIRect::MakeXYWH(500, 500, 10, 10),
+                                                   &clipped, &clippedLoc));
+}
+
+static void test_budget(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    make_source(&src, 0xFF204080);
+    size_t resultSize = src.getSize();
+
+    // Room for about two results.
+    SkGraphics::SetImageFilterCacheLimit(2 * resultSize + 1024);
+    SkAutoTUnref<CountingFilter> blurs[4];
+    for (int i = 0; i < 4; ++i) {
+        blurs[i].reset(SkNEW(CountingFilter));
+        SkBitmap result;
+        apply(blurs[i], src, SkMatrix::I(), &result);
+        REPORTER_ASSERT(reporter,
+                        SkGraphics::GetImageFilterCacheUsed() <=
+                        SkGraphics::GetImageFilterCacheLimit());
+    }
+
+    // The most recent result is still there, the oldest was purged.
+    SkBitmap result;
+    apply(blurs[3], src, SkMatrix::I(), &result);
+    REPORTER_ASSERT(reporter, 1 == blurs[3]->count());
+    apply(blurs[0], src, SkMatrix::I(), &result);
+    REPORTER_ASSERT(reporter, 2 == blurs[0]->count());
+
+    // Lowering the limit purges down to it.
+    SkGraphics::SetImageFilterCacheLimit(resultSize + 1024);
+    REPORTER_ASSERT(reporter, SkGraphics::GetImageFilterCacheUsed() <= resultSize + 1024);
+    SkGraphics::SetImageFilterCacheLimit(0);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetImageFilterCacheUsed());
+}
+
+static void test_image_filter_cache(skiatest::Reporter* reporter) {
+    test_off_by_default(reporter);
+    test_reuse(reporter);
+    test_moved(reporter);
+    test_source_changed(reporter);
+    test_clipped(reporter);
+    test_budget(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("ImageFilterCache", ImageFilterCacheTestClass, test_image_filter_cache)
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkBlurImageFilter.h"
+#include "SkColorPriv.h"
+#include "SkGraphics.h"
+#include "SkMatrix.h"
+#include "SkMorphologyImageFilter.h"
+#include "SkRandom.h"
+
+// Odd sizes, so that the rows and columns don't split evenly across threads.
+static void make_source(SkBitmap* bitmap, int width, int height) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, width, height);
+    bitmap->allocPixels();
+    SkRandom rand;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            *bitmap->getAddr32(x, y) = SkPreMultiplyColor(rand.nextU());
+        }
+    }
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    if (a.width() != b.width() || a.height() != b.height()) {
+        return false;
+    }
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    for (int y = 0; y < a.height(); ++y) {
+        if (memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(SkPMColor))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool apply(SkImageFilter* filter, const SkBitmap& src, SkBitmap* result) {
+    SkIPoint offset = SkIPoint::Make(0, 0);
+    return filter->filterImage(NULL, src, SkMatrix::I(), result, &offset);
+}
+
+template <typename Filter>
+static void test_threads(skiatest::Reporter* reporter, Filter* filter, const SkBitmap& src) {
+    filter->setThreadCount(1);
+    SkBitmap serial;
+    REPORTER_ASSERT(reporter, apply(filter, src, &serial));
+
+    static const int kThreadCounts[] = { 2, 3, 4, 7, 16 };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kThreadCounts); ++i) {
+        filter->setThreadCount(kThreadCounts[i]);
+        SkBitmap threaded;
+        REPORTER_ASSERT(reporter, apply(filter, src, &threaded));
+        REPORTER_ASSERT(reporter, same_pixels(serial, threaded));
+    }
+
+    // Threads are started again after they have been purged.
+    SkGraphics::PurgeImageFilterThreads();
+    SkBitmap restarted;
+    REPORTER_ASSERT(reporter, apply(filter, src, &restarted));
+    REPORTER_ASSERT(reporter, same_pixels(serial, restarted));
+
+    // A filter with no thread count of its own follows the global setting.
+    filter->setThreadCount(0);
+    int prevCount = SkGraphics::SetImageFilterThreadCount(4);
+    SkBitmap global;
+    REPORTER_ASSERT(reporter, apply(filter, src, &global));
+    REPORTER_ASSERT(reporter, same_pixels(serial, global));
+    SkGraphics::SetImageFilterThreadCount(prevCount);
+}
+
+static void test_image_filter_threads(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    make_source(&src, 203, 157);
+
+    SkBlurImageFilter blur(SkIntToScalar(3), SkIntToScalar(5));
+    test_threads(reporter, &blur, src);
+    SkBlurImageFilter blurX(SkIntToScalar(4), 0);
+    test_threads(reporter, &blurX, src);
+    SkBlurImageFilter blurY(0, SkIntToScalar(4));
+    test_threads(reporter, &blurY, src);
+
+    SkDilateImageFilter dilate(3, 2);
+    test_threads(reporter, &dilate, src);
+    SkErodeImageFilter erode(2, 5);
+    test_threads(reporter, &erode, src);
+    SkErodeImageFilter erodeY(0, 4);
+    test_threads(reporter, &erodeY, src);
+
+    int prevCount = SkGraphics::SetImageFilterThreadCount(0);
+    REPORTER_ASSERT(reporter, 1 == SkGraphics::GetImageFilterThreadCount());
+    SkGraphics::SetImageFilterThreadCount(prevCount);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("ImageFilterThreads", ImageFilterThreadsTestClass, test_image_filter_threads)
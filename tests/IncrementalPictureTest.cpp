@@ -0,0 +1,117 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkIncrementalPicture.h"
+#include "SkRandom.h"
+
+static const int kCells = 10;
+static const int kCellSize = 10;
+static const int kSize = kCells * kCellSize;
+
+// Fills a grid of cells, each with its own color.
+static void draw_cells(SkCanvas* canvas, const SkColor colors[]) {
+    SkPaint paint;
+    for (int y = 0; y < kCells; ++y) {
+        for (int x = 0; x < kCells; ++x) {
+            paint.setColor(colors[y * kCells + x]);
+            canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(x * kCellSize),
+                                              SkIntToScalar(y * kCellSize),
+                                              SkIntToScalar(kCellSize),
+                                              SkIntToScalar(kCellSize)), paint);
+        }
+    }
+}
+
+static void draw_to_bitmap(SkPicture* picture, SkBitmap* bitmap) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(*bitmap);
+    canvas.drawPicture(*picture);
+}
+
+static bool same_bitmaps(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Checks that the incremental picture draws the same as recording the cells
+// from scratch.
+static void check_matches(skiatest::Reporter* reporter, const SkIncrementalPicture& incremental,
+                          const SkColor colors[]) {
+    SkPicture expected;
+    draw_cells(expected.beginRecording(kSize, kSize), colors);
+    expected.endRecording();
+    SkBitmap expectedBitmap;
+    draw_to_bitmap(&expected, &expectedBitmap);
+
+    SkAutoTUnref<SkPicture> actual(incremental.createPicture());
+    REPORTER_ASSERT(reporter, kSize == actual->width() && kSize == actual->height());
+    SkBitmap actualBitmap;
+    draw_to_bitmap(actual, &actualBitmap);
+    REPORTER_ASSERT(reporter, same_bitmaps(expectedBitmap, actualBitmap));
+}
+
+static void TestIncrementalPicture(skiatest::Reporter* reporter) {
+    SkColor colors[kCells * kCells];
+    SkMWCRandom rand;
+    for (int i = 0; i < kCells * kCells; ++i) {
+        colors[i] = rand.nextU() | 0xFF000000;
+    }
+
+    SkPicture initial;
+    draw_cells(initial.beginRecording(kSize, kSize), colors);
+    initial.endRecording();
+    SkIncrementalPicture incremental(&initial);
+    REPORTER_ASSERT(reporter, 1 == incremental.countPieces());
+    check_matches(reporter, incremental, colors);
+
+    // Recolor random blocks of cells, recording the whole grid each time and
+    // relying on the update's clip to keep only the block. There are enough
+    // updates to make the pieces get compacted.
+    for (int update = 0; update < 3 * SkIncrementalPicture::kMaxPieces; ++update) {
+        int left = rand.nextULessThan(kCells);
+        int top = rand.nextULessThan(kCells);
+        int right = left + 1 + rand.nextULessThan(kCells - left);
+        int bottom = top + 1 + rand.nextULessThan(kCells - top);
+        for (int y = top; y < bottom; ++y) {
+            for (int x = left; x < right; ++x) {
+                colors[y * kCells + x] = rand.nextU() | 0xFF000000;
+            }
+        }
+        SkIRect invalid = SkIRect::MakeLTRB(left * kCellSize, top * kCellSize,
+                                            right * kCellSize, bottom * kCellSize);
+        draw_cells(incremental.beginUpdate(invalid), colors);
+        incremental.endUpdate();
+        REPORTER_ASSERT(reporter, incremental.countPieces() <= SkIncrementalPicture::kMaxPieces);
+        check_matches(reporter, incremental, colors);
+    }
+
+    // Pieces which are completely covered are dropped.
+    SkAutoTUnref<SkPicture> cover(SkNEW(SkPicture));
+    draw_cells(cover->beginRecording(kSize, kSize), colors);
+    cover->endRecording();
+    incremental.update(SkRegion(SkIRect::MakeWH(kSize, kSize)), cover);
+    REPORTER_ASSERT(reporter, 1 == incremental.countPieces());
+    check_matches(reporter, incremental, colors);
+
+    // An empty picture draws nothing.
+    SkIncrementalPicture empty(kSize, kSize);
+    REPORTER_ASSERT(reporter, 0 == empty.countPieces());
+    SkAutoTUnref<SkPicture> emptyPicture(empty.createPicture());
+    SkBitmap emptyBitmap, white;
+    draw_to_bitmap(emptyPicture, &emptyBitmap);
+    white.setConfig(SkBitmap::kARGB_8888_Config, kSize, kSize);
+    white.allocPixels();
+    white.eraseColor(SK_ColorWHITE);
+    REPORTER_ASSERT(reporter, same_bitmaps(white, emptyBitmap));
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("IncrementalPicture", IncrementalPictureTestClass, TestIncrementalPicture)
@@ -97,6 +97,35 @@ static void regression_cubic(skiatest::Reporter* reporter) {
     REPORTER_ASSERT(reporter, maxR.contains(strokeR));
 }
 
+static void test_filter_level(skiatest::Reporter* reporter) {
+    static const SkPaint::FilterLevel gLevels[] = {
+        SkPaint::kNone_FilterLevel,
+        SkPaint::kLow_FilterLevel,
+        SkPaint::kMedium_FilterLevel,
+        SkPaint::kHigh_FilterLevel,
+    };
+
+    SkPaint paint;
+    REPORTER_ASSERT(reporter, SkPaint::kNone_FilterLevel == paint.getFilterLevel());
+    paint.setAntiAlias(true);
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gLevels); ++i) {
+        paint.setFilterLevel(gLevels[i]);
+        REPORTER_ASSERT(reporter, gLevels[i] == paint.getFilterLevel());
+        REPORTER_ASSERT(reporter, paint.isFilterBitmap() ==
+                                  (SkPaint::kNone_FilterLevel != gLevels[i]));
+        REPORTER_ASSERT(reporter, paint.isAntiAlias());
+    }
+
+    // The boolean setter picks the lowest level that filters.
+    paint.setFilterBitmap(true);
+    REPORTER_ASSERT(reporter, SkPaint::kLow_FilterLevel == paint.getFilterLevel());
+    paint.setFilterLevel(SkPaint::kMedium_FilterLevel);
+    paint.setFilterBitmap(false);
+    REPORTER_ASSERT(reporter, SkPaint::kNone_FilterLevel == paint.getFilterLevel());
+    paint.setFilterBitmap(true);
+    REPORTER_ASSERT(reporter, SkPaint::kLow_FilterLevel == paint.getFilterLevel());
+}
+
 // found and fixed for android: not initializing rect for string's of length 0
 static void regression_measureText(skiatest::Reporter* reporter) {
 
@@ -114,6 +143,7 @@ static void regression_measureText(skiatest::Reporter* reporter) {
 static void TestPaint(skiatest::Reporter* reporter) {
     // TODO add general paint tests
     test_copy(reporter);
+    test_filter_level(reporter);
 
     // regression tests
     regression_cubic(reporter);
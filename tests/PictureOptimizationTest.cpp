@@ -0,0 +1,327 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBBoxHierarchyRecord.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDevice.h"
+#include "SkPicture.h"
+#include "SkPicturePlayback.h"
+#include "SkPictureRecord.h"
+#include "SkRandom.h"
+#include "SkTileGrid.h"
+#include "SkTileGridPicture.h"
+
+static const int kWidth = 64;
+static const int kHeight = 64;
+
+namespace {
+
+// Draws into a bitmap, counting the calls that change the canvas state.
+class CountingCanvas : public SkCanvas {
+public:
+    CountingCanvas(const SkBitmap& bitmap)
+        : INHERITED(bitmap)
+        , fSaves(0)
+        , fSaveLayers(0)
+        , fMatrixChanges(0)
+        , fClips(0) {}
+
+    virtual int save(SaveFlags flags) SK_OVERRIDE {
+        fSaves++;
+        return this->INHERITED::save(flags);
+    }
+    virtual int saveLayer(const SkRect* bounds, const SkPaint* paint,
+                          SaveFlags flags) SK_OVERRIDE {
+        fSaveLayers++;
+        return this->INHERITED::saveLayer(bounds, paint, flags);
+    }
+    virtual bool translate(SkScalar dx, SkScalar dy) SK_OVERRIDE {
+        fMatrixChanges++;
+        return this->INHERITED::translate(dx, dy);
+    }
+    virtual bool scale(SkScalar sx, SkScalar sy) SK_OVERRIDE {
+        fMatrixChanges++;
+        return this->INHERITED::scale(sx, sy);
+    }
+    virtual bool rotate(SkScalar degrees) SK_OVERRIDE {
+        fMatrixChanges++;
+        return this->INHERITED::rotate(degrees);
+    }
+    virtual bool concat(const SkMatrix& matrix) SK_OVERRIDE {
+        fMatrixChanges++;
+        return this->INHERITED::concat(matrix);
+    }
+    virtual void setMatrix(const SkMatrix& matrix) SK_OVERRIDE {
+        fMatrixChanges++;
+        this->INHERITED::setMatrix(matrix);
+    }
+    virtual bool clipRect(const SkRect& rect, SkRegion::Op op, bool doAA) SK_OVERRIDE {
+        fClips++;
+        return this->INHERITED::clipRect(rect, op, doAA);
+    }
+    virtual bool clipPath(const SkPath& path, SkRegion::Op op, bool doAA) SK_OVERRIDE {
+        fClips++;
+        return this->INHERITED::clipPath(path, op, doAA);
+    }
+
+    int fSaves;
+    int fSaveLayers;
+    int fMatrixChanges;
+    int fClips;
+
+private:
+    typedef SkCanvas INHERITED;
+};
+
+}
+
+typedef void (*DrawProc)(SkCanvas*);
+
+static void make_bitmap(SkBitmap* bitmap) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorWHITE);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Record with the given optimizations, then play back, counting state changes.
+static void record_and_draw(DrawProc proc, uint32_t optimizations, bool useTileGrid,
+                            SkBitmap* bitmap, CountingCanvas** counts) {
+    SkBitmap recordBitmap;
+    recordBitmap.setConfig(SkBitmap::kNo_Config, kWidth, kHeight);
+    SkAutoTUnref<SkDevice> device(SkNEW_ARGS(SkDevice, (recordBitmap)));
+    SkAutoTUnref<SkPictureRecord> record;
+    if (useTileGrid) {
+        SkTileGridPicture::TileGridInfo info;
+        info.fMargin.setEmpty();
+        info.fOffset.setZero();
+        info.fTileInterval.set(16, 16);
+        SkAutoTUnref<SkBBoxHierarchy> grid(SkNEW_ARGS(SkTileGrid,
+                (kWidth / 16, kHeight / 16, info)));
+        record.reset(SkNEW_ARGS(SkBBoxHierarchyRecord,
+                (SkPicture::kOptimizeForClippedPlayback_RecordingFlag, grid, device,
+                 optimizations)));
+    } else {
+        record.reset(SkNEW_ARGS(SkPictureRecord, (0, device, NULL, optimizations)));
+    }
+    record->beginRecording();
+    proc(record);
+    record->endRecording();
+    SkPicturePlayback playback(*record);
+
+    make_bitmap(bitmap);
+    *counts = SkNEW_ARGS(CountingCanvas, (*bitmap));
+    playback.draw(**counts);
+}
+
+static void draw_saves_around_draws(SkCanvas* canvas) {
+    SkPaint paint;
+    for (int i = 0; i < 10; ++i) {
+        canvas->save();
+        paint.setColor(0xFF000000 | (i * 0x151515));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i * 5), 0, 8, 8), paint);
+        canvas->save();
+        canvas->drawCircle(SkIntToScalar(i * 5), 20, 4, paint);
+        canvas->restore();
+        canvas->restore();
+    }
+}
+
+// Half the layers are opaque, and can be removed; the others must stay.
+static void draw_layers_around_shapes(SkCanvas* canvas) {
+    SkPaint layerPaint;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 8; ++i) {
+        layerPaint.setAlpha(i & 2 ? 0x20 * i + 0x10 : 0xFF);
+        paint.setColor(0xFF000000 | (i * 0x1F2F3F));
+        canvas->saveLayer(NULL, 0 == i ? NULL : &layerPaint);
+        if (i & 1) {
+            canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i * 8), 4, 6, 20), paint);
+        } else {
+            canvas->drawCircle(SkIntToScalar(i * 8 + 4), 40, 3, paint);
+        }
+        canvas->restore();
+    }
+}
+
+static void draw_redundant_matrices(SkCanvas* canvas) {
+    SkPaint paint;
+    paint.setColor(SK_ColorBLUE);
+    canvas->translate(0, 0);
+    canvas->scale(SK_Scalar1, SK_Scalar1);
+    canvas->concat(SkMatrix::I());
+    SkMatrix matrix;
+    matrix.setTranslate(5, 5);
+    canvas->rotate(30);         // replaced by the setMatrix before it is used
+    canvas->setMatrix(matrix);
+    canvas->drawRect(SkRect::MakeWH(10, 10), paint);
+    canvas->setMatrix(matrix);  // already the matrix
+    canvas->drawRect(SkRect::MakeXYWH(20, 0, 10, 10), paint);
+    for (int i = 0; i < 5; ++i) {
+        canvas->save();
+        canvas->translate(SkIntToScalar(i * 10), 30);
+        canvas->drawRect(SkRect::MakeWH(6, 6), paint);
+        canvas->translate(3, 3);  // undone by the restore before it is used
+        canvas->restore();
+    }
+}
+
+static void draw_redundant_clips(SkCanvas* canvas) {
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    SkRect clip = SkRect::MakeXYWH(4, 4, 40, 40);
+    SkPath path;
+    path.addCircle(30, 30, 20);
+    canvas->clipRect(clip);
+    canvas->drawPaint(paint);
+    canvas->clipRect(clip);     // already in effect
+    canvas->clipPath(path);
+    canvas->drawRect(SkRect::MakeWH(50, 50), paint);
+    canvas->clipPath(path);     // already in effect
+    canvas->clipRect(clip, SkRegion::kIntersect_Op, true);
+    for (int i = 0; i < 5; ++i) {
+        canvas->save();
+        paint.setColor(0xFF000000 | (i * 0x303030));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i * 8), 0, 10, 60), paint);
+        canvas->clipRect(SkRect::MakeWH(10, 10));  // undone by the restore
+        canvas->restore();
+    }
+}
+
+static void draw_random(SkCanvas* canvas) {
+    SkMWCRandom rand(1234);
+    SkPaint paint;
+    int saveCount = canvas->getSaveCount();
+    for (int i = 0; i < 400; ++i) {
+        SkRect rect = SkRect::MakeXYWH(rand.nextRangeScalar(-10, kWidth),
+                                       rand.nextRangeScalar(-10, kHeight),
+                                       rand.nextRangeScalar(1, 30),
+                                       rand.nextRangeScalar(1, 30));
+        paint.setColor(rand.nextU() | 0xFF000000);
+        paint.setAntiAlias(rand.nextBool());
+        switch (rand.nextULessThan(12)) {
+            case 0:
+                canvas->save();
+                break;
+            case 1: {
+                SkPaint layerPaint;
+                layerPaint.setAlpha(rand.nextULessThan(256));
+                canvas->saveLayer(NULL, &layerPaint);
+            } break;
+            case 2:
+            case 3:
+                if (canvas->getSaveCount() > saveCount) {
+                    canvas->restore();
+                }
+                break;
+            case 4:
+                canvas->translate(rand.nextBool() ? 0 : rand.nextRangeScalar(-5, 5),
+                                  rand.nextBool() ? 0 : rand.nextRangeScalar(-5, 5));
+                break;
+            case 5: {
+                SkMatrix matrix;
+                matrix.setRotate(rand.nextRangeScalar(-20, 20));
+                canvas->setMatrix(matrix);
+            } break;
+            case 6:
+                canvas->clipRect(rect, rand.nextBool() ? SkRegion::kIntersect_Op
+                                                       : SkRegion::kUnion_Op);
+                break;
+            case 7:
+                canvas->clipRect(SkRect::MakeXYWH(2, 2, 50, 50));
+                break;
+            case 8:
+                canvas->drawOval(rect, paint);
+                break;
+            default:
+                canvas->drawRect(rect, paint);
+                break;
+        }
+    }
+}
+
+static void test_optimization(skiatest::Reporter* reporter, DrawProc proc,
+                              uint32_t optimization) {
+    SkBitmap expected, bitmap;
+    CountingCanvas* without;
+    CountingCanvas* with;
+    record_and_draw(proc, SkPictureRecord::kAll_Optimizations & ~optimization, false,
+                    &expected, &without);
+    record_and_draw(proc, SkPictureRecord::kAll_Optimizations, false, &bitmap, &with);
+    SkAutoTUnref<SkCanvas> autoWithout(without), autoWith(with);
+
+    REPORTER_ASSERT(reporter, same_pixels(expected, bitmap));
+    switch (optimization) {
+        case SkPictureRecord::kRemoveSaveRestore_Optimization:
+            REPORTER_ASSERT(reporter, with->fSaves < without->fSaves);
+            REPORTER_ASSERT(reporter, 0 == with->fSaves);
+            break;
+        case SkPictureRecord::kRemoveSaveLayer_Optimization:
+            REPORTER_ASSERT(reporter, 8 == without->fSaveLayers);
+            REPORTER_ASSERT(reporter, 4 == with->fSaveLayers);
+            break;
+        case SkPictureRecord::kRemoveRedundantMatrix_Optimization:
+            REPORTER_ASSERT(reporter, 16 == without->fMatrixChanges);
+            REPORTER_ASSERT(reporter, 6 == with->fMatrixChanges);
+            break;
+        case SkPictureRecord::kRemoveRedundantClip_Optimization:
+            REPORTER_ASSERT(reporter, 10 == without->fClips);
+            REPORTER_ASSERT(reporter, 3 == with->fClips);
+            break;
+        default:
+            SkASSERT(0);
+    }
+}
+
+// Every optimization on, and with the state tree of a tile grid, must draw
+// the same as none of them.
+static void test_random(skiatest::Reporter* reporter) {
+    for (int grid = 0; grid < 2; ++grid) {
+        SkBitmap expected, bitmap;
+        CountingCanvas* without;
+        CountingCanvas* with;
+        record_and_draw(draw_random, 0, SkToBool(grid), &expected, &without);
+        record_and_draw(draw_random, SkPictureRecord::kAll_Optimizations, SkToBool(grid),
+                        &bitmap, &with);
+        SkAutoTUnref<SkCanvas> autoWithout(without), autoWith(with);
+        REPORTER_ASSERT(reporter, same_pixels(expected, bitmap));
+    }
+}
+
+static void test_disabled(skiatest::Reporter* reporter) {
+    SkPicture picture;
+    draw_redundant_clips(picture.beginRecording(kWidth, kHeight,
+                         SkPicture::kDisableRecordOptimizations_RecordingFlag));
+    picture.endRecording();
+    SkBitmap bitmap;
+    make_bitmap(&bitmap);
+    CountingCanvas canvas(bitmap);
+    canvas.drawPicture(picture);
+    REPORTER_ASSERT(reporter, 10 == canvas.fClips);
+}
+
+static void test_picture_optimizations(skiatest::Reporter* reporter) {
+    test_optimization(reporter, draw_saves_around_draws,
+                      SkPictureRecord::kRemoveSaveRestore_Optimization);
+    test_optimization(reporter, draw_layers_around_shapes,
+                      SkPictureRecord::kRemoveSaveLayer_Optimization);
+    test_optimization(reporter, draw_redundant_matrices,
+                      SkPictureRecord::kRemoveRedundantMatrix_Optimization);
+    test_optimization(reporter, draw_redundant_clips,
+                      SkPictureRecord::kRemoveRedundantClip_Optimization);
+    test_random(reporter);
+    test_disabled(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PictureOptimization", PictureOptimizationTestClass, test_picture_optimizations)
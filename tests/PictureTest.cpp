@@ -8,12 +8,17 @@
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
 #include "SkData.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkPicture.h"
+#include "SkPictureRecordGroup.h"
 #include "SkRandom.h"
+#include "SkRegion.h"
 #include "SkRRect.h"
 #include "SkShader.h"
 #include "SkStream.h"
+#include "SkTaskScheduler.h"
+#include "SkTileGridPicture.h"
 
 #include "SkPictureUtils.h"
 
@@ -419,6 +424,395 @@ static void test_clone_empty(skiatest::Reporter* reporter) {
     }
 }
 
+// Sticks to content whose rasterization does not depend on the clip, so that banded and
+// serial playback must match exactly.
+static void draw_parallel_content(SkCanvas* canvas, int width, int height) {
+    SkRandom rand;
+    SkPaint paint;
+    for (int i = 0; i < 200; ++i) {
+        paint.setColor(rand.nextU() | 0xFF000000);
+        paint.setAlpha(0xFF - (i & 0x3F));
+        SkScalar x = rand.nextRangeScalar(0, SkIntToScalar(width));
+        SkScalar y = rand.nextRangeScalar(0, SkIntToScalar(height));
+        SkScalar w = rand.nextRangeScalar(SkIntToScalar(2), SkIntToScalar(60));
+        SkScalar h = rand.nextRangeScalar(SkIntToScalar(2), SkIntToScalar(60));
+        canvas->drawRect(SkRect::MakeXYWH(x, y, w, h), paint);
+    }
+}
+
+static void test_draw_parallel(skiatest::Reporter* reporter) {
+    static const int kWidth = 200;
+    static const int kHeight = 300;
+
+    SkTileGridPicture::TileGridInfo info;
+    info.fTileInterval.set(50, 50);
+    info.fMargin.setEmpty();
+    info.fOffset.setZero();
+    SkTileGridPicture tileGrid(kWidth, kHeight, info);
+    SkPicture plain;
+    SkPicture* pictures[] = { &plain, &tileGrid };
+
+    SkTaskScheduler scheduler(3);
+    for (size_t i = 0; i < SK_ARRAY_COUNT(pictures); ++i) {
+        draw_parallel_content(pictures[i]->beginRecording(kWidth, kHeight,
+                              SkPicture::kOptimizeForClippedPlayback_RecordingFlag),
+                              kWidth, kHeight);
+        pictures[i]->endRecording();
+
+        SkBitmap serial, parallel;
+        make_bm(&serial, kWidth, kHeight, SK_ColorWHITE, false);
+        make_bm(&parallel, kWidth, kHeight, SK_ColorWHITE, false);
+
+        // A non-trivial matrix and an anti-aliased, non-rectangular clip.
+        SkRRect clip;
+        clip.setOval(SkRect::MakeXYWH(10, 10, 180, 270));
+        SkCanvas serialCanvas(serial), parallelCanvas(parallel);
+        SkCanvas* canvases[] = { &serialCanvas, &parallelCanvas };
+        for (size_t j = 0; j < SK_ARRAY_COUNT(canvases); ++j) {
+            canvases[j]->clipRRect(clip, SkRegion::kIntersect_Op, true);
+            canvases[j]->translate(SkIntToScalar(5), SkFloatToScalar(3.5f));
+            canvases[j]->scale(SkFloatToScalar(0.9f), SkFloatToScalar(1.1f));
+        }
+        serialCanvas.drawPicture(*pictures[i]);
+        SkPictureUtils::DrawParallel(pictures[i], &parallelCanvas, &scheduler, 7);
+
+        SkAutoLockPixels serialLock(serial), parallelLock(parallel);
+        REPORTER_ASSERT(reporter, 0 == memcmp(serial.getPixels(), parallel.getPixels(),
+                                              serial.getSize()));
+
+        // The caller's clones can be reused from one draw to the next.
+        SkPicture clones[3];
+        pictures[i]->clone(clones, SK_ARRAY_COUNT(clones));
+        for (int k = 0; k < 2; ++k) {
+            parallel.eraseColor(SK_ColorWHITE);
+            SkPictureUtils::DrawParallel(pictures[i], clones, SK_ARRAY_COUNT(clones),
+                                         &parallelCanvas, &scheduler);
+            REPORTER_ASSERT(reporter, 0 == memcmp(serial.getPixels(), parallel.getPixels(),
+                                                  serial.getSize()));
+        }
+    }
+}
+
+#include "SkGradientShader.h"
+
+// Uses several paints, paths and factories (the gradient), and a nested picture.
+static void draw_shared_content(SkCanvas* canvas) {
+    SkAutoTUnref<SkPicture> nested(SkNEW(SkPicture));
+    SkCanvas* nestedCanvas = nested->beginRecording(40, 40);
+    SkPaint nestedPaint;
+    nestedPaint.setColor(SK_ColorBLUE);
+    nestedCanvas->drawCircle(SkIntToScalar(20), SkIntToScalar(20), SkIntToScalar(15),
+                             nestedPaint);
+    nested->endRecording();
+
+    SkRandom rand;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 20; ++i) {
+        SkPath path;
+        path.moveTo(rand.nextRangeScalar(0, 100), rand.nextRangeScalar(0, 100));
+        path.quadTo(rand.nextRangeScalar(0, 100), rand.nextRangeScalar(0, 100),
+                    rand.nextRangeScalar(0, 100), rand.nextRangeScalar(0, 100));
+        path.close();
+        paint.setColor(rand.nextU() | 0xFF000000);
+        paint.setStrokeWidth(SkIntToScalar(i % 3));
+        paint.setStyle(i & 1 ? SkPaint::kStroke_Style : SkPaint::kFill_Style);
+        canvas->drawPath(path, paint);
+    }
+
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(100), SkIntToScalar(100) } };
+    SkColor colors[] = { SK_ColorRED, SK_ColorGREEN };
+    SkAutoTUnref<SkShader> shader(SkGradientShader::CreateLinear(pts, colors, NULL, 2,
+                                                                 SkShader::kClamp_TileMode));
+    paint.setShader(shader);
+    paint.setStyle(SkPaint::kFill_Style);
+    canvas->drawRect(SkRect::MakeXYWH(10, 60, 80, 30), paint);
+
+    canvas->translate(SkIntToScalar(50), SkIntToScalar(10));
+    canvas->drawPicture(*nested);
+}
+
+static void draw_to_bitmap(SkPicture* picture, SkBitmap* bitmap) {
+    make_bm(bitmap, 100, 100, SK_ColorWHITE, false);
+    SkCanvas canvas(*bitmap);
+    canvas.drawPicture(*picture);
+}
+
+static bool same_bitmaps(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+static void test_create_from_data(skiatest::Reporter* reporter) {
+    SkPicture original;
+    draw_shared_content(original.beginRecording(100, 100));
+    original.endRecording();
+    SkBitmap expected;
+    draw_to_bitmap(&original, &expected);
+
+    SkDynamicMemoryWStream wStream;
+    original.serializeForInPlacePlayback(&wStream);
+    SkAutoDataUnref data(wStream.copyToData());
+
+    SkAutoTUnref<SkPicture> shared(SkPicture::CreateFromData(data));
+    REPORTER_ASSERT(reporter, NULL != shared.get());
+    if (NULL == shared.get()) {
+        return;
+    }
+    // A clone made before anything is decoded, drawn from several threads at once.
+    SkAutoTUnref<SkPicture> clone(shared->clone());
+
+    SkBitmap fromData;
+    draw_to_bitmap(shared, &fromData);
+    REPORTER_ASSERT(reporter, same_bitmaps(expected, fromData));
+
+    // Banding can change anti-aliased edges, so compare against banded playback.
+    SkBitmap expectedBanded, fromClone;
+    make_bm(&expectedBanded, 100, 100, SK_ColorWHITE, false);
+    make_bm(&fromClone, 100, 100, SK_ColorWHITE, false);
+    SkCanvas expectedCanvas(expectedBanded), cloneCanvas(fromClone);
+    SkTaskScheduler scheduler(3);
+    SkPictureUtils::DrawParallel(&original, &expectedCanvas, &scheduler, 4);
+    SkPictureUtils::DrawParallel(clone, &cloneCanvas, &scheduler, 4);
+    REPORTER_ASSERT(reporter, same_bitmaps(expectedBanded, fromClone));
+
+    // Serializing a picture that was played back in place gives back the same bytes.
+    SkDynamicMemoryWStream reStream;
+    SkAutoTUnref<SkPicture> unused(SkPicture::CreateFromData(data));
+    unused->serializeForInPlacePlayback(&reStream);
+    SkAutoDataUnref reData(reStream.copyToData());
+    REPORTER_ASSERT(reporter, data->equals(reData));
+
+    // The same bytes read through a stream.
+    SkMemoryStream stream(data);
+    bool success;
+    SkPicture fromStream(&stream, &success, NULL);
+    REPORTER_ASSERT(reporter, success);
+    SkBitmap streamed;
+    draw_to_bitmap(&fromStream, &streamed);
+    REPORTER_ASSERT(reporter, same_bitmaps(expected, streamed));
+
+    SkAutoDataUnref truncated(SkData::NewSubset(data, 0, 8));
+    REPORTER_ASSERT(reporter, NULL == SkPicture::CreateFromData(truncated));
+    REPORTER_ASSERT(reporter, NULL == SkPicture::CreateFromData(NULL));
+
+    // Data cut off part way through fails to load, whether or not it is shared.
+    SkAutoDataUnref cut(SkData::NewSubset(data, 0, data->size() / 2));
+    REPORTER_ASSERT(reporter, NULL == SkPicture::CreateFromData(cut));
+    SkMemoryStream cutStream(cut);
+    SkPicture fromCutStream(&cutStream, &success, NULL);
+    REPORTER_ASSERT(reporter, !success);
+}
+
+// serialize() still writes (and CreateFromData() still reads) the format from
+// before in-place playback, which only serializeForInPlacePlayback() writes.
+static void test_create_from_data_compatible(skiatest::Reporter* reporter) {
+    SkPicture original;
+    draw_shared_content(original.beginRecording(100, 100));
+    original.endRecording();
+    SkBitmap expected;
+    draw_to_bitmap(&original, &expected);
+
+    SkDynamicMemoryWStream wStream, inPlaceStream;
+    original.serialize(&wStream);
+    original.serializeForInPlacePlayback(&inPlaceStream);
+    SkAutoDataUnref data(wStream.copyToData());
+    SkAutoDataUnref inPlaceData(inPlaceStream.copyToData());
+    REPORTER_ASSERT(reporter, 10 == *(const uint32_t*)data->data());
+    REPORTER_ASSERT(reporter, 11 == *(const uint32_t*)inPlaceData->data());
+
+    SkAutoTUnref<SkPicture> fromData(SkPicture::CreateFromData(data));
+    REPORTER_ASSERT(reporter, NULL != fromData.get());
+    if (NULL != fromData.get()) {
+        SkBitmap actual;
+        draw_to_bitmap(fromData, &actual);
+        REPORTER_ASSERT(reporter, same_bitmaps(expected, actual));
+
+        SkDynamicMemoryWStream reStream;
+        fromData->serialize(&reStream);
+        SkAutoDataUnref reData(reStream.copyToData());
+        REPORTER_ASSERT(reporter, data->equals(reData));
+    }
+
+    SkAutoDataUnref cut(SkData::NewSubset(data, 0, data->size() / 2));
+    REPORTER_ASSERT(reporter, NULL == SkPicture::CreateFromData(cut));
+}
+
+// Adds a clip that skips to its restore, and a setMatrix, to the shared content.
+static void draw_part_content(SkCanvas* canvas, int part) {
+    draw_shared_content(canvas);
+
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    canvas->save();
+    canvas->clipRect(SkRect::MakeXYWH(-50, -50, 10, 10));
+    canvas->drawRect(SkRect::MakeWH(100, 100), paint);
+    canvas->restore();
+
+    SkMatrix matrix;
+    matrix.setScale(SkIntToScalar(2), SkIntToScalar(1 + part));
+    canvas->setMatrix(matrix);
+    paint.setColor(SkColorSetARGB(0xFF, 0x40 * part, 0x80, 0));
+    canvas->drawRect(SkRect::MakeXYWH(5, 5, 10, 10), paint);
+}
+
+struct RecordPartsContext {
+    SkPictureRecordGroup* fGroup;
+};
+
+static void record_part(RecordPartsContext* context, int part) {
+    draw_part_content(context->fGroup->beginRecording(part, 100, 100), part);
+    context->fGroup->endRecording(part);
+}
+
+static void test_record_group(skiatest::Reporter* reporter) {
+    static const int kPartCount = 4;
+    const SkPoint offsets[kPartCount] = {
+        { 0, 0 }, { SkIntToScalar(100), 0 }, { 0, SkIntToScalar(100) },
+        { SkIntToScalar(100), SkIntToScalar(100) },
+    };
+
+    // Each part drawn on its own, where it goes.
+    SkBitmap expected;
+    make_bm(&expected, 200, 200, SK_ColorWHITE, false);
+    SkCanvas expectedCanvas(expected);
+    for (int i = 0; i < kPartCount; ++i) {
+        SkPicture part;
+        draw_part_content(part.beginRecording(100, 100), i);
+        part.endRecording();
+        expectedCanvas.save();
+        expectedCanvas.translate(offsets[i].fX, offsets[i].fY);
+        expectedCanvas.drawPicture(part);
+        expectedCanvas.restore();
+    }
+
+    SkPictureRecordGroup group(kPartCount);
+    RecordPartsContext context = { &group };
+    SkTaskScheduler scheduler(3);
+    SkParallelFor(&scheduler, kPartCount, record_part, &context);
+    SkAutoTUnref<SkPicture> spliced(group.createSplicedPicture(200, 200, offsets));
+    REPORTER_ASSERT(reporter, 200 == spliced->width() && 200 == spliced->height());
+
+    SkBitmap actual;
+    make_bm(&actual, 200, 200, SK_ColorWHITE, false);
+    SkCanvas actualCanvas(actual);
+    actualCanvas.drawPicture(*spliced);
+    REPORTER_ASSERT(reporter, same_bitmaps(expected, actual));
+
+    // The spliced picture survives a round trip through a stream.
+    SkDynamicMemoryWStream wStream;
+    spliced->serialize(&wStream);
+    SkAutoDataUnref data(wStream.copyToData());
+    SkAutoTUnref<SkPicture> fromData(SkPicture::CreateFromData(data));
+    REPORTER_ASSERT(reporter, NULL != fromData.get());
+    if (NULL != fromData.get()) {
+        SkBitmap reread;
+        make_bm(&reread, 200, 200, SK_ColorWHITE, false);
+        SkCanvas rereadCanvas(reread);
+        rereadCanvas.drawPicture(*fromData);
+        REPORTER_ASSERT(reporter, same_bitmaps(expected, reread));
+    }
+}
+
+// Draws nested five times, moved by whole pixels, and once scaled up.
+static void draw_nested_content(SkCanvas* canvas, SkPicture* nested) {
+    for (int i = 0; i < 5; ++i) {
+        canvas->save();
+        canvas->translate(SkIntToScalar(i * 20), SkIntToScalar(i * 15));
+        canvas->drawPicture(*nested);
+        canvas->restore();
+    }
+    canvas->scale(SkIntToScalar(2), SkIntToScalar(2));
+    canvas->drawPicture(*nested);
+}
+
+static void test_picture_cache(skiatest::Reporter* reporter) {
+    size_t oldLimit = SkGraphics::SetPictureCacheLimit(1024 * 1024);
+    SkGraphics::PurgePictureCache();
+
+    SkPicture nested;
+    SkCanvas* nestedCanvas = nested.beginRecording(20, 20);
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    nestedCanvas->drawRect(SkRect::MakeWH(SkIntToScalar(10), SkIntToScalar(10)), paint);
+    paint.setColor(SK_ColorBLUE);
+    nestedCanvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(10), SkIntToScalar(10),
+                                            SkIntToScalar(10), SkIntToScalar(10)), paint);
+    nested.endRecording();
+
+    SkPicture outer;
+    draw_nested_content(outer.beginRecording(100, 100), &nested);
+    outer.endRecording();
+
+    SkBitmap expected;
+    make_bm(&expected, 100, 100, SK_ColorWHITE, false);
+    SkCanvas expectedCanvas(expected);
+    expectedCanvas.setAllowPictureCache(false);
+    expectedCanvas.drawPicture(outer);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetPictureCacheUsed());
+
+    // The first draw fills the cache, the second one only blits from it.
+    for (int i = 0; i < 2; ++i) {
+        SkBitmap actual;
+        draw_to_bitmap(&outer, &actual);
+        REPORTER_ASSERT(reporter, same_bitmaps(expected, actual));
+        REPORTER_ASSERT(reporter, SkGraphics::GetPictureCacheUsed() > 0);
+    }
+
+    // A copy shares the cached rasters, but recording again does not.
+    SkPicture copy(nested);
+    REPORTER_ASSERT(reporter, nested.uniqueID() == copy.uniqueID());
+    uint32_t oldID = nested.uniqueID();
+    nested.beginRecording(20, 20)->drawColor(SK_ColorGREEN);
+    nested.endRecording();
+    REPORTER_ASSERT(reporter, oldID != nested.uniqueID());
+
+    // A picture which clears can't be composited, so it is never cached.
+    SkGraphics::PurgePictureCache();
+    SkPicture clearing;
+    clearing.beginRecording(20, 20)->clear(SK_ColorTRANSPARENT);
+    clearing.endRecording();
+    SkPicture clearingOuter;
+    draw_nested_content(clearingOuter.beginRecording(100, 100), &clearing);
+    clearingOuter.endRecording();
+    SkBitmap cleared;
+    draw_to_bitmap(&clearingOuter, &cleared);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetPictureCacheUsed());
+
+    // Nor are pictures with device space sprites or region clips, which draw
+    // the same as without the cache.
+    for (int i = 0; i < 2; ++i) {
+        SkGraphics::PurgePictureCache();
+        SkPicture device;
+        SkCanvas* deviceCanvas = device.beginRecording(20, 20);
+        if (0 == i) {
+            SkBitmap sprite;
+            make_bm(&sprite, 6, 6, SK_ColorRED, false);
+            deviceCanvas->drawSprite(sprite, 3, 4, NULL);
+        } else {
+            deviceCanvas->clipRegion(SkRegion(SkIRect::MakeXYWH(3, 4, 6, 6)));
+            deviceCanvas->drawColor(SK_ColorRED);
+        }
+        device.endRecording();
+        SkPicture deviceOuter;
+        draw_nested_content(deviceOuter.beginRecording(100, 100), &device);
+        deviceOuter.endRecording();
+
+        SkBitmap direct;
+        make_bm(&direct, 100, 100, SK_ColorWHITE, false);
+        SkCanvas directCanvas(direct);
+        directCanvas.setAllowPictureCache(false);
+        directCanvas.drawPicture(deviceOuter);
+        SkBitmap actual;
+        draw_to_bitmap(&deviceOuter, &actual);
+        REPORTER_ASSERT(reporter, same_bitmaps(direct, actual));
+        REPORTER_ASSERT(reporter, 0 == SkGraphics::GetPictureCacheUsed());
+    }
+
+    SkGraphics::SetPictureCacheLimit(oldLimit);
+    SkGraphics::PurgePictureCache();
+}
+
 static void TestPicture(skiatest::Reporter* reporter) {
 #ifdef SK_DEBUG
     test_deleting_empty_playback();
@@ -430,6 +824,11 @@ static void TestPicture(skiatest::Reporter* reporter) {
     test_gatherpixelrefs(reporter);
     test_bitmap_with_encoded_data(reporter);
     test_clone_empty(reporter);
+    test_draw_parallel(reporter);
+    test_create_from_data(reporter);
+    test_create_from_data_compatible(reporter);
+    test_record_group(reporter);
+    test_picture_cache(reporter);
 }
 
 #include "TestClassDef.h"
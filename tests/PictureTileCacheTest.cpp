@@ -0,0 +1,180 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkPictureTileCache.h"
+#include "SkTaskScheduler.h"
+
+static const int kWidth = 100;
+static const int kHeight = 80;
+static const int kTileSize = 32;
+static const int kTilesX = (kWidth + kTileSize - 1) / kTileSize;
+static const int kTilesY = (kHeight + kTileSize - 1) / kTileSize;
+static const size_t kTileBytes = kTileSize * kTileSize * sizeof(SkPMColor);
+
+// Records a grid of 10x10 cells with a translucent, antialiased rect across it,
+// so that tile edges cut through blended pixels. (Curves are avoided because
+// clipping chops them into slightly different edges in each tile.) seed only
+// changes the colors of the top row.
+static SkPicture* make_picture(int seed, int width = kWidth, int height = kHeight) {
+    SkPicture* picture = SkNEW(SkPicture);
+    SkCanvas* canvas = picture->beginRecording(width, height);
+    SkPaint paint;
+    for (int y = 0; y < height; y += 10) {
+        for (int x = 0; x < width; x += 10) {
+            int s = 0 == y ? seed : 0;
+            paint.setColor(SkColorSetRGB((x * 2 + s) & 0xFF, y * 3, (x + y + s) & 0xFF));
+            canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(x), SkIntToScalar(y),
+                                              SkIntToScalar(10), SkIntToScalar(10)), paint);
+        }
+    }
+    paint.setAntiAlias(true);
+    paint.setColor(0x80000000);
+    canvas->drawRect(SkRect::MakeLTRB(SkFloatToScalar(10.5f), SkFloatToScalar(20.25f),
+                                      SkFloatToScalar(90.75f), SkFloatToScalar(60.5f)), paint);
+    picture->endRecording();
+    return picture;
+}
+
+static void alloc_bitmap(SkBitmap* bitmap) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, kWidth, kHeight);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorWHITE);
+}
+
+static bool same_bitmaps(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Draws the cache into a fresh bitmap, checks that it matches drawing the
+// picture into a transparent layer (as each tile is), and returns how many
+// tiles were rendered.
+static int check_draw(skiatest::Reporter* reporter, SkPictureTileCache* cache) {
+    SkBitmap expected;
+    alloc_bitmap(&expected);
+    SkCanvas expectedCanvas(expected);
+    expectedCanvas.saveLayer(NULL, NULL);
+    expectedCanvas.drawPicture(*cache->getPicture());
+    expectedCanvas.restore();
+
+    SkBitmap actual;
+    alloc_bitmap(&actual);
+    SkCanvas actualCanvas(actual);
+    int rendered = cache->draw(&actualCanvas);
+    REPORTER_ASSERT(reporter, same_bitmaps(expected, actual));
+    return rendered;
+}
+
+static void test_invalidate(skiatest::Reporter* reporter, SkTaskScheduler* scheduler) {
+    SkPictureTileCache cache(kTileSize, kTileSize, 64 * kTileBytes, scheduler);
+    SkAutoTUnref<SkPicture> picture(make_picture(0));
+    cache.setPicture(picture);
+    REPORTER_ASSERT(reporter, 0 == cache.getBytesUsed());
+
+    REPORTER_ASSERT(reporter, kTilesX * kTilesY == check_draw(reporter, &cache));
+    REPORTER_ASSERT(reporter, 0 == check_draw(reporter, &cache));
+    const size_t bytesUsed = cache.getBytesUsed();
+    REPORTER_ASSERT(reporter, bytesUsed == (size_t)(kWidth * kHeight * sizeof(SkPMColor)));
+
+    // A rect inside one tile, one across the corner of four, and one outside
+    // the picture.
+    cache.invalidate(SkIRect::MakeXYWH(5, 5, 10, 10));
+    REPORTER_ASSERT(reporter, 1 == check_draw(reporter, &cache));
+    cache.invalidate(SkIRect::MakeXYWH(kTileSize - 1, kTileSize - 1, 2, 2));
+    REPORTER_ASSERT(reporter, 4 == check_draw(reporter, &cache));
+    cache.invalidate(SkIRect::MakeXYWH(kWidth, kHeight, 10, 10));
+    REPORTER_ASSERT(reporter, 0 == check_draw(reporter, &cache));
+
+    // Only the tiles touching the change are rendered from the new picture.
+    SkAutoTUnref<SkPicture> changed(make_picture(40));
+    cache.replacePicture(changed, SkIRect::MakeWH(kWidth, 10));
+    REPORTER_ASSERT(reporter, kTilesX == check_draw(reporter, &cache));
+
+    // A new picture of the same size renders every tile again, into the same pixels.
+    cache.setPicture(picture);
+    REPORTER_ASSERT(reporter, kTilesX * kTilesY == check_draw(reporter, &cache));
+    REPORTER_ASSERT(reporter, bytesUsed == cache.getBytesUsed());
+
+    // One of another size starts over.
+    SkAutoTUnref<SkPicture> resized(make_picture(0, kWidth / 2, kHeight));
+    cache.setPicture(resized);
+    REPORTER_ASSERT(reporter, 0 == cache.getBytesUsed());
+}
+
+static void test_partial_draw(skiatest::Reporter* reporter) {
+    SkPictureTileCache cache(kTileSize, kTileSize, 64 * kTileBytes);
+    SkAutoTUnref<SkPicture> picture(make_picture(0));
+    cache.setPicture(picture);
+
+    SkBitmap bitmap;
+    alloc_bitmap(&bitmap);
+    SkCanvas canvas(bitmap);
+    REPORTER_ASSERT(reporter, 1 == cache.draw(&canvas, SkIRect::MakeXYWH(1, 1, 10, 10)));
+    REPORTER_ASSERT(reporter, 1 == cache.draw(&canvas, SkIRect::MakeXYWH(1, 1, kTileSize, 10)));
+    REPORTER_ASSERT(reporter, 0 == cache.draw(&canvas, SkIRect::MakeXYWH(kWidth, 0, 10, 10)));
+    // Only the pixels of the area are drawn.
+    REPORTER_ASSERT(reporter, SK_ColorWHITE == bitmap.getColor(0, 0));
+    REPORTER_ASSERT(reporter, SK_ColorWHITE == bitmap.getColor(kTileSize + 1, 1));
+    REPORTER_ASSERT(reporter, SK_ColorWHITE != bitmap.getColor(kTileSize, 1));
+
+    // Tiles the canvas clips out are skipped.
+    canvas.clipRect(SkRect::MakeXYWH(0, SkIntToScalar(kTileSize), SkIntToScalar(10),
+                                     SkIntToScalar(10)));
+    REPORTER_ASSERT(reporter, 1 == cache.draw(&canvas));
+    REPORTER_ASSERT(reporter, 3 * kTileBytes == cache.getBytesUsed());
+}
+
+static void test_byte_limit(skiatest::Reporter* reporter) {
+    SkPictureTileCache cache(kTileSize, kTileSize, 3 * kTileBytes);
+    SkAutoTUnref<SkPicture> picture(make_picture(0));
+    cache.setPicture(picture);
+
+    SkBitmap bitmap;
+    alloc_bitmap(&bitmap);
+    SkCanvas canvas(bitmap);
+    // Four tiles of full size, the first of which is the least recently drawn
+    // when the last one needs room.
+    const SkIRect tiles[] = {
+        SkIRect::MakeXYWH(0, 0, kTileSize, kTileSize),
+        SkIRect::MakeXYWH(kTileSize, 0, kTileSize, kTileSize),
+        SkIRect::MakeXYWH(0, kTileSize, kTileSize, kTileSize),
+        SkIRect::MakeXYWH(kTileSize, kTileSize, kTileSize, kTileSize),
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(tiles); ++i) {
+        REPORTER_ASSERT(reporter, 1 == cache.draw(&canvas, tiles[i]));
+        REPORTER_ASSERT(reporter, cache.getBytesUsed() <= 3 * kTileBytes);
+    }
+    REPORTER_ASSERT(reporter, 3 * kTileBytes == cache.getBytesUsed());
+    REPORTER_ASSERT(reporter, 0 == cache.draw(&canvas, tiles[1]));
+    // Making room for tiles[0] again evicts tiles[2], now the least recently drawn.
+    REPORTER_ASSERT(reporter, 1 == cache.draw(&canvas, tiles[0]));
+    REPORTER_ASSERT(reporter, 0 == cache.draw(&canvas, tiles[1]));
+    REPORTER_ASSERT(reporter, 1 == cache.draw(&canvas, tiles[2]));
+
+    // An area bigger than the limit is still drawn whole, then trimmed.
+    REPORTER_ASSERT(reporter, kTilesX * kTilesY - 3 == check_draw(reporter, &cache));
+    REPORTER_ASSERT(reporter, cache.getBytesUsed() <= 3 * kTileBytes);
+
+    REPORTER_ASSERT(reporter, 3 * kTileBytes == cache.setByteLimit(kTileBytes));
+    REPORTER_ASSERT(reporter, cache.getBytesUsed() <= kTileBytes);
+    cache.purge();
+    REPORTER_ASSERT(reporter, 0 == cache.getBytesUsed());
+}
+
+static void TestPictureTileCache(skiatest::Reporter* reporter) {
+    test_invalidate(reporter, NULL);
+    SkTaskScheduler scheduler(3);
+    test_invalidate(reporter, &scheduler);
+    test_partial_draw(reporter);
+    test_byte_limit(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PictureTileCache", PictureTileCacheTestClass, TestPictureTileCache)
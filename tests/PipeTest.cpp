@@ -12,6 +12,8 @@
 #include "SkGPipe.h"
 #include "SkPaint.h"
 #include "SkShader.h"
+#include "SkSharedPipe.h"
+#include "SkThreadUtils.h"
 #include "Test.h"
 
 // Ensures that the pipe gracefully handles drawing an invalid bitmap.
@@ -43,7 +45,102 @@ static void testDrawingAfterEndRecording(SkCanvas* canvas) {
     pipeCanvas->drawBitmap(bm, 0, 0);
 }
 
-static void test_pipeTests(skiatest::Reporter*) {
+static const int kSharedPipeSize = 128;
+
+// Draws enough, with a bitmap flattened into the stream now and then, to wrap
+// around a small ring several times.
+static void draw_shared_pipe_content(SkCanvas* canvas) {
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, 40, 40);
+    bm.allocPixels();
+    SkPaint paint;
+    for (int i = 0; i < 2000; ++i) {
+        if (0 == i % 200) {
+            bm.eraseColor(SkColorSetRGB(i & 0xFF, 0x80, 0));
+            bm.notifyPixelsChanged();
+            canvas->drawBitmap(bm, SkIntToScalar(i % 87), SkIntToScalar(i % 83));
+        }
+        paint.setColor(SkColorSetARGB(0x80, (i * 7) & 0xFF, (i * 13) & 0xFF, (i * 29) & 0xFF));
+        paint.setStrokeWidth(SkIntToScalar(i % 5));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i % 97), SkIntToScalar(i % 101),
+                                          SkIntToScalar(i % 31), SkIntToScalar(i % 29)), paint);
+    }
+}
+
+struct SharedPipeReaderState {
+    void*                   fMemory;
+    SkCanvas*               fCanvas;
+    SkGPipeReader::Status   fStatus;
+};
+
+static void read_shared_pipe(void* data) {
+    SharedPipeReaderState* state = static_cast<SharedPipeReaderState*>(data);
+    SkSharedPipeReader reader(state->fMemory, state->fCanvas);
+    state->fStatus = reader.playback();
+}
+
+static void alloc_shared_pipe_bitmap(SkBitmap* bitmap) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, kSharedPipeSize, kSharedPipeSize);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorWHITE);
+}
+
+// Plays the content back through a shared memory ring on another thread, and
+// checks that it draws the same as drawing it directly.
+static void test_shared_pipe(skiatest::Reporter* reporter, size_t capacity) {
+    SkBitmap expected;
+    alloc_shared_pipe_bitmap(&expected);
+    SkCanvas expectedCanvas(expected);
+    draw_shared_pipe_content(&expectedCanvas);
+
+    SkBitmap actual;
+    alloc_shared_pipe_bitmap(&actual);
+    SkCanvas actualCanvas(actual);
+
+    const size_t size = SkSharedPipeController::MemorySize(capacity);
+    SkAutoMalloc memory(size);
+    SharedPipeReaderState state;
+    state.fMemory = memory.get();
+    state.fCanvas = &actualCanvas;
+    state.fStatus = SkGPipeReader::kError_Status;
+    {
+        SkSharedPipeController controller(memory.get(), size);
+        SkThread readerThread(read_shared_pipe, &state);
+        REPORTER_ASSERT(reporter, readerThread.start());
+
+        SkGPipeWriter writer;
+        SkCanvas* pipeCanvas = writer.startRecording(&controller,
+                                                     SkGPipeWriter::kCrossProcess_Flag);
+        draw_shared_pipe_content(pipeCanvas);
+        writer.endRecording();
+        readerThread.join();
+    }
+
+    REPORTER_ASSERT(reporter, SkGPipeReader::kDone_Status == state.fStatus);
+    SkAutoLockPixels alpe(expected), alpa(actual);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+}
+
+// A writer which closes before finishing its stream leaves the reader with an
+// error rather than waiting forever.
+static void test_shared_pipe_close(skiatest::Reporter* reporter) {
+    SkBitmap bitmap;
+    alloc_shared_pipe_bitmap(&bitmap);
+    SkCanvas canvas(bitmap);
+
+    const size_t size = SkSharedPipeController::MemorySize(64 * 1024);
+    SkAutoMalloc memory(size);
+    SkSharedPipeController controller(memory.get(), size);
+    SkSharedPipeReader reader(memory.get(), &canvas);
+    REPORTER_ASSERT(reporter, SkGPipeReader::kEOF_Status == reader.playbackAvailable());
+
+    size_t actual;
+    REPORTER_ASSERT(reporter, NULL == controller.requestBlock(128 * 1024, &actual));
+    REPORTER_ASSERT(reporter, SkGPipeReader::kError_Status == reader.playback());
+}
+
+static void test_pipeTests(skiatest::Reporter* reporter) {
     SkBitmap bitmap;
     bitmap.setConfig(SkBitmap::kARGB_8888_Config, 64, 64);
     SkCanvas canvas(bitmap);
@@ -55,6 +152,11 @@ static void test_pipeTests(skiatest::Reporter*) {
     writer.endRecording();
 
     testDrawingAfterEndRecording(&canvas);
+
+    // Big enough to hold every command at once, and small enough to wrap often.
+    test_shared_pipe(reporter, 1024 * 1024);
+    test_shared_pipe(reporter, 32 * 1024);
+    test_shared_pipe_close(reporter);
 }
 
 #include "TestClassDef.h"
@@ -78,6 +78,21 @@ static void runQueries(skiatest::Reporter* reporter, SkMWCRandom& rand, DataRect
     }
 }
 
+static void runBatchedQueries(skiatest::Reporter* reporter, SkMWCRandom& rand, DataRect rects[],
+                              SkRTree& tree) {
+    // More queries than fit in one walk of the tree
+    static const int kBatchCount = 40;
+    SkIRect queries[kBatchCount];
+    SkTDArray<void*> hits[kBatchCount];
+    for (int i = 0; i < kBatchCount; ++i) {
+        queries[i] = random_rect(rand);
+    }
+    tree.searchBatch(queries, kBatchCount, hits);
+    for (int i = 0; i < kBatchCount; ++i) {
+        REPORTER_ASSERT(reporter, verify_query(queries[i], rects, hits[i]));
+    }
+}
+
 static void TestRTree(skiatest::Reporter* reporter) {
     DataRect rects[NUM_RECTS];
     SkMWCRandom rand;
@@ -110,12 +125,42 @@ static void TestRTree(skiatest::Reporter* reporter) {
             rtree->insert(rects[i].data, rects[i].rect, true);
         }
         rtree->flushDeferredInserts();
+        REPORTER_ASSERT(reporter, rtree->isPacked());
         runQueries(reporter, rand, rects, *rtree);
+        runBatchedQueries(reporter, rand, rects, *rtree);
         REPORTER_ASSERT(reporter, NUM_RECTS == rtree->getCount());
         REPORTER_ASSERT(reporter, expectedDepthMin <= rtree->getDepth() &&
                                   expectedDepthMax >= rtree->getDepth());
         rtree->clear();
         REPORTER_ASSERT(reporter, 0 == rtree->getCount());
+        REPORTER_ASSERT(reporter, !rtree->isPacked());
+
+        // Then a bulk-load that is left unpacked, which should give the same tree
+        rtree->setPackBulkLoads(false);
+        for (int i = 0; i < NUM_RECTS; ++i) {
+            rtree->insert(rects[i].data, rects[i].rect, true);
+        }
+        rtree->flushDeferredInserts();
+        REPORTER_ASSERT(reporter, !rtree->isPacked());
+        runQueries(reporter, rand, rects, *rtree);
+        runBatchedQueries(reporter, rand, rects, *rtree);
+        rtree->clear();
+        rtree->setPackBulkLoads(true);
+
+        // Then a bulk-load of the first half, with the second half inserted into it afterwards,
+        // which unpacks it
+        for (int i = 0; i < NUM_RECTS / 2; ++i) {
+            rtree->insert(rects[i].data, rects[i].rect, true);
+        }
+        rtree->flushDeferredInserts();
+        REPORTER_ASSERT(reporter, rtree->isPacked());
+        for (int i = NUM_RECTS / 2; i < NUM_RECTS; ++i) {
+            rtree->insert(rects[i].data, rects[i].rect);
+        }
+        REPORTER_ASSERT(reporter, !rtree->isPacked());
+        runQueries(reporter, rand, rects, *rtree);
+        REPORTER_ASSERT(reporter, NUM_RECTS == rtree->getCount());
+        rtree->clear();
 
         // Then try immediate inserts
         for (int i = 0; i < NUM_RECTS; ++i) {
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkPicture.h"
+#include "SkRandom.h"
+#include "SkSegmentedPicture.h"
+#include "SkStream.h"
+
+static const int kWidth = 120;
+static const int kHeight = 100;
+
+static void make_bitmap(SkBitmap* bitmap, int width, int height) {
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, width, height);
+    bitmap->allocPixels();
+    bitmap->eraseColor(SK_ColorWHITE);
+}
+
+static void draw_rects(SkCanvas* canvas, SkRandom* rand, SkPaint* paint, int count) {
+    for (int i = 0; i < count; ++i) {
+        paint->setColor(rand->nextU() | 0xFF000000);
+        canvas->drawRect(SkRect::MakeXYWH(rand->nextRangeScalar(0, kWidth - 30),
+                                          rand->nextRangeScalar(0, kHeight - 30),
+                                          SkIntToScalar(8), SkIntToScalar(8)), *paint);
+    }
+}
+
+// Draws a run of blocks, each in a save/restore of its own, then more drawing
+// after changing the matrix and clip at the top level, some of it in nested
+// saves with anti-aliased and device space clips, and some in a layer.
+static void draw_content(SkCanvas* canvas) {
+    SkBitmap tile;
+    tile.setConfig(SkBitmap::kARGB_8888_Config, 8, 8);
+    tile.allocPixels();
+    tile.eraseColor(SK_ColorGREEN);
+
+    SkRandom rand;
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 60; ++i) {
+        canvas->save();
+        canvas->translate(rand.nextRangeScalar(0, kWidth - 20),
+                          rand.nextRangeScalar(0, kHeight - 20));
+        canvas->clipRect(SkRect::MakeWH(SkIntToScalar(18), SkIntToScalar(18)));
+        paint.setColor(rand.nextU() | 0xFF000000);
+        SkPath path;
+        path.addCircle(SkIntToScalar(10), SkIntToScalar(10), SkIntToScalar(9));
+        canvas->drawPath(path, paint);
+        if (0 == i % 4) {
+            canvas->drawBitmap(tile, SkIntToScalar(4), SkIntToScalar(4), NULL);
+        }
+        canvas->restore();
+    }
+
+    canvas->translate(SkIntToScalar(10), SkIntToScalar(10));
+    canvas->clipRect(SkRect::MakeWH(SkIntToScalar(kWidth - 15), SkIntToScalar(kHeight - 15)));
+    draw_rects(canvas, &rand, &paint, 20);
+
+    canvas->save();
+    canvas->rotate(SkIntToScalar(15));
+    SkPath circle;
+    circle.addCircle(SkIntToScalar(50), SkIntToScalar(35), SkIntToScalar(35));
+    canvas->clipPath(circle, SkRegion::kIntersect_Op, true);
+    draw_rects(canvas, &rand, &paint, 20);
+    canvas->save();
+    canvas->scale(SkFloatToScalar(1.5f), SkFloatToScalar(0.75f));
+    canvas->clipRegion(SkRegion(SkIRect::MakeXYWH(0, 0, kWidth - 30, kHeight)));
+    draw_rects(canvas, &rand, &paint, 20);
+    canvas->restore();
+    draw_rects(canvas, &rand, &paint, 20);
+    canvas->restore();
+
+    // The clip made in a save that only saves the matrix outlives it.
+    canvas->save(SkCanvas::kMatrix_SaveFlag);
+    canvas->clipRect(SkRect::MakeXYWH(0, SkIntToScalar(10), SkIntToScalar(kWidth),
+                                      SkIntToScalar(kHeight - 40)),
+                     SkRegion::kDifference_Op);
+    canvas->translate(SkIntToScalar(5), 0);
+    draw_rects(canvas, &rand, &paint, 10);
+    canvas->restore();
+
+    SkPaint layerPaint;
+    layerPaint.setAlpha(0x80);
+    canvas->saveLayer(NULL, &layerPaint);
+    draw_rects(canvas, &rand, &paint, 20);
+    canvas->restore();
+
+    draw_rects(canvas, &rand, &paint, 20);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+static SkData* write_segmented(size_t segmentSize, int* segmentCount) {
+    SkDynamicMemoryWStream stream;
+    SkSegmentedPictureWriter writer(&stream, kWidth, kHeight, segmentSize);
+    draw_content(&writer);
+    writer.finish();
+    *segmentCount = writer.segmentCount();
+    return stream.copyToData();
+}
+
+static void test_segmented_picture(skiatest::Reporter* reporter) {
+    SkPicture picture;
+    draw_content(picture.beginRecording(kWidth, kHeight));
+    picture.endRecording();
+    SkBitmap expected;
+    make_bitmap(&expected, kWidth, kHeight);
+    SkCanvas expectedCanvas(expected);
+    expectedCanvas.drawPicture(picture);
+
+    int segmentCount;
+    SkAutoDataUnref data(write_segmented(1024, &segmentCount));
+    REPORTER_ASSERT(reporter, segmentCount > 8);
+
+    {
+        SkMemoryStream stream(data);
+        SkSegmentedPictureReader reader(&stream);
+        REPORTER_ASSERT(reporter, reader.isValid());
+        REPORTER_ASSERT(reporter, kWidth == reader.width() && kHeight == reader.height());
+
+        SkBitmap bitmap;
+        make_bitmap(&bitmap, kWidth, kHeight);
+        SkCanvas canvas(bitmap);
+        REPORTER_ASSERT(reporter, reader.draw(&canvas));
+        REPORTER_ASSERT(reporter, 1 == canvas.getSaveCount());
+        REPORTER_ASSERT(reporter, same_pixels(expected, bitmap));
+    }
+
+    {
+        SkMemoryStream stream(data);
+        SkSegmentedPictureReader reader(&stream);
+        int count = 0;
+        while (SkPicture* segment = reader.readSegment()) {
+            segment->unref();
+            count++;
+        }
+        REPORTER_ASSERT(reporter, segmentCount == count);
+    }
+
+    // With the smallest segments, a cut is made before every call outside the
+    // layer, whatever the state, and the segments still draw the same.
+    {
+        int tinyCount;
+        SkAutoDataUnref tiny(write_segmented(1, &tinyCount));
+        REPORTER_ASSERT(reporter, tinyCount > 300);
+        SkMemoryStream stream(tiny);
+        SkSegmentedPictureReader reader(&stream);
+        SkBitmap bitmap;
+        make_bitmap(&bitmap, kWidth, kHeight);
+        SkCanvas canvas(bitmap);
+        REPORTER_ASSERT(reporter, reader.draw(&canvas));
+        REPORTER_ASSERT(reporter, 1 == canvas.getSaveCount());
+        REPORTER_ASSERT(reporter, same_pixels(expected, bitmap));
+    }
+
+    // A segment size bigger than the whole picture gives a single segment.
+    SkAutoDataUnref single(write_segmented(SkSegmentedPictureWriter::kDefaultSegmentSize,
+                                           &segmentCount));
+    REPORTER_ASSERT(reporter, 1 == segmentCount);
+
+    // A truncated stream draws what it can, and reports the failure.
+    SkAutoDataUnref truncated(SkData::NewSubset(data, 0, data->size() / 2));
+    SkMemoryStream truncatedStream(truncated);
+    SkSegmentedPictureReader truncatedReader(&truncatedStream);
+    REPORTER_ASSERT(reporter, truncatedReader.isValid());
+    SkBitmap bitmap;
+    make_bitmap(&bitmap, kWidth, kHeight);
+    SkCanvas canvas(bitmap);
+    REPORTER_ASSERT(reporter, !truncatedReader.draw(&canvas));
+
+    SkMemoryStream notSegmented(data->bytes() + 4, data->size() - 4);
+    SkSegmentedPictureReader badReader(&notSegmented);
+    REPORTER_ASSERT(reporter, !badReader.isValid());
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("SegmentedPicture", SegmentedPictureTestClass, test_segmented_picture)
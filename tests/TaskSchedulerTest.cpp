@@ -0,0 +1,143 @@
+/*
+ * Copyright 2013 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkRunnable.h"
+#include "SkTaskScheduler.h"
+#include "SkTemplates.h"
+#include "SkThread.h"
+
+namespace {
+
+class AddOne : public SkRunnable {
+public:
+    AddOne() : fCounter(NULL), fRuns(0) {}
+
+    virtual void run() SK_OVERRIDE {
+        sk_atomic_inc(fCounter);
+        fRuns++;
+    }
+
+    int32_t* fCounter;
+    int      fRuns;
+};
+
+// Adds a group of children from inside a task and waits for them, exercising helping waits.
+class Spawner : public SkRunnable {
+public:
+    Spawner() : fScheduler(NULL), fCounter(NULL) {}
+
+    virtual void run() SK_OVERRIDE {
+        AddOne children[8];
+        SkTaskGroup group(fScheduler);
+        for (size_t i = 0; i < SK_ARRAY_COUNT(children); i++) {
+            children[i].fCounter = fCounter;
+            group.add(&children[i]);
+        }
+        group.wait();
+    }
+
+    SkTaskScheduler* fScheduler;
+    int32_t*         fCounter;
+};
+
+}  // namespace
+
+static void square(int* values, int index) {
+    values[index] = index * index;
+}
+
+static void test_scheduler(skiatest::Reporter* reporter, int threadCount) {
+    SkTaskScheduler scheduler(threadCount);
+    REPORTER_ASSERT(reporter, threadCount == scheduler.countThreads());
+
+    // Single adds, every runnable runs exactly once.
+    {
+        static const int kCount = 500;
+        int32_t counter = 0;
+        SkAutoTArray<AddOne> runnables(kCount);
+        SkTaskGroup group(&scheduler);
+        for (int i = 0; i < kCount; i++) {
+            runnables[i].fCounter = &counter;
+            group.add(&runnables[i]);
+        }
+        group.add(NULL);
+        group.wait();
+        REPORTER_ASSERT(reporter, kCount == counter);
+        for (int i = 0; i < kCount; i++) {
+            REPORTER_ASSERT(reporter, 1 == runnables[i].fRuns);
+        }
+    }
+
+    // Batches, including NULL entries, and a group that is reused after waiting.
+    {
+        static const int kCount = 333;
+        int32_t counter = 0;
+        SkAutoTArray<AddOne> runnables(kCount);
+        SkAutoTMalloc<SkRunnable*> batch(kCount);
+        for (int i = 0; i < kCount; i++) {
+            runnables[i].fCounter = &counter;
+            batch[i] = (i % 10 == 0) ? NULL : &runnables[i];
+        }
+        SkTaskGroup group(&scheduler);
+        group.addBatch(batch.get(), kCount);
+        group.wait();
+        group.addBatch(batch.get(), kCount);
+        group.wait();
+        REPORTER_ASSERT(reporter, 2 * (kCount - 34) == counter);
+    }
+
+    // Nested groups waited on from inside the scheduler's own threads.
+    {
+        int32_t counter = 0;
+        Spawner spawners[16];
+        SkTaskGroup group(&scheduler);
+        for (size_t i = 0; i < SK_ARRAY_COUNT(spawners); i++) {
+            spawners[i].fScheduler = &scheduler;
+            spawners[i].fCounter = &counter;
+            group.add(&spawners[i]);
+        }
+        group.wait();
+        REPORTER_ASSERT(reporter, 16 * 8 == counter);
+    }
+
+    // Parallel for, with a grain that does not divide the count.
+    {
+        static const int kCount = 1000;
+        SkAutoTMalloc<int> values(kCount);
+        sk_bzero(values.get(), kCount * sizeof(int));
+        SkParallelFor(&scheduler, kCount, square, values.get(), 7);
+        bool allSquared = true;
+        for (int i = 0; i < kCount; i++) {
+            allSquared &= (i * i == values[i]);
+        }
+        REPORTER_ASSERT(reporter, allSquared);
+    }
+
+    // Work added without a group is still run before the scheduler goes away.
+    {
+        int32_t counter = 0;
+        AddOne runnables[32];
+        {
+            SkTaskScheduler local(threadCount);
+            for (size_t i = 0; i < SK_ARRAY_COUNT(runnables); i++) {
+                runnables[i].fCounter = &counter;
+                local.add(&runnables[i]);
+            }
+        }
+        REPORTER_ASSERT(reporter, 32 == counter);
+    }
+}
+
+static void TestTaskScheduler(skiatest::Reporter* reporter) {
+    test_scheduler(reporter, 0);
+    test_scheduler(reporter, 1);
+    test_scheduler(reporter, 4);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("TaskScheduler", TaskSchedulerTestClass, TestTaskScheduler)
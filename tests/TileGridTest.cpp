@@ -11,6 +11,8 @@
 #include "SkTileGridPicture.h"
 #include "SkCanvas.h"
 #include "SkDevice.h"
+#include "SkPath.h"
+#include "SkRandom.h"
 
 enum Tile {
     kTopLeft_Tile = 0x1,
@@ -45,15 +47,15 @@ public:
         info.fMargin.set(borderPixels, borderPixels);
         info.fOffset.setZero();
         info.fTileInterval.set(10 - 2 * borderPixels, 10 - 2 * borderPixels);
-        SkTileGrid grid(2, 2, info, NULL);
+        SkTileGrid grid(2, 2, info);
         grid.insert(NULL, rect, false);
-        REPORTER_ASSERT(reporter, grid.tile(0,0).count() ==
+        REPORTER_ASSERT(reporter, grid.countTileData(0,0) ==
             ((tileMask & kTopLeft_Tile)? 1 : 0));
-        REPORTER_ASSERT(reporter, grid.tile(1,0).count() ==
+        REPORTER_ASSERT(reporter, grid.countTileData(1,0) ==
             ((tileMask & kTopRight_Tile)? 1 : 0));
-        REPORTER_ASSERT(reporter, grid.tile(0,1).count() ==
+        REPORTER_ASSERT(reporter, grid.countTileData(0,1) ==
             ((tileMask & kBottomLeft_Tile)? 1 : 0));
-        REPORTER_ASSERT(reporter, grid.tile(1,1).count() ==
+        REPORTER_ASSERT(reporter, grid.countTileData(1,1) ==
             ((tileMask & kBottomRight_Tile)? 1 : 0));
     }
 
@@ -228,6 +230,183 @@ public:
         }
     }
 
+    enum OcclusionCase {
+        kOpaque_OcclusionCase,
+        kTranslucent_OcclusionCase,
+        kPathClip_OcclusionCase,
+        kLayer_OcclusionCase,
+        kRotated_OcclusionCase,
+
+        kLast_OcclusionCase = kRotated_OcclusionCase
+    };
+
+    // Records a rect in the top left tile, then a background over the top row of tiles and a
+    // rect on top of it, and returns the rects drawn when playing back the top left tile.
+    static void DrawOcclusionCase(OcclusionCase occlusionCase, SkIRect query,
+                                  SkTDArray<SkRect>* rects) {
+        SkTileGridPicture::TileGridInfo info;
+        info.fMargin.setEmpty();
+        info.fOffset.setZero();
+        info.fTileInterval.set(10, 10);
+        SkTileGridPicture picture(20, 20, info);
+        SkCanvas* canvas = picture.beginRecording(20, 20,
+            SkPicture::kOptimizeForClippedPlayback_RecordingFlag |
+            SkPicture::kCullOccludedDraws_RecordingFlag);
+        SkPaint paint;
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(1), SkIntToScalar(1),
+                                          SkIntToScalar(3), SkIntToScalar(3)), paint);
+        canvas->save();
+        SkPaint backgroundPaint;
+        switch (occlusionCase) {
+            case kOpaque_OcclusionCase:
+                break;
+            case kTranslucent_OcclusionCase:
+                backgroundPaint.setAlpha(0x80);
+                break;
+            case kPathClip_OcclusionCase: {
+                SkPath path;
+                path.addCircle(SkIntToScalar(10), SkIntToScalar(10), SkIntToScalar(10));
+                canvas->clipPath(path);
+                break;
+            }
+            case kLayer_OcclusionCase:
+                canvas->saveLayer(NULL, NULL);
+                break;
+            case kRotated_OcclusionCase:
+                canvas->rotate(SkIntToScalar(1));
+                break;
+        }
+        canvas->drawRect(SkRect::MakeWH(SkIntToScalar(20), SkIntToScalar(12)), backgroundPaint);
+        canvas->restoreToCount(1);
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(2), SkIntToScalar(2),
+                                          SkIntToScalar(3), SkIntToScalar(3)), paint);
+        picture.endRecording();
+
+        SkBitmap store;
+        store.setConfig(SkBitmap::kARGB_8888_Config, query.width(), query.height());
+        store.allocPixels();
+        SkDevice device(store);
+        MockCanvas mockCanvas(&device);
+        mockCanvas.translate(SkIntToScalar(-query.fLeft), SkIntToScalar(-query.fTop));
+        picture.draw(&mockCanvas);
+        *rects = mockCanvas.fRects;
+    }
+
+    static void TestOccludedDraws(skiatest::Reporter* reporter) {
+        SkTDArray<SkRect> rects;
+        for (int i = 0; i <= kLast_OcclusionCase; ++i) {
+            OcclusionCase occlusionCase = static_cast<OcclusionCase>(i);
+            SkTileGridPicture::ResetOccludedDrawCount();
+            DrawOcclusionCase(occlusionCase, SkIRect::MakeWH(10, 10), &rects);
+            if (kOpaque_OcclusionCase == occlusionCase) {
+                // The first rect is hidden by the background.
+                REPORTER_ASSERT(reporter, 2 == rects.count());
+                REPORTER_ASSERT(reporter, 1 == SkTileGridPicture::GetOccludedDrawCount());
+            } else {
+                REPORTER_ASSERT(reporter, 3 == rects.count());
+                REPORTER_ASSERT(reporter, 0 == SkTileGridPicture::GetOccludedDrawCount());
+            }
+        }
+
+        // A query covering several tiles.
+        DrawOcclusionCase(kOpaque_OcclusionCase, SkIRect::MakeWH(20, 20), &rects);
+        REPORTER_ASSERT(reporter, 2 == rects.count());
+
+        // Part of the top left tile the background does not cover is visible.
+        DrawOcclusionCase(kOpaque_OcclusionCase, SkIRect::MakeXYWH(-5, 0, 10, 10), &rects);
+        REPORTER_ASSERT(reporter, 3 == rects.count());
+    }
+
+    class RewindClient : public SkBBoxHierarchyClient {
+    public:
+        RewindClient(intptr_t from) : fFrom(from) {}
+        virtual bool shouldRewind(void* data) SK_OVERRIDE {
+            return reinterpret_cast<intptr_t>(data) >= fFrom;
+        }
+    private:
+        intptr_t fFrom;
+    };
+
+    // Checks a search of the tiles in 'tiles' (right and bottom exclusive) against the data
+    // whose tile ranges include any of them, in insertion order.
+    static void verifyTilesSearch(skiatest::Reporter* reporter, SkTileGrid& grid,
+                                  const SkTDArray<SkIRect>& dataTiles, const SkIRect& tiles) {
+        SkTDArray<void*> expected;
+        for (int i = 0; i < dataTiles.count(); ++i) {
+            if (SkIRect::Intersects(dataTiles[i], tiles)) {
+                expected.push(reinterpret_cast<void*>(i + 1));
+            }
+        }
+        SkTDArray<void*> found;
+        grid.search(SkIRect::MakeLTRB(tiles.fLeft * 10, tiles.fTop * 10,
+                                      tiles.fRight * 10, tiles.fBottom * 10), &found);
+        REPORTER_ASSERT(reporter, expected == found);
+    }
+
+    static void TestHierarchy(skiatest::Reporter* reporter) {
+        static const int kTileCount = 7;
+        SkTileGridPicture::TileGridInfo info;
+        info.fMargin.setEmpty();
+        info.fOffset.setZero();
+        info.fTileInterval.set(10, 10);
+        SkTileGrid grid(kTileCount, kTileCount, info);
+
+        // Data at all sorts of sizes, with runs of data in the same tiles.
+        SkMWCRandom rand;
+        SkTDArray<SkIRect> dataTiles;
+        for (int i = 0; dataTiles.count() < 300; ++i) {
+            SkIRect tiles;
+            if (0 == i % 30) {
+                tiles.setLTRB(0, 0, kTileCount, kTileCount);
+            } else {
+                int x = rand.nextULessThan(kTileCount);
+                int y = rand.nextULessThan(kTileCount);
+                int size = (i % 5) ? 1 : 1 + rand.nextULessThan(kTileCount);
+                tiles.setLTRB(x, y, SkMin32(x + size, kTileCount), SkMin32(y + size, kTileCount));
+            }
+            for (int j = 0; j <= i % 3; ++j) {
+                // Inset by the margin and the antialiasing provision.
+                SkIRect bounds = SkIRect::MakeLTRB(tiles.fLeft * 10 + 2, tiles.fTop * 10 + 2,
+                                                   tiles.fRight * 10 - 2, tiles.fBottom * 10 - 2);
+                grid.insert(reinterpret_cast<void*>(dataTiles.count() + 1), bounds, false);
+                dataTiles.push(tiles);
+            }
+        }
+        REPORTER_ASSERT(reporter, dataTiles.count() == grid.getCount());
+
+        for (int y = 0; y < kTileCount; ++y) {
+            for (int x = 0; x < kTileCount; ++x) {
+                verifyTilesSearch(reporter, grid, dataTiles, SkIRect::MakeXYWH(x, y, 1, 1));
+            }
+        }
+        verifyTilesSearch(reporter, grid, dataTiles, SkIRect::MakeXYWH(1, 1, 2, 2));
+        verifyTilesSearch(reporter, grid, dataTiles, SkIRect::MakeXYWH(3, 2, 3, 1));
+        verifyTilesSearch(reporter, grid, dataTiles, SkIRect::MakeWH(kTileCount, kTileCount));
+
+        // Rewinding takes the last data out of every level.
+        RewindClient client(dataTiles.count() - 40);
+        grid.setClient(&client);
+        grid.rewindInserts();
+        dataTiles.setCount(dataTiles.count() - 41);
+        REPORTER_ASSERT(reporter, dataTiles.count() == grid.getCount());
+        for (int y = 0; y < kTileCount; ++y) {
+            for (int x = 0; x < kTileCount; ++x) {
+                verifyTilesSearch(reporter, grid, dataTiles, SkIRect::MakeXYWH(x, y, 1, 1));
+            }
+        }
+        verifyTilesSearch(reporter, grid, dataTiles, SkIRect::MakeWH(kTileCount, kTileCount));
+        grid.setClient(NULL);
+
+        // Data covering the whole grid are not stored once per tile.
+        grid.clear();
+        for (int i = 0; i < 1000; ++i) {
+            grid.insert(reinterpret_cast<void*>(i + 1), SkIRect::MakeWH(70, 70), false);
+        }
+        REPORTER_ASSERT(reporter, 1000 == grid.countTileData(3, 4));
+        REPORTER_ASSERT(reporter, grid.getStorageSize() <
+                                  2 * 1000 * sizeof(void*) + 4096);
+    }
+
     static void Test(skiatest::Reporter* reporter) {
         // Out of bounds
         verifyTileHits(reporter, SkIRect::MakeXYWH(30, 0, 1, 1),  0);
@@ -258,6 +437,8 @@ public:
 
         TestUnalignedQuery(reporter);
         TestOverlapOffsetQueryAlignment(reporter);
+        TestOccludedDraws(reporter);
+        TestHierarchy(reporter);
     }
 };
 
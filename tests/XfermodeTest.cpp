@@ -7,6 +7,8 @@
  */
 #include "Test.h"
 #include "SkColor.h"
+#include "SkColorPriv.h"
+#include "SkRandom.h"
 #include "SkXfermode.h"
 
 static SkPMColor bogusXfermodeProc(SkPMColor src, SkPMColor dst) {
@@ -63,9 +65,109 @@ static void test_IsMode(skiatest::Reporter* reporter) {
     }
 }
 
+static SkPMColor random_pmcolor(SkMWCRandom* rand) {
+    // Favor the alphas and channels where the blend modes change branches.
+    static const uint8_t gEdges[] = { 0, 1, 127, 128, 254, 255 };
+    unsigned a;
+    if (rand->nextU() & 1) {
+        a = gEdges[rand->nextULessThan(SK_ARRAY_COUNT(gEdges))];
+    } else {
+        a = rand->nextULessThan(256);
+    }
+    unsigned c[3];
+    for (int i = 0; i < 3; i++) {
+        switch (rand->nextULessThan(4)) {
+            case 0:  c[i] = 0; break;
+            case 1:  c[i] = a; break;
+            default: c[i] = rand->nextULessThan(a + 1); break;
+        }
+    }
+    return SkPackARGB32(a, c[0], c[1], c[2]);
+}
+
+static SkAlpha random_coverage(SkMWCRandom* rand) {
+    switch (rand->nextULessThan(4)) {
+        case 0:  return 0;
+        case 1:  return 0xFF;
+        default: return rand->nextULessThan(256);
+    }
+}
+
+// xfer32 and xferA8 may use platform row procs. Whatever they use, they must
+// match running the mode's SkXfermodeProc over every pixel, bit for bit.
+static void test_rows(skiatest::Reporter* reporter) {
+    static const int kMaxCount = 37;
+
+    SkMWCRandom rand;
+    SkPMColor src[kMaxCount], dst[kMaxCount], expected[kMaxCount];
+    SkAlpha dstA8[kMaxCount], expectedA8[kMaxCount], aa[kMaxCount];
+
+    for (int i = 0; i <= SkXfermode::kLastMode; ++i) {
+        SkXfermode::Mode mode = (SkXfermode::Mode)i;
+        // Clear and Src have their own rows, which round partial coverage
+        // differently from the lerp used with the modeprocs.
+        if (SkXfermode::kClear_Mode == mode || SkXfermode::kSrc_Mode == mode) {
+            continue;
+        }
+        SkXfermode* xfer = SkXfermode::Create(mode);
+        if (NULL == xfer) {
+            continue;
+        }
+        SkXfermodeProc proc = SkXfermode::GetProc(mode);
+
+        for (int count = 0; count <= kMaxCount; ++count) {
+            for (int useAA = 0; useAA <= 1; ++useAA) {
+                for (int j = 0; j < count; ++j) {
+                    src[j] = random_pmcolor(&rand);
+                    dst[j] = random_pmcolor(&rand);
+                    dstA8[j] = SkGetPackedA32(random_pmcolor(&rand));
+                    aa[j] = random_coverage(&rand);
+                }
+                const SkAlpha* coverage = useAA ? aa : NULL;
+
+                for (int j = 0; j < count; ++j) {
+                    unsigned a = coverage ? coverage[j] : 0xFF;
+                    expected[j] = dst[j];
+                    expectedA8[j] = dstA8[j];
+                    if (0 == a) {
+                        continue;
+                    }
+                    SkPMColor C = proc(src[j], dst[j]);
+                    unsigned A = SkGetPackedA32(proc(src[j],
+                                                     (SkPMColor)dstA8[j] << SK_A32_SHIFT));
+                    if (0xFF != a) {
+                        C = SkFourByteInterp(C, dst[j], a);
+                        A = SkAlphaBlend(A, dstA8[j], SkAlpha255To256(a));
+                    }
+                    expected[j] = C;
+                    expectedA8[j] = A;
+                }
+
+                xfer->xfer32(dst, src, count, coverage);
+                xfer->xferA8(dstA8, src, count, coverage);
+
+                bool same32 = true, sameA8 = true;
+                for (int j = 0; j < count; ++j) {
+                    same32 &= (expected[j] == dst[j]);
+                    sameA8 &= (expectedA8[j] == dstA8[j]);
+                }
+                if (!same32 || !sameA8) {
+                    SkString str;
+                    str.printf("%s: xfer%s differs from its SkXfermodeProc, count %d%s",
+                               SkXfermode::ModeName(mode), same32 ? "A8" : "32", count,
+                               useAA ? " with coverage" : "");
+                    reporter->reportFailed(str);
+                }
+            }
+        }
+        xfer->unref();
+    }
+}
+
 static void test_xfermodes(skiatest::Reporter* reporter) {
     test_asMode(reporter);
     test_IsMode(reporter);
+    test_rows(reporter);
 }
 
 #include "TestClassDef.h"
@@ -22,6 +22,7 @@
 #include "SkPicture.h"
 #include "SkRTree.h"
 #include "SkScalar.h"
+#include "SkSharedPipe.h"
 #include "SkStream.h"
 #include "SkString.h"
 #include "SkTemplates.h"
@@ -174,13 +175,15 @@ int PictureRenderer::getViewHeight() {
     return height;
 }
 
-/** Converts fPicture to a picture that uses a BBoxHierarchy.
+/** Converts fPicture to a picture that uses a BBoxHierarchy, and applies
+ *  the record optimizations if they were asked for.
  *  PictureRenderer subclasses that are used to test picture playback
  *  should call this method during init.
  */
 void PictureRenderer::buildBBoxHierarchy() {
     SkASSERT(NULL != fPicture);
-    if (kNone_BBoxHierarchyType != fBBoxHierarchyType && NULL != fPicture) {
+    if ((kNone_BBoxHierarchyType != fBBoxHierarchyType ||
+         kAsRead_RecordOptimizations != fRecordOptimizations) && NULL != fPicture) {
         SkPicture* newPicture = this->createPicture();
         SkCanvas* recorder = newPicture->beginRecording(fPicture->width(), fPicture->height(),
                                                         this->recordFlags());
@@ -207,9 +210,16 @@ void PictureRenderer::resetState(bool callFinish) {
 }
 
 uint32_t PictureRenderer::recordFlags() {
-    return ((kNone_BBoxHierarchyType == fBBoxHierarchyType) ? 0 :
+    uint32_t flags = ((kNone_BBoxHierarchyType == fBBoxHierarchyType) ? 0 :
         SkPicture::kOptimizeForClippedPlayback_RecordingFlag) |
         SkPicture::kUsePathBoundsForClip_RecordingFlag;
+    if (fCullOccludedDraws && kTileGrid_BBoxHierarchyType == fBBoxHierarchyType) {
+        flags |= SkPicture::kCullOccludedDraws_RecordingFlag;
+    }
+    if (kOff_RecordOptimizations == fRecordOptimizations) {
+        flags |= SkPicture::kDisableRecordOptimizations_RecordingFlag;
+    }
+    return flags;
 }
 
 /**
@@ -316,9 +326,67 @@ SkString PipePictureRenderer::getConfigNameInternal() {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
 
+static const size_t kSharedPipeCapacity = 1024 * 1024;
+
+SharedPipePictureRenderer::SharedPipePictureRenderer()
+    : fRing(SkSharedPipeController::MemorySize(kSharedPipeCapacity)) {}
+
+static void play_shared_pipe(void* reader) {
+    static_cast<SkSharedPipeReader*>(reader)->playback();
+}
+
+bool SharedPipePictureRenderer::render(const SkString* path, SkBitmap** out) {
+    SkASSERT(fCanvas.get() != NULL);
+    SkASSERT(fPicture != NULL);
+    if (NULL == fCanvas.get() || NULL == fPicture) {
+        return false;
+    }
+
+    SkSharedPipeController controller(fRing.get(),
+                                      SkSharedPipeController::MemorySize(kSharedPipeCapacity));
+    SkSharedPipeReader reader(fRing.get(), fCanvas.get());
+    SkThread readerThread(play_shared_pipe, &reader);
+    if (!readerThread.start()) {
+        return false;
+    }
+    SkGPipeWriter writer;
+    SkCanvas* pipeCanvas = writer.startRecording(&controller, SkGPipeWriter::kCrossProcess_Flag);
+    pipeCanvas->drawPicture(*fPicture);
+    writer.endRecording();
+    readerThread.join();
+    fCanvas->flush();
+    if (NULL != path) {
+        return write(fCanvas, *path);
+    }
+    if (NULL != out) {
+        *out = SkNEW(SkBitmap);
+        setup_bitmap(*out, fPicture->width(), fPicture->height());
+        fCanvas->readPixels(*out, 0, 0);
+    }
+    return true;
+}
+
+SkString SharedPipePictureRenderer::getConfigNameInternal() {
+    return SkString("shared_pipe");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+// The calling thread draws a band too, so it only needs threadCount - 1 helpers.
+SimplePictureRenderer::SimplePictureRenderer(int threadCount)
+    : fNumThreads(threadCount)
+    , fScheduler(threadCount > 1 ? SkNEW_ARGS(SkTaskScheduler, (threadCount - 1)) : NULL)
+    , fPictureClones(0) {
+}
+
 void SimplePictureRenderer::init(SkPicture* picture) {
     INHERITED::init(picture);
     this->buildBBoxHierarchy();
+    if (NULL != fScheduler.get()) {
+        // Clone after building the hierarchy, so the clones share it.
+        fPictureClones.reset(fNumThreads - 1);
+        fPicture->clone(fPictureClones.get(), fNumThreads - 1);
+    }
 }
 
 bool SimplePictureRenderer::render(const SkString* path, SkBitmap** out) {
@@ -328,7 +396,12 @@ bool SimplePictureRenderer::render(const SkString* path, SkBitmap** out) {
         return false;
     }
 
-    fCanvas->drawPicture(*fPicture);
+    if (NULL != fScheduler.get()) {
+        SkPictureUtils::DrawParallel(fPicture, fPictureClones.get(), fNumThreads - 1, fCanvas,
+                                     fScheduler.get());
+    } else {
+        fCanvas->drawPicture(*fPicture);
+    }
     fCanvas->flush();
     if (NULL != path) {
         return write(fCanvas, *path);
@@ -343,8 +416,17 @@ bool SimplePictureRenderer::render(const SkString* path, SkBitmap** out) {
     return true;
 }
 
+void SimplePictureRenderer::end() {
+    fPictureClones.reset(0);
+    this->INHERITED::end();
+}
+
 SkString SimplePictureRenderer::getConfigNameInternal() {
-    return SkString("simple");
+    SkString name("simple");
+    if (fNumThreads > 1) {
+        name.appendf("_multi_%i_threads", fNumThreads);
+    }
+    return name;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -593,17 +675,14 @@ SkString TiledPictureRenderer::getConfigNameInternal() {
 class CloneData : public SkRunnable {
 
 public:
-    CloneData(SkPicture* clone, SkCanvas* canvas, SkTDArray<SkRect>& rects, int start, int end,
-              SkRunnable* done)
+    CloneData(SkPicture* clone, SkCanvas* canvas, SkTDArray<SkRect>& rects, int start, int end)
         : fClone(clone)
         , fCanvas(canvas)
         , fPath(NULL)
         , fRects(rects)
         , fStart(start)
         , fEnd(end)
-        , fSuccess(NULL)
-        , fDone(done) {
-        SkASSERT(fDone != NULL);
+        , fSuccess(NULL) {
     }
 
     virtual void run() SK_OVERRIDE {
@@ -635,7 +714,6 @@ public:
                 }
             }
         }
-        fDone->run();
     }
 
     void setPathAndSuccess(const SkString* path, bool* success) {
@@ -658,14 +736,12 @@ private:
     const int          fEnd;
     bool*              fSuccess;    // Only meaningful if path is non-null. Shared by all threads,
                                     // and only set to false upon failure to write to a PNG.
-    SkRunnable*        fDone;
     SkBitmap*          fBitmap;
 };
 
 MultiCorePictureRenderer::MultiCorePictureRenderer(int threadCount)
 : fNumThreads(threadCount)
-, fThreadPool(threadCount)
-, fCountdown(threadCount) {
+, fScheduler(threadCount) {
     // Only need to create fNumThreads - 1 clones, since one thread will use the base
     // picture.
     fPictureClones = SkNEW_ARRAY(SkPicture, fNumThreads - 1);
@@ -695,7 +771,7 @@ void MultiCorePictureRenderer::init(SkPicture *pict) {
         const int start = i * chunkSize;
         const int end = SkMin32(start + chunkSize, fTileRects.count());
         fCloneData[i] = SkNEW_ARGS(CloneData,
-                                   (pic, fCanvasPool[i], fTileRects, start, end, &fCountdown));
+                                   (pic, fCanvasPool[i], fTileRects, start, end));
     }
 }
 
@@ -719,11 +795,11 @@ bool MultiCorePictureRenderer::render(const SkString *path, SkBitmap** out) {
         }
     }
 
-    fCountdown.reset(fNumThreads);
+    SkTaskGroup group(&fScheduler);
     for (int i = 0; i < fNumThreads; i++) {
-        fThreadPool.add(fCloneData[i]);
+        group.add(fCloneData[i]);
     }
-    fCountdown.wait();
+    group.wait();
 
     return success;
 }
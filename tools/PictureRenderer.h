@@ -9,7 +9,6 @@
 #define PictureRenderer_DEFINED
 
 #include "SkCanvas.h"
-#include "SkCountdown.h"
 #include "SkDrawFilter.h"
 #include "SkMath.h"
 #include "SkPaint.h"
@@ -19,7 +18,7 @@
 #include "SkRunnable.h"
 #include "SkString.h"
 #include "SkTDArray.h"
-#include "SkThreadPool.h"
+#include "SkTaskScheduler.h"
 #include "SkTileGridPicture.h"
 #include "SkTypes.h"
 
@@ -59,10 +58,10 @@ public:
     // this uses SkPaint::Flags as a base and adds additional flags
     enum DrawFilterFlags {
         kNone_DrawFilterFlag = 0,
-        kBlur_DrawFilterFlag = 0x4000, // toggles between blur and no blur
-        kHinting_DrawFilterFlag = 0x8000, // toggles between no hinting and normal hinting
-        kSlightHinting_DrawFilterFlag = 0x10000, // toggles between slight and normal hinting
-        kAAClip_DrawFilterFlag = 0x20000, // toggles between soft and hard clip
+        kBlur_DrawFilterFlag = 0x10000, // toggles between blur and no blur
+        kHinting_DrawFilterFlag = 0x20000, // toggles between no hinting and normal hinting
+        kSlightHinting_DrawFilterFlag = 0x40000, // toggles between slight and normal hinting
+        kAAClip_DrawFilterFlag = 0x80000, // toggles between soft and hard clip
     };
 
     SK_COMPILE_ASSERT(!(kBlur_DrawFilterFlag & SkPaint::kAllFlags), blur_flag_must_be_greater);
@@ -70,6 +69,8 @@ public:
             hinting_flag_must_be_greater);
     SK_COMPILE_ASSERT(!(kSlightHinting_DrawFilterFlag & SkPaint::kAllFlags),
             slight_hinting_flag_must_be_greater);
+    SK_COMPILE_ASSERT(!(kAAClip_DrawFilterFlag & SkPaint::kAllFlags),
+            aaclip_flag_must_be_greater);
 
     /**
      * Called with each new SkPicture to render.
@@ -177,6 +178,28 @@ public:
         fGridInfo.fTileInterval.set(width, height);
     }
 
+    /**
+     * Skip draws hidden behind later opaque draws. Only has an effect with a tile grid.
+     */
+    void setCullOccludedDraws(bool cull) {
+        fCullOccludedDraws = cull;
+    }
+
+    enum RecordOptimizations {
+        kAsRead_RecordOptimizations,    // play the picture back as it was read
+        kOn_RecordOptimizations,
+        kOff_RecordOptimizations,
+    };
+
+    /**
+     * Record the picture again before playing it back, with the rewrites that SkPicture applies
+     * to the recorded commands turned on or off (see
+     * SkPicture::kDisableRecordOptimizations_RecordingFlag).
+     */
+    void setRecordOptimizations(RecordOptimizations optimizations) {
+        fRecordOptimizations = optimizations;
+    }
+
     bool isUsingBitmapDevice() {
         return kBitmap_DeviceType == fDeviceType;
     }
@@ -197,6 +220,14 @@ public:
             config.append("_rtree");
         } else if (kTileGrid_BBoxHierarchyType == fBBoxHierarchyType) {
             config.append("_grid");
+            if (fCullOccludedDraws) {
+                config.append("_cull");
+            }
+        }
+        if (kOn_RecordOptimizations == fRecordOptimizations) {
+            config.append("_recopt");
+        } else if (kOff_RecordOptimizations == fRecordOptimizations) {
+            config.append("_norecopt");
         }
 #if SK_SUPPORT_GPU
         switch (fDeviceType) {
@@ -258,6 +289,8 @@ public:
         : fPicture(NULL)
         , fDeviceType(kBitmap_DeviceType)
         , fBBoxHierarchyType(kNone_BBoxHierarchyType)
+        , fCullOccludedDraws(false)
+        , fRecordOptimizations(kAsRead_RecordOptimizations)
         , fScaleFactor(SK_Scalar1)
 #if SK_SUPPORT_GPU
         , fGrContext(NULL)
@@ -281,6 +314,8 @@ protected:
     SkPicture*             fPicture;
     SkDeviceTypes          fDeviceType;
     BBoxHierarchyType      fBBoxHierarchyType;
+    bool                   fCullOccludedDraws;
+    RecordOptimizations    fRecordOptimizations;
     DrawFilterFlags        fDrawFilters[SkDrawFilter::kTypeCount];
     SkString               fDrawFiltersConfig;
     SkTileGridPicture::TileGridInfo fGridInfo; // used when fBBoxHierarchyType is TileGrid
@@ -350,15 +385,47 @@ private:
     typedef PictureRenderer INHERITED;
 };
 
+/**
+ * Like PipePictureRenderer, but streams the commands through an SkSharedPipeController's ring
+ * buffer to a reader on another thread, the way a renderer process would consume them. The stream
+ * is written cross-process, so bitmaps are flattened into it.
+ */
+class SharedPipePictureRenderer : public PictureRenderer {
+public:
+    SharedPipePictureRenderer();
+
+    virtual bool render(const SkString*, SkBitmap** out = NULL) SK_OVERRIDE;
+
+private:
+    virtual SkString getConfigNameInternal() SK_OVERRIDE;
+
+    SkAutoMalloc fRing;
+
+    typedef PictureRenderer INHERITED;
+};
+
 class SimplePictureRenderer : public PictureRenderer {
 public:
+    /**
+     * With threadCount > 1 the picture is drawn with SkPictureUtils::DrawParallel(), which splits
+     * the canvas into bands that are drawn concurrently straight into its pixels.
+     */
+    explicit SimplePictureRenderer(int threadCount = 1);
+
     virtual void init(SkPicture* pict) SK_OVERRIDE;
 
     virtual bool render(const SkString*, SkBitmap** out = NULL) SK_OVERRIDE;
 
+    virtual void end() SK_OVERRIDE;
+
 private:
     virtual SkString getConfigNameInternal() SK_OVERRIDE;
 
+    const int                      fNumThreads;
+    SkAutoTDelete<SkTaskScheduler> fScheduler;
+    // Made once in init(), so that render() does not time the cloning.
+    SkAutoTArray<SkPicture>        fPictureClones;
+
     typedef PictureRenderer INHERITED;
 };
 
@@ -505,10 +572,9 @@ private:
 
     const int            fNumThreads;
     SkTDArray<SkCanvas*> fCanvasPool;
-    SkThreadPool         fThreadPool;
+    SkTaskScheduler      fScheduler;
     SkPicture*           fPictureClones;
     CloneData**          fCloneData;
-    SkCountdown          fCountdown;
 
     typedef TiledPictureRenderer INHERITED;
 };
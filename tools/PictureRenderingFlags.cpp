@@ -38,6 +38,8 @@ DEFINE_string(config, "8888", "[8888|gpu]: Use the corresponding config.");
 DEFINE_string(config, "8888", "[8888]: Use the corresponding config.");
 #endif
 
+DEFINE_bool(cullOccluded, false, "Skip draws hidden behind later opaque draws in each tile. "
+            "Requires --bbh grid.");
 DEFINE_bool(deferImageDecoding, false, "Defer decoding until drawing images. "
             "Has no effect if the provided skp does not have its images encoded.");
 DEFINE_string(mode, "simple", "Run in the corresponding mode:\n"
@@ -58,9 +60,14 @@ DEFINE_string(mode, "simple", "Run in the corresponding mode:\n"
               "rerecord: (Only in render_pictures) Record the picture as a new skp,\n"
               "\twith the bitmaps PNG encoded.\n");
 DEFINE_int32(multi, 1, "Set the number of threads for multi threaded drawing. "
-             "If > 1, requires tiled rendering.");
+             "If > 1, requires tiled or simple rendering.");
 DEFINE_bool(pipe, false, "Use SkGPipe rendering. Currently incompatible with \"mode\".");
+DEFINE_bool(sharedPipe, false, "Like --pipe, but stream the commands to another thread "
+            "through the shared memory ring of an SkSharedPipeController.");
 DEFINE_string2(readPath, r, "", "skp files or directories of skp files to process.");
+DEFINE_string(recordOptimizations, "", "[on|off]: Record each skp again before playing it back, "
+              "with the rewrites SkPicture applies to recorded commands turned on or off. "
+              "By default each skp is played back as it was read.");
 DEFINE_double(scale, 1, "Set the scale factor.");
 DEFINE_string(tiles, "", "Used with --mode copyTile to specify number of tiles per larger tile "
               "in the x and y directions.");
@@ -216,15 +223,18 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
         }
 
         renderer.reset(tiledRenderer.detach());
-        if (FLAGS_pipe) {
+        if (FLAGS_pipe || FLAGS_sharedPipe) {
             error.printf("Pipe rendering is currently not compatible with tiling.\n"
                          "Turning off pipe.\n");
         }
 
     } else { // useTiles
         if (FLAGS_multi > 1) {
-            error.printf("Multithreaded drawing requires tiled rendering.\n");
-            return NULL;
+            if (renderer != NULL || FLAGS_pipe || FLAGS_sharedPipe) {
+                error.printf("Multithreaded drawing requires tiled or simple rendering.\n");
+                return NULL;
+            }
+            renderer.reset(SkNEW_ARGS(sk_tools::SimplePictureRenderer, (FLAGS_multi)));
         }
         if (FLAGS_pipe) {
             if (renderer != NULL) {
@@ -233,6 +243,13 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
             }
             renderer.reset(SkNEW(sk_tools::PipePictureRenderer));
         }
+        if (FLAGS_sharedPipe) {
+            if (renderer != NULL) {
+                error.printf("Pipe is incompatible with other modes.\n");
+                return NULL;
+            }
+            renderer.reset(SkNEW(sk_tools::SharedPipePictureRenderer));
+        }
     }
 
     if (NULL == renderer) {
@@ -260,7 +277,7 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
         else if (0 == strcmp(FLAGS_config[0], "gpu")) {
             deviceType = sk_tools::PictureRenderer::kGPU_DeviceType;
             if (FLAGS_multi > 1) {
-                error.printf("GPU not compatible with multithreaded tiling.\n");
+                error.printf("GPU not compatible with multithreaded drawing.\n");
                 return NULL;
             }
         }
@@ -268,7 +285,7 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
         else if (0 == strcmp(FLAGS_config[0], "angle")) {
             deviceType = sk_tools::PictureRenderer::kAngle_DeviceType;
             if (FLAGS_multi > 1) {
-                error.printf("Angle not compatible with multithreaded tiling.\n");
+                error.printf("Angle not compatible with multithreaded drawing.\n");
                 return NULL;
             }
         }
@@ -308,12 +325,32 @@ sk_tools::PictureRenderer* parseRenderer(SkString& error, PictureTool tool) {
             error.printf("%s is not a valid value for --bbhType\n", type);
             return NULL;
         }
-        if (FLAGS_pipe && sk_tools::PictureRenderer::kNone_BBoxHierarchyType != bbhType) {
+        if ((FLAGS_pipe || FLAGS_sharedPipe) &&
+            sk_tools::PictureRenderer::kNone_BBoxHierarchyType != bbhType) {
             error.printf("--pipe and --bbh cannot be used together\n");
             return NULL;
         }
     }
+    if (FLAGS_cullOccluded && sk_tools::PictureRenderer::kTileGrid_BBoxHierarchyType != bbhType) {
+        error.printf("--cullOccluded requires --bbh grid.\n");
+        return NULL;
+    }
     renderer->setBBoxHierarchyType(bbhType);
+    renderer->setCullOccludedDraws(FLAGS_cullOccluded);
+
+    if (FLAGS_recordOptimizations.count() > 0) {
+        if (0 == strcmp(FLAGS_recordOptimizations[0], "on")) {
+            renderer->setRecordOptimizations(
+                sk_tools::PictureRenderer::kOn_RecordOptimizations);
+        } else if (0 == strcmp(FLAGS_recordOptimizations[0], "off")) {
+            renderer->setRecordOptimizations(
+                sk_tools::PictureRenderer::kOff_RecordOptimizations);
+        } else {
+            error.printf("%s is not a valid value for --recordOptimizations\n",
+                         FLAGS_recordOptimizations[0]);
+            return NULL;
+        }
+    }
     renderer->setScaleFactor(SkDoubleToScalar(FLAGS_scale));
 
     return renderer.detach();
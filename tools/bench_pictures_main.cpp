@@ -10,7 +10,9 @@
 #include "PictureBenchmark.h"
 #include "PictureRenderingFlags.h"
 #include "SkBenchLogger.h"
+#include "SkCanvas.h"
 #include "SkCommandLineFlags.h"
+#include "SkDevice.h"
 #include "SkGraphics.h"
 #include "SkImageDecoder.h"
 #if LAZY_CACHE_STATS
@@ -21,6 +23,7 @@
 #include "SkOSFile.h"
 #include "SkPicture.h"
 #include "SkStream.h"
+#include "SkTileGridPicture.h"
 #include "picture_utils.h"
 
 
@@ -28,6 +31,10 @@ SkBenchLogger gLogger;
 
 // Flags used by this file, in alphabetical order.
 DEFINE_bool(countRAM, false, "Count the RAM used for bitmap pixels in each skp file");
+DEFINE_bool(countStateCalls, false, "Report how many save, restore, matrix and clip calls "
+            "playing back each skp makes, once recorded again with and without the rewrites "
+            "SkPicture applies to recorded commands.");
+DECLARE_bool(cullOccluded);
 DECLARE_bool(deferImageDecoding);
 DEFINE_string(filter, "",
         "type:flag : Enable canvas filtering to disable a paint flag, "
@@ -79,6 +86,8 @@ static char const * const gFilterFlags[] = {
     "autoHinting",
     "verticalText",
     "genA8FromLCD",
+    "mediumQualityFilterBitmap",
+    "highQualityFilterBitmap",
     "blur",
     "hinting",
     "slightHinting",
@@ -147,6 +156,91 @@ static SkString filterFlagsUsage() {
 extern SkLruImageCache gLruImageCache;
 extern bool lazy_decode_bitmap(const void* buffer, size_t size, SkBitmap* bitmap);
 
+namespace {
+
+// Counts the calls that change the canvas state, without drawing anything.
+class StateCallCounter : public SkCanvas {
+public:
+    StateCallCounter(int width, int height) : fCount(0) {
+        SkBitmap bitmap;
+        bitmap.setConfig(SkBitmap::kNo_Config, width, height);
+        this->setDevice(SkNEW_ARGS(SkDevice, (bitmap)))->unref();
+    }
+
+    int count() const { return fCount; }
+
+    virtual int save(SaveFlags flags) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::save(flags);
+    }
+    virtual int saveLayer(const SkRect* bounds, const SkPaint* paint,
+                          SaveFlags flags) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::saveLayer(bounds, paint, flags);
+    }
+    virtual void restore() SK_OVERRIDE {
+        fCount++;
+        this->INHERITED::restore();
+    }
+    virtual bool translate(SkScalar dx, SkScalar dy) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::translate(dx, dy);
+    }
+    virtual bool scale(SkScalar sx, SkScalar sy) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::scale(sx, sy);
+    }
+    virtual bool rotate(SkScalar degrees) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::rotate(degrees);
+    }
+    virtual bool skew(SkScalar sx, SkScalar sy) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::skew(sx, sy);
+    }
+    virtual bool concat(const SkMatrix& matrix) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::concat(matrix);
+    }
+    virtual void setMatrix(const SkMatrix& matrix) SK_OVERRIDE {
+        fCount++;
+        this->INHERITED::setMatrix(matrix);
+    }
+    virtual bool clipRect(const SkRect& rect, SkRegion::Op op, bool doAA) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::clipRect(rect, op, doAA);
+    }
+    virtual bool clipRRect(const SkRRect& rrect, SkRegion::Op op, bool doAA) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::clipRRect(rrect, op, doAA);
+    }
+    virtual bool clipPath(const SkPath& path, SkRegion::Op op, bool doAA) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::clipPath(path, op, doAA);
+    }
+    virtual bool clipRegion(const SkRegion& region, SkRegion::Op op) SK_OVERRIDE {
+        fCount++;
+        return this->INHERITED::clipRegion(region, op);
+    }
+
+private:
+    int fCount;
+
+    typedef SkCanvas INHERITED;
+};
+
+}
+
+static int count_state_calls(SkPicture* picture, uint32_t recordFlags) {
+    SkPicture rerecorded;
+    picture->draw(rerecorded.beginRecording(picture->width(), picture->height(), recordFlags));
+    rerecorded.endRecording();
+
+    StateCallCounter counter(picture->width(), picture->height());
+    counter.drawPicture(rerecorded);
+    return counter.count();
+}
+
 #if LAZY_CACHE_STATS
 static int32_t gTotalCacheHits;
 static int32_t gTotalCacheMisses;
@@ -195,8 +289,28 @@ static bool run_single_benchmark(const SkString& inputPath,
                   filename.c_str());
     gLogger.logProgress(result);
 
+    if (FLAGS_cullOccluded) {
+        SkTileGridPicture::ResetOccludedDrawCount();
+    }
+
     benchmark.run(picture);
 
+    if (FLAGS_countStateCalls) {
+        SkString calls;
+        calls.printf("State calls played back: %i (%i without record optimizations)\n",
+                     count_state_calls(picture, 0),
+                     count_state_calls(picture,
+                                       SkPicture::kDisableRecordOptimizations_RecordingFlag));
+        gLogger.logProgress(calls);
+    }
+
+    if (FLAGS_cullOccluded) {
+        SkString occluded;
+        occluded.printf("Draws skipped because they were hidden: %i\n",
+                        SkTileGridPicture::GetOccludedDrawCount());
+        gLogger.logProgress(occluded);
+    }
+
 #if LAZY_CACHE_STATS
     if (FLAGS_trackDeferredCaching) {
         int32_t cacheHits = SkLazyPixelRef::GetCacheHits();
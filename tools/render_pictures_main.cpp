@@ -9,6 +9,7 @@
 #include "SkBitmap.h"
 #include "SkDevice.h"
 #include "SkCommandLineFlags.h"
+#include "SkData.h"
 #include "SkGraphics.h"
 #include "SkImageDecoder.h"
 #include "SkImageEncoder.h"
@@ -27,6 +28,9 @@ DECLARE_bool(deferImageDecoding);
 DEFINE_int32(maxComponentDiff, 256, "Maximum diff on a component, 0 - 256. Components that differ "
              "by more than this amount are considered errors, though all diffs are reported. "
              "Requires --validate.");
+DEFINE_bool(mmap, false, "Map the picture file into memory. Pictures in the in-place format "
+            "(see SkPicture::serializeForInPlacePlayback()) are played back straight from "
+            "it, decoding their paints and paths on first use; others are read as usual.");
 DECLARE_string(readPath);
 DEFINE_string2(writePath, w, "", "Directory to write the rendered images.");
 DEFINE_bool(writeWholeImage, false, "In tile mode, write the entire rendered image to a "
@@ -51,19 +55,31 @@ static bool render_picture(const SkString& inputPath, const SkString* outputDir,
     SkString inputFilename;
     sk_tools::get_basename(&inputFilename, inputPath);
 
-    SkFILEStream inputStream;
-    inputStream.setPath(inputPath.c_str());
-    if (!inputStream.isValid()) {
-        SkDebugf("Could not open file %s\n", inputPath.c_str());
-        return false;
+    SkPicture::InstallPixelRefProc proc;
+    if (FLAGS_deferImageDecoding) {
+        proc = &lazy_decode_bitmap;
+    } else {
+        proc = &SkImageDecoder::DecodeMemory;
     }
 
     bool success = false;
     SkPicture* picture;
-    if (FLAGS_deferImageDecoding) {
-        picture = SkNEW_ARGS(SkPicture, (&inputStream, &success, &lazy_decode_bitmap));
+    if (FLAGS_mmap) {
+        SkAutoTUnref<SkData> data(SkData::NewFromFileName(inputPath.c_str()));
+        if (NULL == data.get()) {
+            SkDebugf("Could not open file %s\n", inputPath.c_str());
+            return false;
+        }
+        picture = SkPicture::CreateFromData(data, proc);
+        success = NULL != picture;
     } else {
-        picture = SkNEW_ARGS(SkPicture, (&inputStream, &success, &SkImageDecoder::DecodeMemory));
+        SkFILEStream inputStream;
+        inputStream.setPath(inputPath.c_str());
+        if (!inputStream.isValid()) {
+            SkDebugf("Could not open file %s\n", inputPath.c_str());
+            return false;
+        }
+        picture = SkNEW_ARGS(SkPicture, (&inputStream, &success, proc));
     }
     if (!success) {
         SkDebugf("Could not read an SkPicture from %s\n", inputPath.c_str());